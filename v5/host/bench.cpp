@@ -0,0 +1,353 @@
+// ============================================================
+// uniremote-bench — micro-benchmarks for the IR and UI hot paths
+// ============================================================
+// Runs the sketch's own functions on the host stand-ins and reports, per
+// operation: host CPU time, heap allocations and bytes, SPI bytes on the
+// shared bus and the bus time those bytes cost on the device clocks.
+// The last three are deterministic, so a change in them is a real
+// change in the code, not noise.
+//
+//   cmake -S v5/host -B build-host && cmake --build build-host
+//   ./build-host/uniremote-bench [--filter TEXT] [--json out.json]
+//   ./build-host/uniremote-bench --json new.json --compare base.json
+//
+// --compare exits 1 when a benchmark got worse than the baseline by more
+// than --threshold percent (default 5) in allocations, SPI bytes or bus
+// time, or by more than --time-threshold percent (default 25) in CPU time.
+#include <Arduino.h>
+#include <chrono>
+#include <dirent.h>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../uniremote/uniremote.ino"
+
+// ------------------------------------------------------------
+// Harness
+// ------------------------------------------------------------
+// body(state) runs state.iterations operations; setup work between
+// operations goes inside state.pause() / state.resume()
+class BenchState {
+  std::chrono::steady_clock::time_point started;
+  std::chrono::nanoseconds paused { 0 };
+  uint64_t allocs0 = 0, bytes0 = 0, spi0 = 0, bus0 = 0;
+  uint64_t pausedAllocs = 0, pausedBytes = 0, pausedSpi = 0, pausedBus = 0;
+
+  static uint64_t spiBytes() {
+    return host::bus.display.bytes + host::bus.sd.bytes + host::bus.touch.bytes;
+  }
+
+public:
+  uint64_t iterations;
+  explicit BenchState(uint64_t n)
+    : iterations(n) {}
+
+  void start() {
+    allocs0 = host::allocCount(), bytes0 = host::allocBytes(), spi0 = spiBytes(), bus0 = host::nowUs();
+    started = std::chrono::steady_clock::now();
+  }
+  void pause() {
+    paused -= std::chrono::steady_clock::now().time_since_epoch();
+    pausedAllocs -= host::allocCount(), pausedBytes -= host::allocBytes(), pausedSpi -= spiBytes(), pausedBus -= host::nowUs();
+  }
+  void resume() {
+    paused += std::chrono::steady_clock::now().time_since_epoch();
+    pausedAllocs += host::allocCount(), pausedBytes += host::allocBytes(), pausedSpi += spiBytes(), pausedBus += host::nowUs();
+  }
+
+  struct Result {
+    double ns, allocs, allocBytes, spiBytes, busUs;
+  };
+  Result finish() const {
+    double n = (double)iterations;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started - paused).count();
+    return { ns / n, (host::allocCount() - allocs0 - pausedAllocs) / n, (host::allocBytes() - bytes0 - pausedBytes) / n,
+             (spiBytes() - spi0 - pausedSpi) / n, (host::nowUs() - bus0 - pausedBus) / n };
+  }
+};
+
+// Keeps the compiler from dropping work whose result is unused
+template<typename T> static void keep(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Benchmark {
+  const char *name;
+  std::function<void(BenchState &)> body;
+};
+
+static std::vector<Benchmark> &benchmarks() {
+  static std::vector<Benchmark> all;
+  return all;
+}
+
+struct BenchRegistrar {
+  BenchRegistrar(const char *name, std::function<void(BenchState &)> body) {
+    benchmarks().push_back({ name, std::move(body) });
+  }
+};
+#define BENCHMARK(id, name) \
+  static void id(BenchState &state); \
+  static BenchRegistrar id##Registrar(name, id); \
+  static void id(BenchState &state)
+
+// ------------------------------------------------------------
+// Fixtures
+// ------------------------------------------------------------
+constexpr int BENCH_SAVED_SIGNALS = 48;
+constexpr int BENCH_DIR_FILES = 1000;
+static std::string cardDir;
+
+static void writeCardFile(const std::string &path, size_t size) {
+  std::ofstream f(cardDir + path, std::ios::binary);
+  std::string bytes(size, '\0');
+  f.write(bytes.data(), bytes.size());
+}
+
+static void removeSortCache() {
+  std::string dir = cardDir + SORT_CACHE_DIR;
+  if (DIR *d = opendir(dir.c_str())) {
+    for (dirent *e; (e = readdir(d));)
+      if (e->d_name[0] != '.') unlink((dir + "/" + e->d_name).c_str());
+    closedir(d);
+  }
+}
+
+// A card with a realistic saved library and one very large directory
+static void buildCard() {
+  char tmpl[] = "/tmp/uniremote-bench-XXXXXX";
+  cardDir = mkdtemp(tmpl);
+  ::mkdir((cardDir + "/saved-signals").c_str(), 0755);
+  ::mkdir((cardDir + "/big").c_str(), 0755);
+  const char *groups[] = { "TV", "AMP", "PROJ", "FAN", "AC", "LED" };
+  const char *keys[] = { "power", "vol-up", "vol-down", "mute", "input", "menu", "ok", "back" };
+  for (int i = 0; i < BENCH_SAVED_SIGNALS; i++)
+    writeCardFile(std::string("/saved-signals/") + groups[i / 8 % 6] + "-" + keys[i % 8] + ".bin", sizeof(IRSignal));
+  for (int i = 0; i < BENCH_DIR_FILES; i++) writeCardFile("/big/SESS-" + std::to_string(i) + ".irs", 64 + i);
+  host::setSdRoot(cardDir);
+}
+
+static void removeCard() {
+  std::string cmd = "rm -rf '" + cardDir + "'";
+  if (system(cmd.c_str()) != 0) fprintf(stderr, "couldn't remove %s\n", cardDir.c_str());
+}
+
+// NEC 0x04/0x08 as Pronto hex: header, 32 bits, stop, then the repeat frame
+static std::vector<uint16_t> necPronto() {
+  auto cycles = [](uint32_t us) {
+    return (uint16_t)(us / (0x6D * PRONTO_CLOCK_US) + 0.5f);
+  };
+  std::vector<uint16_t> once = { cycles(9000), cycles(4500) };
+  uint32_t data = 0x04 | 0xFB << 8 | 0x08 << 16 | 0xF7u << 24;
+  for (int b = 0; b < 32; b++) once.insert(once.end(), { cycles(560), cycles((data >> b) & 1 ? 1690 : 560) });
+  once.insert(once.end(), { cycles(560), cycles(40000) });
+  std::vector<uint16_t> repeat = { cycles(9000), cycles(2250), cycles(560), cycles(96000) };
+  std::vector<uint16_t> pronto = { 0x0000, 0x006D, (uint16_t)(once.size() / 2), (uint16_t)(repeat.size() / 2) };
+  pronto.insert(pronto.end(), once.begin(), once.end());
+  pronto.insert(pronto.end(), repeat.begin(), repeat.end());
+  return pronto;
+}
+
+// ------------------------------------------------------------
+// Benchmarks
+// ------------------------------------------------------------
+BENCHMARK(benchProntoToSignal, "ir/prontoToSignal") {
+  static const std::vector<uint16_t> pronto = necPronto();
+  IRSignal signal;
+  state.start();
+  for (uint64_t i = 0; i < state.iterations; i++) {
+    prontoToSignal(pronto.data(), pronto.size(), signal);
+    keep(signal);
+  }
+}
+
+// One drag frame of the file browser: scroll 7 px and redraw the view
+BENCHMARK(benchRenderScrollList, "ui/renderScrollList") {
+  loadSDFiles("/big");
+  drawSDFileBrowser();
+  state.start();
+  for (uint64_t i = 0; i < state.iterations; i++) {
+    activeList.scrollPx += 7;
+    if (activeList.scrollPx > activeList.itemCount * activeList.rowHeight - activeList.viewH) activeList.scrollPx = 0;
+    renderScrollList(activeList);
+  }
+}
+
+BENCHMARK(benchDrawButton, "ui/drawButton") {
+  buttonCount = 0;
+  createTouchBox(15, 190, 100, 45, currentTheme.primary, currentTheme.primary, "Monitor", nullptr);
+  state.start();
+  for (uint64_t i = 0; i < state.iterations; i++) drawButton(&buttons[0], i & 1);
+}
+
+BENCHMARK(benchExtractPrefix, "saved/extractPrefix") {
+  String name = "PROJ-vol-down.bin";
+  state.start();
+  for (uint64_t i = 0; i < state.iterations; i++) keep(extractPrefix(name));
+}
+
+// Reading /saved-signals into groups and drawing the group list
+BENCHMARK(benchListSavedSignals, "saved/listSavedSignals") {
+  state.start();
+  for (uint64_t i = 0; i < state.iterations; i++) listSavedSignals();
+}
+
+BENCHMARK(benchLoadSDFilesCold, "sd/loadSDFiles-1000-cold") {
+  state.start();
+  for (uint64_t i = 0; i < state.iterations; i++) {
+    state.pause();
+    removeSortCache();
+    state.resume();
+    loadSDFiles("/big");
+  }
+}
+
+BENCHMARK(benchLoadSDFilesWarm, "sd/loadSDFiles-1000-cached") {
+  loadSDFiles("/big");
+  state.start();
+  for (uint64_t i = 0; i < state.iterations; i++) loadSDFiles("/big");
+}
+
+BENCHMARK(benchSaveSignal, "signal/saveSignalToSD") {
+  IRSignal signal = {};
+  static const std::vector<uint16_t> pronto = necPronto();
+  prontoToSignal(pronto.data(), pronto.size(), signal);
+  strcpy(signal.name, "BENCH-power");
+  state.start();
+  for (uint64_t i = 0; i < state.iterations; i++) saveSignalToSD(signal);
+}
+
+BENCHMARK(benchLoadSignal, "signal/loadSignalFromSD") {
+  IRSignal signal;
+  state.start();
+  for (uint64_t i = 0; i < state.iterations; i++) loadSignalFromSD("/saved-signals/TV-power.bin", signal);
+}
+
+// ------------------------------------------------------------
+// Runner
+// ------------------------------------------------------------
+struct Measured {
+  std::string name;
+  uint64_t iterations;
+  BenchState::Result r;
+};
+
+// Grows the iteration count until a run takes at least minNs
+static Measured measure(const Benchmark &b, double minNs) {
+  for (uint64_t n = 1;; n *= 4) {
+    BenchState state(n);
+    b.body(state);
+    BenchState::Result r = state.finish();
+    if (r.ns * n >= minNs || n >= (1u << 20)) return { b.name, n, r };
+  }
+}
+
+static std::string toJson(const std::vector<Measured> &results) {
+  std::ostringstream out;
+  out << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Measured &m = results[i];
+    char line[512];
+    snprintf(line, sizeof(line),
+             "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, "
+             "\"alloc_bytes_per_op\": %.1f, \"spi_bytes_per_op\": %.1f, \"bus_us_per_op\": %.2f}%s\n",
+             m.name.c_str(), (unsigned long long)m.iterations, m.r.ns, m.r.allocs, m.r.allocBytes, m.r.spiBytes, m.r.busUs,
+             i + 1 < results.size() ? "," : "");
+    out << line;
+  }
+  out << "  ]\n}\n";
+  return out.str();
+}
+
+// Reads what toJson() writes: one benchmark object per line
+static std::map<std::string, BenchState::Result> readJson(const char *path) {
+  std::map<std::string, BenchState::Result> found;
+  std::ifstream f(path);
+  std::string line;
+  auto field = [&line](const char *key) {
+    size_t at = line.find(std::string("\"") + key + "\": ");
+    return at == std::string::npos ? 0.0 : atof(line.c_str() + at + strlen(key) + 4);
+  };
+  while (std::getline(f, line)) {
+    size_t at = line.find("\"name\": \"");
+    if (at == std::string::npos) continue;
+    at += 9;
+    std::string name = line.substr(at, line.find('"', at) - at);
+    found[name] = { field("ns_per_op"), field("allocs_per_op"), field("alloc_bytes_per_op"), field("spi_bytes_per_op"),
+                    field("bus_us_per_op") };
+  }
+  return found;
+}
+
+static bool worse(double now, double base, double pct) {
+  return now > base * (1 + pct / 100) + 1e-9;
+}
+
+int main(int argc, char **argv) {
+  const char *filter = "", *jsonPath = nullptr, *comparePath = nullptr;
+  double threshold = 5, timeThreshold = 25, minMs = 200;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (a == "--filter" && i + 1 < argc) filter = argv[++i];
+    else if (a == "--json" && i + 1 < argc) jsonPath = argv[++i];
+    else if (a == "--compare" && i + 1 < argc) comparePath = argv[++i];
+    else if (a == "--threshold" && i + 1 < argc) threshold = atof(argv[++i]);
+    else if (a == "--time-threshold" && i + 1 < argc) timeThreshold = atof(argv[++i]);
+    else if (a == "--min-ms" && i + 1 < argc) minMs = atof(argv[++i]);
+    else {
+      fprintf(stderr,
+              "usage: %s [--filter TEXT] [--json FILE] [--compare BASE.json] [--threshold PCT] "
+              "[--time-threshold PCT] [--min-ms MS]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  host::setSerialEcho(false);
+  buildCard();
+  setup();
+
+  std::vector<Measured> results;
+  printf("%-30s %10s %12s %10s %12s %12s %12s\n", "benchmark", "iters", "cpu ns/op", "allocs/op", "heap B/op",
+         "spi B/op", "bus us/op");
+  for (const Benchmark &b : benchmarks()) {
+    if (!strstr(b.name, filter)) continue;
+    Measured m = measure(b, minMs * 1e6);
+    results.push_back(m);
+    printf("%-30s %10llu %12.1f %10.2f %12.1f %12.1f %12.2f\n", m.name.c_str(), (unsigned long long)m.iterations, m.r.ns,
+           m.r.allocs, m.r.allocBytes, m.r.spiBytes, m.r.busUs);
+  }
+  removeCard();
+
+  if (jsonPath) {
+    std::ofstream f(jsonPath);
+    f << toJson(results);
+  }
+  if (!comparePath) return 0;
+
+  std::map<std::string, BenchState::Result> base = readJson(comparePath);
+  int regressions = 0;
+  for (const Measured &m : results) {
+    auto it = base.find(m.name);
+    if (it == base.end()) continue;
+    const BenchState::Result &b = it->second;
+    struct {
+      const char *metric;
+      double now, was, pct;
+    } checks[] = { { "cpu ns", m.r.ns, b.ns, timeThreshold },
+                   { "allocs", m.r.allocs, b.allocs, threshold },
+                   { "heap bytes", m.r.allocBytes, b.allocBytes, threshold },
+                   { "spi bytes", m.r.spiBytes, b.spiBytes, threshold },
+                   { "bus us", m.r.busUs, b.busUs, threshold } };
+    for (auto &c : checks) {
+      if (!worse(c.now, c.was, c.pct)) continue;
+      printf("REGRESSION %s: %s %.2f -> %.2f per op\n", m.name.c_str(), c.metric, c.was, c.now);
+      regressions++;
+    }
+  }
+  printf("%d regression%s against %s\n", regressions, regressions == 1 ? "" : "s", comparePath);
+  return regressions ? 1 : 0;
+}
@@ -0,0 +1,351 @@
+#pragma once
+
+// ============================================================
+// Arduino core stand-in
+// ============================================================
+// Just enough of the ESP32 Arduino core for the sketch to build and run
+// on a workstation. Time is virtual (see host.h): millis() and micros()
+// only move when delay(), bus traffic or the host driver advance them,
+// so every run of a script is identical.
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "./host.h"
+
+using std::max;
+using std::min;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define IRAM_ATTR
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define PI 3.1415926535897932384626433832795
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline unsigned long millis() {
+  return (unsigned long)(host::nowUs() / 1000);
+}
+inline unsigned long micros() {
+  return (unsigned long)host::nowUs();
+}
+inline void delay(unsigned long ms) {
+  host::advanceUs((uint64_t)ms * 1000);
+}
+inline void delayMicroseconds(unsigned int us) {
+  host::advanceUs(us);
+}
+inline void yield() {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline uint32_t esp_random() {
+  return (uint32_t)rand();
+}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+inline int digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+
+// ------------------------------------------------------------
+// String
+// ------------------------------------------------------------
+class String {
+  std::string s;
+
+public:
+  String() {}
+  String(const char *c)
+    : s(c ? c : "") {}
+  String(const std::string &x)
+    : s(x) {}
+  explicit String(char c)
+    : s(1, c) {}
+  String(int v)
+    : s(std::to_string(v)) {}
+  String(unsigned v)
+    : s(std::to_string(v)) {}
+  String(long v)
+    : s(std::to_string(v)) {}
+  String(unsigned long v)
+    : s(std::to_string(v)) {}
+  String(long long v)
+    : s(std::to_string(v)) {}
+  String(unsigned long long v)
+    : s(std::to_string(v)) {}
+  String(double v, unsigned decimals = 2) {
+    char b[64];
+    snprintf(b, sizeof(b), "%.*f", (int)decimals, v);
+    s = b;
+  }
+  String(float v, unsigned decimals = 2)
+    : String((double)v, decimals) {}
+
+  const char *c_str() const {
+    return s.c_str();
+  }
+  unsigned length() const {
+    return s.size();
+  }
+  bool isEmpty() const {
+    return s.empty();
+  }
+  void reserve(unsigned n) {
+    s.reserve(n);
+  }
+
+  String operator+(const String &o) const {
+    return String(s + o.s);
+  }
+  String operator+(const char *o) const {
+    return String(s + o);
+  }
+  String operator+(char c) const {
+    return String(s + c);
+  }
+  friend String operator+(const char *a, const String &b) {
+    return String(std::string(a) + b.s);
+  }
+  String &operator+=(const String &o) {
+    s += o.s;
+    return *this;
+  }
+  String &operator+=(const char *o) {
+    s += o;
+    return *this;
+  }
+  String &operator+=(char c) {
+    s += c;
+    return *this;
+  }
+  bool concat(const String &o) {
+    s += o.s;
+    return true;
+  }
+
+  bool operator==(const String &o) const {
+    return s == o.s;
+  }
+  bool operator==(const char *o) const {
+    return s == o;
+  }
+  bool operator!=(const String &o) const {
+    return s != o.s;
+  }
+  bool operator!=(const char *o) const {
+    return s != o;
+  }
+  bool operator<(const String &o) const {
+    return s < o.s;
+  }
+  bool equals(const String &o) const {
+    return s == o.s;
+  }
+  bool equalsIgnoreCase(const String &o) const {
+    return strcasecmp(s.c_str(), o.s.c_str()) == 0;
+  }
+  int compareTo(const String &o) const {
+    return s.compare(o.s);
+  }
+
+  char operator[](unsigned i) const {
+    return i < s.size() ? s[i] : 0;
+  }
+  char charAt(unsigned i) const {
+    return (*this)[i];
+  }
+  bool startsWith(const String &p) const {
+    return s.compare(0, p.s.size(), p.s) == 0;
+  }
+  bool endsWith(const String &p) const {
+    return s.size() >= p.s.size() && s.compare(s.size() - p.s.size(), p.s.size(), p.s) == 0;
+  }
+  String substring(unsigned from) const {
+    return from >= s.size() ? String() : String(s.substr(from));
+  }
+  String substring(unsigned from, unsigned to) const {
+    if (from > to) std::swap(from, to);
+    return from >= s.size() ? String() : String(s.substr(from, to - from));
+  }
+  int indexOf(char c, unsigned from = 0) const {
+    size_t p = s.find(c, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  int indexOf(const String &c, unsigned from = 0) const {
+    size_t p = s.find(c.s, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  int lastIndexOf(char c) const {
+    size_t p = s.rfind(c);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  int lastIndexOf(const String &c) const {
+    size_t p = s.rfind(c.s);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  void replace(const String &from, const String &to) {
+    if (from.s.empty()) return;
+    for (size_t p = 0; (p = s.find(from.s, p)) != std::string::npos; p += to.s.size()) s.replace(p, from.s.size(), to.s);
+  }
+  void toUpperCase() {
+    for (char &c : s) c = toupper((unsigned char)c);
+  }
+  void toLowerCase() {
+    for (char &c : s) c = tolower((unsigned char)c);
+  }
+  void trim() {
+    size_t a = 0, b = s.size();
+    while (a < b && isspace((unsigned char)s[a])) a++;
+    while (b > a && isspace((unsigned char)s[b - 1])) b--;
+    s = s.substr(a, b - a);
+  }
+  long toInt() const {
+    return atol(s.c_str());
+  }
+  float toFloat() const {
+    return (float)atof(s.c_str());
+  }
+};
+
+// ------------------------------------------------------------
+// Print / Stream / Serial
+// ------------------------------------------------------------
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t n) {
+    for (size_t i = 0; i < n; i++) write(buf[i]);
+    return n;
+  }
+  size_t write(const char *str) {
+    return write((const uint8_t *)str, strlen(str));
+  }
+
+  size_t print(const char *str) {
+    return write(str);
+  }
+  size_t print(const String &str) {
+    return write(str.c_str());
+  }
+  size_t print(char c) {
+    return write((uint8_t)c);
+  }
+  size_t print(int v) {
+    return print(String(v));
+  }
+  size_t print(unsigned v) {
+    return print(String(v));
+  }
+  size_t print(long v) {
+    return print(String(v));
+  }
+  size_t print(unsigned long v) {
+    return print(String(v));
+  }
+  size_t print(long long v) {
+    return print(String(v));
+  }
+  size_t print(unsigned long long v) {
+    return print(String(v));
+  }
+  size_t print(double v, int decimals = 2) {
+    return print(String(v, decimals));
+  }
+  template<typename T>
+  size_t println(const T &v) {
+    size_t n = print(v);
+    return n + print("\r\n");
+  }
+  size_t println() {
+    return print("\r\n");
+  }
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+inline size_t Print::printf(const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  return print(buf);
+}
+
+class Stream : public Print {
+public:
+  virtual int available() {
+    return 0;
+  }
+  virtual int read() {
+    return -1;
+  }
+  virtual int peek() {
+    return -1;
+  }
+  size_t readBytes(uint8_t *buf, size_t n) {
+    size_t got = 0;
+    for (int c; got < n && (c = read()) >= 0;) buf[got++] = (uint8_t)c;
+    return got;
+  }
+  size_t readBytes(char *buf, size_t n) {
+    return readBytes((uint8_t *)buf, n);
+  }
+};
+
+// Input comes from host::serialInput(), output goes to host::serialOutput()
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  void end() {}
+  size_t setRxBufferSize(size_t n) {
+    return n;
+  }
+  size_t setTxBufferSize(size_t n) {
+    return n;
+  }
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buf, size_t n) override;
+  using Print::write;
+  int availableForWrite() {
+    return 256;
+  }
+  void flush() {}
+  operator bool() const {
+    return true;
+  }
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+  uint32_t getFreeHeap() {
+    return host::heapFree();
+  }
+  uint32_t getMaxAllocHeap() {
+    return host::heapLargestBlock();
+  }
+};
+
+extern EspClass ESP;
@@ -0,0 +1,364 @@
+#include "./SD.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================
+// Card model
+// ============================================================
+// Every command costs a 6-byte frame plus response and token; data moves
+// in 512-byte sectors. A lookup reads one directory sector per path
+// component; a listing reads one more sector per 16 entries; creating,
+// removing or renaming rewrites a directory sector and a FAT sector.
+constexpr uint32_t SD_SECTOR = 512;
+constexpr uint32_t SD_COMMAND_BYTES = 8;
+constexpr uint32_t SD_DIR_ENTRIES_PER_SECTOR = 16;
+constexpr uint64_t SD_CLUSTER = 32768;
+// One FAT32 partition at SD_PARTITION_LBA, laid out as SD cards ship
+constexpr uint32_t SD_PARTITION_LBA = 8192;
+constexpr uint16_t SD_RESERVED_SECTORS = 32;
+
+SDFS SD;
+
+static uint32_t sdFrequency = 20000000;
+static bool sdMounted = false;
+
+static void chargeSectors(uint32_t sectors) {
+  for (uint32_t i = 0; i < sectors; i++) host::chargeBus(host::bus.sd, SD_SECTOR + SD_COMMAND_BYTES, sdFrequency);
+}
+
+static void chargeLookup(const std::string &path) {
+  chargeSectors(std::max<uint32_t>(1, std::count(path.begin(), path.end(), '/')));
+}
+
+static std::string hostPath(const std::string &path) {
+  return host::sdRoot() + (path.empty() || path[0] != '/' ? "/" : "") + path;
+}
+
+static std::string baseName(const std::string &path) {
+  size_t slash = path.rfind('/');
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+namespace fs {
+
+struct FileImpl {
+  std::string path, base;
+  FILE *fp = nullptr;
+  DIR *dir = nullptr;
+  uint32_t dirEntries = 0;
+  int64_t sector = -1;  // sector held in the file's buffer
+  bool dirty = false;
+
+  ~FileImpl() {
+    close();
+  }
+
+  void close() {
+    if (dirty) chargeSectors(1);
+    dirty = false;
+    if (fp) fclose(fp);
+    if (dir) closedir(dir);
+    fp = nullptr;
+    dir = nullptr;
+  }
+
+  // Brings the sectors under [pos, pos + n) through the buffer
+  void touch(uint64_t pos, size_t n, bool writing) {
+    if (n == 0) return;
+    for (int64_t s = pos / SD_SECTOR; s <= (int64_t)((pos + n - 1) / SD_SECTOR); s++) {
+      if (s == sector) continue;
+      if (dirty) chargeSectors(1);
+      chargeSectors(1);
+      sector = s;
+      dirty = false;
+    }
+    if (writing) dirty = true;
+  }
+
+  // Next entry that isn't . or ..
+  dirent *nextEntry() {
+    for (dirent *e; dir && (e = readdir(dir));) {
+      if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+      if (dirEntries++ % SD_DIR_ENTRIES_PER_SECTOR == 0) chargeSectors(1);
+      return e;
+    }
+    return nullptr;
+  }
+
+  std::string childPath(const char *name) const {
+    return (path == "/" ? "" : path) + "/" + name;
+  }
+};
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buf, size_t n) {
+  if (!impl || !impl->fp) return 0;
+  impl->touch(ftell(impl->fp), n, true);
+  return fwrite(buf, 1, n, impl->fp);
+}
+
+int File::available() {
+  if (!impl || !impl->fp) return 0;
+  return (int)(size() - position());
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+  if (!impl || !impl->fp) return -1;
+  int c = fgetc(impl->fp);
+  if (c != EOF) ungetc(c, impl->fp);
+  return c == EOF ? -1 : c;
+}
+
+size_t File::read(uint8_t *buf, size_t n) {
+  if (!impl || !impl->fp) return 0;
+  long pos = ftell(impl->fp);
+  size_t got = fread(buf, 1, n, impl->fp);
+  impl->touch(pos, got, false);
+  return got;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!impl || !impl->fp) return false;
+  static const int whence[] = { SEEK_SET, SEEK_CUR, SEEK_END };
+  if (fseek(impl->fp, pos, whence[mode]) != 0) return false;
+  return (size_t)ftell(impl->fp) <= size();
+}
+
+size_t File::position() const {
+  return impl && impl->fp ? ftell(impl->fp) : 0;
+}
+
+size_t File::size() const {
+  if (!impl || !impl->fp) return 0;
+  fflush(impl->fp);
+  struct stat st;
+  return fstat(fileno(impl->fp), &st) == 0 ? st.st_size : 0;
+}
+
+void File::flush() {
+  if (!impl || !impl->fp) return;
+  if (impl->dirty) chargeSectors(1);
+  impl->dirty = false;
+  fflush(impl->fp);
+}
+
+void File::close() {
+  if (impl) impl->close();
+  impl.reset();
+}
+
+File::operator bool() const {
+  return impl && (impl->fp || impl->dir);
+}
+
+const char *File::name() const {
+  return impl ? impl->base.c_str() : "";
+}
+
+const char *File::path() const {
+  return impl ? impl->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+  return impl && impl->dir;
+}
+
+time_t File::getLastWrite() {
+  struct stat st;
+  return impl && stat(hostPath(impl->path).c_str(), &st) == 0 ? st.st_mtime : 0;
+}
+
+File File::openNextFile(const char *mode) {
+  if (!impl || !impl->dir) return File();
+  dirent *e = impl->nextEntry();
+  return e ? SD.open(impl->childPath(e->d_name).c_str(), mode) : File();
+}
+
+String File::getNextFileName() {
+  bool isDir;
+  return getNextFileName(&isDir);
+}
+
+String File::getNextFileName(bool *isDir) {
+  if (!impl || !impl->dir) return String();
+  dirent *e = impl->nextEntry();
+  if (!e) return String();
+  std::string child = impl->childPath(e->d_name);
+  struct stat st;
+  *isDir = stat(hostPath(child).c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+  return String(child);
+}
+
+void File::rewindDirectory() {
+  if (!impl || !impl->dir) return;
+  rewinddir(impl->dir);
+  impl->dirEntries = 0;
+}
+
+File FS::open(const char *path, const char *mode, bool) {
+  if (!sdMounted) return File();
+  std::string p = path[0] == '/' ? path : std::string("/") + path;
+  std::string full = hostPath(p);
+  chargeLookup(p);
+  auto impl = std::make_shared<FileImpl>();
+  impl->path = p;
+  impl->base = baseName(p);
+  struct stat st;
+  bool exists = stat(full.c_str(), &st) == 0;
+  if (exists && S_ISDIR(st.st_mode)) {
+    impl->dir = opendir(full.c_str());
+    return impl->dir ? File(impl) : File();
+  }
+  const char *hostMode = mode[0] == 'w' ? "w+b" : mode[0] == 'a' ? "a+b" : "rb";
+  if (!exists && mode[0] == 'r') return File();
+  if (!exists) chargeSectors(2);
+  impl->fp = fopen(full.c_str(), hostMode);
+  return impl->fp ? File(impl) : File();
+}
+
+bool FS::exists(const char *path) {
+  if (!sdMounted) return false;
+  chargeLookup(path);
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char *path) {
+  if (!sdMounted) return false;
+  chargeLookup(path);
+  if (unlink(hostPath(path).c_str()) != 0) return false;
+  chargeSectors(2);
+  return true;
+}
+
+bool FS::rename(const char *from, const char *to) {
+  if (!sdMounted) return false;
+  chargeLookup(from);
+  chargeLookup(to);
+  if (::rename(hostPath(from).c_str(), hostPath(to).c_str()) != 0) return false;
+  chargeSectors(2);
+  return true;
+}
+
+bool FS::mkdir(const char *path) {
+  if (!sdMounted) return false;
+  chargeLookup(path);
+  if (::mkdir(hostPath(path).c_str(), 0755) != 0) return false;
+  chargeSectors(3);
+  return true;
+}
+
+bool FS::rmdir(const char *path) {
+  if (!sdMounted) return false;
+  chargeLookup(path);
+  if (::rmdir(hostPath(path).c_str()) != 0) return false;
+  chargeSectors(2);
+  return true;
+}
+
+}  // namespace fs
+
+// ============================================================
+// SDFS
+// ============================================================
+bool SDFS::begin(uint8_t, SPIClass &, uint32_t frequency) {
+  sdFrequency = frequency;
+  struct stat st;
+  sdMounted = !host::sdRoot().empty() && stat(host::sdRoot().c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+  if (sdMounted) chargeSectors(4);  // MBR, boot sector, FSInfo, root
+  return sdMounted;
+}
+
+void SDFS::end() {
+  sdMounted = false;
+}
+
+uint64_t SDFS::cardSize() {
+  return sdMounted ? host::sdCardBytes() : 0;
+}
+
+struct Volume {
+  uint32_t sectors, fatSectors, clusters;
+};
+
+// Two FATs of 4 bytes per cluster, then the clusters
+static Volume volume() {
+  Volume v;
+  uint32_t perCluster = SD_CLUSTER / SD_SECTOR;
+  v.sectors = host::sdCardBytes() / SD_SECTOR - SD_PARTITION_LBA;
+  v.fatSectors = ((v.sectors / perCluster + 2) * 4 + SD_SECTOR - 1) / SD_SECTOR;
+  v.clusters = (v.sectors - SD_RESERVED_SECTORS - 2 * v.fatSectors) / perCluster;
+  return v;
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+static void put32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+// The MBR and the partition's boot sector; every other sector reads as zeros
+bool SDFS::readRAW(uint8_t *buffer, uint32_t sector) {
+  if (!sdMounted) return false;
+  chargeSectors(1);
+  memset(buffer, 0, SD_SECTOR);
+  Volume v = volume();
+  if (sector == 0) {
+    buffer[0x1C2] = 0x0C;  // FAT32 LBA
+    put32(buffer + 0x1C6, SD_PARTITION_LBA);
+    put32(buffer + 0x1CA, v.sectors);
+  } else if (sector == SD_PARTITION_LBA) {
+    buffer[0] = 0xEB;
+    buffer[1] = 0x58;
+    buffer[2] = 0x90;
+    put16(buffer + 11, SD_SECTOR);
+    buffer[13] = SD_CLUSTER / SD_SECTOR;
+    put16(buffer + 14, SD_RESERVED_SECTORS);
+    buffer[16] = 2;
+    put32(buffer + 32, v.sectors);
+    put32(buffer + 36, v.fatSectors);
+    memcpy(buffer + 0x52, "FAT32   ", 8);
+  } else {
+    return true;
+  }
+  buffer[510] = 0x55;
+  buffer[511] = 0xAA;
+  return true;
+}
+
+uint64_t SDFS::totalBytes() {
+  return sdMounted ? (uint64_t)volume().clusters * SD_CLUSTER : 0;
+}
+
+static uint64_t clustersUsed(const std::string &full) {
+  uint64_t bytes = 0;
+  DIR *dir = opendir(full.c_str());
+  if (!dir) return 0;
+  for (dirent *e; (e = readdir(dir));) {
+    if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+    std::string child = full + "/" + e->d_name;
+    struct stat st;
+    if (stat(child.c_str(), &st) != 0) continue;
+    bytes += S_ISDIR(st.st_mode) ? SD_CLUSTER + clustersUsed(child) : (st.st_size + SD_CLUSTER - 1) / SD_CLUSTER * SD_CLUSTER;
+  }
+  closedir(dir);
+  return bytes;
+}
+
+// FAT has no running total: the real card scans the whole FAT for this
+uint64_t SDFS::usedBytes() {
+  if (!sdMounted) return 0;
+  chargeSectors((uint32_t)(host::sdCardBytes() / SD_CLUSTER * 4 / SD_SECTOR));
+  return clustersUsed(host::sdRoot());
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+// ============================================================
+// FS stand-in, backed by a host directory
+// ============================================================
+// File is a shared handle like the ESP32 core's: copies refer to the same
+// open file, and it closes when the last copy goes. Card traffic is
+// charged to host::bus.sd as FatFs would generate it: whole 512-byte
+// sectors, with one sector buffered per open file.
+#include <memory>
+#include "./Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+  SeekSet = 0,
+  SeekCur = 1,
+  SeekEnd = 2
+};
+
+struct FileImpl;
+
+class File : public Stream {
+  std::shared_ptr<FileImpl> impl;
+
+public:
+  File() {}
+  explicit File(std::shared_ptr<FileImpl> p)
+    : impl(std::move(p)) {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buf, size_t n) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t read(uint8_t *buf, size_t n);
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void flush();
+  void close();
+  operator bool() const;
+
+  const char *name() const;
+  const char *path() const;
+  bool isDirectory() const;
+  time_t getLastWrite();
+  File openNextFile(const char *mode = FILE_READ);
+  String getNextFileName();
+  String getNextFileName(bool *isDir);
+  void rewindDirectory();
+};
+
+class FS {
+public:
+  File open(const char *path, const char *mode = FILE_READ, bool create = false);
+  File open(const String &path, const char *mode = FILE_READ, bool create = false) {
+    return open(path.c_str(), mode, create);
+  }
+  bool exists(const char *path);
+  bool exists(const String &path) {
+    return exists(path.c_str());
+  }
+  bool remove(const char *path);
+  bool remove(const String &path) {
+    return remove(path.c_str());
+  }
+  bool rename(const char *from, const char *to);
+  bool rename(const String &from, const String &to) {
+    return rename(from.c_str(), to.c_str());
+  }
+  bool mkdir(const char *path);
+  bool mkdir(const String &path) {
+    return mkdir(path.c_str());
+  }
+  bool rmdir(const char *path);
+  bool rmdir(const String &path) {
+    return rmdir(path.c_str());
+  }
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekSet;
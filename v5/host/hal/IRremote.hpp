@@ -0,0 +1,104 @@
+#pragma once
+
+// ============================================================
+// IRremote stand-in
+// ============================================================
+// IrSender records what it would have sent (host::sentIr). IrReceiver
+// decodes the rawbuf the sketch loads into it; only NEC is recognised,
+// which is enough to tell a decoded capture from a raw one.
+#include "./Arduino.h"
+
+#define MICROS_PER_TICK 50
+#ifndef RAW_BUFFER_LENGTH
+#define RAW_BUFFER_LENGTH 200
+#endif
+#define IR_REC_STATE_IDLE 0
+#define IR_REC_STATE_MARK 1
+#define IR_REC_STATE_SPACE 2
+#define IR_REC_STATE_STOP 3
+
+enum decode_type_t {
+  UNKNOWN = 0,
+  PULSE_WIDTH,
+  PULSE_DISTANCE,
+  APPLE,
+  DENON,
+  JVC,
+  LG,
+  LG2,
+  NEC,
+  NEC2,
+  ONKYO,
+  PANASONIC,
+  KASEIKYO,
+  KASEIKYO_DENON,
+  KASEIKYO_SHARP,
+  KASEIKYO_JVC,
+  KASEIKYO_MITSUBISHI,
+  RC5,
+  RC6,
+  SAMSUNG,
+  SAMSUNG48,
+  SAMSUNG_LG,
+  SHARP,
+  SONY,
+  BANG_OLUFSEN,
+  BOSEWAVE,
+  LEGO_PF,
+  MAGIQUEST,
+  WHYNTER,
+  FAST
+};
+
+struct IRData {
+  decode_type_t protocol;
+  uint16_t address;
+  uint16_t command;
+  uint16_t extra;
+  uint16_t numberOfBits;
+  uint8_t flags;
+  uint32_t decodedRawData;
+  uint16_t rawlen;
+};
+
+struct irparams_struct {
+  volatile uint8_t StateForISR;
+  uint_fast8_t IRReceivePin;
+  volatile uint_fast16_t TickCounterForISR;
+  bool OverflowFlag;
+  uint_fast16_t rawlen;
+  uint16_t rawbuf[RAW_BUFFER_LENGTH];
+};
+
+class IRrecv {
+public:
+  IRData decodedIRData = {};
+  irparams_struct irparams = {};
+
+  void begin(uint_fast8_t, bool = false) {}
+  void start() {}
+  void stop() {}
+  void resume() {
+    irparams.StateForISR = IR_REC_STATE_IDLE;
+  }
+  bool decode();
+};
+
+class IRsend {
+  uint32_t carrierHz = 38000;
+  std::vector<uint16_t> pending;
+
+public:
+  void begin(uint_fast8_t) {}
+  void enableIROut(uint_fast8_t kHz) {
+    carrierHz = kHz * 1000;
+  }
+  void mark(unsigned us);
+  void space(unsigned us);
+  void sendRaw(const uint16_t *durations, uint_fast16_t count, uint_fast8_t kHz);
+};
+
+extern IRrecv IrReceiver;
+extern IRsend IrSender;
+
+const char *getProtocolString(decode_type_t protocol);
@@ -0,0 +1,547 @@
+#include "./LovyanGFX.hpp"
+
+// ============================================================
+// Font: classic 5x7 GLCD glyphs for 0x20..0x7E, one byte per
+// column, bit 0 at the top; each cell is 6x8 with the spacing
+// ============================================================
+static const uint8_t GLCD_FONT[95][5] = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 },
+  { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },
+  { 0x36, 0x49, 0x56, 0x20, 0x50 }, { 0x00, 0x08, 0x07, 0x03, 0x00 }, { 0x00, 0x1C, 0x22, 0x41, 0x00 },
+  { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x2A, 0x1C, 0x7F, 0x1C, 0x2A }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+  { 0x00, 0x80, 0x70, 0x30, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x00, 0x60, 0x60, 0x00 },
+  { 0x20, 0x10, 0x08, 0x04, 0x02 }, { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 },
+  { 0x72, 0x49, 0x49, 0x49, 0x46 }, { 0x21, 0x41, 0x49, 0x4D, 0x33 }, { 0x18, 0x14, 0x12, 0x7F, 0x10 },
+  { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x31 }, { 0x41, 0x21, 0x11, 0x09, 0x07 },
+  { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x46, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x00, 0x14, 0x00, 0x00 },
+  { 0x00, 0x40, 0x34, 0x00, 0x00 }, { 0x00, 0x08, 0x14, 0x22, 0x41 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },
+  { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x59, 0x09, 0x06 }, { 0x3E, 0x41, 0x5D, 0x59, 0x4E },
+  { 0x7C, 0x12, 0x11, 0x12, 0x7C }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+  { 0x7F, 0x41, 0x41, 0x41, 0x3E }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 },
+  { 0x3E, 0x41, 0x41, 0x51, 0x73 }, { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 },
+  { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 }, { 0x7F, 0x40, 0x40, 0x40, 0x40 },
+  { 0x7F, 0x02, 0x1C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+  { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 },
+  { 0x26, 0x49, 0x49, 0x49, 0x32 }, { 0x03, 0x01, 0x7F, 0x01, 0x03 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F },
+  { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F }, { 0x63, 0x14, 0x08, 0x14, 0x63 },
+  { 0x03, 0x04, 0x78, 0x04, 0x03 }, { 0x61, 0x59, 0x49, 0x4D, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x41 },
+  { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x41, 0x7F }, { 0x04, 0x02, 0x01, 0x02, 0x04 },
+  { 0x40, 0x40, 0x40, 0x40, 0x40 }, { 0x00, 0x03, 0x07, 0x08, 0x00 }, { 0x20, 0x54, 0x54, 0x78, 0x40 },
+  { 0x7F, 0x28, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x28 }, { 0x38, 0x44, 0x44, 0x28, 0x7F },
+  { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x00, 0x08, 0x7E, 0x09, 0x02 }, { 0x18, 0xA4, 0xA4, 0x9C, 0x78 },
+  { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x40, 0x3D, 0x00 },
+  { 0x7F, 0x10, 0x28, 0x44, 0x00 }, { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x78, 0x04, 0x78 },
+  { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, { 0xFC, 0x18, 0x24, 0x24, 0x18 },
+  { 0x18, 0x24, 0x24, 0x18, 0xFC }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x24 },
+  { 0x04, 0x04, 0x3F, 0x44, 0x24 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C },
+  { 0x3C, 0x40, 0x30, 0x40, 0x3C }, { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x4C, 0x90, 0x90, 0x90, 0x7C },
+  { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, { 0x00, 0x00, 0x77, 0x00, 0x00 },
+  { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x02, 0x01, 0x02, 0x04, 0x02 }
+};
+
+// Undrawable (non-ASCII) bytes show as a hollow box
+static const uint8_t GLCD_MISSING[5] = { 0x7F, 0x41, 0x41, 0x41, 0x7F };
+
+namespace lgfx {
+
+// ------------------------------------------------------------
+// Raster core
+// ------------------------------------------------------------
+void LGFXBase::resize(int32_t nw, int32_t nh) {
+  w = nw;
+  h = nh;
+  pixels.assign((size_t)w * h, TFT_BLACK);
+  clearClipRect();
+}
+
+void LGFXBase::span(int32_t x0, int32_t x1, int32_t y, uint16_t color) {
+  if (y < std::max(0, clipY0) || y >= std::min(h, clipY1)) return;
+  x0 = std::max({ x0, 0, clipX0 });
+  x1 = std::min({ x1, w - 1, clipX1 - 1 });
+  for (int32_t x = x0; x <= x1; x++) pixels[(size_t)y * w + x] = color;
+}
+
+void LGFXBase::plot(int32_t x, int32_t y, uint16_t color) {
+  span(x, x, y, color);
+}
+
+void LGFXBase::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  plot(x, y, color);
+  transfer(1);
+}
+
+void LGFXBase::drawFastHLine(int32_t x, int32_t y, int32_t len, uint32_t color) {
+  fillRect(x, y, len, 1, color);
+}
+
+void LGFXBase::drawFastVLine(int32_t x, int32_t y, int32_t len, uint32_t color) {
+  fillRect(x, y, 1, len, color);
+}
+
+void LGFXBase::fillRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color) {
+  if (rw < 0) x += rw + 1, rw = -rw;
+  if (rh < 0) y += rh + 1, rh = -rh;
+  if (rw == 0 || rh == 0) return;
+  for (int32_t row = y; row < y + rh; row++) span(x, x + rw - 1, row, color);
+  int32_t cw = std::min(x + rw, w) - std::max(x, 0), ch = std::min(y + rh, h) - std::max(y, 0);
+  if (cw > 0 && ch > 0) transfer(cw * ch);
+}
+
+void LGFXBase::drawRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color) {
+  drawFastHLine(x, y, rw, color);
+  drawFastHLine(x, y + rh - 1, rw, color);
+  drawFastVLine(x, y + 1, rh - 2, color);
+  drawFastVLine(x + rw - 1, y + 1, rh - 2, color);
+}
+
+// Corners are quarter circles of radius r, drawn as spans
+void LGFXBase::fillRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color) {
+  r = std::min({ r, rw / 2, rh / 2 });
+  for (int32_t row = 0; row < rh; row++) {
+    int32_t inset = 0;
+    int32_t dy = row < r ? r - row : (row >= rh - r ? row - (rh - r - 1) : 0);
+    if (dy) inset = r - (int32_t)std::floor(std::sqrt((double)r * r - (double)dy * dy) + 0.5);
+    span(x + inset, x + rw - 1 - inset, y + row, color);
+  }
+  transfer(rw * rh);
+}
+
+void LGFXBase::drawRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color) {
+  r = std::min({ r, rw / 2, rh / 2 });
+  drawFastHLine(x + r, y, rw - 2 * r, color);
+  drawFastHLine(x + r, y + rh - 1, rw - 2 * r, color);
+  drawFastVLine(x, y + r, rh - 2 * r, color);
+  drawFastVLine(x + rw - 1, y + r, rh - 2 * r, color);
+  int32_t f = 1 - r, ddx = 1, ddy = -2 * r, px = 0, py = r;
+  while (px < py) {
+    if (f >= 0) {
+      py--;
+      ddy += 2;
+      f += ddy;
+    }
+    px++;
+    ddx += 2;
+    f += ddx;
+    plot(x + r - px, y + r - py, color), plot(x + r - py, y + r - px, color);
+    plot(x + rw - 1 - r + px, y + r - py, color), plot(x + rw - 1 - r + py, y + r - px, color);
+    plot(x + r - px, y + rh - 1 - r + py, color), plot(x + r - py, y + rh - 1 - r + px, color);
+    plot(x + rw - 1 - r + px, y + rh - 1 - r + py, color), plot(x + rw - 1 - r + py, y + rh - 1 - r + px, color);
+    transfer(8);
+  }
+}
+
+void LGFXBase::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) {
+  int32_t dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int32_t dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int32_t err = dx + dy, n = 0;
+  for (;; n++) {
+    plot(x0, y0, color);
+    if (x0 == x1 && y0 == y1) break;
+    int32_t e2 = 2 * err;
+    if (e2 >= dy) err += dy, x0 += sx;
+    if (e2 <= dx) err += dx, y0 += sy;
+  }
+  transfer(n + 1);
+}
+
+void LGFXBase::drawCircle(int32_t cx, int32_t cy, int32_t r, uint32_t color) {
+  int32_t x = r, y = 0, err = 1 - r;
+  while (x >= y) {
+    const int32_t pts[8][2] = { { x, y }, { y, x }, { -y, x }, { -x, y }, { -x, -y }, { -y, -x }, { y, -x }, { x, -y } };
+    for (auto &p : pts) plot(cx + p[0], cy + p[1], color);
+    transfer(8);
+    y++;
+    if (err < 0) {
+      err += 2 * y + 1;
+    } else {
+      x--;
+      err += 2 * (y - x) + 1;
+    }
+  }
+}
+
+void LGFXBase::fillCircle(int32_t cx, int32_t cy, int32_t r, uint32_t color) {
+  for (int32_t dy = -r; dy <= r; dy++) {
+    int32_t dx = (int32_t)std::floor(std::sqrt((double)r * r - (double)dy * dy) + 0.5);
+    span(cx - dx, cx + dx, cy + dy, color);
+    transfer(2 * dx + 1);
+  }
+}
+
+void LGFXBase::drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+  drawLine(x0, y0, x1, y1, color);
+  drawLine(x1, y1, x2, y2, color);
+  drawLine(x2, y2, x0, y0, color);
+}
+
+void LGFXBase::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+  if (y0 > y1) std::swap(y0, y1), std::swap(x0, x1);
+  if (y1 > y2) std::swap(y1, y2), std::swap(x1, x2);
+  if (y0 > y1) std::swap(y0, y1), std::swap(x0, x1);
+  for (int32_t y = y0; y <= y2; y++) {
+    auto edge = [y](int32_t ax, int32_t ay, int32_t bx, int32_t by) {
+      return by == ay ? ax : ax + (bx - ax) * (y - ay) / (by - ay);
+    };
+    int32_t a = edge(x0, y0, x2, y2);
+    int32_t b = y < y1 ? edge(x0, y0, x1, y1) : edge(x1, y1, x2, y2);
+    if (a > b) std::swap(a, b);
+    span(a, b, y, color);
+    transfer(b - a + 1);
+  }
+}
+
+uint32_t LGFXBase::blit(int32_t x, int32_t y, int32_t iw, int32_t ih, const uint16_t *data) {
+  uint32_t written = 0;
+  for (int32_t row = 0; row < ih; row++) {
+    int32_t py = y + row;
+    if (py < std::max(0, clipY0) || py >= std::min(h, clipY1)) continue;
+    for (int32_t col = 0; col < iw; col++) {
+      int32_t px = x + col;
+      if (px >= std::max(0, clipX0) && px < std::min(w, clipX1)) {
+        pixels[(size_t)py * w + px] = data[(size_t)row * iw + col];
+        written++;
+      }
+    }
+  }
+  return written;
+}
+
+void LGFXBase::pushImage(int32_t x, int32_t y, int32_t iw, int32_t ih, const uint16_t *data) {
+  // The panel driver only sends the clipped part's window
+  transfer(blit(x, y, iw, ih, data), true);
+}
+
+uint16_t LGFXBase::readPixel(int32_t x, int32_t y) const {
+  return x >= 0 && y >= 0 && x < w && y < h ? pixels[(size_t)y * w + x] : 0;
+}
+
+void LGFXBase::setClipRect(int32_t x, int32_t y, int32_t cw, int32_t ch) {
+  clipX0 = x;
+  clipY0 = y;
+  clipX1 = x + cw;
+  clipY1 = y + ch;
+}
+
+void LGFXBase::clearClipRect() {
+  clipX0 = clipY0 = 0;
+  clipX1 = clipY1 = INT32_MAX;
+}
+
+// ------------------------------------------------------------
+// Text
+// ------------------------------------------------------------
+int32_t LGFXBase::textWidth(const char *str) const {
+  return (int32_t)strlen(str) * 6 * textSize;
+}
+
+// Transparent text goes out a pixel block at a time, as LovyanGFX does;
+// with a background set, each glyph cell is one transfer
+void LGFXBase::drawGlyph(int32_t x, int32_t y, uint8_t c) {
+  const uint8_t *glyph = c >= 0x20 && c < 0x7F ? GLCD_FONT[c - 0x20] : GLCD_MISSING;
+  int32_t blocks = 0;
+  for (int col = 0; col < 6; col++) {
+    uint8_t bits = col < 5 ? glyph[col] : 0;
+    for (int row = 0; row < 8; row++) {
+      bool on = bits & (1 << row);
+      if (!on && !textBgOn) continue;
+      for (int dy = 0; dy < textSize; dy++)
+        span(x + col * textSize, x + col * textSize + textSize - 1, y + row * textSize + dy, on ? textFg : textBg);
+      blocks++;
+    }
+  }
+  if (textBgOn) transfer(48 * textSize * textSize);
+  else
+    for (int32_t i = 0; i < blocks; i++) transfer(textSize * textSize);
+}
+
+size_t LGFXBase::write(uint8_t c) {
+  if (c == '\r') return 1;
+  if (c == '\n') {
+    cursorX = 0;
+    cursorY += 8 * textSize;
+    return 1;
+  }
+  if ((c & 0xC0) == 0x80) return 1;  // UTF-8 continuation: one box per code point
+  if (textWrap && cursorX + 6 * textSize > w) {
+    cursorX = 0;
+    cursorY += 8 * textSize;
+  }
+  drawGlyph(cursorX, cursorY, c);
+  cursorX += 6 * textSize;
+  return 1;
+}
+
+int32_t LGFXBase::drawString(const char *str, int32_t x, int32_t y) {
+  int32_t tw = textWidth(str), th = fontHeight();
+  if (textDatum & 1) x -= tw / 2;
+  if (textDatum & 2) x -= tw;
+  if (textDatum & 4) y -= th / 2;
+  if (textDatum & 8) y -= th;
+  int32_t savedX = cursorX, savedY = cursorY;
+  bool wrap = textWrap;
+  cursorX = x;
+  cursorY = y;
+  textWrap = false;
+  print(str);
+  textWrap = wrap;
+  cursorX = savedX;
+  cursorY = savedY;
+  return tw;
+}
+
+// ------------------------------------------------------------
+// Bus
+// ------------------------------------------------------------
+void Bus_SPI::charge(uint64_t bytes) {
+  if (inTransaction) pending += bytes;
+  else host::chargeBus(host::bus.display, bytes, cfg.freq_write);
+}
+
+void Bus_SPI::beginTransaction() {
+  inTransaction = true;
+  pending = 0;
+}
+
+void Bus_SPI::endTransaction() {
+  inTransaction = false;
+  if (pending) host::chargeBus(host::bus.display, pending, cfg.freq_write);
+  pending = 0;
+}
+
+void Bus_SPI::writeCommand(uint32_t, uint_fast8_t bit_length) {
+  charge(bit_length / 8);
+}
+
+void Bus_SPI::writeData(uint32_t, uint_fast8_t bit_length) {
+  charge(bit_length / 8);
+}
+
+void Bus_SPI::writeDataRepeat(uint32_t, uint_fast8_t bit_length, uint32_t count) {
+  charge((uint64_t)bit_length / 8 * count);
+}
+
+void Bus_SPI::writePixels(pixelcopy_t *param, uint32_t length) {
+  charge((uint64_t)param->dst_bits / 8 * length);
+}
+
+void Bus_SPI::writeBytes(const uint8_t *, uint32_t length, bool, bool) {
+  charge(length);
+}
+
+// ------------------------------------------------------------
+// Device
+// ------------------------------------------------------------
+static LGFX_Device *screen = nullptr;
+
+bool LGFX_Device::init() {
+  if (!panel) return false;
+  resize(panel->config().panel_width, panel->config().panel_height);
+  screen = this;
+  return true;
+}
+
+void LGFX_Device::setRotation(uint8_t r) {
+  rotation = r & 3;
+  if (!panel) return;
+  int32_t pw = panel->config().panel_width, ph = panel->config().panel_height;
+  if (rotation & 1) std::swap(pw, ph);
+  if (pw != w || ph != h) resize(pw, ph);
+}
+
+void LGFX_Device::startWrite() {
+  Bus_SPI *bus = panel ? panel->getBus() : nullptr;
+  if (bus && writeDepth++ == 0) bus->beginTransaction();
+}
+
+void LGFX_Device::endWrite() {
+  Bus_SPI *bus = panel ? panel->getBus() : nullptr;
+  if (bus && writeDepth && --writeDepth == 0) bus->endTransaction();
+}
+
+constexpr uint8_t ILI9341_CASET = 0x2A, ILI9341_PASET = 0x2B, ILI9341_RAMWR = 0x2C;
+
+// Column and page address set (1 + 4 bytes each), memory write, pixels
+void LGFX_Device::transfer(uint32_t pixelCount, bool image) {
+  Bus_SPI *bus = panel ? panel->getBus() : nullptr;
+  if (!bus) return;
+  startWrite();
+  bus->writeCommand(ILI9341_CASET, 8);
+  bus->writeData(0, 32);
+  bus->writeCommand(ILI9341_PASET, 8);
+  bus->writeData(0, 32);
+  bus->writeCommand(ILI9341_RAMWR, 8);
+  if (image) {
+    pixelcopy_t copy;
+    bus->writePixels(&copy, pixelCount);
+  } else {
+    bus->writeDataRepeat(0, 16, pixelCount);
+  }
+  endWrite();
+}
+
+// One XPT2046 poll: pressure plus averaged X and Y conversions, 3 bytes each
+constexpr uint32_t XPT2046_POLL_BYTES = 3 * 8;
+
+// The panel reads like the board's: raw X 3850 at the left edge and 240
+// at the right, raw Y 250 at the top and 3750 at the bottom, and a
+// firm press at pressure 1500
+constexpr int32_t PANEL_RAW_LEFT = 3850, PANEL_RAW_RIGHT = 240;
+constexpr int32_t PANEL_RAW_TOP = 250, PANEL_RAW_BOTTOM = 3750;
+constexpr uint16_t PANEL_PRESS_Z = 1500;
+
+// As in LovyanGFX, the raw reading mapped through the touch config
+bool LGFX_Device::getTouch(int32_t *x, int32_t *y) {
+  touch_point_t tp;
+  if (!getTouchRaw(&tp, 1)) return false;
+  const Touch_XPT2046::config_t &c = panel->getTouch()->config();
+  int32_t spanX = (int32_t)c.x_max - c.x_min, spanY = (int32_t)c.y_max - c.y_min;
+  if (!spanX || !spanY) return false;
+  if (x) *x = (tp.x - c.x_min) * (w - 1) / spanX;
+  if (y) *y = (tp.y - c.y_min) * (h - 1) / spanY;
+  return true;
+}
+
+bool LGFX_Device::getTouch(uint16_t *x, uint16_t *y) {
+  int32_t tx, ty;
+  if (!getTouch(&tx, &ty)) return false;
+  if (x) *x = tx;
+  if (y) *y = ty;
+  return true;
+}
+
+// Replayed readings come back as they were; a screen press is mapped
+// back through the panel above
+uint_fast8_t LGFX_Device::getTouchRaw(touch_point_t *tp, uint_fast8_t count) {
+  if (!count || !panel || !panel->getTouch()) return 0;
+  host::chargeBus(host::bus.touch, XPT2046_POLL_BYTES, panel->getTouch()->config().freq);
+  int x, y, z;
+  if (host::touchRawState(x, y, z)) {
+    if (z <= 0) return 0;
+  } else if (host::touchState(x, y)) {
+    x = PANEL_RAW_LEFT + (PANEL_RAW_RIGHT - PANEL_RAW_LEFT) * x / std::max<int32_t>(1, w - 1);
+    y = PANEL_RAW_TOP + (PANEL_RAW_BOTTOM - PANEL_RAW_TOP) * y / std::max<int32_t>(1, h - 1);
+    z = PANEL_PRESS_Z;
+  } else {
+    return 0;
+  }
+  tp->x = x;
+  tp->y = y;
+  tp->size = z;
+  tp->id = 0;
+  return 1;
+}
+
+}  // namespace lgfx
+
+// ============================================================
+// Sprites
+// ============================================================
+void *LGFX_Sprite::createSprite(int32_t sw, int32_t sh) {
+  deleteSprite();
+  if (sw <= 0 || sh <= 0 || !host::heapTake((uint32_t)sw * sh * 2)) return nullptr;
+  resize(sw, sh);
+  return pixels.data();
+}
+
+void LGFX_Sprite::deleteSprite() {
+  host::heapGive((uint32_t)w * h * 2);
+  pixels.clear();
+  pixels.shrink_to_fit();
+  w = h = 0;
+}
+
+void LGFX_Sprite::pushSprite(int32_t x, int32_t y) {
+  if (parent) pushSprite(parent, x, y);
+}
+
+void LGFX_Sprite::pushSprite(lgfx::LGFXBase *dst, int32_t x, int32_t y) {
+  if (!pixels.empty()) dst->pushImage(x, y, w, h, pixels.data());
+}
+
+void LGFX_Sprite::scroll(int32_t dx, int32_t dy) {
+  std::vector<uint16_t> moved(pixels.size(), TFT_BLACK);
+  for (int32_t y = 0; y < h; y++)
+    for (int32_t x = 0; x < w; x++) {
+      int32_t sx = x - dx, sy = y - dy;
+      if (sx >= 0 && sy >= 0 && sx < w && sy < h) moved[(size_t)y * w + x] = pixels[(size_t)sy * w + sx];
+    }
+  pixels.swap(moved);
+}
+
+// ============================================================
+// PNG snapshot: 8-bit RGB, zlib stored blocks (no compression)
+// ============================================================
+static uint32_t pngCrc(const uint8_t *data, size_t n, uint32_t crc = 0xFFFFFFFF) {
+  for (size_t i = 0; i < n; i++) {
+    crc ^= data[i];
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return crc;
+}
+
+static void putBe32(std::vector<uint8_t> &out, uint32_t v) {
+  for (int s = 24; s >= 0; s -= 8) out.push_back(v >> s);
+}
+
+static void pngChunk(FILE *f, const char *type, const std::vector<uint8_t> &data) {
+  std::vector<uint8_t> chunk;
+  putBe32(chunk, data.size());
+  chunk.insert(chunk.end(), type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+  putBe32(chunk, pngCrc(chunk.data() + 4, chunk.size() - 4) ^ 0xFFFFFFFF);
+  fwrite(chunk.data(), 1, chunk.size(), f);
+}
+
+namespace host {
+
+const uint16_t *screenPixels(int &width, int &height) {
+  if (!lgfx::screen) return nullptr;
+  width = lgfx::screen->width();
+  height = lgfx::screen->height();
+  static std::vector<uint16_t> copy;
+  copy.resize((size_t)width * height);
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++) copy[(size_t)y * width + x] = lgfx::screen->readPixel(x, y);
+  return copy.data();
+}
+
+bool saveScreenPng(const char *path) {
+  int width, height;
+  const uint16_t *px = screenPixels(width, height);
+  if (!px) return false;
+  std::vector<uint8_t> raw;
+  for (int y = 0; y < height; y++) {
+    raw.push_back(0);  // filter: none
+    for (int x = 0; x < width; x++) {
+      uint16_t c = px[(size_t)y * width + x];
+      raw.push_back(((c >> 11) & 0x1F) * 255 / 31);
+      raw.push_back(((c >> 5) & 0x3F) * 255 / 63);
+      raw.push_back((c & 0x1F) * 255 / 31);
+    }
+  }
+  std::vector<uint8_t> z = { 0x78, 0x01 };
+  for (size_t at = 0; at < raw.size(); at += 65535) {
+    uint16_t n = (uint16_t)std::min<size_t>(65535, raw.size() - at);
+    z.push_back(at + n == raw.size());
+    z.push_back(n & 0xFF), z.push_back(n >> 8), z.push_back(~n & 0xFF), z.push_back((uint16_t)~n >> 8);
+    z.insert(z.end(), raw.begin() + at, raw.begin() + at + n);
+  }
+  uint32_t a = 1, b = 0;
+  for (uint8_t v : raw) a = (a + v) % 65521, b = (b + a) % 65521;
+  putBe32(z, b << 16 | a);
+
+  FILE *f = fopen(path, "wb");
+  if (!f) return false;
+  static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  fwrite(signature, 1, 8, f);
+  std::vector<uint8_t> ihdr;
+  putBe32(ihdr, width);
+  putBe32(ihdr, height);
+  ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 });  // 8-bit RGB
+  pngChunk(f, "IHDR", ihdr);
+  pngChunk(f, "IDAT", z);
+  pngChunk(f, "IEND", {});
+  return fclose(f) == 0;
+}
+
+}  // namespace host
@@ -0,0 +1,306 @@
+#pragma once
+
+// ============================================================
+// LovyanGFX stand-in: RGB565 framebuffers
+// ============================================================
+// LGFX_Device draws into a panel-sized framebuffer and charges each
+// primitive to its Bus_SPI as the ILI9341 would receive it: an address
+// window, then two bytes per pixel. Sprites draw in RAM and pay
+// only when pushed. Text uses the 6x8 GLCD font LovyanGFX starts with.
+#include <vector>
+#include "./Arduino.h"
+
+#define TFT_BLACK 0x0000
+#define TFT_NAVY 0x000F
+#define TFT_DARKGREEN 0x03E0
+#define TFT_MAROON 0x7800
+#define TFT_DARKGREY 0x7BEF
+#define TFT_BLUE 0x001F
+#define TFT_GREEN 0x07E0
+#define TFT_CYAN 0x07FF
+#define TFT_RED 0xF800
+#define TFT_MAGENTA 0xF81F
+#define TFT_YELLOW 0xFFE0
+#define TFT_WHITE 0xFFFF
+#define TFT_ORANGE 0xFDA0
+#define SPI2_HOST 1
+
+namespace lgfx {
+
+enum textdatum_t : uint8_t {
+  top_left = 0,
+  top_center = 1,
+  top_right = 2,
+  middle_left = 4,
+  middle_center = 5,
+  middle_right = 6,
+  bottom_left = 8,
+  bottom_center = 9,
+  bottom_right = 10
+};
+
+struct touch_point_t {
+  int16_t x, y;
+  uint16_t size, id;
+};
+
+struct pixelcopy_t {
+  uint8_t src_bits = 16, dst_bits = 16;
+};
+
+// What the panel driver sends goes through these virtuals, as in
+// LovyanGFX, so a subclass can watch the traffic. Bytes are charged to
+// host::bus.display once per transaction at freq_write.
+class Bus_SPI {
+public:
+  virtual ~Bus_SPI() = default;
+  virtual void beginTransaction();
+  virtual void endTransaction();
+  virtual void writeCommand(uint32_t data, uint_fast8_t bit_length);
+  virtual void writeData(uint32_t data, uint_fast8_t bit_length);
+  virtual void writeDataRepeat(uint32_t data, uint_fast8_t bit_length, uint32_t count);
+  virtual void writePixels(pixelcopy_t *param, uint32_t length);
+  virtual void writeBytes(const uint8_t *data, uint32_t length, bool dc, bool use_dma);
+
+  struct config_t {
+    int spi_host = SPI2_HOST;
+    uint8_t spi_mode = 0;
+    uint32_t freq_write = 16000000;
+    uint32_t freq_read = 8000000;
+    int16_t pin_sclk = -1, pin_mosi = -1, pin_miso = -1, pin_dc = -1;
+    bool spi_3wire = false, use_lock = true;
+    int dma_channel = 0;
+  };
+  const config_t &config() const {
+    return cfg;
+  }
+  void config(const config_t &c) {
+    cfg = c;
+  }
+
+private:
+  config_t cfg;
+  uint64_t pending = 0;
+  bool inTransaction = false;
+  void charge(uint64_t bytes);
+};
+
+class Touch_XPT2046 {
+public:
+  struct config_t {
+    uint16_t x_min = 0, x_max = 4095, y_min = 0, y_max = 4095;
+    int16_t pin_sclk = -1, pin_mosi = -1, pin_miso = -1, pin_cs = -1, pin_int = -1;
+    bool bus_shared = true;
+    int spi_host = SPI2_HOST;
+    uint32_t freq = 1000000;
+    uint8_t offset_rotation = 0;
+  };
+  const config_t &config() const {
+    return cfg;
+  }
+  void config(const config_t &c) {
+    cfg = c;
+  }
+
+private:
+  config_t cfg;
+};
+
+class Panel_ILI9341 {
+public:
+  struct config_t {
+    int16_t pin_cs = -1, pin_rst = -1, pin_busy = -1;
+    uint16_t memory_width = 240, memory_height = 320;
+    uint16_t panel_width = 240, panel_height = 320;
+    int16_t offset_x = 0, offset_y = 0;
+    uint8_t offset_rotation = 0;
+    bool readable = true, invert = false, rgb_order = false, dlen_16bit = false, bus_shared = true;
+  };
+  const config_t &config() const {
+    return cfg;
+  }
+  void config(const config_t &c) {
+    cfg = c;
+  }
+  void setBus(Bus_SPI *b) {
+    bus = b;
+  }
+  void setTouch(Touch_XPT2046 *t) {
+    touch = t;
+  }
+  Bus_SPI *getBus() const {
+    return bus;
+  }
+  Touch_XPT2046 *getTouch() const {
+    return touch;
+  }
+
+private:
+  config_t cfg;
+  Bus_SPI *bus = nullptr;
+  Touch_XPT2046 *touch = nullptr;
+};
+
+class LGFXBase : public Print {
+public:
+  LGFXBase() {}
+  LGFXBase(const LGFXBase &) = delete;
+  LGFXBase &operator=(const LGFXBase &) = delete;
+
+  int32_t width() const {
+    return w;
+  }
+  int32_t height() const {
+    return h;
+  }
+
+  void startWrite() {}
+  void endWrite() {}
+
+  void drawPixel(int32_t x, int32_t y, uint32_t color);
+  void drawFastHLine(int32_t x, int32_t y, int32_t len, uint32_t color);
+  void drawFastVLine(int32_t x, int32_t y, int32_t len, uint32_t color);
+  void fillRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color);
+  void drawRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color);
+  void fillRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color);
+  void drawRoundRect(int32_t x, int32_t y, int32_t rw, int32_t rh, int32_t r, uint32_t color);
+  void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color);
+  void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+  void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+  void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+  void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+  void fillScreen(uint32_t color) {
+    fillRect(0, 0, w, h, color);
+  }
+  void clear(uint32_t color = 0) {
+    fillScreen(color);
+  }
+  void pushImage(int32_t x, int32_t y, int32_t iw, int32_t ih, const uint16_t *data);
+  uint16_t readPixel(int32_t x, int32_t y) const;
+
+  void setClipRect(int32_t x, int32_t y, int32_t cw, int32_t ch);
+  void clearClipRect();
+
+  void setCursor(int32_t x, int32_t y) {
+    cursorX = x;
+    cursorY = y;
+  }
+  int32_t getCursorX() const {
+    return cursorX;
+  }
+  int32_t getCursorY() const {
+    return cursorY;
+  }
+  void setTextSize(float size) {
+    textSize = size < 1 ? 1 : (int)size;
+  }
+  void setTextColor(uint32_t fg) {
+    textFg = fg;
+    textBgOn = false;
+  }
+  void setTextColor(uint32_t fg, uint32_t bg) {
+    textFg = fg;
+    textBg = bg;
+    textBgOn = true;
+  }
+  void setTextDatum(uint8_t datum) {
+    textDatum = datum;
+  }
+  void setTextWrap(bool wrapX, bool = false) {
+    textWrap = wrapX;
+  }
+  int32_t textWidth(const char *str) const;
+  int32_t textWidth(const String &str) const {
+    return textWidth(str.c_str());
+  }
+  int32_t fontHeight() const {
+    return 8 * textSize;
+  }
+  int32_t drawString(const char *str, int32_t x, int32_t y);
+  int32_t drawString(const String &str, int32_t x, int32_t y) {
+    return drawString(str.c_str(), x, y);
+  }
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  static uint16_t color565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+  }
+
+protected:
+  std::vector<uint16_t> pixels;
+  int32_t w = 0, h = 0;
+
+  // A primitive touched this many pixels as one transfer; images go out
+  // as pixel data, everything else as one repeated color
+  virtual void transfer(uint32_t, bool = false) {}
+  void resize(int32_t nw, int32_t nh);
+  // Pixels written, which is only the part inside the clip rect
+  uint32_t blit(int32_t x, int32_t y, int32_t iw, int32_t ih, const uint16_t *data);
+
+private:
+  int32_t clipX0 = 0, clipY0 = 0, clipX1 = INT32_MAX, clipY1 = INT32_MAX;
+  int32_t cursorX = 0, cursorY = 0;
+  int textSize = 1;
+  uint32_t textFg = TFT_WHITE, textBg = TFT_BLACK;
+  bool textBgOn = false, textWrap = true;
+  uint8_t textDatum = top_left;
+
+  void span(int32_t x0, int32_t x1, int32_t y, uint16_t color);  // no bus charge
+  void plot(int32_t x, int32_t y, uint16_t color);
+  void drawGlyph(int32_t x, int32_t y, uint8_t c);
+};
+
+class LGFX_Device : public LGFXBase {
+public:
+  void setPanel(Panel_ILI9341 *p) {
+    panel = p;
+  }
+  bool init();
+  // Nested calls share one bus transaction, as on the device
+  void startWrite();
+  void endWrite();
+  bool begin() {
+    return init();
+  }
+  void setRotation(uint8_t r);
+  uint8_t getRotation() const {
+    return rotation;
+  }
+  void setBrightness(uint8_t) {}
+  bool getTouch(int32_t *x, int32_t *y);
+  bool getTouch(uint16_t *x, uint16_t *y);
+  uint_fast8_t getTouchRaw(touch_point_t *tp, uint_fast8_t count = 1);
+  void setTouchCalibrate(uint16_t *) {}
+
+protected:
+  void transfer(uint32_t pixelCount, bool image) override;
+
+private:
+  Panel_ILI9341 *panel = nullptr;
+  uint8_t rotation = 0;
+  uint32_t writeDepth = 0;
+};
+
+}  // namespace lgfx
+
+class LGFX_Sprite : public lgfx::LGFXBase {
+public:
+  explicit LGFX_Sprite(lgfx::LGFXBase *parent = nullptr)
+    : parent(parent) {}
+  void setColorDepth(int) {}
+  void *createSprite(int32_t sw, int32_t sh);
+  void deleteSprite();
+  void fillSprite(uint32_t color) {
+    fillScreen(color);
+  }
+  void pushSprite(int32_t x, int32_t y);
+  void pushSprite(lgfx::LGFXBase *dst, int32_t x, int32_t y);
+  void scroll(int32_t dx, int32_t dy);
+  const uint16_t *buffer() const {
+    return pixels.data();
+  }
+
+private:
+  lgfx::LGFXBase *parent;
+};
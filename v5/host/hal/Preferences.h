@@ -0,0 +1,64 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "./Arduino.h"
+
+// NVS stand-in: namespaces of byte blobs kept in memory for the run
+class Preferences {
+  std::map<std::string, std::vector<uint8_t>> *space = nullptr;
+  bool readOnly = false;
+
+  template<typename T>
+  T get(const char *key, T fallback) {
+    T v;
+    return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : fallback;
+  }
+  template<typename T>
+  size_t put(const char *key, T v) {
+    return putBytes(key, &v, sizeof(v));
+  }
+
+public:
+  bool begin(const char *name, bool readOnly = false);
+  void end();
+  bool clear();
+  bool isKey(const char *key);
+  bool remove(const char *key);
+
+  size_t putBytes(const char *key, const void *value, size_t len);
+  size_t getBytes(const char *key, void *buf, size_t maxLen);
+  size_t getBytesLength(const char *key);
+
+  uint8_t getUChar(const char *key, uint8_t fallback = 0) {
+    return get(key, fallback);
+  }
+  size_t putUChar(const char *key, uint8_t v) {
+    return put(key, v);
+  }
+  uint16_t getUShort(const char *key, uint16_t fallback = 0) {
+    return get(key, fallback);
+  }
+  size_t putUShort(const char *key, uint16_t v) {
+    return put(key, v);
+  }
+  uint32_t getUInt(const char *key, uint32_t fallback = 0) {
+    return get(key, fallback);
+  }
+  size_t putUInt(const char *key, uint32_t v) {
+    return put(key, v);
+  }
+  uint64_t getULong64(const char *key, uint64_t fallback = 0) {
+    return get(key, fallback);
+  }
+  size_t putULong64(const char *key, uint64_t v) {
+    return put(key, v);
+  }
+  bool getBool(const char *key, bool fallback = false) {
+    return get<uint8_t>(key, fallback) != 0;
+  }
+  size_t putBool(const char *key, bool v) {
+    return put<uint8_t>(key, v);
+  }
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "./FS.h"
+#include "./SPI.h"
+
+// SD stand-in: the card is host::sdRoot(), clocked at the begin() frequency
+class SDFS : public fs::FS {
+public:
+  bool begin(uint8_t ssPin, SPIClass &spi, uint32_t frequency);
+  void end();
+  uint64_t cardSize();
+  uint64_t totalBytes();
+  uint64_t usedBytes();
+  bool readRAW(uint8_t *buffer, uint32_t sector);
+};
+
+extern SDFS SD;
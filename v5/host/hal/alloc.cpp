@@ -0,0 +1,51 @@
+#include "./host.h"
+#include <cstdlib>
+#include <new>
+
+// ============================================================
+// Heap allocation counting
+// ============================================================
+// The global operator new and delete for every host target, counting
+// what goes through them. They live in their own translation unit,
+// apart from any new expression, so the compiler never sees free() meet
+// a pointer it knows came from operator new and warns about a mismatch
+// (-Wmismatched-new-delete) in any build type.
+namespace {
+
+uint64_t allocCalls = 0, allocBytesTotal = 0;
+
+}  // namespace
+
+namespace host {
+
+uint64_t allocCount() {
+  return allocCalls;
+}
+
+uint64_t allocBytes() {
+  return allocBytesTotal;
+}
+
+}  // namespace host
+
+void *operator new(size_t n) {
+  allocCalls++;
+  allocBytesTotal += n;
+  if (void *p = malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void *operator new[](size_t n) {
+  return operator new(n);
+}
+void operator delete(void *p) noexcept {
+  free(p);
+}
+void operator delete[](void *p) noexcept {
+  free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+void operator delete[](void *p, size_t) noexcept {
+  free(p);
+}
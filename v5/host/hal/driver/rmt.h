@@ -0,0 +1,75 @@
+#pragma once
+
+// ============================================================
+// ESP-IDF legacy RMT driver stand-in (TX only)
+// ============================================================
+// rmt_write_items() turns the items back into mark/space durations and
+// records them in host::sentIr, with the carrier last set on the channel.
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int esp_err_t;
+typedef int gpio_num_t;
+typedef uint32_t TickType_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_TIMEOUT 0x107
+#define pdMS_TO_TICKS(ms) (ms)
+#define portMAX_DELAY 0xFFFFFFFF
+
+enum rmt_channel_t {
+  RMT_CHANNEL_0,
+  RMT_CHANNEL_1,
+  RMT_CHANNEL_2,
+  RMT_CHANNEL_3,
+  RMT_CHANNEL_MAX
+};
+enum rmt_carrier_level_t {
+  RMT_CARRIER_LEVEL_LOW,
+  RMT_CARRIER_LEVEL_HIGH
+};
+enum rmt_idle_level_t {
+  RMT_IDLE_LEVEL_LOW,
+  RMT_IDLE_LEVEL_HIGH
+};
+enum rmt_mode_t {
+  RMT_MODE_TX,
+  RMT_MODE_RX
+};
+
+struct rmt_tx_config_t {
+  uint32_t carrier_freq_hz;
+  rmt_carrier_level_t carrier_level;
+  rmt_idle_level_t idle_level;
+  uint8_t carrier_duty_percent;
+  bool carrier_en;
+  bool loop_en;
+  bool idle_output_en;
+};
+
+struct rmt_config_t {
+  rmt_mode_t rmt_mode;
+  rmt_channel_t channel;
+  gpio_num_t gpio_num;
+  uint8_t clk_div;
+  uint8_t mem_block_num;
+  uint32_t flags;
+  rmt_tx_config_t tx_config;
+};
+
+typedef struct {
+  uint32_t val;
+} rmt_item32_t;
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) \
+  rmt_config_t { \
+    RMT_MODE_TX, channel_id, gpio, 80, 1, 0, { 38000, RMT_CARRIER_LEVEL_HIGH, RMT_IDLE_LEVEL_LOW, 33, true, false, true } \
+  }
+
+esp_err_t rmt_config(const rmt_config_t *config);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rxBufSize, int intrAllocFlags);
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *items, int count, bool waitDone);
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t waitTime);
+esp_err_t rmt_tx_stop(rmt_channel_t channel);
+esp_err_t rmt_set_tx_carrier(rmt_channel_t channel, bool enable, uint16_t highLevel, uint16_t lowLevel, rmt_carrier_level_t level);
@@ -0,0 +1,426 @@
+#include <map>
+#include "./Arduino.h"
+#include "./IRremote.hpp"
+#include "./Preferences.h"
+#include "./driver/rmt.h"
+
+// ============================================================
+// Clock and pins
+// ============================================================
+namespace {
+
+struct PinEdge {
+  uint64_t atUs;
+  uint8_t level;
+};
+
+uint64_t clockUs = 0;
+std::deque<PinEdge> irEdges;  // in time order
+uint8_t pinLevels[64];
+void (*pinIsrs[64])() = {};
+int irPin = -1;  // the pin with an interrupt attached
+
+bool touchDown = false, touchIsRaw = false;
+int touchX = 0, touchY = 0, touchZ = 0;
+
+std::deque<uint8_t> serialIn;
+std::string serialOut;
+bool serialEcho = true;
+
+std::string cardRoot;
+uint64_t cardBytes = 8ULL << 30;
+
+// A freshly booted ESP32-C3 without Wi-Fi
+uint32_t heapFreeBytes = 280000, heapBlockCap = 200000;
+
+std::vector<host::SentIr> sent;
+
+struct PinLevelsInit {
+  PinLevelsInit() {
+    memset(pinLevels, HIGH, sizeof(pinLevels));
+  }
+} pinLevelsInit;
+
+}  // namespace
+
+namespace host {
+
+BusStats bus;
+
+uint64_t nowUs() {
+  return clockUs;
+}
+
+void advanceUs(uint64_t us) {
+  uint64_t target = clockUs + us;
+  while (!irEdges.empty() && irEdges.front().atUs <= target) {
+    PinEdge e = irEdges.front();
+    irEdges.pop_front();
+    if (e.atUs > clockUs) clockUs = e.atUs;
+    if (irPin < 0) continue;
+    pinLevels[irPin] = e.level;
+    if (pinIsrs[irPin]) pinIsrs[irPin]();
+  }
+  clockUs = target;
+}
+
+void chargeBus(BusCounter &counter, uint64_t bytes, uint32_t freqHz) {
+  counter.bytes += bytes;
+  counter.transactions++;
+  if (freqHz) advanceUs(bytes * 8 * 1000000 / freqHz);
+}
+
+void resetBus() {
+  bus = BusStats();
+}
+
+void touchPress(int x, int y) {
+  touchDown = true;
+  touchIsRaw = false;
+  touchX = x;
+  touchY = y;
+}
+
+void touchRelease() {
+  touchDown = false;
+}
+
+void touchRaw(int x, int y, int z) {
+  touchDown = true;
+  touchIsRaw = true;
+  touchX = x;
+  touchY = y;
+  touchZ = z;
+}
+
+bool touchState(int &x, int &y) {
+  x = touchX;
+  y = touchY;
+  return touchDown && !touchIsRaw;
+}
+
+bool touchRawState(int &x, int &y, int &z) {
+  x = touchX;
+  y = touchY;
+  z = touchZ;
+  return touchDown && touchIsRaw;
+}
+
+void injectIr(const uint16_t *durations, uint16_t count, uint32_t delayUs) {
+  uint64_t t = std::max(clockUs, irEdges.empty() ? 0 : irEdges.back().atUs) + delayUs;
+  for (uint16_t i = 0; i < count; i++) {
+    irEdges.push_back({ t, (uint8_t)(i % 2 ? HIGH : LOW) });  // receivers are active low
+    t += durations[i];
+  }
+  if (count % 2) irEdges.push_back({ t, HIGH });
+}
+
+void injectNec(uint16_t address, uint8_t command, uint32_t delayUs) {
+  uint32_t data = address > 0xFF ? address : address | (uint32_t)(~address & 0xFF) << 8;
+  data |= (uint32_t)command << 16 | (uint32_t)(uint8_t)~command << 24;
+  uint16_t d[68] = { 9000, 4500 };
+  for (int b = 0; b < 32; b++) {
+    d[2 + b * 2] = 560;
+    d[3 + b * 2] = (data >> b) & 1 ? 1690 : 560;
+  }
+  d[66] = 560;
+  injectIr(d, 67, delayUs);
+}
+
+std::vector<SentIr> &sentIr() {
+  return sent;
+}
+
+void recordSentIr(uint32_t carrierHz, std::vector<uint16_t> durations) {
+  sent.push_back({ clockUs, carrierHz, std::move(durations) });
+}
+
+std::deque<uint8_t> &serialInput() {
+  return serialIn;
+}
+
+std::string &serialOutput() {
+  return serialOut;
+}
+
+void setSerialEcho(bool toStdout) {
+  serialEcho = toStdout;
+}
+
+void setSdRoot(const std::string &dir) {
+  cardRoot = dir;
+  while (cardRoot.size() > 1 && cardRoot.back() == '/') cardRoot.pop_back();
+}
+
+const std::string &sdRoot() {
+  return cardRoot;
+}
+
+void setSdCardBytes(uint64_t bytes) {
+  cardBytes = bytes;
+}
+
+uint64_t sdCardBytes() {
+  return cardBytes;
+}
+
+void setHeap(uint32_t freeBytes, uint32_t largestBlock) {
+  heapFreeBytes = freeBytes;
+  heapBlockCap = largestBlock;
+}
+
+bool heapTake(uint32_t bytes) {
+  if (bytes > heapLargestBlock()) return false;
+  heapFreeBytes -= bytes;
+  return true;
+}
+
+void heapGive(uint32_t bytes) {
+  heapFreeBytes += bytes;
+}
+
+uint32_t heapFree() {
+  return heapFreeBytes;
+}
+
+uint32_t heapLargestBlock() {
+  return std::min(heapFreeBytes, heapBlockCap);
+}
+
+}  // namespace host
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin < 64) pinLevels[pin] = level;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < 64 ? pinLevels[pin] : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int) {
+  if (pin >= 64) return;
+  pinIsrs[pin] = isr;
+  irPin = pin;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < 64) pinIsrs[pin] = nullptr;
+}
+
+// ============================================================
+// Serial
+// ============================================================
+HardwareSerial Serial;
+EspClass ESP;
+
+int HardwareSerial::available() {
+  return (int)serialIn.size();
+}
+
+int HardwareSerial::read() {
+  if (serialIn.empty()) return -1;
+  uint8_t c = serialIn.front();
+  serialIn.pop_front();
+  return c;
+}
+
+int HardwareSerial::peek() {
+  return serialIn.empty() ? -1 : serialIn.front();
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t n) {
+  serialOut.append((const char *)buf, n);
+  if (serialEcho) fwrite(buf, 1, n, stdout);
+  return n;
+}
+
+// ============================================================
+// Preferences
+// ============================================================
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs;
+
+bool Preferences::begin(const char *name, bool ro) {
+  space = &nvs[name];
+  readOnly = ro;
+  return true;
+}
+
+void Preferences::end() {
+  space = nullptr;
+}
+
+bool Preferences::clear() {
+  if (!space || readOnly) return false;
+  space->clear();
+  return true;
+}
+
+bool Preferences::isKey(const char *key) {
+  return space && space->count(key);
+}
+
+bool Preferences::remove(const char *key) {
+  return space && !readOnly && space->erase(key) > 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+  if (!space || readOnly) return 0;
+  (*space)[key].assign((const uint8_t *)value, (const uint8_t *)value + len);
+  return len;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+  if (!space || !space->count(key)) return 0;
+  const std::vector<uint8_t> &v = space->at(key);
+  if (v.size() > maxLen) return 0;
+  memcpy(buf, v.data(), v.size());
+  return v.size();
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  return space && space->count(key) ? space->at(key).size() : 0;
+}
+
+// ============================================================
+// IR
+// ============================================================
+IRrecv IrReceiver;
+IRsend IrSender;
+
+static bool ticksNear(uint16_t ticks, uint32_t us) {
+  uint32_t t = ticks * MICROS_PER_TICK;
+  return t >= us * 3 / 4 && t <= us * 5 / 4;
+}
+
+bool IRrecv::decode() {
+  decodedIRData = {};
+  decodedIRData.rawlen = irparams.rawlen;
+  const uint16_t *d = irparams.rawbuf + 1;
+  if (irparams.rawlen < 68 || !ticksNear(d[0], 9000) || !ticksNear(d[1], 4500)) return false;
+  uint32_t data = 0;
+  for (int b = 0; b < 32; b++) {
+    if (!ticksNear(d[2 + b * 2], 560)) return false;
+    bool one = ticksNear(d[3 + b * 2], 1690);
+    if (!one && !ticksNear(d[3 + b * 2], 560)) return false;
+    data |= (uint32_t)one << b;
+  }
+  if ((uint8_t)(data >> 16) != (uint8_t)~(data >> 24)) return false;
+  uint8_t lo = data, hi = data >> 8;
+  decodedIRData.protocol = NEC;
+  decodedIRData.address = lo == (uint8_t)~hi ? lo : data & 0xFFFF;
+  decodedIRData.command = (data >> 16) & 0xFF;
+  decodedIRData.numberOfBits = 32;
+  decodedIRData.decodedRawData = data;
+  return true;
+}
+
+void IRsend::mark(unsigned us) {
+  pending.push_back(us);
+  host::advanceUs(us);
+}
+
+void IRsend::space(unsigned us) {
+  if (pending.empty()) return;
+  pending.push_back(us);
+  host::advanceUs(us);
+  host::recordSentIr(carrierHz, pending);
+  pending.clear();
+}
+
+void IRsend::sendRaw(const uint16_t *durations, uint_fast16_t count, uint_fast8_t kHz) {
+  uint64_t total = 0;
+  for (uint_fast16_t i = 0; i < count; i++) total += durations[i];
+  host::recordSentIr(kHz * 1000, std::vector<uint16_t>(durations, durations + count));
+  host::advanceUs(total);
+}
+
+const char *getProtocolString(decode_type_t protocol) {
+  switch (protocol) {
+    case NEC: return "NEC";
+    case SONY: return "Sony";
+    case RC5: return "RC5";
+    case RC6: return "RC6";
+    case SAMSUNG: return "Samsung";
+    case PANASONIC: return "Panasonic";
+    case LG: return "LG";
+    default: return "UNKNOWN";
+  }
+}
+
+// ============================================================
+// RMT
+// ============================================================
+static uint8_t rmtClockDiv[RMT_CHANNEL_MAX] = { 80, 80, 80, 80 };
+static uint32_t rmtCarrierHz[RMT_CHANNEL_MAX] = { 38000, 38000, 38000, 38000 };
+static uint64_t rmtBusyUntil[RMT_CHANNEL_MAX] = {};
+
+esp_err_t rmt_config(const rmt_config_t *config) {
+  if (config->channel >= RMT_CHANNEL_MAX || config->clk_div == 0) return ESP_FAIL;
+  rmtClockDiv[config->channel] = config->clk_div;
+  rmtCarrierHz[config->channel] = config->tx_config.carrier_freq_hz;
+  return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t, int) {
+  return channel < RMT_CHANNEL_MAX ? ESP_OK : ESP_FAIL;
+}
+
+// Halves are level/duration pairs; a zero duration ends the frame
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *items, int count, bool waitDone) {
+  if (channel >= RMT_CHANNEL_MAX) return ESP_FAIL;
+  std::vector<uint16_t> durations;
+  bool lastLevel = false;
+  uint64_t totalNs = 0, tickNs = 1000ULL * rmtClockDiv[channel] / 80;
+  for (int i = 0; i < count * 2; i++) {
+    uint16_t half = i % 2 ? items[i / 2].val >> 16 : items[i / 2].val & 0xFFFF;
+    uint16_t ticks = half & 0x7FFF;
+    bool level = half >> 15;
+    if (ticks == 0) break;
+    uint32_t us = (uint32_t)(ticks * tickNs / 1000);
+    totalNs += ticks * tickNs;
+    if (!durations.empty() && level == lastLevel) {
+      uint32_t merged = durations.back() + us;
+      durations.back() = merged > 0xFFFF ? 0xFFFF : merged;
+    } else if (durations.empty() && !level) {
+      continue;  // leading idle
+    } else {
+      durations.push_back(us);
+    }
+    lastLevel = level;
+  }
+  host::recordSentIr(rmtCarrierHz[channel], std::move(durations));
+  rmtBusyUntil[channel] = host::nowUs() + totalNs / 1000;
+  if (waitDone) rmt_wait_tx_done(channel, portMAX_DELAY);
+  return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t waitMs) {
+  if (channel >= RMT_CHANNEL_MAX) return ESP_FAIL;
+  uint64_t now = host::nowUs();
+  if (rmtBusyUntil[channel] <= now) return ESP_OK;
+  uint64_t wait = rmtBusyUntil[channel] - now;
+  if (waitMs != portMAX_DELAY && wait > (uint64_t)waitMs * 1000) {
+    host::advanceUs((uint64_t)waitMs * 1000);
+    return ESP_ERR_TIMEOUT;
+  }
+  host::advanceUs(wait);
+  return ESP_OK;
+}
+
+esp_err_t rmt_tx_stop(rmt_channel_t channel) {
+  if (channel >= RMT_CHANNEL_MAX) return ESP_FAIL;
+  rmtBusyUntil[channel] = host::nowUs();
+  return ESP_OK;
+}
+
+esp_err_t rmt_set_tx_carrier(rmt_channel_t channel, bool enable, uint16_t high, uint16_t low, rmt_carrier_level_t) {
+  if (channel >= RMT_CHANNEL_MAX) return ESP_FAIL;
+  rmtCarrierHz[channel] = enable && high + low ? 80000000 / (high + low) : 0;
+  return ESP_OK;
+}
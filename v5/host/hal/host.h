@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+// ============================================================
+// Host controls
+// ============================================================
+// What a driver, benchmark or regression script uses to run the sketch
+// on a workstation: a virtual clock, the touch panel, the IR receiver
+// pin, the serial port, the SD card directory, and counters for what
+// crossed the shared SPI bus. The stand-in libraries next to this file
+// read and update this state; the sketch itself never sees it.
+namespace host {
+
+// Virtual clock in microseconds; starts at 0. advanceUs() also plays
+// any injected IR edges that fall due, at their own timestamps.
+uint64_t nowUs();
+void advanceUs(uint64_t us);
+
+// Bytes clocked over SPI per device. Bus time is charged to the virtual
+// clock at the device's configured frequency, so slow screens and card
+// scans show up in millis() exactly as they would on hardware.
+struct BusCounter {
+  uint64_t bytes = 0;
+  uint32_t transactions = 0;
+};
+struct BusStats {
+  BusCounter display, sd, touch;
+};
+extern BusStats bus;
+void chargeBus(BusCounter &counter, uint64_t bytes, uint32_t freqHz);
+void resetBus();
+
+// Touch panel: screen coordinates while pressed, or a raw controller
+// reading (X, Y, pressure) replayed as the board recorded it
+void touchPress(int x, int y);
+void touchRelease();
+void touchRaw(int x, int y, int z);
+bool touchState(int &x, int &y);
+bool touchRawState(int &x, int &y, int &z);
+
+// IR receiver module (active low). Schedules mark/space durations,
+// starting with a mark, delayUs from now.
+void injectIr(const uint16_t *durations, uint16_t count, uint32_t delayUs = 0);
+void injectNec(uint16_t address, uint8_t command, uint32_t delayUs = 0);
+
+// Everything the sketch sent, whether through RMT or IrSender
+struct SentIr {
+  uint64_t atUs;
+  uint32_t carrierHz;
+  std::vector<uint16_t> durations;
+};
+std::vector<SentIr> &sentIr();
+void recordSentIr(uint32_t carrierHz, std::vector<uint16_t> durations);
+
+// Serial port: bytes the sketch will read, and what it wrote
+std::deque<uint8_t> &serialInput();
+std::string &serialOutput();
+void setSerialEcho(bool toStdout);
+
+// SD card: a host directory standing in for the card root. An empty
+// root means no card is inserted.
+void setSdRoot(const std::string &dir);
+const std::string &sdRoot();
+void setSdCardBytes(uint64_t bytes);
+uint64_t sdCardBytes();
+
+// Heap as ESP.getFreeHeap() and getMaxAllocHeap() report it. Sprites
+// take their buffers from it, so a small largest block makes
+// createSprite() fail the way a fragmented device heap does.
+void setHeap(uint32_t freeBytes, uint32_t largestBlock);
+bool heapTake(uint32_t bytes);
+void heapGive(uint32_t bytes);
+uint32_t heapFree();
+uint32_t heapLargestBlock();
+
+// Calls to the global operator new since start, and the bytes they
+// asked for (hal/alloc.cpp replaces it in every host target)
+uint64_t allocCount();
+uint64_t allocBytes();
+
+// Screen contents (RGB565, row-major) and a PNG snapshot of them
+bool saveScreenPng(const char *path);
+const uint16_t *screenPixels(int &width, int &height);
+
+}  // namespace host
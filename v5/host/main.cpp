@@ -0,0 +1,295 @@
+// ============================================================
+// uniremote-host — runs the sketch on a workstation
+// ============================================================
+// Boots the firmware against the stand-ins in hal/ and plays a script of
+// touches, IR frames and waits on the virtual clock, taking PNG
+// snapshots and checking what was transmitted along the way.
+//
+//   cmake -S v5/host -B build-host && cmake --build build-host
+//   ./build-host/uniremote-host --sd card-dir script.txt
+//
+// Script lines ('#' starts a comment):
+//   wait MS                   run loop() for MS of virtual time
+//   tap X Y                   press for 100 ms, release, settle 300 ms
+//   tap2 X Y                  double tap (opens a list row)
+//   press X Y / move X Y / release
+//   touch FILE                replay raw panel readings, "US X Y Z" per line
+//   drag X0 Y0 X1 Y1 MS       press, slide over MS, release
+//   nec ADDR CMD              a NEC frame arrives at the receiver
+//   ir FILE.bin               a saved signal's timings arrive
+//   serial TEXT               bytes arrive on the serial port
+//   heap FREE LARGEST         what ESP.getFreeHeap()/getMaxAllocHeap() report
+//   png PATH                  snapshot of the screen
+//   expect-sent N             fail unless N frames were sent so far
+//   sent                      print the last frame sent
+//   stats                     clock, loop passes and SPI traffic
+//   bus                       display traffic per screen and gesture
+//   expect-budget             fail if any of it went over BUS_BUDGETS
+//   trace PATH                the event trace dump, as "irsync trace" fetches it
+//   allocs                    heap allocations loop() made since the last check
+//   scroll                    the list's drawn scroll offset, frames drawn, fling speed
+//   expect-scroll MIN MAX     fail unless the drawn offset is within MIN..MAX px
+//   expect-allocs N           fail if that was more than N
+//   touch-lag                 the touch filter's lag while the finger moved, since the last check
+//   expect-touch-lag US       fail if any of it was over US
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "host.h"
+#include "IR-signal.h"
+#include "IR-busmeter.h"
+#include "IR-trace.h"
+#include "IR-kinetic.h"
+#include "IR-touch.h"
+#include "IR-perf.h"
+
+void setup();
+void loop();
+extern BusOpTable busOps;
+extern TraceBuffer trace;
+extern ScrollFling scrollFling;
+extern float scrollShownPx;
+extern uint32_t scrollFrames;
+extern TouchFilter touchFilter;
+
+struct StdoutPrint {
+  void print(const char *text) {
+    fputs(text, stdout);
+  }
+};
+
+static uint64_t loopPasses = 0;
+static uint64_t loopAllocs = 0;
+static PerfHistogram touchLag;
+
+// Only the sketch's own allocations count, not the script runner's
+static void runLoop() {
+  uint64_t allocs0 = host::allocCount();
+  loop();
+  loopAllocs += host::allocCount() - allocs0;
+  loopPasses++;
+  if (touchFilter.moving) touchLag.add(touchFilter.lagUs);
+}
+
+// loop() always moves the clock (its own delays, bus traffic), so this ends
+static void runFor(uint64_t us) {
+  uint64_t until = host::nowUs() + us;
+  while (host::nowUs() < until) runLoop();
+}
+
+static void printStats() {
+  printf("t=%.3f s  loops=%llu  display %llu B/%u tx  sd %llu B/%u tx  touch %llu B/%u tx  ir sent %zu\n",
+         host::nowUs() / 1e6, (unsigned long long)loopPasses, (unsigned long long)host::bus.display.bytes,
+         host::bus.display.transactions, (unsigned long long)host::bus.sd.bytes, host::bus.sd.transactions,
+         (unsigned long long)host::bus.touch.bytes, host::bus.touch.transactions, host::sentIr().size());
+}
+
+static bool writeTrace(const std::string &path) {
+  uint32_t size = trace.freeze(host::nowUs());
+  std::vector<uint8_t> data(size);
+  bool ok = trace.read(0, data.data(), size);
+  trace.thaw();
+  std::ofstream f(path, std::ios::binary);
+  return ok && f.write((const char *)data.data(), size);
+}
+
+// Readings take effect at their times relative to the first; the panel
+// is released after the last
+static bool replayTouch(const std::string &path) {
+  std::ifstream f(path);
+  if (!f) return false;
+  std::string line;
+  long long firstUs = -1;
+  uint64_t start = host::nowUs();
+  while (std::getline(f, line)) {
+    std::istringstream in(line);
+    long long us;
+    int x, y, z;
+    if (line.empty() || line[0] == '#') continue;
+    if (!(in >> us >> x >> y >> z)) return false;
+    if (firstUs < 0) firstUs = us;
+    while (host::nowUs() < start + (uint64_t)(us - firstUs)) runLoop();
+    host::touchRaw(x, y, z);
+  }
+  runLoop();
+  host::touchRelease();
+  runFor(1);
+  return true;
+}
+
+static bool injectSignalFile(const std::string &path) {
+  IRSignal signal;
+  std::ifstream f(path, std::ios::binary);
+  if (!f.read((char *)&signal, sizeof(signal)) || signal.rawDataLen == 0 || signal.rawDataLen > MAX_RAW_LEN) return false;
+  uint8_t len = signalOnceLen(signal) ? signalOnceLen(signal) : signal.rawDataLen;
+  uint16_t durations[MAX_RAW_LEN];
+  host::injectIr(copySection(signal, 0, len, durations), len);
+  return true;
+}
+
+// False stops the script
+static bool runCommand(const std::string &line, int lineNo) {
+  std::istringstream in(line);
+  std::string cmd;
+  if (!(in >> cmd) || cmd[0] == '#') return true;
+  int x0, y0, x1, y1;
+  long ms;
+  if (cmd == "wait" && in >> ms) {
+    runFor(ms * 1000);
+  } else if (cmd == "tap" && in >> x0 >> y0) {
+    host::touchPress(x0, y0);
+    runFor(100000);
+    host::touchRelease();
+    runFor(300000);
+  } else if (cmd == "tap2" && in >> x0 >> y0) {
+    for (int i = 0; i < 2; i++) {
+      host::touchPress(x0, y0);
+      runFor(60000);
+      host::touchRelease();
+      runFor(60000);
+    }
+    runFor(240000);
+  } else if ((cmd == "press" || cmd == "move") && in >> x0 >> y0) {
+    host::touchPress(x0, y0);
+    runFor(1);
+  } else if (cmd == "touch") {
+    std::string path;
+    in >> path;
+    if (!replayTouch(path)) {
+      fprintf(stderr, "line %d: can't replay touch readings %s\n", lineNo, path.c_str());
+      return false;
+    }
+  } else if (cmd == "release") {
+    host::touchRelease();
+    runFor(1);
+  } else if (cmd == "drag" && in >> x0 >> y0 >> x1 >> y1 >> ms) {
+    uint64_t start = host::nowUs(), span = ms * 1000;
+    host::touchPress(x0, y0);
+    for (uint64_t t = 0; t < span; t = host::nowUs() - start) {
+      host::touchPress(x0 + (int)((x1 - x0) * (int64_t)t / (int64_t)span), y0 + (int)((y1 - y0) * (int64_t)t / (int64_t)span));
+      runLoop();
+    }
+    host::touchPress(x1, y1);
+    runFor(1);
+    host::touchRelease();
+    runFor(1);
+  } else if (cmd == "nec") {
+    std::string addr, command;
+    in >> addr >> command;
+    host::injectNec(strtoul(addr.c_str(), nullptr, 0), strtoul(command.c_str(), nullptr, 0));
+  } else if (cmd == "ir") {
+    std::string path;
+    in >> path;
+    if (!injectSignalFile(path)) {
+      fprintf(stderr, "line %d: can't read signal %s\n", lineNo, path.c_str());
+      return false;
+    }
+  } else if (cmd == "serial") {
+    std::string text;
+    std::getline(in >> std::ws, text);
+    text += '\n';
+    host::serialInput().insert(host::serialInput().end(), text.begin(), text.end());
+  } else if (cmd == "heap" && in >> x0 >> y0) {
+    host::setHeap(x0, y0);
+  } else if (cmd == "png") {
+    std::string path;
+    in >> path;
+    if (!host::saveScreenPng(path.c_str())) {
+      fprintf(stderr, "line %d: can't write %s\n", lineNo, path.c_str());
+      return false;
+    }
+  } else if (cmd == "expect-sent" && in >> x0) {
+    if ((int)host::sentIr().size() != x0) {
+      fprintf(stderr, "line %d: expected %d frames sent, got %zu\n", lineNo, x0, host::sentIr().size());
+      return false;
+    }
+  } else if (cmd == "sent") {
+    if (host::sentIr().empty()) {
+      printf("nothing sent\n");
+      return true;
+    }
+    const host::SentIr &last = host::sentIr().back();
+    printf("sent at %.3f s, %lu Hz, %zu durations:", last.atUs / 1e6, (unsigned long)last.carrierHz, last.durations.size());
+    for (uint16_t d : last.durations) printf(" %u", d);
+    printf("\n");
+  } else if (cmd == "stats") {
+    printStats();
+  } else if (cmd == "bus" || cmd == "expect-budget") {
+    StdoutPrint out;
+    uint8_t over = busOps.print(out);
+    if (cmd == "expect-budget" && over) {
+      fprintf(stderr, "line %d: %u bus op%s over budget\n", lineNo, over, over == 1 ? "" : "s");
+      return false;
+    }
+  } else if (cmd == "allocs" || (cmd == "expect-allocs" && in >> x0)) {
+    uint64_t n = loopAllocs;
+    loopAllocs = 0;
+    if (cmd == "allocs") printf("%llu heap allocations in loop()\n", (unsigned long long)n);
+    else if (n > (uint64_t)x0) {
+      fprintf(stderr, "line %d: expected at most %d heap allocations in loop(), got %llu\n", lineNo, x0, (unsigned long long)n);
+      return false;
+    }
+  } else if (cmd == "touch-lag" || (cmd == "expect-touch-lag" && in >> x0)) {
+    PerfHistogram h = touchLag;
+    touchLag.clear();
+    if (cmd == "touch-lag")
+      printf("touch lag %lu readings, p50 %lu us, p95 %lu us, max %lu us\n", (unsigned long)h.n,
+             (unsigned long)h.percentile(50), (unsigned long)h.percentile(95), (unsigned long)h.maxUs);
+    else if (h.maxUs > (uint32_t)x0) {
+      fprintf(stderr, "line %d: expected touch lag at most %d us, got %lu\n", lineNo, x0, (unsigned long)h.maxUs);
+      return false;
+    }
+  } else if (cmd == "scroll") {
+    printf("scroll %.1f px, %u frames, fling %.3f px/ms\n", scrollShownPx, scrollFrames, scrollFling.velocity);
+  } else if (cmd == "expect-scroll" && in >> x0 >> x1) {
+    if (scrollShownPx < x0 || scrollShownPx > x1) {
+      fprintf(stderr, "line %d: expected scroll within %d..%d px, got %.1f\n", lineNo, x0, x1, scrollShownPx);
+      return false;
+    }
+  } else if (cmd == "trace") {
+    std::string path;
+    in >> path;
+    if (!writeTrace(path)) {
+      fprintf(stderr, "line %d: can't write %s\n", lineNo, path.c_str());
+      return false;
+    }
+  } else {
+    fprintf(stderr, "line %d: can't parse \"%s\"\n", lineNo, line.c_str());
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const char *script = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--sd") && i + 1 < argc) host::setSdRoot(argv[++i]);
+    else if (!strcmp(argv[i], "--quiet")) host::setSerialEcho(false);
+    else if (argv[i][0] != '-' && !script) script = argv[i];
+    else {
+      fprintf(stderr, "usage: %s [--sd DIR] [--quiet] [script]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  setup();
+  runFor(500000);
+  if (!script) {
+    printStats();
+    return 0;
+  }
+
+  std::ifstream f(script);
+  if (!f) {
+    fprintf(stderr, "can't open %s\n", script);
+    return 2;
+  }
+  std::string line;
+  for (int lineNo = 1; std::getline(f, line); lineNo++)
+    if (!runCommand(line, lineNo)) return 1;
+  return 0;
+}
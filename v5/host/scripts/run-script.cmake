@@ -0,0 +1,15 @@
+# Runs one host script against a fresh copy of a fixture card, so what
+# the sketch writes (sort cache, saved signals) never reaches the source
+# tree. Relative paths in the script resolve from scripts/.
+#
+#   cmake -DHOST=uniremote-host -DCARD=cards/basic -DWORK=dir -DSCRIPT=x.txt -P run-script.cmake
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK})
+if(CARD)
+  file(COPY ${CARD}/ DESTINATION ${WORK})
+endif()
+get_filename_component(scriptDir ${SCRIPT} DIRECTORY)
+execute_process(COMMAND ${HOST} --quiet --sd ${WORK} ${SCRIPT} WORKING_DIRECTORY ${scriptDir} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${SCRIPT} failed: ${result}")
+endif()
@@ -0,0 +1,4 @@
+// The sketch as one translation unit, as the Arduino builder compiles it:
+// Arduino.h first, then the .ino with its own prototypes
+#include <Arduino.h>
+#include "../uniremote/uniremote.ino"
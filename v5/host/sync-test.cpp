@@ -0,0 +1,229 @@
+// ============================================================
+// uniremote-sync-test — irsync against the sketch's SyncServer
+// ============================================================
+// Compiles the sketch in, as uniremote-test does, and serves a pty pair
+// with the sketch's SyncServer and SdSyncStore over a scratch card.
+// The real irsync tool runs on the other end for push, list, pull and
+// delete; a stalled upload is then written by hand to check the
+// server drops it after SYNC_RECEIVE_IDLE_MS.
+//
+//   cmake -S v5/host -B build-host && cmake --build build-host
+//   ./build-host/uniremote-sync-test build-host/irsync WORKDIR
+#include <Arduino.h>
+#include <chrono>
+#include <fcntl.h>
+#include <fstream>
+#include <poll.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+#include "../uniremote/uniremote.ino"
+
+static int failures = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      failures++; \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+    } \
+  } while (0)
+
+// ------------------------------------------------------------
+// The device end of the pty, as SyncServer's Port
+// ------------------------------------------------------------
+struct PtyPort {
+  int fd = -1;
+  uint8_t buf[512];
+  size_t head = 0, tail = 0;
+
+  int available() {
+    if (head == tail) {
+      ssize_t n = ::read(fd, buf, sizeof(buf));
+      head = 0;
+      tail = n > 0 ? n : 0;
+    }
+    return tail - head;
+  }
+  int read() {
+    return available() > 0 ? buf[head++] : -1;
+  }
+  size_t write(const uint8_t *p, size_t n) {
+    for (size_t done = 0; done < n;) {
+      ssize_t w = ::write(fd, p + done, n - done);
+      if (w > 0) done += w;
+      else if (w < 0 && errno != EAGAIN) return done;
+      else usleep(200);
+    }
+    return n;
+  }
+};
+
+static uint32_t realMs() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+static std::string readFile(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream s;
+  s << in.rdbuf();
+  return s.str();
+}
+
+static void writeFile(const std::string &path, const std::string &data) {
+  std::ofstream(path, std::ios::binary) << data;
+}
+
+static bool exists(const std::string &path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0;
+}
+
+static void makeRaw(int fd) {
+  termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+}
+
+// ------------------------------------------------------------
+// Fixture
+// ------------------------------------------------------------
+static PtyPort port;
+static int slaveFd = -1;
+static std::string slavePath, irsyncPath, workDir;
+static SyncServer<PtyPort, SdSyncStore> server;
+
+static bool openPty() {
+  port.fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (port.fd < 0 || grantpt(port.fd) != 0 || unlockpt(port.fd) != 0) return false;
+  slavePath = ptsname(port.fd);
+  // Held open here too, so the master doesn't see a hangup between runs
+  slaveFd = ::open(slavePath.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (slaveFd < 0) return false;
+  makeRaw(slaveFd);
+  return true;
+}
+
+// Runs irsync with args, serving it until it exits; its exit code
+static int irsync(std::vector<std::string> args) {
+  args.insert(args.begin(), { irsyncPath, slavePath });
+  pid_t pid = fork();
+  if (pid == 0) {
+    std::vector<char *> argv;
+    for (std::string &a : args) argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+  int status = 0;
+  uint32_t startMs = realMs();
+  while (realMs() - startMs < 30000) {
+    server.service(port, syncStore, realMs());
+    if (waitpid(pid, &status, WNOHANG) == pid) return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    pollfd p = { port.fd, POLLIN, 0 };
+    poll(&p, 1, 1);
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, &status, 0);
+  fprintf(stderr, "irsync %s timed out\n", args[2].c_str());
+  return -1;
+}
+
+// ------------------------------------------------------------
+// Tests
+// ------------------------------------------------------------
+static void pushListPullDelete() {
+  std::string src = workDir + "/push", dst = workDir + "/pull";
+  ::mkdir(src.c_str(), 0755);
+  ::mkdir(dst.c_str(), 0755);
+  // A few chunks and a part chunk, so the window wraps and the tail is short
+  std::string big;
+  for (int i = 0; i < SYNC_CHUNK_BYTES * 9 + 37; i++) big += (char)(i * 7 + i / 251);
+  writeFile(src + "/TV-power.bin", big);
+  writeFile(src + "/AMP-mute.bin", "short");
+
+  CHECK(irsync({ "push", src }) == 0);
+  std::string saved = host::sdRoot() + "/saved-signals/";
+  CHECK(readFile(saved + "TV-power.bin") == big);
+  CHECK(readFile(saved + "AMP-mute.bin") == "short");
+  CHECK(!exists(host::sdRoot() + SYNC_TEMP_PATH));
+
+  CHECK(irsync({ "list" }) == 0);
+  CHECK(irsync({ "pull", dst }) == 0);
+  CHECK(readFile(dst + "/TV-power.bin") == big);
+  CHECK(readFile(dst + "/AMP-mute.bin") == "short");
+
+  CHECK(irsync({ "delete", "AMP-mute.bin" }) == 0);
+  CHECK(!exists(saved + "AMP-mute.bin"));
+  CHECK(irsync({ "delete", "AMP-mute.bin" }) != 0);
+  CHECK(!server.busy());
+}
+
+// A host that sends PUT and one chunk, then goes away
+static void stalledUpload() {
+  uint8_t frame[SYNC_FRAME_MAX], payload[SYNC_MAX_PAYLOAD];
+  const char *name = "stalled.bin";
+  syncPut32(payload, SYNC_CHUNK_BYTES * 4);
+  syncPut32(payload + 4, 0);
+  memcpy(payload + 8, name, strlen(name));
+  uint16_t n = encodeSyncFrame(SYNC_PUT, 1, payload, 8 + strlen(name), frame);
+  CHECK(::write(slaveFd, frame, n) == n);
+  memset(payload, 0x55, SYNC_CHUNK_BYTES);
+  n = encodeSyncFrame(SYNC_DATA, 0, payload, SYNC_CHUNK_BYTES, frame);
+  CHECK(::write(slaveFd, frame, n) == n);
+
+  uint32_t t0 = 1000;
+  for (int i = 0; i < 20; i++) {
+    server.service(port, syncStore, t0);
+    usleep(1000);
+  }
+  CHECK(server.busy());
+  CHECK(exists(host::sdRoot() + SYNC_TEMP_PATH));
+
+  server.service(port, syncStore, t0 + SYNC_RECEIVE_IDLE_MS);
+  CHECK(server.busy());
+  server.service(port, syncStore, t0 + SYNC_RECEIVE_IDLE_MS + 1);
+  CHECK(!server.busy());
+  CHECK(!exists(host::sdRoot() + SYNC_TEMP_PATH));
+  CHECK(!exists(host::sdRoot() + "/saved-signals/" + name));
+
+  // OK for the PUT, ACK for the chunk, then the timeout's ERR
+  SyncFrameParser parser;
+  bool timedOut = false;
+  uint8_t b;
+  while (::read(slaveFd, &b, 1) == 1) {
+    if (parser.feed(b) && parser.frame.type == SYNC_ERR) timedOut = parser.frame.payload[0] == SYNC_ERR_PROTOCOL;
+  }
+  CHECK(timedOut);
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s IRSYNC WORKDIR\n", argv[0]);
+    return 2;
+  }
+  irsyncPath = argv[1];
+  workDir = argv[2];
+  std::string reset = "rm -rf '" + workDir + "' && mkdir -p '" + workDir + "/card/saved-signals'";
+  if (system(reset.c_str()) != 0) return 2;
+  if (!openPty()) {
+    perror("pty");
+    return 2;
+  }
+
+  host::setSerialEcho(false);
+  host::setSdRoot(workDir + "/card");
+  setup();
+
+  pushListPullDelete();
+  stalledUpload();
+  printf("%d checks failed\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,1178 @@
+// ============================================================
+// uniremote-test — unit tests for the IR and UI code
+// ============================================================
+// Compiles the sketch in, as uniremote-bench does, and checks its own
+// functions on the host stand-ins. Tests are registered with
+// TEST(id, "group/name"); a failed CHECK prints the line and what was
+// being checked, and the run exits 1.
+//
+//   cmake -S v5/host -B build-host && cmake --build build-host
+//   ./build-host/uniremote-test [--filter TEXT]
+#include <Arduino.h>
+#include <cmath>
+#include <cstdarg>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "../uniremote/uniremote.ino"
+#include "../uniremote/IR-codes.h"
+
+// ------------------------------------------------------------
+// Harness
+// ------------------------------------------------------------
+struct Test {
+  const char *name;
+  void (*body)();
+};
+
+static std::vector<Test> &tests() {
+  static std::vector<Test> all;
+  return all;
+}
+
+struct TestRegistrar {
+  TestRegistrar(const char *name, void (*body)()) {
+    tests().push_back({ name, body });
+  }
+};
+#define TEST(id, name) \
+  static void id(); \
+  static TestRegistrar id##Registrar(name, id); \
+  static void id()
+
+static int testFailures = 0;
+static char testContext[80] = "";
+
+// What the following checks are about, e.g. the code being looped over
+static void context(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(testContext, sizeof(testContext), fmt, args);
+  va_end(args);
+}
+
+static bool check(bool ok, int line, const char *what) {
+  if (!ok) {
+    testFailures++;
+    fprintf(stderr, "  line %d%s%s: %s\n", line, testContext[0] ? ", " : "", testContext, what);
+  }
+  return ok;
+}
+
+static bool checkNear(double actual, double expected, double tolerance, int line, const char *what) {
+  if (std::fabs(actual - expected) <= tolerance) return true;
+  char text[160];
+  snprintf(text, sizeof(text), "%s is %.1f, expected %.1f +- %.1f", what, actual, expected, tolerance);
+  return check(false, line, text);
+}
+
+#define CHECK(cond) check((cond), __LINE__, #cond)
+#define CHECK_NEAR(actual, expected, tolerance) checkNear((actual), (expected), (tolerance), __LINE__, #actual)
+
+// ------------------------------------------------------------
+// Fixtures
+// ------------------------------------------------------------
+// The learned Pronto codes the built-in table was generated from
+struct ProntoBrand {
+  const char *brand;
+  const IRCode *codes;
+  uint8_t count;
+};
+static const ProntoBrand PRONTO_BRANDS[] = {
+  { "ACER", ACER_CODES, ACER_CODES_LENGTH },     { "BENQ", BENQ_CODES, BENQ_CODES_LENGTH },
+  { "EPSON", EPSON_CODES, EPSON_CODES_LENGTH },  { "LED_STRIP", LED_STRIP_CODES, LED_STRIP_CODES_LENGTH },
+  { "NEC", NEC_CODES, NEC_CODES_LENGTH },        { "PANASONIC", PANASONIC_CODES, PANASONIC_CODES_LENGTH },
+};
+
+template<typename F> static void forEachPronto(F body) {
+  for (const ProntoBrand &b : PRONTO_BRANDS)
+    for (uint8_t i = 0; i < b.count; i++) {
+      context("%s %s", b.brand, b.codes[i].codeName);
+      body(b, b.codes[i]);
+    }
+  context("");
+}
+
+template<typename F> static void forEachBuiltIn(F body) {
+  for (uint16_t i = 0; i < IR_DB_CODE_COUNT; i++) {
+    const IRCodeEntry &e = IR_DB_CODES[i];
+    context("%s %s", IR_DB_BRANDS[e.brand], IR_DB_FUNCTIONS[e.function]);
+    IRSignal signal;
+    if (CHECK(irDbSignal(e, signal))) body(e, signal);
+  }
+  context("");
+}
+
+// The learned code a built-in row was generated from, if there was one
+static const IRCode *prontoFor(const IRCodeEntry &e) {
+  for (const ProntoBrand &b : PRONTO_BRANDS) {
+    if (strcmp(b.brand, IR_DB_BRANDS[e.brand])) continue;
+    for (uint8_t i = 0; i < b.count; i++)
+      if (!strcmp(b.codes[i].codeName, IR_DB_FUNCTIONS[e.function])) return &b.codes[i];
+  }
+  return nullptr;
+}
+
+// What IRremote reports when it decodes a frame of this protocol
+static decode_type_t decodeTypeFor(uint8_t protocol) {
+  switch (protocol) {
+    case IR_PROTO_NEC: return NEC;
+    case IR_PROTO_NEC2: return NEC2;
+    case IR_PROTO_NECX: return SAMSUNG;
+    case IR_PROTO_KASEIKYO: return KASEIKYO;
+    case IR_PROTO_KASEIKYO56: return PANASONIC;
+    case IR_PROTO_SONY12:
+    case IR_PROTO_SONY15:
+    case IR_PROTO_SONY20: return SONY;
+    case IR_PROTO_RC5: return RC5;
+    case IR_PROTO_RC6: return RC6;
+    default: return UNKNOWN;
+  }
+}
+
+static uint32_t protocolPeriodUs(uint8_t protocol) {
+  switch (protocol) {
+    case IR_PROTO_KASEIKYO:
+    case IR_PROTO_KASEIKYO56: return KASEIKYO_PERIOD_US;
+    case IR_PROTO_SONY12:
+    case IR_PROTO_SONY15:
+    case IR_PROTO_SONY20: return SONY_PERIOD_US;
+    case IR_PROTO_RC5: return RC5_PERIOD_US;
+    case IR_PROTO_RC6: return RC6_PERIOD_US;
+    default: return NEC_PERIOD_US;
+  }
+}
+
+// ------------------------------------------------------------
+// Signal model and protocol timing
+// ------------------------------------------------------------
+// Learned codes keep their once and repeat pairs apart, and each
+// section lasts what its Pronto words add up to, long gaps included,
+// give or take the rounding of each entry to whole µs
+TEST(testProntoSections, "signal/pronto-sections") {
+  forEachPronto([](const ProntoBrand &, const IRCode &code) {
+    const uint16_t *w = code.codeArray;
+    IRSignal signal;
+    if (!CHECK(prontoToSignal(w, IR_CODE_WORDS, signal))) return;
+    if (w[0] != 0x0000) {
+      CHECK(signal.repeatLen == 0);
+      return;
+    }
+    CHECK(signalOnceLen(signal) == w[2] * 2);
+    CHECK(signal.repeatLen == w[3] * 2);
+    double unit = w[1] * PRONTO_CLOCK_US, onceUs = 0, repeatUs = 0;
+    for (int i = 0; i < (w[2] + w[3]) * 2; i++) (i < w[2] * 2 ? onceUs : repeatUs) += w[4 + i] * unit;
+    if (w[2]) CHECK_NEAR(signalOncePeriodUs(signal), onceUs, w[2] * 2 * 0.5 + 1);
+    if (w[3]) CHECK_NEAR(signalRepeatPeriodUs(signal), repeatUs, w[3] * 2 * 0.5 + 1);
+  });
+}
+
+// NEC sends a frame and then repeat bursts, a Sony press is three frames
+// and every other protocol repeats its whole frame. Each frame is padded
+// to the protocol's period.
+TEST(testBuiltInPeriods, "signal/built-in-periods") {
+  forEachBuiltIn([](const IRCodeEntry &e, const IRSignal &signal) {
+    uint32_t period = protocolPeriodUs(e.protocol);
+    CHECK(signal.repeatLen > 0);
+    CHECK(signal.rawDataLen % 2 == 0);
+    CHECK_NEAR(signalRepeatPeriodUs(signal), period, 0);
+    if (e.protocol == IR_PROTO_NEC) {
+      CHECK_NEAR(signalOncePeriodUs(signal), period, 0);
+      CHECK(signal.repeatLen == 4);
+      CHECK_NEAR(signal.rawData[signalRepeatStart(signal)], 9000, 0);
+      CHECK_NEAR(signal.rawData[signalRepeatStart(signal) + 1], 2250, 0);
+    } else if (decodeTypeFor(e.protocol) == SONY) {
+      CHECK_NEAR(signalOncePeriodUs(signal), SONY_PRESS_FRAMES * period, 0);
+      if (CHECK(signalOnceLen(signal) == SONY_PRESS_FRAMES * signal.repeatLen))
+        for (uint8_t f = 0; f < SONY_PRESS_FRAMES; f++)
+          CHECK(!memcmp(&signal.rawData[f * signal.repeatLen], &signal.rawData[signalRepeatStart(signal)], signal.repeatLen * 2));
+    } else {
+      CHECK(signalOnceLen(signal) == 0);
+    }
+    // Every uint16_t entry but a clamped lead-out adds up to the period
+    uint32_t frameUs = 0;
+    for (uint8_t i = signalRepeatStart(signal); i + 1 < signal.rawDataLen; i++) frameUs += signal.rawData[i];
+    CHECK(frameUs < period);
+  });
+}
+
+// A built-in row decoded from a learned code sends what was learned:
+// the same sections, entry for entry within 12.5% (the worst is BenQ's,
+// learned a little long; receivers allow about 25%). Lead-outs are
+// padding to the period and may differ; a learned section that ends on
+// a mark (the LED strip's raw codes) has none.
+TEST(testBuiltInTimings, "signal/built-in-timings") {
+  forEachBuiltIn([](const IRCodeEntry &e, const IRSignal &signal) {
+    const IRCode *code = prontoFor(e);
+    if (!code) return;
+    IRSignal learned;
+    if (!CHECK(prontoToSignal(code->codeArray, IR_CODE_WORDS, learned))) return;
+    struct {
+      uint8_t start, len, learnedStart, learnedLen;
+    } sections[] = {
+      { 0, signalOnceLen(signal), 0, signalOnceLen(learned) },
+      { signalRepeatStart(signal), signal.repeatLen, signalRepeatStart(learned), learned.repeatLen },
+    };
+    for (auto &s : sections) {
+      if (!s.learnedLen) continue;
+      if (!CHECK(s.len == s.learnedLen + (s.learnedLen & 1))) continue;
+      for (uint8_t i = 0; i + 1 < s.len; i++) {
+        double want = learned.rawData[s.learnedStart + i];
+        CHECK_NEAR(signal.rawData[s.start + i], want, want * 0.125);
+      }
+    }
+  });
+}
+
+// The RC5 toggle bit (third of 14, Manchester with "1" as space then
+// mark) follows the toggle argument, and each Send press flips it
+TEST(testRc5Toggle, "signal/rc5-toggle") {
+  auto toggleBit = [](const IRSignal &signal) {
+    std::vector<bool> halves = { false };  // the leading space of the first "1" isn't sent
+    for (uint8_t i = 0; i + 1 < signal.repeatLen; i++)
+      for (int n = (signal.rawData[i] + RC5_HALF_BIT_US / 2) / RC5_HALF_BIT_US; n > 0; n--) halves.push_back((i & 1) == 0);
+    halves.resize(28, false);
+    return (bool)halves[2 * 2 + 1];
+  };
+  IRSignal signal;
+  for (bool toggle : { false, true }) {
+    context("toggle %d", toggle);
+    if (CHECK(generateSignal(IR_PROTO_RC5, 0x00, 0x0C, signal, toggle))) CHECK(toggleBit(signal) == toggle);
+  }
+  context("");
+  bool first = nextPressToggle();
+  CHECK(nextPressToggle() != first);
+}
+
+// A Sony tap sends its three frames in one go
+TEST(testSonyPress, "transmit/sony-press") {
+  forEachBuiltIn([](const IRCodeEntry &e, const IRSignal &signal) {
+    if (decodeTypeFor(e.protocol) != SONY) return;
+    host::sentIr().clear();
+    transmitSignal(signal);
+    holdRepeatActive = false;
+    if (!CHECK(host::sentIr().size() == 1)) return;
+    int leaders = 0;
+    for (uint16_t d : host::sentIr()[0].durations) leaders += d == SONY_UNIT_US * 4;
+    CHECK(leaders == SONY_PRESS_FRAMES);
+  });
+}
+
+// Holding Send re-sends the repeat section once per its period, with no
+// drift; a signal without one is sent once however long Send is held
+TEST(testHoldRepeatCadence, "transmit/hold-repeat-cadence") {
+  const uint32_t STEP_US = 100;
+  forEachBuiltIn([&](const IRCodeEntry &, const IRSignal &signal) {
+    host::sentIr().clear();
+    transmitSignal(signal);
+    CHECK(holdRepeatActive);
+    uint32_t firstUs = signalOnceLen(signal) ? signalOncePeriodUs(signal) : signalRepeatPeriodUs(signal);
+    for (uint64_t end = host::nowUs() + firstUs + 4 * signalRepeatPeriodUs(signal) + 1000; host::nowUs() < end;) {
+      serviceHeldTransmit();
+      host::advanceUs(STEP_US);
+    }
+    holdRepeatActive = false;
+    const std::vector<host::SentIr> &sent = host::sentIr();
+    if (!CHECK(sent.size() == 6)) return;
+    CHECK_NEAR(sent[1].atUs - sent[0].atUs, firstUs, STEP_US);
+    for (size_t i = 2; i < sent.size(); i++)
+      CHECK_NEAR(sent[i].atUs - sent[1].atUs, (i - 1) * (double)signalRepeatPeriodUs(signal), STEP_US);
+  });
+
+  IRSignal once;
+  if (!CHECK(prontoToSignal(LED_STRIP_CODES[0].codeArray, IR_CODE_WORDS, once))) return;
+  transmitSignal(once);
+  CHECK(!holdRepeatActive);
+}
+
+// ------------------------------------------------------------
+// Carrier
+// ------------------------------------------------------------
+// A built-in code goes out on its protocol's carrier: the one a capture
+// of it would be given, and within 1 kHz of the learned code it came
+// from. Receivers accept a few kHz either side.
+TEST(testBuiltInCarriers, "signal/built-in-carriers") {
+  forEachBuiltIn([](const IRCodeEntry &e, const IRSignal &signal) {
+    CHECK_NEAR(signalCarrierHz(signal), carrierForProtocol(decodeTypeFor(e.protocol)), 0);
+    if (const IRCode *code = prontoFor(e)) {
+      const uint16_t *w = code->codeArray;
+      CHECK_NEAR(signalCarrierHz(signal), w[0] == 0x0000 ? prontoCarrierHz(w[1]) : DEFAULT_CARRIER_HZ, 1000);
+    }
+  });
+}
+
+// The Pronto carrier word is carried through, e.g. 006D = 38.0 kHz
+TEST(testProntoCarriers, "signal/pronto-carriers") {
+  CHECK_NEAR(prontoCarrierHz(0x006D), 38029, 1);
+  CHECK_NEAR(prontoCarrierHz(0x0070), 37010, 1);
+  CHECK(prontoCarrierHz(0) == 0);
+  forEachPronto([](const ProntoBrand &, const IRCode &code) {
+    IRSignal signal;
+    if (!CHECK(prontoToSignal(code.codeArray, IR_CODE_WORDS, signal))) return;
+    if (code.codeArray[0] == 0x0000) CHECK(signal.carrierHz == prontoCarrierHz(code.codeArray[1]));
+    else CHECK(signalCarrierHz(signal) == DEFAULT_CARRIER_HZ);
+  });
+}
+
+// What goes out is on the signal's carrier, to the RMT divider's
+// resolution, for the first frame and the held repeats alike
+TEST(testSentCarrier, "transmit/sent-carrier") {
+  forEachBuiltIn([](const IRCodeEntry &, const IRSignal &signal) {
+    host::sentIr().clear();
+    transmitSignal(signal);
+    serviceHeldTransmit();
+    host::advanceUs(signalOncePeriodUs(signal) + signalRepeatPeriodUs(signal));
+    serviceHeldTransmit();
+    holdRepeatActive = false;
+    for (const host::SentIr &sent : host::sentIr()) CHECK_NEAR(sent.carrierHz, signalCarrierHz(signal), signalCarrierHz(signal) / 200.0);
+    CHECK(host::sentIr().size() >= 2);
+  });
+}
+
+// ------------------------------------------------------------
+// RMT encoding
+// ------------------------------------------------------------
+struct RmtHalf {
+  uint16_t ticks;
+  bool level;
+};
+
+// The halves up to the end marker, in order
+static std::vector<RmtHalf> rmtHalves(const RmtFrame &frame) {
+  std::vector<RmtHalf> halves;
+  for (uint16_t i = 0; i < frame.itemCount; i++) {
+    for (int h = 0; h < 2; h++) {
+      uint16_t half = frame.items[i] >> (16 * h);
+      if ((half & 0x7FFF) == 0) return halves;
+      halves.push_back({ (uint16_t)(half & 0x7FFF), (half >> 15) == 1 });
+    }
+  }
+  return halves;
+}
+
+TEST(testRmtCarrierTicks, "rmt/carrier-ticks") {
+  struct {
+    uint32_t hz;
+    uint16_t high, low;
+  } cases[] = { { 38000, 695, 1410 }, { 36000, 733, 1489 }, { 37000, 713, 1449 }, { 40000, 660, 1340 } };
+  for (auto &c : cases) {
+    context("%lu Hz", (unsigned long)c.hz);
+    uint16_t high, low;
+    rmtCarrierTicks(c.hz, RMT_SOURCE_CLOCK_HZ, high, low);
+    CHECK(high == c.high);
+    CHECK(low == c.low);
+    CHECK_NEAR(RMT_SOURCE_CLOCK_HZ / (double)(high + low), c.hz, c.hz / 1000.0);
+  }
+  context("");
+  // Too slow for the 16-bit counters: clamped, not wrapped
+  uint16_t high, low;
+  rmtCarrierTicks(1000, RMT_SOURCE_CLOCK_HZ, high, low);
+  CHECK(high + low == 0xFFFF);
+}
+
+// Edges are rounded on the running total, so they never drift more than
+// half a tick from where the durations put them
+TEST(testRmtRounding, "rmt/duration-rounding") {
+  const uint16_t durations[] = { 1000, 1000, 1000, 1000, 1000 };
+  RmtFrame frame;
+  CHECK(encodeRmtFrame(durations, 5, 0, 3000, frame));
+  std::vector<RmtHalf> halves = rmtHalves(frame);
+  if (!CHECK(halves.size() == 5)) return;
+  const uint16_t expected[] = { 333, 334, 333, 333, 334 };
+  for (int i = 0; i < 5; i++) {
+    CHECK(halves[i].ticks == expected[i]);
+    CHECK(halves[i].level == (i % 2 == 0));
+  }
+
+  forEachBuiltIn([](const IRCodeEntry &, const IRSignal &signal) {
+    const uint32_t TICK_NS = 12500;
+    uint16_t section[MAX_RAW_LEN];
+    copySection(signal, signalRepeatStart(signal), signal.repeatLen, section);
+    RmtFrame frame;
+    if (!CHECK(encodeRmtFrame(section, signal.repeatLen, 0, TICK_NS, frame))) return;
+    uint64_t edgeNs = 0, wantNs = 0;
+    size_t half = 0;
+    std::vector<RmtHalf> halves = rmtHalves(frame);
+    for (uint8_t i = 0; i < signal.repeatLen; i++) {
+      wantNs += section[i] * 1000ULL;
+      for (uint64_t end = (wantNs + TICK_NS / 2) / TICK_NS * TICK_NS; edgeNs < end && half < halves.size(); half++) {
+        CHECK(halves[half].level == (i % 2 == 0));
+        edgeNs += halves[half].ticks * (uint64_t)TICK_NS;
+      }
+      CHECK_NEAR((double)edgeNs, (double)wantNs, TICK_NS / 2);
+    }
+    CHECK(half == halves.size());
+  });
+}
+
+// Anything over 15 bits of ticks continues in the next half at the same
+// level, and a period longer than the durations stretches the lead-out
+TEST(testRmtLongSplit, "rmt/long-split") {
+  const uint16_t durations[] = { 9000, 65535, 560 };
+  RmtFrame frame;
+  CHECK(encodeRmtFrame(durations, 3, 200000, 1000, frame));
+  std::vector<RmtHalf> halves = rmtHalves(frame);
+  const RmtHalf expected[] = { { 9000, true },   { 32767, false }, { 32767, false }, { 1, false },
+                               { 560, true },    { 32767, false }, { 32767, false }, { 32767, false },
+                               { 26604, false } };
+  if (!CHECK(halves.size() == 9)) return;
+  for (int i = 0; i < 9; i++) {
+    context("half %d", i);
+    CHECK(halves[i].ticks == expected[i].ticks);
+    CHECK(halves[i].level == expected[i].level);
+  }
+  context("");
+  // An odd number of halves ends with a zero second half
+  CHECK(frame.itemCount == 5);
+  CHECK((frame.items[4] >> 16) == 0);
+
+  // More than RMT_MAX_ITEMS items: reported, not overrun
+  uint16_t long_[MAX_RAW_LEN];
+  for (uint16_t &d : long_) d = 65535;
+  CHECK(!encodeRmtFrame(long_, MAX_RAW_LEN, 0, 1000, frame));
+  CHECK(frame.truncated);
+  CHECK(frame.itemCount == RMT_MAX_ITEMS);
+}
+
+// Keyed by what goes on air: a renamed copy is a hit, a different
+// carrier is not, and a miss replaces the least recently used slot
+TEST(testRmtSignalCache, "rmt/signal-cache") {
+  RmtSignalCache cache;
+  IRSignal signals[RMT_CACHE_SLOTS + 1];
+  for (int i = 0; i <= RMT_CACHE_SLOTS; i++) generateSignal(IR_PROTO_NEC, 0x04, i, signals[i]);
+
+  const RmtCacheEntry *first = &cache.get(signals[0]);
+  IRSignal renamed = signals[0];
+  strcpy(renamed.name, "renamed");
+  CHECK(&cache.get(renamed) == first);
+  IRSignal otherCarrier = signals[0];
+  otherCarrier.carrierHz = 40000;
+  CHECK(signalContentKey(otherCarrier) != signalContentKey(signals[0]));
+
+  for (int i = 1; i < RMT_CACHE_SLOTS; i++) cache.get(signals[i]);  // full
+  const RmtCacheEntry *oldest = &cache.get(signals[1]);
+  cache.get(signals[0]);
+  for (int i = 2; i < RMT_CACHE_SLOTS; i++) cache.get(signals[i]);  // signals[1] is now least recently used
+  cache.get(signals[RMT_CACHE_SLOTS]);
+  CHECK(oldest->key == signalContentKey(signals[RMT_CACHE_SLOTS]));
+  CHECK(&cache.get(signals[0]) == first);
+
+  const RmtCacheEntry &entry = cache.get(signals[0]);
+  uint16_t high, low;
+  rmtCarrierTicks(signalCarrierHz(signals[0]), RMT_SOURCE_CLOCK_HZ, high, low);
+  CHECK(entry.carrierHighTicks == high && entry.carrierLowTicks == low);
+  uint32_t ticks = 0;
+  for (const RmtHalf &h : rmtHalves(entry.repeat)) ticks += h.ticks;
+  CHECK(ticks == signalRepeatPeriodUs(signals[0]));
+}
+
+// What the RMT stand-in plays back from the items is the signal itself;
+// only the lead-out may differ, stretched to the period or clamped
+TEST(testRmtSent, "rmt/sent-durations") {
+  forEachBuiltIn([](const IRCodeEntry &, const IRSignal &signal) {
+    host::sentIr().clear();
+    sendSignalSection(signal, true);
+    if (!CHECK(host::sentIr().size() == 1)) return;
+    const std::vector<uint16_t> &sent = host::sentIr()[0].durations;
+    if (!CHECK(sent.size() == signal.repeatLen)) return;
+    for (uint8_t i = 0; i + 1 < signal.repeatLen; i++) CHECK(sent[i] == signal.rawData[signalRepeatStart(signal) + i]);
+  });
+}
+
+// ------------------------------------------------------------
+// Waveform
+// ------------------------------------------------------------
+struct WaveInterval {
+  uint32_t startUs, us;
+  bool mark;
+};
+
+// The waveform screen's layout: once section then one repeat frame,
+// each padded to its period with space
+static std::vector<WaveInterval> waveIntervals(const IRSignal &signal) {
+  std::vector<WaveInterval> out;
+  uint32_t t = 0;
+  auto section = [&](uint8_t start, uint8_t len, uint32_t periodUs) {
+    uint32_t from = t;
+    for (uint8_t i = 0; i < len; i++) {
+      out.push_back({ t, signal.rawData[start + i], (i & 1) == 0 });
+      t += signal.rawData[start + i];
+    }
+    if (len && from + periodUs > t) {
+      out.push_back({ t, from + periodUs - t, false });
+      t = from + periodUs;
+    }
+  };
+  section(0, signalOnceLen(signal), signalOncePeriodUs(signal));
+  section(signalRepeatStart(signal), signal.repeatLen, signalRepeatPeriodUs(signal));
+  return out;
+}
+
+// What span() should say, from the durations one by one
+static void waveSpanExpected(const std::vector<WaveInterval> &intervals, uint32_t a, uint32_t b, bool &lo, bool &hi) {
+  lo = hi = false;
+  for (const WaveInterval &w : intervals) {
+    if (w.startUs >= b) break;
+    if (w.startUs + w.us <= a) continue;
+    (w.mark ? hi : lo) = true;
+  }
+  if (b > intervals.back().startUs + intervals.back().us) lo = true;  // idle past the end
+  lo = !lo;  // span() reports the lowest level: false once a space was seen
+}
+
+// Every edge lands on its own µs at the finest zoom, and coarser columns
+// see both levels exactly where a duration boundary falls inside them
+TEST(testWaveformSpans, "waveform/spans") {
+  static WaveformPyramid pyramid;
+  forEachBuiltIn([](const IRCodeEntry &, const IRSignal &signal) {
+    pyramid.build(signal);
+    std::vector<WaveInterval> intervals = waveIntervals(signal);
+    CHECK(pyramid.totalUs == intervals.back().startUs + intervals.back().us);
+    bool lo, hi;
+    for (size_t i = 0; i + 1 < intervals.size(); i++) {
+      const WaveInterval &w = intervals[i], &next = intervals[i + 1];
+      uint32_t end = w.startUs + w.us;
+      pyramid.span(w.startUs, end, lo, hi);
+      if (!CHECK(hi == w.mark && lo == w.mark)) return;
+      pyramid.span(end - 1, end + 1, lo, hi);
+      if (!CHECK(hi == (w.mark || next.mark) && lo == (w.mark && next.mark))) return;
+    }
+    for (uint32_t usPerPx : { 7u, 64u, 470u }) {
+      for (uint32_t a = 0; a < pyramid.totalUs + usPerPx; a += usPerPx) {
+        bool expectLo, expectHi;
+        waveSpanExpected(intervals, a, a + usPerPx, expectLo, expectHi);
+        pyramid.span(a, a + usPerPx, lo, hi);
+        if (!CHECK(lo == expectLo && hi == expectHi)) return;
+      }
+    }
+  });
+}
+
+// ------------------------------------------------------------
+// Loopback alignment
+// ------------------------------------------------------------
+// Each section of every built-in code goes through the simulated channel
+// and back through the alignment: a clean channel measures every
+// duration with no error, a stretching and jittery one still pairs every
+// edge and reports the stretch as mark and space bias, and a swallowed
+// leading mark only costs the two durations it closed.
+TEST(testLoopbackChannel, "loopback/simulated-channel") {
+  static LoopbackStats stretched;
+  stretched = LoopbackStats();
+  forEachBuiltIn([](const IRCodeEntry &, const IRSignal &signal) {
+    struct {
+      uint8_t start, len;
+    } sections[] = { { 0, signalOnceLen(signal) }, { signalRepeatStart(signal), signal.repeatLen } };
+    for (auto &section : sections) {
+      if (!section.len) continue;
+      uint16_t sent[MAX_RAW_LEN], recv[MAX_RAW_LEN];
+      copySection(signal, section.start, section.len, sent);
+      uint8_t durations = section.len & 1 ? section.len : section.len - 1;
+
+      SimulatedIrChannel clean;
+      clean.markStretchUs = 0;
+      clean.jitterUs = 0;
+      LoopbackStats stats;
+      alignLoopback(sent, section.len, recv, clean.transmit(sent, section.len, recv), stats);
+      CHECK(stats.sentDurations == durations);
+      CHECK(stats.measured == durations && stats.maxAbsErrUs == 0 && stats.extraEdges == 0);
+
+      SimulatedIrChannel noisy;
+      alignLoopback(sent, section.len, recv, noisy.transmit(sent, section.len, recv), stats);
+      CHECK(stats.measured == durations && stats.extraEdges == 0);
+      CHECK(stats.maxAbsErrUs <= noisy.markStretchUs + 2 * noisy.jitterUs);
+      stretched.merge(stats);
+
+      if (durations < 5) continue;
+      SimulatedIrChannel late;
+      late.swallowLeadMarks = 1;
+      alignLoopback(sent, section.len, recv, late.transmit(sent, section.len, recv), stats);
+      CHECK(stats.measured == durations - 2 && stats.extraEdges == 0);
+      CHECK(stats.maxAbsErrUs <= late.markStretchUs + 2 * late.jitterUs);
+    }
+  });
+  SimulatedIrChannel channel;
+  CHECK_NEAR(stretched.markBiasUs(), channel.markStretchUs, 3);
+  CHECK_NEAR(stretched.spaceBiasUs(), -channel.markStretchUs, 3);
+  CHECK(stretched.histogram[LoopbackStats::loopbackHistBin(channel.markStretchUs)] > 0);
+}
+
+// ------------------------------------------------------------
+// Receive stream
+// ------------------------------------------------------------
+// Plays mark/space durations into the segmenter as a receiver module
+// (active low) would produce them, starting with a mark at startUs.
+// Returns the time of the last edge: the start of the trailing space
+// for an odd count, of a mark still in progress for an even one.
+static uint32_t feedFrame(IrFrameSegmenter &seg, uint32_t startUs, std::initializer_list<uint16_t> durations) {
+  uint32_t t = startUs;
+  bool mark = true;
+  seg.feed(t, false);
+  for (uint16_t d : durations) {
+    t += d;
+    mark = !mark;
+    seg.feed(t, !mark);
+  }
+  return t;
+}
+
+// A space of IR_FRAME_GAP_US or more before a mark starts a new frame;
+// anything shorter stays inside the frame
+TEST(testSegmenterGap, "stream/gap-boundary") {
+  IrFrameQueue queue;
+  IrFrameSegmenter seg(queue);
+  uint32_t t = feedFrame(seg, 1000, { 9000, 4500, 560, IR_FRAME_GAP_US - 1, 560 });
+  t = feedFrame(seg, t + IR_FRAME_GAP_US, { 9000, 2250, 560 });
+  seg.poll(t + IR_FRAME_GAP_US);
+  if (!CHECK(queue.count == 2)) return;
+  const uint16_t first[] = { 9000, 4500, 560, IR_FRAME_GAP_US - 1, 560 };
+  CHECK(queue.at(0)->len == 5 && !memcmp(queue.at(0)->durations, first, sizeof(first)));
+  CHECK(queue.at(0)->startUs == 1000);
+  CHECK(queue.at(1)->len == 3 && queue.at(1)->durations[1] == 2250);
+  CHECK(seg.framesEmitted == 2);
+
+  // poll() closes a frame only after a full gap of idle line
+  IrFrameQueue q2;
+  IrFrameSegmenter seg2(q2);
+  t = feedFrame(seg2, 0, { 9000, 2250, 560 });
+  seg2.poll(t + IR_FRAME_GAP_US - 1);
+  CHECK(q2.count == 0);
+  seg2.poll(t + IR_FRAME_GAP_US);
+  CHECK(q2.count == 1);
+
+  // Bursts shorter than IR_MIN_FRAME_LEN are glitches; a repeated level
+  // is a missed edge and keeps the earlier timestamp
+  IrFrameQueue q3;
+  IrFrameSegmenter seg3(q3);
+  t = feedFrame(seg3, 0, { 300 });
+  seg3.poll(t + IR_FRAME_GAP_US);
+  CHECK(q3.count == 0 && seg3.framesEmitted == 0);
+  t += IR_FRAME_GAP_US;
+  seg3.feed(t, false);
+  seg3.feed(t + 500, true);
+  seg3.feed(t + 700, true);
+  seg3.feed(t + 1000, false);
+  seg3.feed(t + 1500, true);
+  seg3.poll(t + 1500 + IR_FRAME_GAP_US);
+  CHECK(q3.count == 1 && q3.front()->durations[1] == 500);
+}
+
+// A full ring refuses and counts edges rather than overwriting unread
+// ones, and keeps its order across index wrap-around
+TEST(testEdgeRingOverflow, "stream/ring-overflow") {
+  static IrEdgeRing ring;
+  for (int i = 0; i < IR_EDGE_RING_SIZE; i++) CHECK(ring.push(i * 10, i & 1));
+  CHECK(!ring.push(999999, true));
+  CHECK(ring.dropped == 1);
+  uint32_t timeUs;
+  bool level;
+  for (int i = 0; i < IR_EDGE_RING_SIZE; i++) {
+    if (!CHECK(ring.pop(timeUs, level))) break;
+    if (!CHECK(timeUs == (uint32_t)i * 10 && level == (i & 1))) break;
+  }
+  CHECK(!ring.pop(timeUs, level));
+
+  // The level lives in bit 0, so times lose their lowest bit
+  CHECK(ring.push(12345, false) && ring.pop(timeUs, level) && timeUs == 12344 && !level);
+
+  ring.head = ring.tail = 0xFFFFFFF0u;
+  for (uint32_t i = 0; i < 32; i++) CHECK(ring.push(i * 2, true));
+  for (uint32_t i = 0; i < 32; i++) CHECK(ring.pop(timeUs, level) && timeUs == i * 2);
+  CHECK(ring.head == 16);
+}
+
+// With every slot waiting for loop(), a new frame is still parsed (in
+// scratch) so the stream stays in step, but it is counted and dropped
+TEST(testFrameQueueFull, "stream/full-queue") {
+  IrFrameQueue queue;
+  IrFrameSegmenter seg(queue);
+  uint32_t t = 0;
+  for (int i = 0; i <= IR_FRAME_QUEUE_SLOTS; i++) t = feedFrame(seg, t + IR_FRAME_GAP_US, { 9000, 2250, (uint16_t)(560 + i) });
+  seg.poll(t + IR_FRAME_GAP_US);
+  CHECK(queue.count == IR_FRAME_QUEUE_SLOTS);
+  CHECK(seg.framesEmitted == IR_FRAME_QUEUE_SLOTS);
+  CHECK(seg.framesDropped == 1);
+  for (int i = 0; i < IR_FRAME_QUEUE_SLOTS; i++) CHECK(queue.at(i)->durations[2] == 560 + i);
+
+  // Once loop() takes one, the next frame is queued again
+  queue.pop();
+  t = feedFrame(seg, t + 2 * IR_FRAME_GAP_US, { 9000, 2250, 777 });
+  seg.poll(t + IR_FRAME_GAP_US);
+  CHECK(queue.count == IR_FRAME_QUEUE_SLOTS);
+  CHECK(queue.at(IR_FRAME_QUEUE_SLOTS - 1)->durations[2] == 777);
+
+  // clear() while a frame is being written keeps that slot for it
+  queue.clear();
+  t = feedFrame(seg, t + 2 * IR_FRAME_GAP_US, { 9000, 2250, 560 });
+  t = feedFrame(seg, t + IR_FRAME_GAP_US, { 9000, 4500 });
+  CHECK(queue.count == 1);
+  queue.clear();
+  seg.feed(t + 560, true);
+  seg.poll(t + 560 + IR_FRAME_GAP_US);
+  CHECK(queue.count == 1 && queue.front()->len == 3 && queue.front()->durations[2] == 560);
+}
+
+// A frame longer than MAX_RAW_LEN keeps its first entries and says so
+TEST(testFrameOverflow, "stream/frame-overflow") {
+  IrFrameQueue queue;
+  IrFrameSegmenter seg(queue);
+  uint32_t t = 0;
+  bool level = false;
+  for (int i = 0; i < MAX_RAW_LEN + 12; i++, t += 500, level = !level) seg.feed(t, level);
+  seg.poll(t + IR_FRAME_GAP_US);
+  if (!CHECK(queue.count == 1)) return;
+  CHECK(queue.front()->len == MAX_RAW_LEN);
+  CHECK(queue.front()->overflow);
+}
+
+// ------------------------------------------------------------
+// Kinetic scrolling
+// ------------------------------------------------------------
+// A finger sliding along y at pxPerMs for ms, read every SCROLL_POLL_MS
+// (a little late, as loop() is) with up to noisePx of panel noise, goes
+// through a TouchFilter into v as the sketch feeds it. Noise and timing
+// come from a fixed LCG, so every run sees the same trace. Returns the
+// time of the last reading.
+static uint32_t feedSwipe(ScrollVelocity &v, TouchFilter &filter, uint32_t t0, float y0, float pxPerMs, uint32_t ms,
+                          float noisePx) {
+  uint32_t seed = 2463534242u, t = t0;
+  auto next = [&seed]() {
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0f;  // 0..1
+  };
+  for (uint32_t at = 0; at <= ms; at += SCROLL_POLL_MS) {
+    t = t0 + at * 1000 + (uint32_t)(next() * 800);
+    float y = y0 + pxPerMs * (t - t0) / 1000.0f + (2 * next() - 1) * noisePx;
+    filter.add(t, 120, y, 1000);
+    v.add(t, filter.y());
+  }
+  return t;
+}
+
+// The release speed is the finger's, clean or noisy, and a finger that
+// stopped before lifting doesn't fling
+TEST(testScrollVelocity, "scroll/velocity") {
+  for (float speed : { 0.5f, 1.5f, 4.0f, -1.5f }) {
+    for (float noise : { 0.0f, 2.0f }) {
+      context("%.1f px/ms, noise %.0f px", speed, noise);
+      ScrollVelocity v;
+      TouchFilter filter;
+      uint32_t t = feedSwipe(v, filter, 1000000, speed > 0 ? 20 : 300, speed, 250, noise);
+      CHECK_NEAR(v.perMs(t), speed, 0.05 * fabsf(speed) + 0.05 * noise);
+
+      // Held still for longer than the window: no fling
+      float y = filter.y();
+      for (uint32_t at = SCROLL_POLL_MS; at <= 150; at += SCROLL_POLL_MS) {
+        filter.add(t + at * 1000, 120, y, 1000);
+        v.add(t + at * 1000, filter.y());
+      }
+      CHECK(fabsf(v.perMs(t + 150000)) < FLING_MIN_VELOCITY);
+    }
+  }
+  context("");
+  ScrollVelocity v;
+  CHECK(v.perMs(0) == 0);
+  v.add(1000, 50);
+  CHECK(v.perMs(1000) == 0);
+}
+
+// A fling covers velocity * FLING_TAU_MS, less the tail under
+// FLING_STOP_VELOCITY, however the frames fall
+TEST(testScrollFling, "scroll/fling") {
+  static const uint32_t STEADY[] = { SCROLL_FRAME_US };
+  static const uint32_t UNEVEN[] = { 5000, 41000, 17000, 90000, 33333, 250000, 8000 };
+  static const uint32_t ONE_JUMP[] = { 5000000 };
+  struct Schedule {
+    const char *name;
+    const uint32_t *stepsUs;
+    size_t n;
+  };
+  const Schedule schedules[] = { { "steady", STEADY, 1 }, { "uneven", UNEVEN, 7 }, { "one jump", ONE_JUMP, 1 } };
+  for (float v0 : { 2.0f, -0.8f, 20.0f }) {
+    float v = v0 > FLING_MAX_VELOCITY ? FLING_MAX_VELOCITY : v0;
+    for (const Schedule &s : schedules) {
+      context("%.1f px/ms, %s frames", v0, s.name);
+      ScrollFling fling;
+      fling.start(v0, 1000);
+      CHECK(fling.active && fling.velocity == v);
+      float total = 0;
+      uint32_t t = 1000;
+      for (size_t i = 0; fling.active && i < 10000; i++) {
+        t += s.stepsUs[i % s.n];
+        total += fling.advance(t);
+      }
+      CHECK(!fling.active && fling.advance(t + 1000) == 0);
+      float tail = FLING_STOP_VELOCITY * FLING_TAU_MS;
+      CHECK_NEAR(total, v * FLING_TAU_MS - (v > 0 ? tail : -tail) / 2, tail / 2 + 0.01f);
+    }
+  }
+  context("");
+  ScrollFling slow;
+  slow.start(FLING_MIN_VELOCITY / 2, 1000);
+  CHECK(!slow.active && slow.advance(100000) == 0);
+}
+
+// Frames land on a fixed grid while polls come every SCROLL_POLL_MS and
+// drawing takes time; a frame late by a whole period restarts the grid
+// instead of firing the missed frames back to back
+TEST(testFramePacer, "scroll/frame-pacer") {
+  FramePacer pacer(SCROLL_FRAME_US);
+  uint32_t t0 = 7000000, t = t0;
+  pacer.restart(t0);
+  std::vector<uint32_t> frames;
+  while (t - t0 < 1000000) {
+    if (pacer.due(t)) {
+      frames.push_back(t);
+      t += 12000;  // drawing
+    }
+    t += SCROLL_POLL_MS * 1000;
+  }
+  CHECK_NEAR(frames.size(), 1000000.0 / SCROLL_FRAME_US, 1);
+  for (size_t i = 0; i < frames.size(); i++) {
+    context("frame %zu", i);
+    uint32_t grid = t0 + i * SCROLL_FRAME_US;
+    CHECK(frames[i] >= grid && frames[i] - grid < SCROLL_POLL_MS * 1000);
+  }
+  context("");
+
+  // A 100 ms stall: one frame, then a full period before the next
+  t = frames.back() + 100000;
+  CHECK(pacer.due(t));
+  CHECK(!pacer.due(t + 1000));
+  CHECK(!pacer.due(t + SCROLL_FRAME_US - 1));
+  CHECK(pacer.due(t + SCROLL_FRAME_US));
+}
+
+// ------------------------------------------------------------
+// Touch filter
+// ------------------------------------------------------------
+// Raw panel readings as irtrace --touch exports them from a device's
+// trace dump, and as the host's "touch FILE" replays them. The traces
+// in scripts/touch say in their header what they hold.
+struct TouchRead {
+  uint32_t us;
+  int32_t x, y;
+  uint16_t z;
+};
+
+static std::vector<TouchRead> loadTouchTrace(const char *name) {
+  std::vector<TouchRead> reads;
+  std::ifstream f(std::string(TOUCH_TRACE_DIR "/") + name);
+  std::string line;
+  while (std::getline(f, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream in(line);
+    TouchRead r;
+    if (in >> r.us >> r.x >> r.y >> r.z) reads.push_back(r);
+  }
+  context("%s", name);
+  CHECK(!reads.empty());
+  context("");
+  return reads;
+}
+
+// What readTouch hands the filter: screen pixels by TOUCH_CAL_DEFAULT
+static bool addTouchRead(TouchFilter &filter, const TouchRead &r) {
+  return filter.add(r.us, TOUCH_CAL_DEFAULT.x(r.x, tft.width()), TOUCH_CAL_DEFAULT.y(r.y, tft.height()), r.z);
+}
+
+// A press starts at TOUCH_PRESS_Z, survives reads between the two
+// thresholds and single light ones, and ends after TOUCH_LIFT_SAMPLES
+// light reads in a row; readings between the thresholds don't start one
+TEST(testTouchPressure, "touch/pressure-hysteresis") {
+  std::vector<TouchRead> reads = loadTouchTrace("press-light.txt");
+  TouchFilter filter;
+  int presses = 0, inBand = 0, loneLight = 0, lightRun = 0;
+  bool down = false;
+  for (size_t i = 0; i < reads.size(); i++) {
+    context("press-light.txt read %zu, z %u", i, reads[i].z);
+    bool wasDown = down;
+    down = addTouchRead(filter, reads[i]);
+    bool light = reads[i].z < TOUCH_LIFT_Z;
+    lightRun = light ? lightRun + 1 : 0;
+    if (down && !wasDown) {
+      presses++;
+      CHECK(reads[i].z >= TOUCH_PRESS_Z);
+    }
+    if (!wasDown) CHECK(down == (reads[i].z >= TOUCH_PRESS_Z));
+    else if (lightRun >= TOUCH_LIFT_SAMPLES) CHECK(!down);
+    else CHECK(down && filter.lifting == light);
+    if (wasDown && !light && reads[i].z < TOUCH_PRESS_Z) inBand++;
+    if (wasDown && down && light) loneLight++;
+  }
+  context("");
+  CHECK(presses == 1 && !down);
+  CHECK(inBand >= 3 && loneLight >= 2);  // the trace has what it says
+
+  // The noisy traces' single light reads don't split them either
+  for (const char *name : { "hold-noisy.txt", "swipe-noisy.txt" }) {
+    context("%s", name);
+    TouchFilter f;
+    bool all = true;
+    for (const TouchRead &r : loadTouchTrace(name)) all = addTouchRead(f, r) && all;
+    CHECK(all);
+  }
+  context("");
+}
+
+// A single wild reading doesn't move the output: a still finger stays
+// put, and a swipe doesn't step towards a reading far off its path
+TEST(testTouchOutliers, "touch/median-outliers") {
+  std::vector<TouchRead> hold = loadTouchTrace("hold-noisy.txt");
+  TouchFilter filter;
+  float rawWorst = 0;
+  for (size_t i = 0; i < hold.size(); i++) {
+    context("hold-noisy.txt read %zu", i);
+    addTouchRead(filter, hold[i]);
+    rawWorst = fmaxf(rawWorst, fabsf(TOUCH_CAL_DEFAULT.x(hold[i].x, tft.width()) - 120));
+    CHECK_NEAR(filter.x(), 120, 3);
+    CHECK_NEAR(filter.y(), 100, 3);
+  }
+  context("");
+  CHECK(rawWorst > 15);
+
+  std::vector<TouchRead> swipe = loadTouchTrace("swipe-noisy.txt");
+  std::vector<float> rawY;
+  for (const TouchRead &r : swipe) rawY.push_back(TOUCH_CAL_DEFAULT.y(r.y, tft.height()));
+  TouchFilter f;
+  float lastY = 0;
+  int outliers = 0;
+  for (size_t i = 0; i < swipe.size(); i++) {
+    context("swipe-noisy.txt read %zu", i);
+    addTouchRead(f, swipe[i]);
+    // The finger covers 3.2 px a read; a reading 25 px off the line
+    // between its neighbours is off its path, and the output moves
+    // towards it by no more than the finger would
+    float offPath = i && i + 1 < swipe.size() ? rawY[i] - (rawY[i - 1] + rawY[i + 1]) / 2 : 0;
+    if (!f.lifting && fabsf(offPath) > 25) {
+      outliers++;
+      CHECK(fabsf(f.y() - lastY) < fabsf(offPath) / 4);
+    }
+    lastY = f.y();
+  }
+  context("");
+  CHECK(outliers >= 3);
+}
+
+// While the finger moves, the output trails the median of the last
+// TOUCH_MEDIAN_SAMPLES readings by at most TOUCH_MAX_LAG_PX, and lagUs
+// stays within one read interval plus TOUCH_MAX_SMOOTH_LAG_US
+TEST(testTouchLagBound, "touch/lag-bound") {
+  std::vector<TouchRead> swipe = loadTouchTrace("swipe-noisy.txt");
+  TouchFilter filter;
+  float windowX[TOUCH_MEDIAN_SAMPLES], windowY[TOUCH_MEDIAN_SAMPLES];
+  auto median = [](const float *v) {
+    float s[TOUCH_MEDIAN_SAMPLES];
+    memcpy(s, v, sizeof(s));
+    std::sort(s, s + TOUCH_MEDIAN_SAMPLES);
+    return s[TOUCH_MEDIAN_SAMPLES / 2];
+  };
+  size_t kept = 0;
+  int moving = 0;
+  uint32_t lastUs = 0;  // the last reading the filter took
+  for (size_t i = 0; i < swipe.size(); i++) {
+    context("swipe-noisy.txt read %zu", i);
+    addTouchRead(filter, swipe[i]);
+    if (filter.lifting) continue;
+    uint32_t dtUs = swipe[i].us - lastUs;
+    lastUs = swipe[i].us;
+    windowX[kept % TOUCH_MEDIAN_SAMPLES] = TOUCH_CAL_DEFAULT.x(swipe[i].x, tft.width());
+    windowY[kept % TOUCH_MEDIAN_SAMPLES] = TOUCH_CAL_DEFAULT.y(swipe[i].y, tft.height());
+    if (++kept < TOUCH_MEDIAN_SAMPLES || !filter.moving) continue;
+    moving++;
+    CHECK(hypotf(filter.x() - median(windowX), filter.y() - median(windowY)) <= TOUCH_MAX_LAG_PX + 0.01f);
+    CHECK(filter.lagUs <= dtUs + TOUCH_MAX_SMOOTH_LAG_US);
+  }
+  context("");
+  CHECK(moving >= 30);
+}
+
+// ------------------------------------------------------------
+// Session log
+// ------------------------------------------------------------
+// A session file in memory, read back as readSessionRecord reads a File
+struct ByteSource {
+  std::vector<uint8_t> bytes;
+  size_t at = 0;
+
+  size_t read(uint8_t *p, size_t n) {
+    if (n > bytes.size() - at) n = bytes.size() - at;
+    memcpy(p, bytes.data() + at, n);
+    at += n;
+    return n;
+  }
+};
+
+// What serviceSessionRecorder writes: whole sectors, each contiguous in
+// the buffer, then on stop whatever is left
+static void drainSession(SessionWriteBuffer &buf, std::vector<uint8_t> &out, bool stopping) {
+  while (buf.sectorReady()) {
+    CHECK(buf.contiguous() >= (uint32_t)SESSION_SECTOR_BYTES);
+    out.insert(out.end(), buf.peek(), buf.peek() + SESSION_SECTOR_BYTES);
+    buf.consume(SESSION_SECTOR_BYTES);
+  }
+  while (stopping && buf.pending()) {
+    uint32_t n = buf.contiguous();
+    out.insert(out.end(), buf.peek(), buf.peek() + n);
+    buf.consume(n);
+  }
+}
+
+// Frames of every length go through the buffer many times over its
+// size, with micros() wrapping on the way, and read back as recorded
+TEST(testSessionRoundTrip, "session/round-trip") {
+  static SessionWriteBuffer buf;
+  std::vector<uint8_t> file;
+  std::vector<std::vector<uint16_t>> frames;
+  std::vector<uint32_t> deltas;
+  buf.reset();
+  uint32_t startUs = 0xFFFF0000u, nowMs = 5000;
+  for (int i = 0; i < 300; i++) {
+    std::vector<uint16_t> d(1 + (i * 37) % MAX_RAW_LEN);
+    for (size_t j = 0; j < d.size(); j++) d[j] = (uint16_t)(100 + i * 7 + j * 13);
+    uint32_t delta = i ? 500 + (i * 7919) % 400000 : 0;
+    startUs += delta;
+    nowMs += delta / 1000;
+    CHECK(buf.addFrame(startUs, nowMs, d.data(), d.size(), i % 50 == 49));
+    frames.push_back(d);
+    deltas.push_back(delta);
+    drainSession(buf, file, false);
+  }
+  drainSession(buf, file, true);
+  CHECK(buf.framesRecorded == 300 && buf.framesDropped == 0);
+  CHECK(file.size() == buf.bytesTotal() && file.size() > 8 * SESSION_BUFFER_BYTES);
+
+  ByteSource src { file };
+  CHECK(readSessionHeader(src));
+  static SessionRecord r;
+  for (size_t i = 0; i < frames.size(); i++) {
+    context("frame %zu", i);
+    if (!CHECK(readSessionRecord(src, r))) break;
+    CHECK(r.header.deltaUs == deltas[i]);
+    CHECK(r.header.flags == (i % 50 == 49 ? SESSION_FLAG_OVERFLOW : 0));
+    CHECK(r.header.len == frames[i].size() && !memcmp(r.durations, frames[i].data(), r.header.len * 2));
+  }
+  context("");
+  CHECK(!readSessionRecord(src, r));
+}
+
+// A full buffer drops the frame without blocking and flags the next one
+// that fits
+TEST(testSessionDrops, "session/drops") {
+  static SessionWriteBuffer buf;
+  std::vector<uint8_t> file;
+  uint16_t d[MAX_RAW_LEN];
+  for (int i = 0; i < MAX_RAW_LEN; i++) d[i] = 560;
+  uint32_t t = 1000, kept = 0;
+  auto add = [&](uint8_t len) {
+    t += 100000;  // 100 ms apart
+    return buf.addFrame(t, t / 1000, d, len, false);
+  };
+  buf.reset();
+  while (add(MAX_RAW_LEN)) kept++;
+  CHECK(kept == (SESSION_BUFFER_BYTES - sizeof(SessionFileHeader)) / (sizeof(SessionRecordHeader) + sizeof(d)));
+  CHECK(!add(MAX_RAW_LEN));
+  CHECK(buf.framesDropped == 2 && buf.framesRecorded == kept);
+
+  drainSession(buf, file, false);
+  CHECK(add(4));
+  CHECK(add(4));
+  drainSession(buf, file, true);
+
+  ByteSource src { file };
+  static SessionRecord r;
+  CHECK(readSessionHeader(src));
+  for (uint32_t i = 0; i < kept; i++) CHECK(readSessionRecord(src, r) && r.header.flags == 0);
+  CHECK(readSessionRecord(src, r) && r.header.flags == SESSION_FLAG_AFTER_DROP && r.header.deltaUs == 300000);
+  CHECK(readSessionRecord(src, r) && r.header.flags == 0 && r.header.len == 4);
+  CHECK(!readSessionRecord(src, r));
+}
+
+// Gaps under SESSION_MAX_GAP_MS keep their length; longer ones, even
+// ones micros() wrapped over, are logged as SESSION_MAX_GAP_MS and flagged
+TEST(testSessionLongGap, "session/long-gap") {
+  static SessionWriteBuffer buf;
+  std::vector<uint8_t> file;
+  uint16_t d[4] = { 9000, 4500, 560, 560 };
+  struct Gap {
+    uint64_t us;
+    uint32_t deltaUs;
+    uint8_t flags;
+  };
+  const uint64_t maxUs = SESSION_MAX_GAP_MS * 1000ull;
+  const Gap gaps[] = {
+    { 1000000, 1000000, 0 },
+    { maxUs - 1000, (uint32_t)maxUs - 1000, 0 },
+    { maxUs, (uint32_t)maxUs, SESSION_FLAG_LONG_GAP },
+    { 75 * 60 * 1000000ull, (uint32_t)maxUs, SESSION_FLAG_LONG_GAP },      // micros() wrapped once
+    { 0x100000000ull + 2000, (uint32_t)maxUs, SESSION_FLAG_LONG_GAP },  // wrapped to a 2 ms delta
+  };
+  buf.reset();
+  uint64_t us = 123456789;
+  CHECK(buf.addFrame((uint32_t)us, us / 1000, d, 4, false));
+  for (const Gap &g : gaps) {
+    us += g.us;
+    CHECK(buf.addFrame((uint32_t)us, (uint32_t)(us / 1000), d, 4, false));
+  }
+  drainSession(buf, file, true);
+
+  ByteSource src { file };
+  static SessionRecord r;
+  CHECK(readSessionHeader(src) && readSessionRecord(src, r) && r.header.deltaUs == 0);
+  for (const Gap &g : gaps) {
+    context("gap %llu us", (unsigned long long)g.us);
+    CHECK(readSessionRecord(src, r) && r.header.deltaUs == g.deltaUs && r.header.flags == g.flags);
+  }
+  context("");
+}
+
+// The reader stops at a foreign header, an impossible length or a
+// record cut short
+TEST(testSessionBadRecords, "session/bad-records") {
+  SessionFileHeader fh = { SESSION_MAGIC, SESSION_VERSION + 1, 0 };
+  ByteSource wrongVersion { std::vector<uint8_t>((uint8_t *)&fh, (uint8_t *)(&fh + 1)) };
+  CHECK(!readSessionHeader(wrongVersion));
+  ByteSource empty;
+  CHECK(!readSessionHeader(empty));
+
+  static SessionRecord r;
+  SessionRecordHeader rh = { 1000, MAX_RAW_LEN + 1, 0 };
+  ByteSource tooLong { std::vector<uint8_t>((uint8_t *)&rh, (uint8_t *)(&rh + 1)) };
+  tooLong.bytes.resize(tooLong.bytes.size() + (MAX_RAW_LEN + 1) * 2);
+  CHECK(!readSessionRecord(tooLong, r));
+
+  rh.len = 10;
+  ByteSource cut { std::vector<uint8_t>((uint8_t *)&rh, (uint8_t *)(&rh + 1)) };
+  cut.bytes.resize(cut.bytes.size() + 19);
+  CHECK(!readSessionRecord(cut, r));
+}
+
+// ------------------------------------------------------------
+// Runner
+// ------------------------------------------------------------
+int main(int argc, char **argv) {
+  const char *filter = "";
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [--filter TEXT]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  host::setSerialEcho(false);
+  setup();
+
+  int run = 0, failed = 0;
+  for (const Test &t : tests()) {
+    if (!strstr(t.name, filter)) continue;
+    int before = testFailures;
+    t.body();
+    run++;
+    bool ok = testFailures == before;
+    if (!ok) failed++;
+    printf("%-40s %s\n", t.name, ok ? "ok" : "FAILED");
+  }
+  printf("%d of %d tests failed\n", failed, run);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,719 @@
+// ============================================================
+// irpack — host-side code importer
+// ============================================================
+// Bulk-converts Pronto text (v4/IR-codes.txt layout), LIRC .conf and
+// Flipper .ir files into the device's signal pack plus its search word
+// index (signals.irx beside signals.irp), and optionally into
+// /saved-signals .bin files. Uses the sketch's own headers, so what it
+// writes is exactly what the device reads.
+//
+//   g++ -std=c++17 -O2 -pthread -o irpack v5/tools/irpack.cpp
+//   ./irpack -o signals.irp v4/IR-codes.txt flipper-irdb/ lirc-remotes/
+//
+// Files are parsed in parallel, one file per worker. Names are
+// normalised, raw timings quantised, duplicates dropped, and every
+// rejected entry is reported with its file and line.
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../uniremote/IR-signal.h"
+#include "../uniremote/IR-protocols.h"
+#include "../uniremote/IR-pack.h"
+#include "../uniremote/IR-search.h"
+
+namespace fs = std::filesystem;
+
+constexpr uint32_t DEFAULT_LEAD_OUT_US = 40000;  // raw frames that end on a mark
+constexpr uint16_t QUANTISE_MAX_US = 20000;      // longer entries are gaps, left alone
+constexpr int QUANTISE_TOLERANCE_PCT = 12;
+constexpr uint16_t QUANTISE_STEP_US = 5;
+constexpr size_t REJECTS_SHOWN = 50;
+
+struct ImportedCode {
+  std::string brand, name, source;
+  uint8_t kind = PACK_KIND_RAW;
+  uint8_t protocol = 0;
+  uint32_t address = 0;
+  uint16_t command = 0;
+  IRSignal raw;
+};
+
+struct Rejected {
+  std::string source, reason;
+};
+
+struct ParseResult {
+  std::vector<ImportedCode> codes;
+  std::vector<Rejected> rejected;
+};
+
+// ============================================================
+// Normalising
+// ============================================================
+std::string trim(const std::string &s) {
+  size_t a = s.find_first_not_of(" \t\r\n"), b = s.find_last_not_of(" \t\r\n");
+  return a == std::string::npos ? "" : s.substr(a, b - a + 1);
+}
+
+// Upper case, '_' and runs of blanks become one space, trimmed to what
+// a pack name holds
+std::string normaliseName(const std::string &in) {
+  std::string out;
+  for (char c : in) {
+    unsigned char u = (unsigned char)c;
+    if (c == '_' || isspace(u)) {
+      if (!out.empty() && out.back() != ' ') out += ' ';
+    } else if (isprint(u)) {
+      out += (char)toupper(u);
+    }
+  }
+  out = trim(out);
+  if (out.size() > PACK_NAME_CHARS - 1) out = trim(out.substr(0, PACK_NAME_CHARS - 1));
+  return out;
+}
+
+// LIRC and Flipper key names: "KEY_POWER" -> "POWER"
+std::string normaliseKeyName(const std::string &in) {
+  std::string s = trim(in);
+  if (s.size() > 4 && strncasecmp(s.c_str(), "KEY_", 4) == 0) s = s.substr(4);
+  return normaliseName(s);
+}
+
+// Files and LIRC remotes are usually one remote model each, so the
+// whole name becomes the brand: "Samsung_BN59-00685A" -> "SAMSUNG BN59-00685A".
+// Cutting it down to the maker would collide every model's POWER key.
+std::string brandFromName(const std::string &name) {
+  return normaliseName(name);
+}
+
+// Snaps marks and spaces that lie within a few percent of each other to
+// their cluster mean, so learned jitter doesn't survive into the pack
+// and equal codes learned twice compare equal
+void quantiseDurations(IRSignal &signal) {
+  for (int parity = 0; parity < 2; parity++) {
+    std::vector<uint16_t> values;
+    for (uint8_t i = parity; i < signal.rawDataLen; i += 2)
+      if (signal.rawData[i] <= QUANTISE_MAX_US) values.push_back(signal.rawData[i]);
+    std::sort(values.begin(), values.end());
+    std::map<uint16_t, uint16_t> snapped;
+    for (size_t i = 0; i < values.size();) {
+      size_t j = i;
+      uint32_t sum = 0;
+      while (j < values.size() && values[j] <= values[i] + values[i] * QUANTISE_TOLERANCE_PCT / 100) sum += values[j++];
+      uint32_t mean = (sum / (j - i) + QUANTISE_STEP_US / 2) / QUANTISE_STEP_US * QUANTISE_STEP_US;
+      for (size_t k = i; k < j; k++) snapped[values[k]] = mean ? (uint16_t)mean : values[k];
+      i = j;
+    }
+    for (uint8_t i = parity; i < signal.rawDataLen; i += 2) {
+      auto it = snapped.find(signal.rawData[i]);
+      if (it != snapped.end()) signal.rawData[i] = it->second;
+    }
+  }
+}
+
+// Mark/space list to a repeat-only signal with a lead-out gap
+bool rawToSignal(const std::vector<uint32_t> &durations, uint32_t carrierHz, uint32_t gapUs, IRSignal &out) {
+  SignalBuilder b(out);
+  for (size_t i = 0; i < durations.size(); i++) b.add(durations[i], (i & 1) == 0);
+  if (out.rawDataLen == 0 || b.overflow) return false;
+  uint32_t frameUs = b.sectionUs();
+  uint32_t leadOut = (durations.size() & 1) ? (gapUs ? gapUs : DEFAULT_LEAD_OUT_US) : 0;
+  uint32_t period = b.endSection(frameUs + leadOut, 0);
+  b.repeatDone(period, 0);
+  out.carrierHz = carrierHz;
+  if (b.overflow || out.rawDataLen > MAX_RAW_LEN) return false;
+  quantiseDurations(out);
+  return true;
+}
+
+bool parseUint(const std::string &s, uint32_t &out, int base = 0) {
+  if (s.empty()) return false;
+  char *end = nullptr;
+  unsigned long long v = strtoull(s.c_str(), &end, base);
+  if (*end != '\0' || v > UINT32_MAX) return false;
+  out = (uint32_t)v;
+  return true;
+}
+
+std::string sourceOf(const std::string &path, int line) {
+  return path + ":" + std::to_string(line);
+}
+
+// ============================================================
+// Pronto text
+// ============================================================
+// "Brand:" on its own line starts a brand, "NAME: 0000 006D ..." adds a
+// code to it. Codes before the first brand line take the file's name.
+void parseProntoText(const std::string &path, const std::string &text, const std::string &brandOverride, ParseResult &res) {
+  std::istringstream in(text);
+  std::string line, brand = brandOverride.empty() ? brandFromName(fs::path(path).stem().string()) : brandOverride;
+  int lineNo = 0;
+  while (std::getline(in, line)) {
+    lineNo++;
+    line = trim(line);
+    if (line.empty() || line[0] == '#') continue;
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+      res.rejected.push_back({ sourceOf(path, lineNo), "no ':' between name and code" });
+      continue;
+    }
+    std::string name = trim(line.substr(0, colon)), words = trim(line.substr(colon + 1));
+    if (words.empty()) {
+      if (brandOverride.empty()) brand = normaliseName(name);
+      continue;
+    }
+    std::vector<uint16_t> pronto;
+    std::istringstream ws(words);
+    std::string word;
+    bool bad = false;
+    while (ws >> word) {
+      uint32_t v;
+      if (word.size() != 4 || !parseUint(word, v, 16)) {
+        bad = true;
+        break;
+      }
+      pronto.push_back((uint16_t)v);
+    }
+    ImportedCode code;
+    code.brand = brand;
+    code.name = normaliseName(name);
+    code.source = sourceOf(path, lineNo);
+    if (bad || pronto.empty()) {
+      res.rejected.push_back({ code.source, "'" + word + "' is not a 4-digit hex word" });
+      continue;
+    }
+    memset(&code.raw, 0, sizeof(IRSignal));
+    if (!prontoToSignal(pronto.data(), (uint16_t)pronto.size(), code.raw)) {
+      res.rejected.push_back({ code.source, "Pronto code is malformed or longer than " + std::to_string(MAX_RAW_LEN) + " entries" });
+      continue;
+    }
+    quantiseDurations(code.raw);
+    res.codes.push_back(code);
+  }
+}
+
+// ============================================================
+// LIRC
+// ============================================================
+// Handles RAW_CODES remotes and SPACE_ENC (pulse-distance) remotes,
+// which covers NEC, Samsung, Kaseikyo and most other learned configs.
+// Bi-phase remotes (RC5, RC6, SHIFT_ENC) are reported, not guessed at.
+struct LircRemote {
+  std::string name;
+  bool raw = false, constLength = false, reverse = false;
+  std::string unsupported;
+  uint32_t bits = 0, preBits = 0, postBits = 0;
+  uint64_t pre = 0, post = 0;
+  uint32_t header[2] = { 0, 0 }, one[2] = { 0, 0 }, zero[2] = { 0, 0 };
+  uint32_t plead = 0, ptrail = 0, gap = 0, frequency = 38000;
+};
+
+void lircAddBits(SignalBuilder &b, const LircRemote &r, uint64_t value, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t bit = r.reverse ? i : count - 1 - i;
+    const uint32_t *pair = (value >> bit) & 1 ? r.one : r.zero;
+    b.mark(pair[0]);
+    b.space(pair[1]);
+  }
+}
+
+bool lircEncode(const LircRemote &r, uint64_t data, IRSignal &out) {
+  SignalBuilder b(out);
+  if (r.header[0]) {
+    b.mark(r.header[0]);
+    b.space(r.header[1]);
+  }
+  if (r.plead) b.mark(r.plead);
+  lircAddBits(b, r, r.pre, r.preBits);
+  lircAddBits(b, r, data, r.bits);
+  lircAddBits(b, r, r.post, r.postBits);
+  if (r.ptrail) b.mark(r.ptrail);
+  uint32_t frameUs = b.sectionUs();
+  uint32_t period = r.constLength && r.gap > frameUs ? r.gap : frameUs + (r.gap ? r.gap : DEFAULT_LEAD_OUT_US);
+  b.repeatDone(b.endSection(period, 0), 0);
+  out.carrierHz = r.frequency;
+  return !b.overflow && out.rawDataLen > 0;
+}
+
+void parseLirc(const std::string &path, const std::string &text, const std::string &brandOverride, ParseResult &res) {
+  std::istringstream in(text);
+  std::string line;
+  int lineNo = 0;
+  LircRemote remote;
+  enum { OUTSIDE, REMOTE, CODES, RAW_CODES } state = OUTSIDE;
+  std::string rawName;
+  std::vector<uint32_t> rawDurations;
+  int rawLine = 0;
+
+  auto brandOf = [&]() {
+    return brandOverride.empty() ? brandFromName(remote.name.empty() ? fs::path(path).stem().string() : remote.name) : brandOverride;
+  };
+  auto flushRaw = [&]() {
+    if (rawName.empty()) return;
+    ImportedCode code;
+    code.brand = brandOf();
+    code.name = normaliseKeyName(rawName);
+    code.source = sourceOf(path, rawLine);
+    if (rawToSignal(rawDurations, remote.frequency, remote.gap, code.raw)) res.codes.push_back(code);
+    else res.rejected.push_back({ code.source, "raw code is empty or longer than " + std::to_string(MAX_RAW_LEN) + " entries" });
+    rawName.clear();
+    rawDurations.clear();
+  };
+
+  while (std::getline(in, line)) {
+    lineNo++;
+    size_t hash = line.find('#');
+    if (hash != std::string::npos) line = line.substr(0, hash);
+    std::istringstream ls(line);
+    std::vector<std::string> tok;
+    for (std::string t; ls >> t;) tok.push_back(t);
+    if (tok.empty()) continue;
+    std::string key = tok[0];
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+
+    if (key == "begin" && tok.size() > 1) {
+      std::string what = tok[1];
+      std::transform(what.begin(), what.end(), what.begin(), ::tolower);
+      if (what == "remote") {
+        remote = LircRemote();
+        state = REMOTE;
+      } else if (what == "codes") {
+        state = CODES;
+      } else if (what == "raw_codes") {
+        state = RAW_CODES;
+        remote.raw = true;
+      }
+      continue;
+    }
+    if (key == "end") {
+      if (state == RAW_CODES) flushRaw();
+      state = state == REMOTE ? OUTSIDE : REMOTE;
+      continue;
+    }
+
+    if (state == REMOTE) {
+      uint32_t v1 = 0, v2 = 0;
+      bool n1 = tok.size() > 1 && parseUint(tok[1], v1), n2 = tok.size() > 2 && parseUint(tok[2], v2);
+      if (key == "name" && tok.size() > 1) remote.name = tok[1];
+      else if (key == "bits" && n1) remote.bits = v1;
+      else if (key == "pre_data_bits" && n1) remote.preBits = v1;
+      else if (key == "post_data_bits" && n1) remote.postBits = v1;
+      else if (key == "pre_data" && tok.size() > 1) remote.pre = strtoull(tok[1].c_str(), nullptr, 0);
+      else if (key == "post_data" && tok.size() > 1) remote.post = strtoull(tok[1].c_str(), nullptr, 0);
+      else if (key == "header" && n1 && n2) remote.header[0] = v1, remote.header[1] = v2;
+      else if (key == "one" && n1 && n2) remote.one[0] = v1, remote.one[1] = v2;
+      else if (key == "zero" && n1 && n2) remote.zero[0] = v1, remote.zero[1] = v2;
+      else if (key == "plead" && n1) remote.plead = v1;
+      else if (key == "ptrail" && n1) remote.ptrail = v1;
+      else if (key == "gap" && n1) remote.gap = v1;
+      else if (key == "frequency" && n1) remote.frequency = v1;
+      else if (key == "flags" && tok.size() > 1) {
+        std::string flags;
+        for (size_t i = 1; i < tok.size(); i++) flags += tok[i];
+        std::stringstream fs_(flags);
+        for (std::string f; std::getline(fs_, f, '|');) {
+          f = trim(f);
+          if (f == "RAW_CODES") remote.raw = true;
+          else if (f == "CONST_LENGTH") remote.constLength = true;
+          else if (f == "REVERSE") remote.reverse = true;
+          else if (f == "RC5" || f == "RC6" || f == "SHIFT_ENC" || f == "RCMM" || f == "GRUNDIG" || f == "BO" || f == "XMP" || f == "SERIAL")
+            remote.unsupported = f;
+        }
+      }
+    } else if (state == CODES && tok.size() > 1) {
+      ImportedCode code;
+      code.brand = brandOf();
+      code.name = normaliseKeyName(tok[0]);
+      code.source = sourceOf(path, lineNo);
+      if (!remote.unsupported.empty()) {
+        res.rejected.push_back({ code.source, "LIRC " + remote.unsupported + " encoding is not supported" });
+      } else if (!remote.one[0] || !remote.zero[0] || !remote.bits) {
+        res.rejected.push_back({ code.source, "remote has no one/zero/bits timing" });
+      } else if (!lircEncode(remote, strtoull(tok[1].c_str(), nullptr, 0), code.raw)) {
+        res.rejected.push_back({ code.source, "encoded frame is longer than " + std::to_string(MAX_RAW_LEN) + " entries" });
+      } else {
+        quantiseDurations(code.raw);
+        res.codes.push_back(code);
+      }
+    } else if (state == RAW_CODES) {
+      if (key == "name" && tok.size() > 1) {
+        flushRaw();
+        rawName = tok[1];
+        rawLine = lineNo;
+        continue;
+      }
+      for (const std::string &t : tok) {
+        uint32_t v;
+        if (parseUint(t, v, 10)) rawDurations.push_back(v);
+      }
+    }
+  }
+}
+
+// ============================================================
+// Flipper .ir
+// ============================================================
+// Records are "name:" ... blocks. Parsed records keep their protocol
+// (stored as address/command, timings generated on the device); raw
+// records keep their durations.
+bool flipperProtocol(const std::string &name, uint32_t &address, ImportedCode &code) {
+  code.kind = PACK_KIND_PROTOCOL;
+  code.address = address;
+  if (name == "NEC") code.protocol = IR_PROTO_NEC, code.address &= 0xFF;
+  else if (name == "NECext") code.protocol = IR_PROTO_NEC, code.address &= 0xFFFF;
+  else if (name == "Samsung32") code.protocol = IR_PROTO_NECX, code.address = (address & 0xFF) * 0x0101;
+  else if (name == "SIRC") code.protocol = IR_PROTO_SONY12;
+  else if (name == "SIRC15") code.protocol = IR_PROTO_SONY15;
+  else if (name == "SIRC20") code.protocol = IR_PROTO_SONY20;
+  else if (name == "RC5") code.protocol = IR_PROTO_RC5;
+  else if (name == "RC6") code.protocol = IR_PROTO_RC6;
+  else return false;
+  // An NECext address whose high byte happens to be zero would be sent
+  // with an inverted low byte by the generator; keep it as timings instead
+  if (name == "NECext" && code.address <= 0xFF) {
+    SignalBuilder b(code.raw);
+    addNecFrame(b, 9000, code.address, code.command, true);
+    b.repeatDone(b.endSection(NEC_PERIOD_US, NEC_UNIT_US), 0);
+    code.raw.carrierHz = irProtocolCarrierHz(IR_PROTO_NEC);
+    code.kind = PACK_KIND_RAW;
+  }
+  return true;
+}
+
+// "04 00 00 00" -> 0x00000004
+uint32_t flipperBytes(const std::string &value) {
+  std::istringstream in(value);
+  uint32_t v = 0;
+  int shift = 0;
+  for (std::string b; in >> b && shift < 32; shift += 8) v |= (uint32_t)strtoul(b.c_str(), nullptr, 16) << shift;
+  return v;
+}
+
+void parseFlipper(const std::string &path, const std::string &text, const std::string &brandOverride, ParseResult &res) {
+  std::string brand = brandOverride.empty() ? brandFromName(fs::path(path).stem().string()) : brandOverride;
+  std::map<std::string, std::string> fields;
+  int recordLine = 0;
+
+  auto flush = [&]() {
+    if (fields.empty()) return;
+    ImportedCode code;
+    code.brand = brand;
+    code.name = normaliseKeyName(fields["name"]);
+    code.source = sourceOf(path, recordLine);
+    memset(&code.raw, 0, sizeof(IRSignal));
+    std::string type = fields["type"];
+    if (code.name.empty()) {
+      res.rejected.push_back({ code.source, "record has no name" });
+    } else if (type == "parsed") {
+      uint32_t address = flipperBytes(fields["address"]);
+      code.command = (uint16_t)flipperBytes(fields["command"]);
+      if (flipperProtocol(fields["protocol"], address, code)) res.codes.push_back(code);
+      else res.rejected.push_back({ code.source, "protocol '" + fields["protocol"] + "' is not supported" });
+    } else if (type == "raw") {
+      std::vector<uint32_t> durations;
+      std::istringstream in(fields["data"]);
+      for (std::string t; in >> t;) {
+        uint32_t v;
+        if (parseUint(t, v, 10)) durations.push_back(v);
+      }
+      uint32_t freq = 0;
+      if (!parseUint(fields["frequency"], freq, 10)) freq = DEFAULT_CARRIER_HZ;
+      if (rawToSignal(durations, freq, 0, code.raw)) res.codes.push_back(code);
+      else res.rejected.push_back({ code.source, "raw data is empty or longer than " + std::to_string(MAX_RAW_LEN) + " entries" });
+    } else {
+      res.rejected.push_back({ code.source, "record type '" + type + "' is unknown" });
+    }
+    fields.clear();
+  };
+
+  std::istringstream in(text);
+  std::string line;
+  int lineNo = 0;
+  while (std::getline(in, line)) {
+    lineNo++;
+    line = trim(line);
+    if (line.empty() || line[0] == '#') continue;
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    std::string key = trim(line.substr(0, colon)), value = trim(line.substr(colon + 1));
+    if (key == "Filetype" || key == "Version") continue;
+    if (key == "name") {
+      flush();
+      recordLine = lineNo;
+    }
+    // Long raw recordings repeat the data: key; keep every chunk
+    if (key == "data" && fields.count("data")) fields["data"] += " " + value;
+    else fields[key] = value;
+  }
+  flush();
+}
+
+// ============================================================
+// Driver
+// ============================================================
+void parseFile(const std::string &path, const std::string &brandOverride, ParseResult &res) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    res.rejected.push_back({ path, "can't be read" });
+    return;
+  }
+  std::stringstream buf;
+  buf << f.rdbuf();
+  std::string text = buf.str(), ext = fs::path(path).extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  if (ext == ".ir" || text.compare(0, 9, "Filetype:") == 0) parseFlipper(path, text, brandOverride, res);
+  else if (ext == ".conf" || ext == ".lircd" || text.find("begin remote") != std::string::npos) parseLirc(path, text, brandOverride, res);
+  else parseProntoText(path, text, brandOverride, res);
+}
+
+// The bytes stored for a code; equal payloads mean equal codes
+std::string payloadOf(const ImportedCode &c) {
+  std::string p;
+  if (c.kind == PACK_KIND_PROTOCOL) {
+    PackProtocolPayload pp = { c.address, c.command };
+    p.assign((const char *)&pp, sizeof(pp));
+  } else {
+    PackRawPayload rp = { c.raw.carrierHz, c.raw.oncePeriodUs, c.raw.repeatPeriodUs, c.raw.rawDataLen, c.raw.repeatLen };
+    p.assign((const char *)&rp, sizeof(rp));
+    p.append((const char *)c.raw.rawData, c.raw.rawDataLen * sizeof(uint16_t));
+  }
+  return p;
+}
+
+// Every word start of every "BRAND CODE", sorted by key for the
+// device's type-ahead search
+bool writeWordIndex(const std::string &path, const std::vector<ImportedCode> &codes, uint32_t packFileSize) {
+  std::vector<PackWordEntry> words;
+  for (size_t i = 0; i < codes.size(); i++) {
+    char brand[PACK_NAME_CHARS] = {}, name[PACK_NAME_CHARS] = {};
+    strncpy(brand, codes[i].brand.c_str(), PACK_NAME_CHARS - 1);
+    strncpy(name, codes[i].name.c_str(), PACK_NAME_CHARS - 1);
+    packWordKeys(brand, name, [&](const char *key) {
+      PackWordEntry w;
+      memcpy(w.key, key, PACK_WORD_CHARS);
+      w.code = (uint32_t)i;
+      words.push_back(w);
+    });
+  }
+  std::sort(words.begin(), words.end(), [](const PackWordEntry &a, const PackWordEntry &b) {
+    int c = memcmp(a.key, b.key, PACK_WORD_CHARS);
+    return c ? c < 0 : a.code < b.code;
+  });
+  PackWordsHeader h = { PACK_WORDS_MAGIC, PACK_WORDS_VERSION, 0, (uint32_t)words.size(), packFileSize };
+  std::ofstream f(path, std::ios::binary);
+  f.write((const char *)&h, sizeof(h));
+  f.write((const char *)words.data(), words.size() * sizeof(PackWordEntry));
+  return (bool)f;
+}
+
+bool writePack(const std::string &path, const std::vector<ImportedCode> &codes) {
+  std::vector<PackBrandEntry> brands;
+  std::vector<PackCodeEntry> entries(codes.size());
+  for (size_t i = 0; i < codes.size(); i++) {
+    if (brands.empty() || brands.back().name != codes[i].brand) {
+      PackBrandEntry b = {};
+      strncpy(b.name, codes[i].brand.c_str(), PACK_NAME_CHARS - 1);
+      b.firstCode = (uint32_t)i;
+      brands.push_back(b);
+    }
+    brands.back().codeCount++;
+  }
+  if (brands.size() > UINT16_MAX) {
+    fprintf(stderr, "irpack: %zu brands, a pack holds at most %u\n", brands.size(), UINT16_MAX);
+    return false;
+  }
+
+  PackHeader h = {};
+  h.magic = PACK_MAGIC;
+  h.version = PACK_VERSION;
+  h.brandCount = (uint16_t)brands.size();
+  h.codeCount = (uint32_t)codes.size();
+  h.brandIndexOffset = sizeof(PackHeader);
+  h.codeIndexOffset = h.brandIndexOffset + brands.size() * sizeof(PackBrandEntry);
+
+  // Identical payloads (the same key under two names) are stored once
+  std::string payloads;
+  std::map<std::string, uint32_t> payloadAt;
+  uint32_t payloadBase = h.codeIndexOffset + codes.size() * sizeof(PackCodeEntry);
+  for (size_t i = 0; i < codes.size(); i++) {
+    std::string p = payloadOf(codes[i]);
+    auto it = payloadAt.find(p);
+    if (it == payloadAt.end()) {
+      it = payloadAt.emplace(p, payloadBase + (uint32_t)payloads.size()).first;
+      payloads += p;
+    }
+    PackCodeEntry &e = entries[i];
+    memset(&e, 0, sizeof(e));
+    strncpy(e.name, codes[i].name.c_str(), PACK_NAME_CHARS - 1);
+    e.payloadOffset = it->second;
+    e.payloadLen = (uint16_t)p.size();
+    e.kind = codes[i].kind;
+    e.protocol = codes[i].protocol;
+  }
+  h.fileSize = payloadBase + (uint32_t)payloads.size();
+
+  std::ofstream f(path, std::ios::binary);
+  f.write((const char *)&h, sizeof(h));
+  f.write((const char *)brands.data(), brands.size() * sizeof(PackBrandEntry));
+  f.write((const char *)entries.data(), entries.size() * sizeof(PackCodeEntry));
+  f.write(payloads.data(), payloads.size());
+  return (bool)f && writeWordIndex(fs::path(path).replace_extension(".irx").string(), codes, h.fileSize);
+}
+
+// Saved-signal file names keep to letters, digits and '-'; anything
+// else becomes '_'. The device groups by what comes before the first
+// '-', so a brand's own '-' becomes '_' too.
+std::string savedSignalPart(const std::string &in, bool keepDash) {
+  std::string out = in;
+  for (char &c : out)
+    if (!isalnum((unsigned char)c) && !(keepDash && c == '-')) c = '_';
+  return out;
+}
+
+// One IRSignal per file, named BRAND-NAME so the device groups them by
+// brand. An entry that can't be written is skipped and reported; only a
+// directory that can't be created fails the export.
+bool writeSavedSignals(const std::string &dir, const std::vector<ImportedCode> &codes, std::vector<Rejected> &skipped) {
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  if (ec) {
+    fprintf(stderr, "can't create %s: %s\n", dir.c_str(), ec.message().c_str());
+    return false;
+  }
+  std::map<std::string, std::string> written;  // lower-cased name (FAT ignores case) -> source
+  for (const ImportedCode &c : codes) {
+    IRSignal s;
+    if (c.kind == PACK_KIND_PROTOCOL) {
+      if (!generateSignal(c.protocol, c.address, c.command, s)) {
+        skipped.push_back({ c.source, "not exported: protocol code doesn't fit a signal" });
+        continue;
+      }
+    } else {
+      s = c.raw;
+    }
+    std::string name = (savedSignalPart(c.brand, false) + "-" + savedSignalPart(c.name, true)).substr(0, MAX_SAVED_SIGNAL_CHARS);
+    std::string key = name;
+    for (char &k : key) k = (char)tolower((unsigned char)k);
+    auto seen = written.find(key);
+    if (seen != written.end()) {
+      skipped.push_back({ c.source, "not exported: " + name + " is already taken by " + seen->second });
+      continue;
+    }
+    memset(s.name, 0, sizeof(s.name));
+    memcpy(s.name, name.data(), name.size());
+    std::ofstream f(dir + "/" + name + ".bin", std::ios::binary);
+    f.write((const char *)&s, sizeof(IRSignal));
+    if (!f) {
+      skipped.push_back({ c.source, "not exported: can't write " + name + ".bin" });
+      continue;
+    }
+    written[key] = c.source;
+  }
+  return true;
+}
+
+void usage() {
+  fprintf(stderr,
+          "usage: irpack [-o pack.irp] [-b saved-signals-dir] [--brand NAME] [-j threads] [-v] input...\n"
+          "  inputs are Pronto text, LIRC .conf or Flipper .ir files, or directories of them\n");
+}
+
+int main(int argc, char **argv) {
+  std::string packPath, binDir, brandOverride;
+  std::vector<std::string> inputs;
+  unsigned threads = std::thread::hardware_concurrency();
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (a == "-o" && i + 1 < argc) packPath = argv[++i];
+    else if (a == "-b" && i + 1 < argc) binDir = argv[++i];
+    else if (a == "--brand" && i + 1 < argc) brandOverride = normaliseName(argv[++i]);
+    else if (a == "-j" && i + 1 < argc) threads = (unsigned)atoi(argv[++i]);
+    else if (a == "-v") verbose = true;
+    else if (!a.empty() && a[0] == '-') {
+      usage();
+      return 2;
+    } else inputs.push_back(a);
+  }
+  if (inputs.empty() || (packPath.empty() && binDir.empty())) {
+    usage();
+    return 2;
+  }
+  auto started = std::chrono::steady_clock::now();
+
+  std::vector<std::string> files;
+  for (const std::string &in : inputs) {
+    if (fs::is_directory(in)) {
+      for (const auto &e : fs::recursive_directory_iterator(in))
+        if (e.is_regular_file()) files.push_back(e.path().string());
+    } else {
+      files.push_back(in);
+    }
+  }
+  std::sort(files.begin(), files.end());
+
+  // Workers take the next file; results stay in file order so the
+  // output doesn't depend on the thread count
+  std::vector<ParseResult> results(files.size());
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> pool;
+  if (threads == 0) threads = 1;
+  for (unsigned t = 0; t < threads && t < files.size(); t++)
+    pool.emplace_back([&]() {
+      for (size_t i; (i = next++) < files.size();) parseFile(files[i], brandOverride, results[i]);
+    });
+  for (std::thread &t : pool) t.join();
+
+  std::vector<ImportedCode> codes;
+  std::vector<Rejected> rejected;
+  for (ParseResult &r : results) {
+    for (ImportedCode &c : r.codes) {
+      if (c.brand.empty()) c.brand = "UNKNOWN";
+      if (c.name.empty()) rejected.push_back({ c.source, "name is empty" });
+      else codes.push_back(std::move(c));
+    }
+    rejected.insert(rejected.end(), r.rejected.begin(), r.rejected.end());
+  }
+
+  // Sorted the way the device binary-searches: byte order, brand then name
+  std::stable_sort(codes.begin(), codes.end(), [](const ImportedCode &a, const ImportedCode &b) {
+    int c = strcmp(a.brand.c_str(), b.brand.c_str());
+    return c ? c < 0 : strcmp(a.name.c_str(), b.name.c_str()) < 0;
+  });
+  size_t duplicates = 0;
+  std::vector<ImportedCode> unique;
+  for (ImportedCode &c : codes) {
+    if (!unique.empty() && unique.back().brand == c.brand && unique.back().name == c.name) {
+      if (payloadOf(unique.back()) == payloadOf(c)) duplicates++;
+      else rejected.push_back({ c.source, "conflicts with " + unique.back().source + " (" + c.brand + " " + c.name + ")" });
+      continue;
+    }
+    unique.push_back(std::move(c));
+  }
+
+  bool ok = true;
+  if (!packPath.empty()) ok = writePack(packPath, unique) && ok;
+  if (!binDir.empty()) ok = writeSavedSignals(binDir, unique, rejected) && ok;
+
+  size_t brandCount = 0;
+  for (size_t i = 0; i < unique.size(); i++)
+    if (i == 0 || unique[i].brand != unique[i - 1].brand) brandCount++;
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+  for (size_t i = 0; i < rejected.size() && (verbose || i < REJECTS_SHOWN); i++)
+    fprintf(stderr, "rejected %s: %s\n", rejected[i].source.c_str(), rejected[i].reason.c_str());
+  if (!verbose && rejected.size() > REJECTS_SHOWN) fprintf(stderr, "... %zu more rejected (-v lists all)\n", rejected.size() - REJECTS_SHOWN);
+  fprintf(stderr, "%zu files, %zu codes in %zu brands, %zu duplicates dropped, %zu rejected, %.0f ms (%u threads)\n", files.size(),
+          unique.size(), brandCount, duplicates, rejected.size(), ms, threads);
+  return ok ? 0 : 1;
+}
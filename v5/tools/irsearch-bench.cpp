@@ -0,0 +1,154 @@
+// ============================================================
+// irsearch-bench — per-keystroke latency of the signal search
+// ============================================================
+// Builds a synthetic library of BRAND FUNCTION names, loads it into both
+// search indexes from IR-search.h (the RAM index used for saved and
+// compiled signals, and a pack word index held in memory), then "types"
+// sampled names one character at a time and times each query the way
+// the search screen runs it: count every match, keep the first few.
+//
+//   g++ -std=c++17 -O2 -o irsearch-bench v5/tools/irsearch-bench.cpp
+//   ./irsearch-bench [names] [samples]
+//
+// Host times are not device times; the pack figures to read are
+// entries fetched per keystroke, each one a seek and a 20-byte read on
+// the card.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "../uniremote/IR-search.h"
+
+constexpr uint16_t BENCH_NAMES = 10000;
+constexpr int PREVIEW_ROWS = 4;
+
+static const char *BRANDS[] = { "SAMSUNG", "LG", "SONY", "PANASONIC", "PHILIPS", "TOSHIBA", "SHARP", "HITACHI",
+                                "VIZIO", "TCL", "HISENSE", "JVC", "PIONEER", "YAMAHA", "DENON", "ONKYO",
+                                "BOSE", "SANYO", "GRUNDIG", "SKYWORTH", "DAIKIN", "MITSUBISHI", "FUJITSU", "GREE" };
+static const char *FUNCTIONS[] = { "POWER", "POWER ON", "POWER OFF", "VOL UP", "VOL DOWN", "MUTE", "CH UP",
+                                   "CH DOWN", "INPUT", "MENU", "OK", "BACK", "HOME", "PLAY", "PAUSE", "STOP",
+                                   "TEMP UP", "TEMP DOWN", "MODE", "FAN", "SWING", "SLEEP", "TIMER", "INFO" };
+
+// Memory-backed Source for IrPackWordIndex
+struct MemSource {
+  std::vector<uint8_t> bytes;
+  size_t pos = 0;
+  bool seek(uint32_t p) {
+    pos = p;
+    return pos <= bytes.size();
+  }
+  size_t read(uint8_t *buf, size_t n) {
+    n = std::min(n, bytes.size() - pos);
+    memcpy(buf, bytes.data() + pos, n);
+    pos += n;
+    return n;
+  }
+};
+
+struct Stats {
+  std::vector<double> us;
+  void report(const char *label) {
+    std::sort(us.begin(), us.end());
+    double sum = 0;
+    for (double v : us) sum += v;
+    printf("%-12s %zu keystrokes  mean %7.2f us  p99 %7.2f us  max %7.2f us\n", label, us.size(), sum / us.size(),
+           us[us.size() * 99 / 100], us.back());
+  }
+};
+
+int main(int argc, char **argv) {
+  int names = argc > 1 ? atoi(argv[1]) : BENCH_NAMES;
+  int samples = argc > 2 ? atoi(argv[2]) : 500;
+  if (names < 1 || names > BENCH_NAMES) {
+    fprintf(stderr, "names must be 1..%d\n", BENCH_NAMES);
+    return 2;
+  }
+
+  // Brand, function and a model number keep every name distinct
+  std::mt19937 rng(41);
+  std::vector<std::string> brands, codes;
+  for (int i = 0; i < names; i++) {
+    brands.push_back(BRANDS[rng() % (sizeof(BRANDS) / sizeof(BRANDS[0]))]);
+    codes.push_back(std::string(FUNCTIONS[rng() % (sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0]))]) + " "
+                    + std::to_string(rng() % 900 + 100));
+  }
+
+  static SignalNameIndex<BENCH_NAMES, BENCH_NAMES * 5> ram;
+  auto t0 = std::chrono::steady_clock::now();
+  ram.beginBulk();
+  for (int i = 0; i < names; i++) ram.add((brands[i] + " " + codes[i]).c_str(), i);
+  ram.finishBulk();
+  double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  printf("RAM index: %u names built in %.1f ms (%zu bytes)\n", ram.size(), buildMs, sizeof(ram));
+
+  // Same library as a pack word index, laid out as irpack writes it
+  std::vector<PackWordEntry> words;
+  for (int i = 0; i < names; i++)
+    packWordKeys(brands[i].c_str(), codes[i].c_str(), [&](const char *key) {
+      PackWordEntry w;
+      memcpy(w.key, key, PACK_WORD_CHARS);
+      w.code = i;
+      words.push_back(w);
+    });
+  std::sort(words.begin(), words.end(), [](const PackWordEntry &a, const PackWordEntry &b) {
+    int c = memcmp(a.key, b.key, PACK_WORD_CHARS);
+    return c ? c < 0 : a.code < b.code;
+  });
+  MemSource src;
+  PackWordsHeader h = { PACK_WORDS_MAGIC, PACK_WORDS_VERSION, 0, (uint32_t)words.size(), 0 };
+  src.bytes.resize(sizeof(h) + words.size() * sizeof(PackWordEntry));
+  memcpy(src.bytes.data(), &h, sizeof(h));
+  memcpy(src.bytes.data() + sizeof(h), words.data(), words.size() * sizeof(PackWordEntry));
+  IrPackWordIndex<MemSource> pack;
+  if (!pack.open(src, src.bytes.size(), 0)) {
+    fprintf(stderr, "word index rejected\n");
+    return 1;
+  }
+  printf("Pack index: %u word entries (%zu bytes)\n\n", pack.count(), src.bytes.size());
+
+  // Type each sampled name a character at a time
+  Stats ramStats, packStats;
+  std::vector<uint32_t> packReads;
+  uint64_t checksum = 0;
+  for (int s = 0; s < samples; s++) {
+    int pick = rng() % names;
+    std::string full = rng() % 2 ? codes[pick] : brands[pick] + " " + codes[pick];
+    for (size_t len = 1; len <= full.size(); len++) {
+      std::string q = full.substr(0, len);
+
+      auto a = std::chrono::steady_clock::now();
+      int kept = 0;
+      checksum += ram.query(q.c_str(), [&](uint16_t slot) {
+        checksum += slot;
+        return ++kept < PREVIEW_ROWS;
+      });
+      auto b = std::chrono::steady_clock::now();
+      ramStats.us.push_back(std::chrono::duration<double, std::micro>(b - a).count());
+
+      uint32_t before = pack.reads;
+      a = std::chrono::steady_clock::now();
+      uint32_t first = pack.bound(q.c_str(), false), end = pack.bound(q.c_str(), true, first);
+      PackWordEntry w;
+      for (uint32_t i = first; i < end && i < first + PREVIEW_ROWS; i++)
+        if (pack.entry(i, w)) checksum += w.code;
+      checksum += end - first;
+      b = std::chrono::steady_clock::now();
+      packStats.us.push_back(std::chrono::duration<double, std::micro>(b - a).count());
+      packReads.push_back(pack.reads - before);
+    }
+  }
+
+  ramStats.report("RAM index");
+  packStats.report("Pack index");
+  std::sort(packReads.begin(), packReads.end());
+  double sum = 0;
+  for (uint32_t r : packReads) sum += r;
+  printf("Pack reads   mean %.1f  p99 %u  max %u per keystroke\n", sum / packReads.size(),
+         packReads[packReads.size() * 99 / 100], packReads.back());
+  printf("(checksum %llu)\n", (unsigned long long)checksum);
+  return 0;
+}
@@ -0,0 +1,358 @@
+// ============================================================
+// irsync — host side of the serial sync protocol
+// ============================================================
+// Talks to the device's /saved-signals library over its USB serial
+// port using IR-sync.h, the same framing and windowing the sketch runs.
+//
+//   g++ -std=c++17 -O2 -o irsync v5/tools/irsync.cpp
+//   ./irsync /dev/ttyACM0 list
+//   ./irsync /dev/ttyACM0 get "TV-power.bin" [local-file]
+//   ./irsync /dev/ttyACM0 put local-dir/TV-power.bin
+//   ./irsync /dev/ttyACM0 delete "TV-power.bin"
+//   ./irsync /dev/ttyACM0 push local-dir [--delete]   only new or changed files go up
+//   ./irsync /dev/ttyACM0 pull local-dir              only new or changed files come down
+//   ./irsync /dev/ttyACM0 trace [local-file]          the event trace, for irtrace
+//
+// push and pull compare the device's manifest (name, size, CRC-32)
+// with the local directory, so unchanged signals never cross the wire.
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <poll.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+#include "../uniremote/IR-sync.h"
+
+namespace fs = std::filesystem;
+
+constexpr int REPLY_TIMEOUT_MS = 1500;
+constexpr int REQUEST_ATTEMPTS = 4;
+
+struct ManifestEntry {
+  uint32_t size, crc;
+};
+
+uint32_t nowMs() {
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+class SyncClient {
+  int fd = -1;
+  SyncFrameParser parser;
+  uint8_t out[SYNC_FRAME_MAX];
+  uint8_t seq = 0;
+
+public:
+  SyncFrame reply;
+  std::string error;
+
+  bool open(const char *path) {
+    fd = ::open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+      error = std::string(path) + ": " + strerror(errno);
+      return false;
+    }
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+      cfmakeraw(&tio);
+      cfsetispeed(&tio, B115200);
+      cfsetospeed(&tio, B115200);
+      tio.c_cc[VMIN] = 0;
+      tio.c_cc[VTIME] = 0;
+      tcsetattr(fd, TCSANOW, &tio);
+    }
+    return true;
+  }
+
+  void send(uint8_t type, uint8_t frameSeq, const uint8_t *payload, uint16_t len) {
+    uint16_t n = encodeSyncFrame(type, frameSeq, payload, len, out);
+    for (uint16_t done = 0; done < n;) {
+      ssize_t w = ::write(fd, out + done, n - done);
+      if (w > 0) done += w;
+      else if (w < 0 && errno != EAGAIN && errno != EINTR) return;
+    }
+  }
+
+  // Next good frame into reply, or false after timeoutMs
+  bool receive(int timeoutMs) {
+    uint32_t until = nowMs() + timeoutMs;
+    uint8_t buf[256];
+    for (;;) {
+      int left = (int)(until - nowMs());
+      if (left <= 0) return false;
+      pollfd p = { fd, POLLIN, 0 };
+      if (poll(&p, 1, left) <= 0) continue;
+      ssize_t n = ::read(fd, buf, 1);
+      if (n <= 0) continue;
+      if (parser.feed(buf[0])) {
+        reply = parser.frame;
+        return true;
+      }
+    }
+  }
+
+  // Sends a request until an OK or ERR answers it
+  bool request(uint8_t type, const uint8_t *payload, uint16_t len) {
+    for (int attempt = 0; attempt < REQUEST_ATTEMPTS; attempt++) {
+      uint8_t mySeq = ++seq;
+      send(type, mySeq, payload, len);
+      uint32_t until = nowMs() + REPLY_TIMEOUT_MS;
+      while ((int)(until - nowMs()) > 0) {
+        if (!receive((int)(until - nowMs()))) break;
+        if (reply.type == SYNC_ERR) {
+          error = std::string((const char *)reply.payload + 1, reply.len ? reply.len - 1 : 0);
+          return false;
+        }
+        if (reply.type == SYNC_OK && reply.seq == mySeq) return true;
+      }
+    }
+    error = "no answer";
+    return false;
+  }
+
+  bool hello() {
+    if (!request(SYNC_HELLO, nullptr, 0)) return false;
+    if (reply.len < 5 || syncGet16(reply.payload) != SYNC_VERSION || syncGet16(reply.payload + 2) != SYNC_CHUNK_BYTES) {
+      error = "device speaks a different protocol version";
+      return false;
+    }
+    return true;
+  }
+
+  bool list(std::map<std::string, ManifestEntry> &manifest) {
+    for (int attempt = 0; attempt < REQUEST_ATTEMPTS; attempt++) {
+      manifest.clear();
+      send(SYNC_LIST, ++seq, nullptr, 0);
+      uint16_t count = 0;
+      bool gap = false;
+      while (receive(REPLY_TIMEOUT_MS)) {
+        if (reply.type == SYNC_ERR) {
+          error = std::string((const char *)reply.payload + 1, reply.len ? reply.len - 1 : 0);
+          return false;
+        }
+        if (reply.type == SYNC_ENTRY && reply.len > 8) {
+          if (reply.seq != (count & 0xFF)) gap = true;
+          count++;
+          manifest[std::string((const char *)reply.payload + 8, reply.len - 8)] = { syncGet32(reply.payload), syncGet32(reply.payload + 4) };
+        } else if (reply.type == SYNC_LIST_END) {
+          if (!gap && reply.len >= 2 && syncGet16(reply.payload) == count) return true;
+          break;
+        }
+      }
+    }
+    error = "listing kept losing entries";
+    return false;
+  }
+
+  bool get(const std::string &name, std::vector<uint8_t> &data) {
+    return request(SYNC_GET, (const uint8_t *)name.data(), name.size()) && receiveFile(data);
+  }
+
+  bool trace(std::vector<uint8_t> &data) {
+    return request(SYNC_TRACE, nullptr, 0) && receiveFile(data);
+  }
+
+  // The transfer that follows an OK to GET or TRACE
+  bool receiveFile(std::vector<uint8_t> &data) {
+    uint32_t size = reply.len >= 4 ? syncGet32(reply.payload) : 0;
+    data.clear();
+    SyncReceiveWindow rx;
+    rx.start();
+    uint32_t crc = 0;
+    while (receive(REPLY_TIMEOUT_MS * 2)) {
+      if (reply.type == SYNC_DATA) {
+        uint8_t replyType, replySeq;
+        if (rx.accept(reply.seq, replyType, replySeq)) {
+          data.insert(data.end(), reply.payload, reply.payload + reply.len);
+          crc = syncCrc32(crc, reply.payload, reply.len);
+        }
+        if (replyType) send(replyType, replySeq, nullptr, 0);
+      } else if (reply.type == SYNC_END && reply.len >= 8) {
+        if (data.size() != size || syncGet32(reply.payload) != size || syncGet32(reply.payload + 4) != crc) {
+          error = "transfer arrived damaged";
+          return false;
+        }
+        send(SYNC_OK, reply.seq, nullptr, 0);
+        return true;
+      } else if (reply.type == SYNC_ERR) {
+        error = std::string((const char *)reply.payload + 1, reply.len ? reply.len - 1 : 0);
+        return false;
+      }
+    }
+    error = "transfer stalled";
+    return false;
+  }
+
+  bool put(const std::string &name, const std::vector<uint8_t> &data) {
+    uint32_t crc = syncCrc32(0, data.data(), data.size());
+    uint8_t p[8 + SYNC_NAME_CHARS];
+    syncPut32(p, data.size());
+    syncPut32(p + 4, crc);
+    memcpy(p + 8, name.data(), name.size());
+    if (!request(SYNC_PUT, p, 8 + name.size())) return false;
+
+    SyncWindow window;
+    window.start(data.size());
+    window.lastSendMs = nowMs();
+    while (!window.done()) {
+      while (window.canSend()) {
+        uint32_t off = window.next * SYNC_CHUNK_BYTES;
+        uint16_t n = data.size() - off < SYNC_CHUNK_BYTES ? data.size() - off : SYNC_CHUNK_BYTES;
+        send(SYNC_DATA, window.next & 0xFF, data.data() + off, n);
+        window.next++;
+        window.lastSendMs = nowMs();
+      }
+      if (receive(SYNC_RETRY_MS)) {
+        if (reply.type == SYNC_ACK) window.ack(reply.seq);
+        else if (reply.type == SYNC_NAK) {
+          if (reply.seq != (window.base & 0xFF)) window.ack((reply.seq - 1) & 0xFF);
+          window.rewind();
+        } else if (reply.type == SYNC_ERR) {
+          error = std::string((const char *)reply.payload + 1, reply.len ? reply.len - 1 : 0);
+          return false;
+        }
+      }
+      if (window.timedOut(nowMs())) {
+        if (++window.retries > SYNC_MAX_RETRIES) {
+          error = "transfer stalled";
+          return false;
+        }
+        window.rewind();
+      }
+    }
+    syncPut32(p, data.size());
+    syncPut32(p + 4, crc);
+    return request(SYNC_END, p, 8);
+  }
+
+  bool remove(const std::string &name) {
+    return request(SYNC_DELETE, (const uint8_t *)name.data(), name.size());
+  }
+};
+
+bool readFile(const fs::path &path, std::vector<uint8_t> &data) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) return false;
+  data.assign(std::istreambuf_iterator<char>(f), {});
+  return true;
+}
+
+bool writeFile(const fs::path &path, const std::vector<uint8_t> &data) {
+  std::ofstream f(path, std::ios::binary);
+  f.write((const char *)data.data(), data.size());
+  return (bool)f;
+}
+
+std::map<std::string, ManifestEntry> localManifest(const fs::path &dir) {
+  std::map<std::string, ManifestEntry> m;
+  if (!fs::is_directory(dir)) return m;
+  for (const auto &e : fs::directory_iterator(dir)) {
+    std::string name = e.path().filename().string();
+    std::vector<uint8_t> data;
+    if (!e.is_regular_file() || !syncNameValid(name.c_str(), name.size()) || !readFile(e.path(), data)) continue;
+    m[name] = { (uint32_t)data.size(), syncCrc32(0, data.data(), data.size()) };
+  }
+  return m;
+}
+
+bool sameEntry(const std::map<std::string, ManifestEntry> &m, const std::string &name, const ManifestEntry &e) {
+  auto it = m.find(name);
+  return it != m.end() && it->second.size == e.size && it->second.crc == e.crc;
+}
+
+int fail(SyncClient &c, const std::string &what) {
+  fprintf(stderr, "irsync: %s: %s\n", what.c_str(), c.error.c_str());
+  return 1;
+}
+
+void usage() {
+  fprintf(stderr,
+          "usage: irsync PORT list | get NAME [FILE] | put FILE | delete NAME | push DIR [--delete] | pull DIR | trace [FILE]\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    usage();
+    return 2;
+  }
+  std::string cmd = argv[2];
+  SyncClient c;
+  if (!c.open(argv[1])) return fail(c, "open");
+  if (!c.hello()) return fail(c, "hello");
+
+  if (cmd == "list") {
+    std::map<std::string, ManifestEntry> m;
+    if (!c.list(m)) return fail(c, "list");
+    for (const auto &e : m) printf("%8u  %08x  %s\n", e.second.size, e.second.crc, e.first.c_str());
+    return 0;
+  }
+  if (cmd == "get" && argc >= 4) {
+    std::vector<uint8_t> data;
+    if (!c.get(argv[3], data)) return fail(c, argv[3]);
+    return writeFile(argc >= 5 ? argv[4] : argv[3], data) ? 0 : 1;
+  }
+  if (cmd == "trace") {
+    std::vector<uint8_t> data;
+    if (!c.trace(data)) return fail(c, "trace");
+    return writeFile(argc >= 4 ? argv[3] : "uniremote.trace", data) ? 0 : 1;
+  }
+  if (cmd == "put" && argc >= 4) {
+    std::vector<uint8_t> data;
+    fs::path path = argv[3];
+    if (!readFile(path, data)) {
+      fprintf(stderr, "irsync: can't read %s\n", argv[3]);
+      return 1;
+    }
+    return c.put(path.filename().string(), data) ? 0 : fail(c, argv[3]);
+  }
+  if (cmd == "delete" && argc >= 4) return c.remove(argv[3]) ? 0 : fail(c, argv[3]);
+
+  if ((cmd == "push" || cmd == "pull") && argc >= 4) {
+    fs::path dir = argv[3];
+    std::map<std::string, ManifestEntry> remote, local = localManifest(dir);
+    if (!c.list(remote)) return fail(c, "list");
+    int moved = 0, same = 0, removed = 0;
+    if (cmd == "push") {
+      for (const auto &e : local) {
+        if (sameEntry(remote, e.first, e.second)) {
+          same++;
+          continue;
+        }
+        std::vector<uint8_t> data;
+        if (!readFile(dir / e.first, data) || !c.put(e.first, data)) return fail(c, e.first);
+        moved++;
+      }
+      if (argc >= 5 && std::string(argv[4]) == "--delete") {
+        for (const auto &e : remote) {
+          if (local.count(e.first)) continue;
+          if (!c.remove(e.first)) return fail(c, e.first);
+          removed++;
+        }
+      }
+    } else {
+      fs::create_directories(dir);
+      for (const auto &e : remote) {
+        if (sameEntry(local, e.first, e.second)) {
+          same++;
+          continue;
+        }
+        std::vector<uint8_t> data;
+        if (!c.get(e.first, data) || !writeFile(dir / e.first, data)) return fail(c, e.first);
+        moved++;
+      }
+    }
+    printf("%d %s, %d unchanged, %d deleted\n", moved, cmd == "push" ? "sent" : "received", same, removed);
+    return 0;
+  }
+  usage();
+  return 2;
+}
@@ -0,0 +1,113 @@
+// ============================================================
+// irtrace — event trace dump to Chrome trace JSON
+// ============================================================
+// Turns the flight recorder dump from the device (IR-trace.h, fetched
+// with "irsync PORT trace") into the JSON that chrome://tracing and
+// ui.perfetto.dev open, one track per event kind.
+//
+//   g++ -std=c++17 -O2 -o irtrace v5/tools/irtrace.cpp
+//   ./irtrace uniremote.trace > uniremote.json
+//   ./irtrace --touch uniremote.trace > touch.txt
+//
+// --touch writes the raw touch panel readings instead, one "US X Y Z"
+// line per poll, which the host build's "touch FILE" replays.
+//
+// Times are microseconds before the dump, so the 32-bit device clock
+// wrapping during a recording doesn't matter. Begin/end pairs are
+// matched in recording order and written as complete events; an end
+// whose begin was already overwritten is dropped.
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <vector>
+#include "../uniremote/IR-trace.h"
+
+struct Span {
+  int64_t ts, dur;  // dur < 0: instant
+  uint8_t id;
+  uint16_t arg, endArg;
+};
+
+uint32_t get32(const uint8_t *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+int main(int argc, char **argv) {
+  bool touchOnly = argc == 3 && !strcmp(argv[1], "--touch");
+  if (argc != 2 && !touchOnly) {
+    fprintf(stderr, "usage: irtrace [--touch] DUMP > trace.json\n");
+    return 2;
+  }
+  const char *path = argv[argc - 1];
+  std::ifstream f(path, std::ios::binary);
+  std::vector<uint8_t> data(std::istreambuf_iterator<char>(f), {});
+  if (data.size() < TRACE_HEADER_BYTES || memcmp(data.data(), "IRTR", 4) || (data[4] | data[5] << 8) != TRACE_VERSION
+      || data[6] != TRACE_EVENT_BYTES) {
+    fprintf(stderr, "irtrace: %s is not a version %u trace dump\n", path, TRACE_VERSION);
+    return 1;
+  }
+  uint32_t count = get32(data.data() + 8), dumpUs = get32(data.data() + 12);
+  if (data.size() != TRACE_HEADER_BYTES + (size_t)count * TRACE_EVENT_BYTES) {
+    fprintf(stderr, "irtrace: %s is truncated\n", path);
+    return 1;
+  }
+
+  std::vector<Span> spans;
+  std::map<uint8_t, std::vector<Span>> open;
+  int64_t first = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t *e = data.data() + TRACE_HEADER_BYTES + i * TRACE_EVENT_BYTES;
+    int64_t ts = (int32_t)(get32(e) - dumpUs);
+    uint8_t id = e[4];
+    uint16_t arg = e[6] | e[7] << 8;
+    first = std::min(first, ts);
+    if (e[5] == 'B') {
+      open[id].push_back({ ts, 0, id, arg, 0 });
+    } else if (e[5] == 'E' && !open[id].empty()) {
+      Span s = open[id].back();
+      open[id].pop_back();
+      s.dur = std::max<int64_t>(ts - s.ts, 0);
+      s.endArg = arg;
+      spans.push_back(s);
+    } else if (e[5] == 'i') {
+      spans.push_back({ ts, -1, id, arg, 0 });
+    }
+  }
+  std::stable_sort(spans.begin(), spans.end(), [](const Span &a, const Span &b) { return a.ts < b.ts; });
+
+  if (touchOnly) {
+    uint32_t polls = 0;
+    for (const Span &s : spans) {
+      if (s.id != TRACE_TOUCH) continue;
+      uint16_t x, y, z;
+      traceTouchReading(s.arg, s.endArg, x, y, z);
+      printf("%lld %u %u %u\n", (long long)(s.ts - first), x, y, z);
+      polls++;
+    }
+    fprintf(stderr, "irtrace: %u touch polls\n", polls);
+    return 0;
+  }
+
+  printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (uint8_t id = 1; id < TRACE_ID_COUNT; id++)
+    printf("%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", id > 1 ? "," : "",
+           id, traceName(id));
+  for (const Span &s : spans) {
+    printf(",\n{\"name\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%lld,", traceName(s.id), s.id, (long long)(s.ts - first));
+    if (s.dur < 0) printf("\"ph\":\"i\",\"s\":\"t\",");
+    else printf("\"ph\":\"X\",\"dur\":%lld,", (long long)s.dur);
+    if (s.id == TRACE_TOUCH) {
+      uint16_t x, y, z;
+      traceTouchReading(s.arg, s.endArg, x, y, z);
+      printf("\"args\":{\"x\":%u,\"y\":%u,\"z\":%u}}", x, y, z);
+    } else {
+      printf("\"args\":{\"arg\":%u}}", s.arg);
+    }
+  }
+  printf("\n]}\n");
+  fprintf(stderr, "irtrace: %u events, %zu spans over %.3f s\n", count, spans.size(), -first / 1e6);
+  return 0;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================
+// Display bus accounting
+// ============================================================
+// BusTally is what the panel driver pushed over SPI: transactions,
+// address windows (one per RAMWR), pixels written and total bytes.
+// BusOpTable charges growth in the tally to named operations — a screen
+// draw, a button press, a scroll frame — keeping the last, worst and
+// total per name, and flags any name whose worst draw went over its
+// entry in the budget table.
+struct BusTally {
+  uint32_t transactions = 0, windows = 0;
+  uint64_t pixels = 0, bytes = 0;
+};
+
+inline BusTally operator-(const BusTally &a, const BusTally &b) {
+  BusTally d;
+  d.transactions = a.transactions - b.transactions;
+  d.windows = a.windows - b.windows;
+  d.pixels = a.pixels - b.pixels;
+  d.bytes = a.bytes - b.bytes;
+  return d;
+}
+
+inline void operator+=(BusTally &a, const BusTally &b) {
+  a.transactions += b.transactions;
+  a.windows += b.windows;
+  a.pixels += b.pixels;
+  a.bytes += b.bytes;
+}
+
+struct BusBudget {
+  const char *name;
+  uint32_t maxBytes;
+};
+
+constexpr int BUS_OP_SLOTS = 32;
+constexpr int BUS_OP_NAME_CHARS = 28;
+
+struct BusOpStats {
+  char name[BUS_OP_NAME_CHARS];
+  uint32_t count, budget;  // budget 0: none
+  BusTally last, worst, total;
+};
+
+class BusOpTable {
+  const BusBudget *budgets;
+  uint8_t budgetCount;
+  BusOpStats ops[BUS_OP_SLOTS];
+  uint8_t used = 0;
+
+  // The last slot collects every name that found the table full
+  BusOpStats *slotFor(const char *name) {
+    for (uint8_t i = 0; i < used; i++)
+      if (!strcmp(ops[i].name, name)) return &ops[i];
+    if (used == BUS_OP_SLOTS) return &ops[BUS_OP_SLOTS - 1];
+    BusOpStats *s = &ops[used++];
+    *s = BusOpStats();
+    snprintf(s->name, sizeof(s->name), "%s", used == BUS_OP_SLOTS ? "(other)" : name);
+    for (uint8_t i = 0; i < budgetCount; i++)
+      if (!strcmp(budgets[i].name, s->name)) s->budget = budgets[i].maxBytes;
+    return s;
+  }
+
+public:
+  BusOpTable(const BusBudget *budgets, uint8_t budgetCount)
+    : budgets(budgets), budgetCount(budgetCount) {}
+
+  // False when this draw went over the name's budget
+  bool record(const char *name, const BusTally &delta) {
+    BusOpStats *s = slotFor(name);
+    s->count++;
+    s->last = delta;
+    s->total += delta;
+    if (delta.bytes > s->worst.bytes) s->worst = delta;
+    return !s->budget || delta.bytes <= s->budget;
+  }
+
+  uint8_t size() const {
+    return used;
+  }
+  const BusOpStats &operator[](uint8_t i) const {
+    return ops[i];
+  }
+  const BusOpStats *find(const char *name) const {
+    for (uint8_t i = 0; i < used; i++)
+      if (!strcmp(ops[i].name, name)) return &ops[i];
+    return nullptr;
+  }
+  void clear() {
+    used = 0;
+  }
+
+  // One line per name, worst draw of each, to anything with
+  // print(const char *); returns how many names are over budget
+  template<typename Out>
+  uint8_t print(Out &out) const {
+    char line[112];
+    uint8_t over = 0;
+    out.print("bus op                        count  worst B  windows   pixels  tx  budget\n");
+    for (uint8_t i = 0; i < used; i++) {
+      const BusOpStats &s = ops[i];
+      bool bad = s.budget && s.worst.bytes > s.budget;
+      over += bad;
+      snprintf(line, sizeof(line), "%-28s %6lu %8lu %8lu %8lu %3lu  %s%lu\n", s.name, (unsigned long)s.count,
+               (unsigned long)s.worst.bytes, (unsigned long)s.worst.windows, (unsigned long)s.worst.pixels,
+               (unsigned long)s.worst.transactions, bad ? "OVER " : "", (unsigned long)s.budget);
+      out.print(line);
+    }
+    return over;
+  }
+};
@@ -1,8 +1,10 @@
 #pragma once
 
+constexpr uint16_t IR_CODE_WORDS = 150;
+
 struct IRCode {
   const char *codeName;
-  const uint16_t codeArray[150];
+  const uint16_t codeArray[IR_CODE_WORDS];
 };
 
 const IRCode EPSON_CODES[4] = {
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "./IR-protocols.h"
+
+// ============================================================
+// Built-in device codes
+// ============================================================
+// One 9-byte row per code. Brand and function names are indices into
+// the string tables below; timings are generated when a code is sent.
+// Rows are grouped by brand (brands in alphabetical order) so a brand
+// is one contiguous range of the table.
+//
+// The projector and LED strip rows reproduce the learned Pronto codes
+// in IR-codes.h; the TV rows are the makers' published power codes.
+struct IRCodeEntry {
+  uint32_t address;
+  uint16_t command;
+  uint8_t brand;
+  uint8_t function;
+  uint8_t protocol;
+} __attribute__((packed));
+
+enum IrDbBrand : uint8_t {
+  DB_ACER,
+  DB_BENQ,
+  DB_EPSON,
+  DB_LED_STRIP,
+  DB_LG,
+  DB_NEC,
+  DB_PANASONIC,
+  DB_PHILIPS,
+  DB_SAMSUNG,
+  DB_SONY,
+  DB_BRAND_COUNT
+};
+
+const char *const IR_DB_BRANDS[DB_BRAND_COUNT] = {
+  "ACER", "BENQ", "EPSON", "LED_STRIP", "LG", "NEC", "PANASONIC", "PHILIPS", "SAMSUNG", "SONY"
+};
+
+enum IrDbFunction : uint8_t {
+  FN_FREEZE,
+  FN_POWER,
+  FN_POWER_ON,
+  FN_POWER_OFF,
+  FN_POWER_TOGGLE,
+  FN_ON,
+  FN_OFF,
+  FN_POWER_RC5,
+  FN_POWER_RC6,
+  DB_FUNCTION_COUNT
+};
+
+const char *const IR_DB_FUNCTIONS[DB_FUNCTION_COUNT] = {
+  "FREEZE", "POWER", "POWER ON", "POWER OFF", "POWER TOGGLE", "ON", "OFF", "POWER RC5", "POWER RC6"
+};
+
+const IRCodeEntry IR_DB_CODES[] = {
+  { 0x1308, 0x8E, DB_ACER, FN_FREEZE, IR_PROTO_NEC },
+  { 0x1308, 0x87, DB_ACER, FN_POWER_TOGGLE, IR_PROTO_NEC },
+  { 0x3000, 0x03, DB_BENQ, FN_FREEZE, IR_PROTO_NEC2 },
+  { 0x3000, 0x4F, DB_BENQ, FN_POWER_ON, IR_PROTO_NEC2 },
+  { 0x3000, 0x4E, DB_BENQ, FN_POWER_OFF, IR_PROTO_NEC2 },
+  { 0x3000, 0x02, DB_BENQ, FN_POWER_TOGGLE, IR_PROTO_NEC2 },
+  { 0x5583, 0x92, DB_EPSON, FN_FREEZE, IR_PROTO_NEC2 },
+  { 0x5583, 0x90, DB_EPSON, FN_POWER_ON, IR_PROTO_NEC2 },
+  { 0x5583, 0x91, DB_EPSON, FN_POWER_OFF, IR_PROTO_NEC2 },
+  { 0x5583, 0x90, DB_EPSON, FN_POWER_TOGGLE, IR_PROTO_NEC2 },
+  { 0xEF00, 0x03, DB_LED_STRIP, FN_ON, IR_PROTO_NEC },
+  { 0xEF00, 0x02, DB_LED_STRIP, FN_OFF, IR_PROTO_NEC },
+  { 0x04, 0x08, DB_LG, FN_POWER, IR_PROTO_NEC },
+  { 0xE918, 0x4C, DB_NEC, FN_FREEZE, IR_PROTO_NEC },
+  { 0xE918, 0x08, DB_NEC, FN_POWER_ON, IR_PROTO_NEC },
+  { 0xE918, 0x14, DB_NEC, FN_POWER_OFF, IR_PROTO_NEC },
+  { 0xE918, 0x08, DB_NEC, FN_POWER_TOGGLE, IR_PROTO_NEC },
+  { 0x488, 0x0200, DB_PANASONIC, FN_FREEZE, IR_PROTO_KASEIKYO56 },
+  { 0x488, 0x3E00, DB_PANASONIC, FN_POWER_ON, IR_PROTO_KASEIKYO56 },
+  { 0x488, 0x3F00, DB_PANASONIC, FN_POWER_OFF, IR_PROTO_KASEIKYO56 },
+  { 0x488, 0x3D00, DB_PANASONIC, FN_POWER_TOGGLE, IR_PROTO_KASEIKYO56 },
+  { 0x00, 0x0C, DB_PHILIPS, FN_POWER_RC5, IR_PROTO_RC5 },
+  { 0x00, 0x0C, DB_PHILIPS, FN_POWER_RC6, IR_PROTO_RC6 },
+  { 0x0707, 0x02, DB_SAMSUNG, FN_POWER, IR_PROTO_NECX },
+  { 0x01, 0x15, DB_SONY, FN_POWER, IR_PROTO_SONY12 },
+};
+constexpr uint16_t IR_DB_CODE_COUNT = sizeof(IR_DB_CODES) / sizeof(IR_DB_CODES[0]);
+
+// First row and row count of a brand (rows are grouped by brand)
+inline uint16_t irDbBrandRange(uint8_t brand, uint16_t &first) {
+  first = 0;
+  while (first < IR_DB_CODE_COUNT && IR_DB_CODES[first].brand < brand) first++;
+  uint16_t end = first;
+  while (end < IR_DB_CODE_COUNT && IR_DB_CODES[end].brand == brand) end++;
+  return end - first;
+}
+
+// toggle: RC5/RC6 toggle bit, see generateSignal()
+inline bool irDbSignal(const IRCodeEntry &entry, IRSignal &out, bool toggle = false) {
+  if (!generateSignal(entry.protocol, entry.address, entry.command, out, toggle)) return false;
+  snprintf(out.name, sizeof(out.name), "%s %s", IR_DB_BRANDS[entry.brand], IR_DB_FUNCTIONS[entry.function]);
+  return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// ============================================================
+// Kinetic scrolling
+// ============================================================
+// While a finger drags a list, ScrollVelocity keeps its recent
+// positions; on release their least-squares slope over the last
+// SCROLL_VELOCITY_WINDOW_US is the fling's starting speed. ScrollFling
+// then coasts with exponential decay: speed drops by e every
+// FLING_TAU_MS, so the list travels velocity * FLING_TAU_MS in all and
+// advance() covers the same ground however unevenly it is called.
+// FramePacer spaces frames on a fixed deadline grid so drawing time
+// doesn't stretch the period.
+constexpr int SCROLL_VELOCITY_SAMPLES = 16;
+constexpr uint32_t SCROLL_VELOCITY_WINDOW_US = 100000;
+constexpr float FLING_TAU_MS = 325;
+constexpr float FLING_MIN_VELOCITY = 0.3f;   // px/ms; slower releases just stop
+constexpr float FLING_STOP_VELOCITY = 0.02f;  // px/ms; about a pixel per frame
+constexpr float FLING_MAX_VELOCITY = 6;      // px/ms
+
+class ScrollVelocity {
+  uint32_t us[SCROLL_VELOCITY_SAMPLES];
+  float px[SCROLL_VELOCITY_SAMPLES];
+  uint8_t next = 0, count = 0;
+
+public:
+  void clear() {
+    next = count = 0;
+  }
+  void add(uint32_t nowUs, float pos) {
+    us[next] = nowUs;
+    px[next] = pos;
+    next = (next + 1) % SCROLL_VELOCITY_SAMPLES;
+    if (count < SCROLL_VELOCITY_SAMPLES) count++;
+  }
+  // px/ms over the samples in the window before nowUs; 0 with fewer than 2
+  float perMs(uint32_t nowUs) const {
+    float st = 0, sp = 0, stt = 0, stp = 0;
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      uint8_t k = (next + SCROLL_VELOCITY_SAMPLES - 1 - i) % SCROLL_VELOCITY_SAMPLES;
+      if (nowUs - us[k] > SCROLL_VELOCITY_WINDOW_US) break;
+      float t = (int32_t)(us[k] - nowUs) / 1000.0f;
+      st += t;
+      sp += px[k];
+      stt += t * t;
+      stp += t * px[k];
+      n++;
+    }
+    float den = n * stt - st * st;
+    if (n < 2 || den <= 0) return 0;
+    return (n * stp - st * sp) / den;
+  }
+};
+
+struct ScrollFling {
+  float velocity = 0;  // px/ms along the scroll offset
+  uint32_t lastUs = 0;
+  bool active = false;
+
+  void start(float v, uint32_t nowUs) {
+    velocity = v > FLING_MAX_VELOCITY ? FLING_MAX_VELOCITY : v < -FLING_MAX_VELOCITY ? -FLING_MAX_VELOCITY : v;
+    lastUs = nowUs;
+    active = fabsf(velocity) >= FLING_MIN_VELOCITY;
+    if (!active) velocity = 0;
+  }
+  void stop() {
+    active = false;
+    velocity = 0;
+  }
+  // Scroll distance since the last call
+  float advance(uint32_t nowUs) {
+    if (!active) return 0;
+    float decay = expf(-(float)(nowUs - lastUs) / 1000.0f / FLING_TAU_MS);
+    float dx = velocity * FLING_TAU_MS * (1 - decay);
+    lastUs = nowUs;
+    velocity *= decay;
+    if (fabsf(velocity) < FLING_STOP_VELOCITY) stop();
+    return dx;
+  }
+};
+
+class FramePacer {
+  uint32_t periodUs, nextUs = 0;
+
+public:
+  explicit FramePacer(uint32_t periodUs)
+    : periodUs(periodUs) {}
+
+  void restart(uint32_t nowUs) {
+    nextUs = nowUs;
+  }
+  // True once per period. A frame that ran a whole period late starts
+  // the grid over rather than letting the missed frames bunch up
+  bool due(uint32_t nowUs) {
+    if ((int32_t)(nowUs - nextUs) < 0) return false;
+    nextUs += periodUs;
+    if ((int32_t)(nowUs - nextUs) >= 0) nextUs = nowUs + periodUs;
+    return true;
+  }
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "./IR-signal.h"
+
+// ============================================================
+// Loopback alignment
+// ============================================================
+// Compares what was sent with what the device's own receiver saw.
+// Both sides are turned into edge times, the first received mark is
+// lined up with a sent mark, and every sent edge is paired with the
+// nearest received edge of the same polarity. Errors are measured on
+// durations between two paired edges, so one missed edge only costs
+// the two durations around it.
+constexpr int LOOPBACK_HIST_BINS = 16;
+constexpr int LOOPBACK_HIST_BIN_US = 25;  // bins span -200..+200 µs, outer bins catch the rest
+constexpr uint16_t LOOPBACK_MIN_TOLERANCE_US = 150;
+constexpr uint8_t LOOPBACK_MAX_LEAD_SKIP = 2;  // received frame may miss this many leading marks
+
+struct LoopbackStats {
+  uint16_t sentDurations = 0, measured = 0, extraEdges = 0;
+  uint32_t sumAbsErrUs = 0;
+  uint16_t maxAbsErrUs = 0;
+  int32_t markErrSumUs = 0, spaceErrSumUs = 0;
+  uint16_t markCount = 0, spaceCount = 0;
+  uint16_t histogram[LOOPBACK_HIST_BINS] = {};
+
+  void add(int32_t errUs, bool mark) {
+    uint32_t absErr = errUs < 0 ? -errUs : errUs;
+    measured++;
+    sumAbsErrUs += absErr;
+    if (absErr > maxAbsErrUs) maxAbsErrUs = absErr > 65535 ? 65535 : (uint16_t)absErr;
+    if (mark) {
+      markErrSumUs += errUs;
+      markCount++;
+    } else {
+      spaceErrSumUs += errUs;
+      spaceCount++;
+    }
+    histogram[loopbackHistBin(errUs)]++;
+  }
+
+  void merge(const LoopbackStats &o) {
+    sentDurations += o.sentDurations;
+    measured += o.measured;
+    extraEdges += o.extraEdges;
+    sumAbsErrUs += o.sumAbsErrUs;
+    if (o.maxAbsErrUs > maxAbsErrUs) maxAbsErrUs = o.maxAbsErrUs;
+    markErrSumUs += o.markErrSumUs;
+    spaceErrSumUs += o.spaceErrSumUs;
+    markCount += o.markCount;
+    spaceCount += o.spaceCount;
+    for (int b = 0; b < LOOPBACK_HIST_BINS; b++) histogram[b] += o.histogram[b];
+  }
+
+  uint16_t meanAbsErrUs() const {
+    return measured ? (uint16_t)(sumAbsErrUs / measured) : 0;
+  }
+  // Receiver modules typically stretch marks and shorten spaces by the same amount
+  int16_t markBiasUs() const {
+    return markCount ? (int16_t)(markErrSumUs / markCount) : 0;
+  }
+  int16_t spaceBiasUs() const {
+    return spaceCount ? (int16_t)(spaceErrSumUs / spaceCount) : 0;
+  }
+
+  static uint8_t loopbackHistBin(int32_t errUs) {
+    int32_t bin = (errUs + LOOPBACK_HIST_BINS / 2 * LOOPBACK_HIST_BIN_US) / LOOPBACK_HIST_BIN_US;
+    if (errUs + LOOPBACK_HIST_BINS / 2 * LOOPBACK_HIST_BIN_US < 0) bin = 0;
+    return bin >= LOOPBACK_HIST_BINS ? LOOPBACK_HIST_BINS - 1 : (uint8_t)bin;
+  }
+};
+
+// Edge k is the end of duration k-1; edge 0 starts the first mark
+inline uint8_t durationsToEdges(const uint16_t *durations, uint8_t len, uint32_t *edges) {
+  uint32_t t = 0;
+  edges[0] = 0;
+  for (uint8_t i = 0; i < len; i++) edges[i + 1] = t += durations[i];
+  return len + 1;
+}
+
+// Pairs each sent edge with the nearest same-polarity received edge once
+// the received frame is shifted so its first edge sits on sent edge
+// `lead`. Returns how many sent edges found a partner.
+inline uint16_t pairLoopbackEdges(const uint32_t *sent, uint8_t sentCount, const uint32_t *recv, uint8_t recvCount,
+                                  uint8_t lead, int16_t *pair) {
+  uint16_t paired = 0;
+  uint8_t j = 0;
+  for (uint8_t i = 0; i < sentCount; i++) {
+    pair[i] = -1;
+    if (i < lead) continue;
+    uint32_t gapBefore = i > 0 ? sent[i] - sent[i - 1] : UINT32_MAX;
+    uint32_t gapAfter = i + 1 < sentCount ? sent[i + 1] - sent[i] : UINT32_MAX;
+    uint32_t tolerance = (gapBefore < gapAfter ? gapBefore : gapAfter) / 4;
+    if (tolerance < LOOPBACK_MIN_TOLERANCE_US) tolerance = LOOPBACK_MIN_TOLERANCE_US;
+
+    int64_t target = (int64_t)sent[i] - sent[lead];
+    while (j + 1 < recvCount && (int64_t)recv[j + 1] - recv[0] <= target) j++;
+    int best = -1;
+    uint32_t bestDist = tolerance + 1;
+    for (int k = (int)j - 2; k <= (int)j + 2; k++) {
+      if (k < 0 || k >= recvCount || (k & 1) != ((i - lead) & 1)) continue;
+      int64_t d = (int64_t)recv[k] - recv[0] - target;
+      uint32_t dist = d < 0 ? (uint32_t)-d : (uint32_t)d;
+      if (dist < bestDist) {
+        bestDist = dist;
+        best = k;
+      }
+    }
+    pair[i] = (int16_t)best;
+    if (best >= 0) paired++;
+  }
+  return paired;
+}
+
+// sent is a whole section including its lead-out space, recv a captured
+// frame (which never includes the trailing gap)
+inline void alignLoopback(const uint16_t *sent, uint8_t sentLen, const uint16_t *recv, uint8_t recvLen, LoopbackStats &out) {
+  out = LoopbackStats();
+  if (sentLen && !(sentLen & 1)) sentLen--;  // the lead-out has no closing edge
+  out.sentDurations = sentLen;
+  if (!sentLen || !recvLen) return;
+
+  uint32_t sentEdges[MAX_RAW_LEN + 1], recvEdges[MAX_RAW_LEN + 1];
+  int16_t pair[MAX_RAW_LEN + 1], bestPair[MAX_RAW_LEN + 1];
+  uint8_t sentCount = durationsToEdges(sent, sentLen, sentEdges);
+  uint8_t recvCount = durationsToEdges(recv, recvLen, recvEdges);
+
+  uint16_t bestPaired = 0;
+  for (uint8_t lead = 0; lead <= 2 * LOOPBACK_MAX_LEAD_SKIP && lead < sentCount; lead += 2) {
+    uint16_t paired = pairLoopbackEdges(sentEdges, sentCount, recvEdges, recvCount, lead, pair);
+    if (paired > bestPaired) {
+      bestPaired = paired;
+      memcpy(bestPair, pair, sentCount * sizeof(int16_t));
+    }
+  }
+  if (!bestPaired) return;
+
+  for (uint8_t k = 0; k + 1 < sentCount; k++) {
+    if (bestPair[k] < 0 || bestPair[k + 1] < 0) continue;
+    int32_t sentUs = sentEdges[k + 1] - sentEdges[k];
+    int32_t recvUs = recvEdges[bestPair[k + 1]] - recvEdges[bestPair[k]];
+    out.add(recvUs - sentUs, (k & 1) == 0);
+  }
+  out.extraEdges = recvCount > bestPaired ? recvCount - bestPaired : 0;
+}
+
+// ============================================================
+// Simulated channel
+// ============================================================
+// Stand-in for LED -> air -> receiver module when checking the
+// alignment on a host: marks come out stretched, every edge is
+// jittered, and leading marks can be swallowed while the module's AGC
+// settles. Deterministic for a given seed.
+struct SimulatedIrChannel {
+  int16_t markStretchUs = 40;
+  uint16_t jitterUs = 20;
+  uint8_t swallowLeadMarks = 0;
+  uint32_t seed = 1;
+
+  int32_t noise() {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return jitterUs ? (int32_t)(seed % (2 * jitterUs + 1)) - jitterUs : 0;
+  }
+
+  uint8_t transmit(const uint16_t *sent, uint8_t sentLen, uint16_t *recv) {
+    if (sentLen && !(sentLen & 1)) sentLen--;
+    uint32_t edges[MAX_RAW_LEN + 1];
+    uint8_t count = durationsToEdges(sent, sentLen, edges);
+    int64_t moved[MAX_RAW_LEN + 1];
+    for (uint8_t k = 0; k < count; k++) moved[k] = (int64_t)edges[k] + ((k & 1) ? markStretchUs : 0) + noise();
+    uint8_t first = 2 * swallowLeadMarks < count ? 2 * swallowLeadMarks : count - 1;
+    uint8_t n = 0;
+    for (uint8_t k = first; k + 1 < count; k++) {
+      int64_t d = moved[k + 1] - moved[k];
+      recv[n++] = d < 1 ? 1 : d > 65535 ? 65535 : (uint16_t)d;
+    }
+    return n;
+  }
+};
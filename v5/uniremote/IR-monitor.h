@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "./IR-stream.h"
+
+// ============================================================
+// Live monitor model
+// ============================================================
+// Bounded history of received frames plus a duration histogram over
+// exactly the frames still held: adding a frame that evicts the oldest
+// subtracts the evicted frame's durations again. The screen only reads
+// from here and redraws what the dirty markers say changed.
+constexpr int MONITOR_SLOTS = 12;
+constexpr int MONITOR_HIST_BINS = 20;
+constexpr uint16_t MONITOR_HIST_BIN_US = 250;  // last bin collects everything >= 4.75 ms
+constexpr uint32_t MONITOR_FPS_WINDOW_MS = 1000;
+
+struct MonitorFrame {
+  uint32_t seq;
+  uint32_t timeMs;
+  uint16_t durations[MAX_RAW_LEN];
+  uint8_t len;
+  bool decoded;
+  uint8_t protocol;  // IRremote decode_type_t
+  uint16_t address, command;
+  uint32_t carrierHz;
+};
+
+inline uint8_t monitorHistBin(uint16_t durationUs) {
+  uint16_t bin = durationUs / MONITOR_HIST_BIN_US;
+  return bin >= MONITOR_HIST_BINS ? MONITOR_HIST_BINS - 1 : (uint8_t)bin;
+}
+
+struct IrMonitor {
+  MonitorFrame frames[MONITOR_SLOTS];
+  uint8_t head = 0, count = 0;  // head = slot the next frame goes into
+  uint32_t totalFrames = 0;
+  uint16_t histogram[MONITOR_HIST_BINS] = {};
+  uint32_t histDirty = 0;  // one bit per bin
+  uint32_t fpsWindowStartMs = 0, fpsWindowFrames = 0, fps = 0;
+
+  void clear() {
+    head = count = 0;
+    totalFrames = 0;
+    memset(histogram, 0, sizeof(histogram));
+    histDirty = (1UL << MONITOR_HIST_BINS) - 1;
+    fpsWindowFrames = fps = 0;
+  }
+
+  // 0 = newest
+  const MonitorFrame &newest(int back) const {
+    return frames[(head + MONITOR_SLOTS - 1 - back) % MONITOR_SLOTS];
+  }
+
+  MonitorFrame &add(const IrFrame &frame, uint32_t nowMs) {
+    MonitorFrame &slot = frames[head];
+    if (count == MONITOR_SLOTS) countDurations(slot, -1);
+    else count++;
+    head = (head + 1) % MONITOR_SLOTS;
+
+    slot.seq = ++totalFrames;
+    slot.timeMs = nowMs;
+    slot.len = frame.len;
+    memcpy(slot.durations, frame.durations, frame.len * sizeof(uint16_t));
+    slot.decoded = false;
+    slot.protocol = 0;
+    slot.address = slot.command = 0;
+    slot.carrierHz = 0;
+    countDurations(slot, 1);
+    fpsWindowFrames++;
+    return slot;
+  }
+
+  // Frames per second over the last complete window
+  void tick(uint32_t nowMs) {
+    if (nowMs - fpsWindowStartMs < MONITOR_FPS_WINDOW_MS) return;
+    fps = nowMs - fpsWindowStartMs < 2 * MONITOR_FPS_WINDOW_MS ? fpsWindowFrames : 0;
+    fpsWindowFrames = 0;
+    fpsWindowStartMs = nowMs;
+  }
+
+  uint16_t histogramMax() const {
+    uint16_t m = 0;
+    for (uint16_t c : histogram)
+      if (c > m) m = c;
+    return m;
+  }
+
+private:
+  void countDurations(const MonitorFrame &f, int delta) {
+    for (uint8_t i = 0; i < f.len; i++) {
+      uint8_t bin = monitorHistBin(f.durations[i]);
+      histogram[bin] += delta;
+      histDirty |= 1UL << bin;
+    }
+  }
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+// ============================================================
+// Natural sort
+// ============================================================
+// Orders names the way people read them: directories first, case folded,
+// digit runs compared by value so "SESS-2" < "SESS-10". Sorting moves
+// 8-byte NaturalSortKeys, never the strings: a key's head packs the
+// directory flag and the first three folded characters, so most
+// comparisons are one integer compare and only ties look at the names.
+// Callers keep the names in their own numbered slots.
+struct NaturalSortKey {
+  uint32_t head;
+  uint16_t slot;  // caller storage holding the name
+  uint16_t pos;   // caller's own tag, e.g. the entry's position in its directory
+};
+
+inline bool naturalDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+inline uint8_t naturalFold(char c) {
+  return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : (uint8_t)c;
+}
+
+// <0, 0, >0 like strcmp. A digit run sorts before any other character,
+// which is what lets the head encode every digit as 0x01.
+inline int naturalCompare(const char *a, const char *b) {
+  const char *a0 = a, *b0 = b;
+  while (*a && *b) {
+    bool da = naturalDigit(*a), db = naturalDigit(*b);
+    if (da != db) return da ? -1 : 1;
+    if (da) {
+      while (*a == '0') a++;
+      while (*b == '0') b++;
+      const char *ae = a, *be = b;
+      while (naturalDigit(*ae)) ae++;
+      while (naturalDigit(*be)) be++;
+      if (ae - a != be - b) return (ae - a) < (be - b) ? -1 : 1;
+      for (; a < ae; a++, b++)
+        if (*a != *b) return *a < *b ? -1 : 1;
+      continue;
+    }
+    uint8_t ca = naturalFold(*a), cb = naturalFold(*b);
+    if (ca != cb) return ca < cb ? -1 : 1;
+    a++;
+    b++;
+  }
+  if (*a || *b) return *a ? 1 : -1;
+  return strcmp(a0, b0);  // equal but for case or leading zeros
+}
+
+// Heads order exactly like naturalCompare wherever they differ: 0x00
+// past the end, 0x01 from the first digit on, folded characters before it
+inline uint32_t naturalSortHead(const char *name, bool isDir) {
+  uint32_t head = isDir ? 0 : 0x80000000u;
+  for (int shift = 16; shift >= 0; shift -= 8) {
+    uint8_t c = 0;
+    if (*name) c = naturalDigit(*name) ? 1 : naturalFold(*name++);
+    head |= (uint32_t)c << shift;
+  }
+  return head;
+}
+
+// NameOf(slot) -> const char *
+template<typename NameOf>
+inline bool naturalKeyLess(const NaturalSortKey &a, const NaturalSortKey &b, NameOf &nameOf) {
+  if (a.head != b.head) return a.head < b.head;
+  return naturalCompare(nameOf(a.slot), nameOf(b.slot)) < 0;
+}
+
+template<typename NameOf>
+void naturalSort(NaturalSortKey *keys, uint16_t n, NameOf nameOf) {
+  std::sort(keys, keys + n, [&](const NaturalSortKey &a, const NaturalSortKey &b) {
+    return naturalKeyLess(a, b, nameOf);
+  });
+}
+
+// Rearranges caller storage to match sorted keys in one pass over the
+// permutation's cycles. move(dst, src) copies slot src into slot dst;
+// -1 stands for a single spare slot. Leaves keys[i].slot == i.
+template<typename Move>
+void naturalApplyOrder(NaturalSortKey *keys, uint16_t n, Move move) {
+  for (uint16_t i = 0; i < n; i++) {
+    if (keys[i].slot == i) continue;
+    move(-1, i);
+    uint16_t j = i;
+    while (keys[j].slot != i) {
+      uint16_t src = keys[j].slot;
+      move(j, src);
+      keys[j].slot = j;
+      j = src;
+    }
+    move(j, -1);
+    keys[j].slot = j;
+  }
+}
+
+// Keeps the `capacity` first names in natural order out of a stream of
+// any length, as a max-heap on the last one kept. For each candidate:
+// slotFor() says where to store it (or -1 when it doesn't make the cut),
+// the caller stores the name there, then place() admits it.
+template<typename NameOf>
+class NaturalTopK {
+  NaturalSortKey *keys;
+  uint16_t cap;
+  uint16_t n = 0;
+  NameOf nameOf;
+  uint32_t pendingHead = 0;
+  uint16_t pendingSlot = 0;
+
+  bool less(const NaturalSortKey &a, const NaturalSortKey &b) {
+    return naturalKeyLess(a, b, nameOf);
+  }
+
+public:
+  NaturalTopK(NaturalSortKey *storage, uint16_t capacity, NameOf names)
+    : keys(storage), cap(capacity), nameOf(names) {}
+
+  int slotFor(const char *name, bool isDir) {
+    if (cap == 0) return -1;
+    uint32_t head = naturalSortHead(name, isDir);
+    auto cmp = [this](const NaturalSortKey &a, const NaturalSortKey &b) {
+      return less(a, b);
+    };
+    if (n < cap) {
+      pendingSlot = n;
+    } else {
+      const NaturalSortKey &worst = keys[0];
+      if (head > worst.head || (head == worst.head && naturalCompare(name, nameOf(worst.slot)) >= 0)) return -1;
+      std::pop_heap(keys, keys + n, cmp);
+      pendingSlot = keys[--n].slot;
+    }
+    pendingHead = head;
+    return pendingSlot;
+  }
+
+  void place(uint16_t pos) {
+    keys[n++] = { pendingHead, pendingSlot, pos };
+    std::push_heap(keys, keys + n, [this](const NaturalSortKey &a, const NaturalSortKey &b) {
+      return less(a, b);
+    });
+  }
+
+  // Sorts what was kept in place; returns how many
+  uint16_t finish() {
+    std::sort_heap(keys, keys + n, [this](const NaturalSortKey &a, const NaturalSortKey &b) {
+      return less(a, b);
+    });
+    return n;
+  }
+};
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "./IR-signal.h"
+#include "./IR-protocols.h"
+
+// ============================================================
+// Signal pack
+// ============================================================
+// One read-only file holding a whole code library:
+//   PackHeader
+//   PackBrandEntry[brandCount]  sorted by name
+//   PackCodeEntry[codeCount]    grouped by brand in brand order, sorted by name within a brand
+//   payloads                    addressed by PackCodeEntry::payloadOffset
+// Index entries are fixed-size so entry i lives at a computed offset:
+// the reader seeks straight to it and never holds more than a few
+// entries in RAM, however large the pack.
+constexpr uint32_t PACK_MAGIC = 0x4B505249;  // "IRPK"
+constexpr uint16_t PACK_VERSION = 1;
+constexpr int PACK_NAME_CHARS = 24;  // including the terminator
+
+constexpr uint8_t PACK_KIND_PROTOCOL = 0;  // PackProtocolPayload, timings generated on load
+constexpr uint8_t PACK_KIND_RAW = 1;       // PackRawPayload + durations
+
+struct PackHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t brandCount;
+  uint32_t codeCount;
+  uint32_t brandIndexOffset;
+  uint32_t codeIndexOffset;
+  uint32_t fileSize;
+} __attribute__((packed));
+
+struct PackBrandEntry {
+  char name[PACK_NAME_CHARS];
+  uint32_t firstCode;
+  uint32_t codeCount;
+} __attribute__((packed));
+
+struct PackCodeEntry {
+  char name[PACK_NAME_CHARS];
+  uint32_t payloadOffset;
+  uint16_t payloadLen;
+  uint8_t kind;
+  uint8_t protocol;  // IrProtocol for PACK_KIND_PROTOCOL, shown in lists
+} __attribute__((packed));
+
+struct PackProtocolPayload {
+  uint32_t address;
+  uint16_t command;
+} __attribute__((packed));
+
+struct PackRawPayload {
+  uint32_t carrierHz;
+  uint32_t oncePeriodUs;
+  uint32_t repeatPeriodUs;
+  uint8_t rawDataLen;
+  uint8_t repeatLen;
+} __attribute__((packed));
+
+// Names compare like strncmp over the fixed field; a shorter prefix
+// sorts before every name that starts with it
+inline int packNameCompare(const char *a, const char *b) {
+  return strncmp(a, b, PACK_NAME_CHARS);
+}
+
+// Source needs bool seek(uint32_t) and size_t read(uint8_t *, size_t) —
+// an Arduino File works as-is. Lists render one row at a time, so the
+// last few entries read are kept in a small direct-mapped cache.
+template<typename Source>
+class IrPackReader {
+  static constexpr uint8_t CACHE_ROWS = 16;
+
+  Source *src = nullptr;
+  PackHeader header;
+  PackBrandEntry brandCache[CACHE_ROWS];
+  PackCodeEntry codeCache[CACHE_ROWS];
+  int32_t brandCacheIdx[CACHE_ROWS], codeCacheIdx[CACHE_ROWS];
+
+  bool readAt(uint32_t offset, void *out, size_t n) {
+    if (!src || offset + n > header.fileSize) return false;
+    if (!src->seek(offset)) return false;
+    return src->read((uint8_t *)out, n) == n;
+  }
+
+public:
+  bool open(Source &source, uint32_t fileSize) {
+    src = &source;
+    header.fileSize = sizeof(PackHeader);
+    for (uint8_t i = 0; i < CACHE_ROWS; i++) brandCacheIdx[i] = codeCacheIdx[i] = -1;
+    PackHeader h;
+    if (!readAt(0, &h, sizeof(h))) return close();
+    if (h.magic != PACK_MAGIC || h.version != PACK_VERSION || h.fileSize != fileSize) return close();
+    if (h.brandIndexOffset + (uint64_t)h.brandCount * sizeof(PackBrandEntry) > fileSize) return close();
+    if (h.codeIndexOffset + (uint64_t)h.codeCount * sizeof(PackCodeEntry) > fileSize) return close();
+    header = h;
+    return true;
+  }
+
+  bool close() {
+    src = nullptr;
+    header.brandCount = 0;
+    header.codeCount = 0;
+    return false;
+  }
+
+  bool isOpen() const {
+    return src != nullptr;
+  }
+  uint16_t brandCount() const {
+    return src ? header.brandCount : 0;
+  }
+  uint32_t codeCount() const {
+    return src ? header.codeCount : 0;
+  }
+
+  bool brand(uint16_t i, PackBrandEntry &out) {
+    if (i >= brandCount()) return false;
+    uint8_t slot = i % CACHE_ROWS;
+    if (brandCacheIdx[slot] != i) {
+      if (!readAt(header.brandIndexOffset + (uint32_t)i * sizeof(PackBrandEntry), &brandCache[slot], sizeof(PackBrandEntry)))
+        return false;
+      brandCache[slot].name[PACK_NAME_CHARS - 1] = '\0';
+      if (brandCache[slot].firstCode > header.codeCount || brandCache[slot].codeCount > header.codeCount - brandCache[slot].firstCode)
+        brandCache[slot].codeCount = 0;
+      brandCacheIdx[slot] = i;
+    }
+    out = brandCache[slot];
+    return true;
+  }
+
+  bool code(uint32_t i, PackCodeEntry &out) {
+    if (i >= codeCount()) return false;
+    uint8_t slot = i % CACHE_ROWS;
+    if (codeCacheIdx[slot] != (int32_t)i) {
+      if (!readAt(header.codeIndexOffset + i * sizeof(PackCodeEntry), &codeCache[slot], sizeof(PackCodeEntry)))
+        return false;
+      codeCache[slot].name[PACK_NAME_CHARS - 1] = '\0';
+      codeCacheIdx[slot] = i;
+    }
+    out = codeCache[slot];
+    return true;
+  }
+
+  // First brand whose name is >= name (brandCount() when none)
+  uint16_t lowerBoundBrand(const char *name) {
+    uint16_t lo = 0, hi = brandCount();
+    PackBrandEntry e;
+    while (lo < hi) {
+      uint16_t mid = lo + (hi - lo) / 2;
+      if (!brand(mid, e)) return brandCount();
+      if (packNameCompare(e.name, name) < 0) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo;
+  }
+
+  // Brand index, or -1
+  int32_t findBrand(const char *name) {
+    uint16_t i = lowerBoundBrand(name);
+    PackBrandEntry e;
+    return brand(i, e) && packNameCompare(e.name, name) == 0 ? i : -1;
+  }
+
+  // Code index within the whole pack, or -1
+  int32_t findCode(const PackBrandEntry &b, const char *name) {
+    uint32_t lo = b.firstCode, hi = b.firstCode + b.codeCount;
+    PackCodeEntry e;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (!code(mid, e)) return -1;
+      if (packNameCompare(e.name, name) < 0) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo < b.firstCode + b.codeCount && code(lo, e) && packNameCompare(e.name, name) == 0 ? (int32_t)lo : -1;
+  }
+
+  // Brand holding code i, or -1; brands hold consecutive code ranges in order
+  int32_t brandOfCode(uint32_t i) {
+    uint16_t lo = 0, hi = brandCount();
+    PackBrandEntry e;
+    while (lo < hi) {
+      uint16_t mid = lo + (hi - lo) / 2;
+      if (!brand(mid, e)) return -1;
+      if (e.firstCode + e.codeCount <= i) lo = mid + 1;
+      else hi = mid;
+    }
+    return brand(lo, e) && i >= e.firstCode && i < e.firstCode + e.codeCount ? lo : -1;
+  }
+
+  // Seeks to the one payload and decodes it; name is "BRAND CODE"
+  bool loadSignal(const PackBrandEntry &b, uint32_t codeIdx, IRSignal &out, bool toggle = false) {
+    PackCodeEntry e;
+    if (!code(codeIdx, e)) return false;
+    if (e.kind == PACK_KIND_PROTOCOL) {
+      PackProtocolPayload p;
+      if (e.payloadLen != sizeof(p) || !readAt(e.payloadOffset, &p, sizeof(p))) return false;
+      if (!generateSignal(e.protocol, p.address, p.command, out, toggle)) return false;
+    } else if (e.kind == PACK_KIND_RAW) {
+      PackRawPayload p;
+      if (e.payloadLen < sizeof(p) || !readAt(e.payloadOffset, &p, sizeof(p))) return false;
+      if (p.rawDataLen > MAX_RAW_LEN || e.payloadLen != sizeof(p) + p.rawDataLen * sizeof(uint16_t)) return false;
+      memset(&out, 0, sizeof(IRSignal));
+      if (!readAt(e.payloadOffset + sizeof(p), out.rawData, p.rawDataLen * sizeof(uint16_t))) return false;
+      out.rawDataLen = p.rawDataLen;
+      out.repeatLen = p.repeatLen;
+      out.oncePeriodUs = p.oncePeriodUs;
+      out.repeatPeriodUs = p.repeatPeriodUs;
+      out.carrierHz = p.carrierHz;
+      sanitizeSignal(out);
+    } else {
+      return false;
+    }
+    // Two pack names can be longer than a signal name: keep the start and mark the cut
+    if (snprintf(out.name, sizeof(out.name), "%s %s", b.name, e.name) >= (int)sizeof(out.name)) out.name[sizeof(out.name) - 2] = '~';
+    return true;
+  }
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================
+// Performance counters
+// ============================================================
+// Latencies go into fixed-size histograms: one octave of microseconds
+// per 4 buckets, so a percentile read back is within 25% of the true
+// value from 1 us to over an hour. add() is a few shifts and an
+// increment, with no allocation, so the counters stay on in release
+// builds; whoever reports a window clears it afterwards.
+constexpr uint8_t PERF_SUB_BITS = 2;
+constexpr uint8_t PERF_BUCKETS = 32 << PERF_SUB_BITS;
+
+struct PerfHistogram {
+  uint32_t counts[PERF_BUCKETS];
+  uint32_t n, maxUs;
+
+  // Values below 4 us get a bucket each; above that the top three bits
+  // pick the bucket within the octave
+  static uint8_t bucketOf(uint32_t us) {
+    if (us < (1u << PERF_SUB_BITS)) return us;
+    uint8_t octave = 31 - __builtin_clz(us);
+    uint8_t sub = (us >> (octave - PERF_SUB_BITS)) & ((1u << PERF_SUB_BITS) - 1);
+    return ((octave - PERF_SUB_BITS + 1) << PERF_SUB_BITS) + sub;
+  }
+  // Largest value that lands in bucket b
+  static uint32_t bucketTop(uint8_t b) {
+    if (b < (1u << PERF_SUB_BITS)) return b;
+    uint8_t octave = (b >> PERF_SUB_BITS) + PERF_SUB_BITS - 1;
+    uint32_t sub = b & ((1u << PERF_SUB_BITS) - 1);
+    uint64_t top = ((uint64_t)((1u << PERF_SUB_BITS) + sub + 1) << (octave - PERF_SUB_BITS)) - 1;
+    return top > UINT32_MAX ? UINT32_MAX : (uint32_t)top;
+  }
+
+  void add(uint32_t us) {
+    counts[bucketOf(us)]++;
+    n++;
+    if (us > maxUs) maxUs = us;
+  }
+  void clear() {
+    memset(this, 0, sizeof(*this));
+  }
+  // Upper edge of the bucket holding the pct-th percentile, capped at
+  // the largest value seen; 0 when empty
+  uint32_t percentile(uint8_t pct) const {
+    if (!n) return 0;
+    uint32_t rank = ((uint64_t)n * pct + 99) / 100, seen = 0;
+    for (uint8_t b = 0; b < PERF_BUCKETS; b++) {
+      seen += counts[b];
+      if (seen >= rank && seen) return bucketTop(b) < maxUs ? bucketTop(b) : maxUs;
+    }
+    return maxUs;
+  }
+};
+
+struct PerfCounters {
+  PerfHistogram loop;           // loop() start to start, delays included
+  PerfHistogram render;         // list rows drawn into the sprite
+  PerfHistogram present;        // sprite pushed to the panel
+  PerfHistogram touchCallback;  // touch seen -> button callback starts
+  PerfHistogram tapToIr;        // touch seen -> first IR frame starts
+  PerfHistogram sd;             // one SD operation (file load/store, listing, sync chunk)
+  PerfHistogram touchLag;       // touch filter lag, while the finger moves
+  uint32_t spriteAllocFailures;
+  uint32_t windowStartMs;
+
+  void clearWindow(uint32_t nowMs) {
+    uint32_t failures = spriteAllocFailures;
+    memset(this, 0, sizeof(*this));
+    spriteAllocFailures = failures;
+    windowStartMs = nowMs;
+  }
+};
+
+// One JSON object per line, all times in microseconds
+inline int formatPerfJson(char *out, size_t n, const PerfCounters &c, uint32_t nowMs, uint32_t freeHeap, uint32_t largestBlock) {
+  struct {
+    const char *name;
+    const PerfHistogram &h;
+  } rows[] = { { "loop", c.loop }, { "render", c.render }, { "present", c.present },
+               { "touch_cb", c.touchCallback }, { "tap_ir", c.tapToIr }, { "sd", c.sd },
+               { "touch_lag", c.touchLag } };
+  int len = snprintf(out, n, "{\"perf\":{\"ms\":%lu,\"window_ms\":%lu", (unsigned long)nowMs,
+                     (unsigned long)(nowMs - c.windowStartMs));
+  for (auto &r : rows) {
+    if ((size_t)len >= n) break;
+    len += snprintf(out + len, n - len, ",\"%s\":{\"n\":%lu,\"p50\":%lu,\"p95\":%lu,\"p99\":%lu,\"max\":%lu}", r.name,
+                    (unsigned long)r.h.n, (unsigned long)r.h.percentile(50), (unsigned long)r.h.percentile(95),
+                    (unsigned long)r.h.percentile(99), (unsigned long)r.h.maxUs);
+  }
+  if ((size_t)len < n)
+    len += snprintf(out + len, n - len, ",\"heap_free\":%lu,\"heap_block\":%lu,\"sprite_fail\":%lu}}\n",
+                    (unsigned long)freeHeap, (unsigned long)largestBlock, (unsigned long)c.spriteAllocFailures);
+  return len;
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "./IR-signal.h"
+
+// ============================================================
+// Protocol generators
+// ============================================================
+// Produce a signal from (protocol, address, command) on demand, in the
+// same once/repeat layout prontoToSignal() produces, so the transmit
+// path can't tell a generated code from a learned one.
+enum IrProtocol : uint8_t {
+  IR_PROTO_NEC,         // 8-bit address (+ inverse) or 16-bit extended; repeat burst while held
+  IR_PROTO_NEC2,        // NEC frame that repeats as a whole frame (Epson, BenQ)
+  IR_PROTO_NECX,        // 4.5 ms leader, 16-bit address, whole-frame repeat (Samsung)
+  IR_PROTO_KASEIKYO,    // 48 bit: vendor (address >> 16), 12-bit address, 8-bit command
+  IR_PROTO_KASEIKYO56,  // 56 bit: as above with a 16-bit command (Panasonic projectors)
+  IR_PROTO_SONY12,      // 7-bit command, 5-bit address
+  IR_PROTO_SONY15,      // 7-bit command, 8-bit address
+  IR_PROTO_SONY20,      // 7-bit command, 13-bit address (5 + 8 extended)
+  IR_PROTO_RC5,         // 5-bit address, 7-bit command (bit 6 in the field bit)
+  IR_PROTO_RC6,         // mode 0: 8-bit address, 8-bit command
+  IR_PROTO_COUNT
+};
+
+constexpr uint32_t NEC_PERIOD_US = 108000;
+constexpr uint16_t NEC_UNIT_US = 560;
+constexpr uint16_t KASEIKYO_UNIT_US = 432;
+constexpr uint32_t KASEIKYO_PERIOD_US = 130000;
+constexpr uint16_t KASEIKYO_DEFAULT_VENDOR = 0x2002;  // Panasonic
+constexpr uint16_t SONY_UNIT_US = 600;
+constexpr uint32_t SONY_PERIOD_US = 45000;
+constexpr uint8_t SONY_PRESS_FRAMES = 3;  // receivers act on a frame seen three times
+constexpr uint16_t RC5_HALF_BIT_US = 889;
+constexpr uint32_t RC5_PERIOD_US = 113778;
+constexpr uint16_t RC6_UNIT_US = 444;
+constexpr uint32_t RC6_PERIOD_US = 107000;
+
+inline const char *irProtocolName(uint8_t protocol) {
+  static const char *const NAMES[IR_PROTO_COUNT] = { "NEC", "NEC2", "NECx", "Kaseikyo", "Kaseikyo56",
+                                                     "Sony12", "Sony15", "Sony20", "RC5", "RC6" };
+  return protocol < IR_PROTO_COUNT ? NAMES[protocol] : "?";
+}
+
+inline uint32_t irProtocolCarrierHz(uint8_t protocol) {
+  switch (protocol) {
+    case IR_PROTO_KASEIKYO:
+    case IR_PROTO_KASEIKYO56: return 37000;
+    case IR_PROTO_SONY12:
+    case IR_PROTO_SONY15:
+    case IR_PROTO_SONY20: return 40000;
+    case IR_PROTO_RC5:
+    case IR_PROTO_RC6: return 36000;
+    default: return 38000;
+  }
+}
+
+// Appends levels to a signal, merging neighbours of the same level
+// (Manchester codes produce those) and closing each section with a
+// lead-out space that pads it to the protocol period.
+class SignalBuilder {
+  IRSignal &signal;
+  uint32_t sectionStartUs = 0, elapsedUs = 0;
+  uint8_t sectionStart = 0;
+
+public:
+  bool overflow = false;
+
+  explicit SignalBuilder(IRSignal &out)
+    : signal(out) {
+    memset(&signal, 0, sizeof(IRSignal));
+  }
+
+  void add(uint32_t us, bool mark) {
+    uint8_t n = signal.rawDataLen;
+    if (n == sectionStart && !mark) return;  // sections start with a mark (RC5's first half-bit)
+    elapsedUs += us;
+    bool lastIsMark = ((n - sectionStart) & 1) == 1;
+    if (n > sectionStart && lastIsMark == mark) {
+      uint32_t merged = signal.rawData[n - 1] + us;
+      signal.rawData[n - 1] = merged > 65535 ? 65535 : (uint16_t)merged;
+      return;
+    }
+    if (n >= MAX_RAW_LEN) {
+      overflow = true;
+      return;
+    }
+    signal.rawData[signal.rawDataLen++] = us > 65535 ? 65535 : (uint16_t)us;
+  }
+  void mark(uint32_t us) {
+    add(us, true);
+  }
+  void space(uint32_t us) {
+    add(us, false);
+  }
+
+  // Time since the current section started
+  uint32_t sectionUs() const {
+    return elapsedUs - sectionStartUs;
+  }
+
+  // Pads the section to periodUs (never less than minGapUs of gap) and
+  // returns its true length, which a clamped uint16_t entry can't hold
+  uint32_t endSection(uint32_t periodUs, uint16_t minGapUs) {
+    uint32_t frameUs = elapsedUs - sectionStartUs;
+    uint32_t gap = periodUs > frameUs + minGapUs ? periodUs - frameUs : minGapUs;
+    space(gap);  // merges into a trailing half-bit space
+    uint32_t total = frameUs + gap;
+    sectionStart = signal.rawDataLen;
+    sectionStartUs = elapsedUs;
+    return total;
+  }
+
+  // Everything added so far becomes the once part, the rest the repeat part
+  void onceDone(uint32_t periodUs) {
+    signal.oncePeriodUs = periodUs;
+  }
+  void repeatDone(uint32_t periodUs, uint8_t onceLen) {
+    signal.repeatLen = signal.rawDataLen - onceLen;
+    signal.repeatPeriodUs = periodUs;
+  }
+};
+
+// Pulse-distance bits, least significant bit of each byte first
+inline void addPulseDistanceBytes(SignalBuilder &b, const uint8_t *bytes, uint8_t count, uint16_t unitUs, uint8_t oneSpaceUnits) {
+  for (uint8_t i = 0; i < count; i++) {
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      b.mark(unitUs);
+      b.space(bytes[i] & (1 << bit) ? unitUs * oneSpaceUnits : unitUs);
+    }
+  }
+  b.mark(unitUs);  // stop bit
+}
+
+inline void addNecFrame(SignalBuilder &b, uint16_t leaderMarkUs, uint32_t address, uint16_t command, bool forceExtended) {
+  uint8_t bytes[4];
+  bytes[0] = address & 0xFF;
+  bytes[1] = (address > 0xFF || forceExtended) ? (address >> 8) & 0xFF : ~address & 0xFF;
+  bytes[2] = command & 0xFF;
+  bytes[3] = ~command & 0xFF;
+  b.mark(leaderMarkUs);
+  b.space(4500);
+  addPulseDistanceBytes(b, bytes, 4, NEC_UNIT_US, 3);
+}
+
+inline void addKaseikyoFrame(SignalBuilder &b, uint32_t address, uint16_t command, bool wideCommand) {
+  uint16_t vendor = address >> 16 ? address >> 16 : KASEIKYO_DEFAULT_VENDOR;
+  uint8_t vendorParity = (vendor ^ (vendor >> 8)) & 0xFF;
+  vendorParity = (vendorParity ^ (vendorParity >> 4)) & 0x0F;
+  uint8_t bytes[7];
+  uint8_t n = 0;
+  bytes[n++] = vendor & 0xFF;
+  bytes[n++] = vendor >> 8;
+  bytes[n++] = vendorParity | ((address & 0x0F) << 4);
+  bytes[n++] = (address >> 4) & 0xFF;
+  bytes[n++] = command & 0xFF;
+  if (wideCommand) bytes[n++] = command >> 8;
+  uint8_t parity = 0;
+  for (uint8_t i = 2; i < n; i++) parity ^= bytes[i];
+  bytes[n++] = parity;
+  b.mark(KASEIKYO_UNIT_US * 8);
+  b.space(KASEIKYO_UNIT_US * 4);
+  addPulseDistanceBytes(b, bytes, n, KASEIKYO_UNIT_US, 3);
+}
+
+// Pulse-width: mark length carries the bit, LSB first
+inline void addSonyFrame(SignalBuilder &b, uint32_t address, uint16_t command, uint8_t addressBits) {
+  uint32_t value = (command & 0x7F) | (address << 7);
+  b.mark(SONY_UNIT_US * 4);
+  for (uint8_t i = 0; i < 7 + addressBits; i++) {
+    b.space(SONY_UNIT_US);
+    b.mark(value & (1UL << i) ? SONY_UNIT_US * 2 : SONY_UNIT_US);
+  }
+}
+
+// Manchester, MSB first. RC5 "1" is space-then-mark, RC6 the opposite.
+inline void addBiphaseBit(SignalBuilder &b, bool one, uint16_t halfUs, bool markFirstForOne) {
+  bool markFirst = one == markFirstForOne;
+  b.add(halfUs, markFirst);
+  b.add(halfUs, !markFirst);
+}
+
+inline void addRc5Frame(SignalBuilder &b, uint32_t address, uint16_t command, bool toggle) {
+  uint16_t bits = (1 << 13) | ((command & 0x40) ? 0 : 1 << 12) | (toggle ? 1 << 11 : 0) | ((address & 0x1F) << 6) | (command & 0x3F);
+  for (int i = 13; i >= 0; i--) addBiphaseBit(b, bits & (1 << i), RC5_HALF_BIT_US, false);
+}
+
+inline void addRc6Frame(SignalBuilder &b, uint32_t address, uint16_t command, bool toggle) {
+  b.mark(RC6_UNIT_US * 6);
+  b.space(RC6_UNIT_US * 2);
+  addBiphaseBit(b, true, RC6_UNIT_US, true);                       // start bit
+  for (int i = 0; i < 3; i++) addBiphaseBit(b, false, RC6_UNIT_US, true);  // mode 0
+  addBiphaseBit(b, toggle, RC6_UNIT_US * 2, true);                 // trailer bit is double length
+  uint16_t bits = ((address & 0xFF) << 8) | (command & 0xFF);
+  for (int i = 15; i >= 0; i--) addBiphaseBit(b, bits & (1 << i), RC6_UNIT_US, true);
+}
+
+// NEC sends its frame once and then short repeat bursts. A Sony press is
+// SONY_PRESS_FRAMES frames, then one more per period while held. Every
+// other protocol here repeats the whole frame, so it is stored as
+// repeat-only. toggle is the RC5/RC6 toggle bit, which the caller flips
+// on each new press so a receiver can tell it from a held key.
+inline bool generateSignal(uint8_t protocol, uint32_t address, uint16_t command, IRSignal &out, bool toggle = false) {
+  SignalBuilder b(out);
+  uint32_t period = 0;
+  switch (protocol) {
+    case IR_PROTO_NEC:
+      addNecFrame(b, 9000, address, command, false);
+      b.onceDone(b.endSection(NEC_PERIOD_US, NEC_UNIT_US));
+      {
+        uint8_t onceLen = out.rawDataLen;
+        b.mark(9000);
+        b.space(2250);
+        b.mark(NEC_UNIT_US);
+        b.repeatDone(b.endSection(NEC_PERIOD_US, NEC_UNIT_US), onceLen);
+      }
+      break;
+    case IR_PROTO_NEC2:
+      addNecFrame(b, 9000, address, command, false);
+      period = b.endSection(NEC_PERIOD_US, NEC_UNIT_US);
+      break;
+    case IR_PROTO_NECX:
+      addNecFrame(b, 4500, address, command, true);
+      period = b.endSection(NEC_PERIOD_US, NEC_UNIT_US);
+      break;
+    case IR_PROTO_KASEIKYO:
+    case IR_PROTO_KASEIKYO56:
+      addKaseikyoFrame(b, address, command, protocol == IR_PROTO_KASEIKYO56);
+      period = b.endSection(KASEIKYO_PERIOD_US, KASEIKYO_UNIT_US);
+      break;
+    case IR_PROTO_SONY12:
+    case IR_PROTO_SONY15:
+    case IR_PROTO_SONY20:
+      {
+        uint8_t addressBits = protocol == IR_PROTO_SONY12 ? 5 : protocol == IR_PROTO_SONY15 ? 8 : 13;
+        uint32_t onceUs = 0;
+        for (uint8_t i = 0; i < SONY_PRESS_FRAMES; i++) {
+          addSonyFrame(b, address, command, addressBits);
+          onceUs += b.endSection(SONY_PERIOD_US, SONY_UNIT_US);
+        }
+        b.onceDone(onceUs);
+        uint8_t onceLen = out.rawDataLen;
+        addSonyFrame(b, address, command, addressBits);
+        b.repeatDone(b.endSection(SONY_PERIOD_US, SONY_UNIT_US), onceLen);
+      }
+      break;
+    case IR_PROTO_RC5:
+      addRc5Frame(b, address, command, toggle);
+      period = b.endSection(RC5_PERIOD_US, RC5_HALF_BIT_US);
+      break;
+    case IR_PROTO_RC6:
+      addRc6Frame(b, address, command, toggle);
+      period = b.endSection(RC6_PERIOD_US, RC6_UNIT_US);
+      break;
+    default:
+      return false;
+  }
+  if (period) b.repeatDone(period, 0);
+  out.carrierHz = irProtocolCarrierHz(protocol);
+  return !b.overflow && out.rawDataLen > 0;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stdint.h>
+#include "./IR-signal.h"
+
+// ============================================================
+// RMT item encoding
+// ============================================================
+// Turns mark/space durations into RMT items once per signal so the
+// peripheral can play them back while loop() keeps running.
+// Item layout matches rmt_item32_t: duration0:15 level0:1 duration1:15 level1:1
+constexpr uint32_t RMT_SOURCE_CLOCK_HZ = 80000000;  // APB
+constexpr uint8_t RMT_CLOCK_DIV = 80;               // 1 tick = 1 µs
+constexpr uint32_t RMT_TICK_NS = 1000000000UL / (RMT_SOURCE_CLOCK_HZ / RMT_CLOCK_DIV);
+constexpr uint16_t RMT_MAX_HALF_TICKS = 32767;
+// Every uint16_t entry fits in two halves, plus room for a stretched lead-out
+constexpr int RMT_MAX_ITEMS = MAX_RAW_LEN + 16;
+constexpr uint8_t RMT_CARRIER_DUTY_PERCENT = 33;
+constexpr int RMT_CACHE_SLOTS = 4;
+
+struct RmtFrame {
+  uint32_t items[RMT_MAX_ITEMS];
+  uint16_t itemCount;
+  bool truncated;
+};
+
+inline uint32_t rmtItem(uint16_t duration0, bool level0, uint16_t duration1, bool level1) {
+  return (uint32_t)duration0 | ((uint32_t)level0 << 15) | ((uint32_t)duration1 << 16) | ((uint32_t)level1 << 31);
+}
+
+// Appends level halves two per item, splitting anything over 15 bits
+class RmtItemWriter {
+  RmtFrame &frame;
+  uint16_t pendingTicks = 0;
+  bool pendingLevel = false, hasPending = false;
+
+  bool pushHalf(uint16_t ticks, bool level) {
+    if (!hasPending) {
+      pendingTicks = ticks;
+      pendingLevel = level;
+      hasPending = true;
+      return true;
+    }
+    if (frame.itemCount >= RMT_MAX_ITEMS) return false;
+    frame.items[frame.itemCount++] = rmtItem(pendingTicks, pendingLevel, ticks, level);
+    hasPending = false;
+    return true;
+  }
+
+public:
+  explicit RmtItemWriter(RmtFrame &out)
+    : frame(out) {
+    frame.itemCount = 0;
+    frame.truncated = false;
+  }
+
+  bool add(uint32_t ticks, bool level) {
+    while (ticks > 0) {
+      uint16_t half = ticks > RMT_MAX_HALF_TICKS ? RMT_MAX_HALF_TICKS : (uint16_t)ticks;
+      if (!pushHalf(half, level)) {
+        frame.truncated = true;
+        return false;
+      }
+      ticks -= half;
+    }
+    return true;
+  }
+
+  // A zero-length second half doubles as the end marker
+  void finish() {
+    if (!hasPending) return;
+    if (frame.itemCount < RMT_MAX_ITEMS) {
+      frame.items[frame.itemCount++] = rmtItem(pendingTicks, pendingLevel, 0, false);
+    } else {
+      frame.truncated = true;
+    }
+    hasPending = false;
+  }
+};
+
+// Rounds on the running total rather than per entry, so a long frame
+// never drifts by more than half a tick. When periodUs is longer than
+// the durations add up to, the trailing space is stretched to match.
+inline bool encodeRmtFrame(const uint16_t *durations, uint8_t len, uint32_t periodUs, uint32_t tickNs, RmtFrame &out) {
+  RmtItemWriter writer(out);
+  uint64_t elapsedNs = 0;
+  uint32_t elapsedTicks = 0, totalUs = 0;
+  bool ok = true;
+
+  for (uint8_t i = 0; i < len && ok; i++) {
+    totalUs += durations[i];
+    elapsedNs += (uint64_t)durations[i] * 1000;
+    uint32_t endTicks = (uint32_t)((elapsedNs + tickNs / 2) / tickNs);
+    ok = writer.add(endTicks - elapsedTicks, (i & 1) == 0);
+    elapsedTicks = endTicks;
+  }
+  if (ok && periodUs > totalUs) {
+    uint32_t endTicks = (uint32_t)(((uint64_t)periodUs * 1000 + tickNs / 2) / tickNs);
+    writer.add(endTicks - elapsedTicks, false);
+  }
+  writer.finish();
+  return !out.truncated;
+}
+
+// Carrier high/low lengths in source clock ticks
+inline void rmtCarrierTicks(uint32_t carrierHz, uint32_t sourceClockHz, uint16_t &highTicks, uint16_t &lowTicks) {
+  uint32_t period = (sourceClockHz + carrierHz / 2) / carrierHz;
+  if (period > 0xFFFF) period = 0xFFFF;
+  highTicks = (uint16_t)((period * RMT_CARRIER_DUTY_PERCENT + 50) / 100);
+  lowTicks = (uint16_t)(period - highTicks);
+}
+
+// ============================================================
+// Per-signal cache
+// ============================================================
+// Keyed by what goes on air (the name is ignored), least recently used
+// slot is re-encoded on a miss. Callers must not request a new entry
+// while a cached frame is still being transmitted.
+struct RmtCacheEntry {
+  uint32_t key;
+  uint32_t lastUse;
+  uint16_t carrierHighTicks, carrierLowTicks;
+  RmtFrame once, repeat;
+};
+
+inline uint32_t signalContentKey(const IRSignal &signal) {
+  uint32_t h = 2166136261UL;
+  auto mix = [&h](uint32_t v) {
+    for (int b = 0; b < 4; b++) {
+      h ^= (v >> (b * 8)) & 0xFF;
+      h *= 16777619UL;
+    }
+  };
+  for (uint8_t i = 0; i < signal.rawDataLen; i++) mix(signal.rawData[i]);
+  mix(signal.rawDataLen | (signal.repeatLen << 8));
+  mix(signal.oncePeriodUs);
+  mix(signal.repeatPeriodUs);
+  mix(signalCarrierHz(signal));
+  return h ? h : 1;
+}
+
+struct RmtSignalCache {
+  RmtCacheEntry slots[RMT_CACHE_SLOTS] = {};
+  uint32_t useCounter = 0;
+
+  const RmtCacheEntry &get(const IRSignal &signal) {
+    uint32_t key = signalContentKey(signal);
+    RmtCacheEntry *victim = &slots[0];
+    for (RmtCacheEntry &slot : slots) {
+      if (slot.key == key) {
+        slot.lastUse = ++useCounter;
+        return slot;
+      }
+      if (slot.lastUse < victim->lastUse) victim = &slot;
+    }
+    victim->key = key;
+    victim->lastUse = ++useCounter;
+    rmtCarrierTicks(signalCarrierHz(signal), RMT_SOURCE_CLOCK_HZ, victim->carrierHighTicks, victim->carrierLowTicks);
+    uint16_t section[MAX_RAW_LEN];
+    encodeRmtFrame(copySection(signal, 0, signalOnceLen(signal), section), signalOnceLen(signal), signalOncePeriodUs(signal),
+                   RMT_TICK_NS, victim->once);
+    encodeRmtFrame(copySection(signal, signalRepeatStart(signal), signal.repeatLen, section), signal.repeatLen,
+                   signalRepeatPeriodUs(signal), RMT_TICK_NS, victim->repeat);
+    return *victim;
+  }
+};
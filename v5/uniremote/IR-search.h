@@ -0,0 +1,278 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "./IR-pack.h"
+
+// ============================================================
+// Signal name search
+// ============================================================
+// Type-ahead over signal names. A query matches a name when it is a
+// prefix of the name read from one of its word starts: "POW" finds
+// "SAMSUNG POWER", and so does "SAMSUNG PO". Both indexes below are
+// sorted arrays of word starts (every suffix of a name that begins a
+// word), so a query is one lower-bound search and a walk over the
+// matches: the answer a prefix trie gives, without the pointers.
+// Case is folded and '-' / '_' read as spaces.
+inline char searchFold(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+  return (c == '-' || c == '_') ? ' ' : c;
+}
+
+inline bool searchWordStart(const char *name, int i) {
+  return searchFold(name[i]) != ' ' && (i == 0 || searchFold(name[i - 1]) == ' ');
+}
+
+// Sort order of two word suffixes
+inline int searchCompare(const char *a, const char *b) {
+  for (;; a++, b++) {
+    char x = searchFold(*a), y = searchFold(*b);
+    if (x != y) return (uint8_t)x < (uint8_t)y ? -1 : 1;
+    if (!x) return 0;
+  }
+}
+
+// 0 when text starts with query, otherwise which side of it text sorts
+// on. Text is at most n characters and need not be terminated at n; a
+// longer query then matches on its first n characters only.
+inline int searchPrefixCompare(const char *text, const char *query, int n = 0x7FFF) {
+  for (int i = 0; query[i] && i < n; i++) {
+    char t = searchFold(text[i]), q = searchFold(query[i]);
+    if (t != q) return (uint8_t)t < (uint8_t)q ? -1 : 1;
+  }
+  return 0;
+}
+
+inline bool searchNameMatches(const char *name, const char *query) {
+  for (int i = 0; name[i]; i++)
+    if (searchWordStart(name, i) && searchPrefixCompare(name + i, query) == 0) return true;
+  return false;
+}
+
+// ------------------------------------------------------------
+// In-RAM index for names that come and go (saved signals). Names live
+// in fixed slots; the word array is kept sorted, so add() and remove()
+// are a binary search and one memmove. A bulk load appends and sorts
+// once at the end.
+// ------------------------------------------------------------
+constexpr int SEARCH_NAME_CHARS = 32;  // including the terminator
+
+template<uint16_t MaxNames, uint16_t MaxWords>
+class SignalNameIndex {
+  struct Word {
+    uint16_t name;
+    uint8_t at;
+  };
+
+  char names[MaxNames][SEARCH_NAME_CHARS];
+  uint32_t tags[MaxNames];
+  Word words[MaxWords];
+  uint32_t seen[(MaxNames + 31) / 32];
+  uint16_t nameCount = 0, wordCount = 0;
+  bool bulk = false;
+
+  const char *suffix(const Word &w) const {
+    return names[w.name] + w.at;
+  }
+
+  // First word whose suffix is not before text
+  uint16_t lowerBound(const char *text, bool prefix) const {
+    uint16_t lo = 0, hi = wordCount;
+    while (lo < hi) {
+      uint16_t mid = lo + (hi - lo) / 2;
+      int c = prefix ? searchPrefixCompare(suffix(words[mid]), text) : searchCompare(suffix(words[mid]), text);
+      if (c < 0) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo;
+  }
+
+public:
+  SignalNameIndex() {
+    clear();
+  }
+
+  void clear() {
+    for (uint16_t i = 0; i < MaxNames; i++) names[i][0] = '\0';
+    nameCount = wordCount = 0;
+    bulk = false;
+  }
+
+  // Appends without sorting until finishBulk()
+  void beginBulk() {
+    bulk = true;
+  }
+  void finishBulk() {
+    std::sort(words, words + wordCount, [this](const Word &a, const Word &b) {
+      int c = searchCompare(suffix(a), suffix(b));
+      return c ? c < 0 : a.name < b.name;
+    });
+    bulk = false;
+  }
+
+  uint16_t size() const {
+    return nameCount;
+  }
+  const char *name(uint16_t slot) const {
+    return names[slot];
+  }
+  uint32_t tag(uint16_t slot) const {
+    return tags[slot];
+  }
+
+  // False when the name is empty, too long, or the index is full
+  bool add(const char *name, uint32_t tag) {
+    size_t len = strlen(name);
+    if (len == 0 || len >= SEARCH_NAME_CHARS || nameCount >= MaxNames) return false;
+    uint16_t n = 0;
+    for (size_t i = 0; i < len; i++) n += searchWordStart(name, i);
+    if (n == 0 || wordCount + n > MaxWords) return false;
+    uint16_t slot = 0;
+    while (names[slot][0]) slot++;
+    memcpy(names[slot], name, len + 1);
+    tags[slot] = tag;
+    nameCount++;
+    for (size_t i = 0; i < len; i++) {
+      if (!searchWordStart(name, i)) continue;
+      Word w = { slot, (uint8_t)i };
+      uint16_t at = bulk ? wordCount : lowerBound(suffix(w), false);
+      memmove(&words[at + 1], &words[at], (wordCount - at) * sizeof(Word));
+      words[at] = w;
+      wordCount++;
+    }
+    return true;
+  }
+
+  bool remove(const char *name) {
+    uint16_t slot = 0;
+    while (slot < MaxNames && (names[slot][0] == '\0' || strcmp(names[slot], name) != 0)) slot++;
+    if (slot == MaxNames) return false;
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < wordCount; i++)
+      if (words[i].name != slot) words[kept++] = words[i];
+    wordCount = kept;
+    names[slot][0] = '\0';
+    nameCount--;
+    return true;
+  }
+
+  // Counts the names matching query and hands each one, once and in
+  // word order, to visit(slot) until it returns false
+  template<typename Visit>
+  uint32_t query(const char *q, Visit visit) {
+    memset(seen, 0, sizeof(seen));
+    uint32_t matches = 0;
+    bool visiting = true;
+    for (uint16_t i = lowerBound(q, true); i < wordCount && searchPrefixCompare(suffix(words[i]), q) == 0; i++) {
+      uint16_t slot = words[i].name;
+      if (seen[slot / 32] & (1u << (slot % 32))) continue;
+      seen[slot / 32] |= 1u << (slot % 32);
+      matches++;
+      if (visiting) visiting = visit(slot);
+    }
+    return matches;
+  }
+};
+
+// ------------------------------------------------------------
+// Word index for a signal pack, written by the importer next to it
+// (signals.irx beside signals.irp). Fixed-size entries sorted by key,
+// read through the same seek-and-read Source as IrPackReader.
+// ------------------------------------------------------------
+constexpr uint32_t PACK_WORDS_MAGIC = 0x57505249;  // "IRPW"
+constexpr uint16_t PACK_WORDS_VERSION = 1;
+constexpr int PACK_WORD_CHARS = 16;  // key is zero-padded, not terminated when full
+
+struct PackWordsHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t count;
+  uint32_t packFileSize;  // the pack it was built for
+} __attribute__((packed));
+
+struct PackWordEntry {
+  char key[PACK_WORD_CHARS];  // folded "BRAND CODE" from a word start
+  uint32_t code;
+} __attribute__((packed));
+
+// Calls emit(const char *key) for each word start of "BRAND CODE"
+template<typename Emit>
+void packWordKeys(const char *brand, const char *code, Emit emit) {
+  char full[PACK_NAME_CHARS * 2];
+  snprintf(full, sizeof(full), "%s %s", brand, code);
+  for (int i = 0; full[i]; i++) {
+    if (!searchWordStart(full, i)) continue;
+    char key[PACK_WORD_CHARS] = {};
+    for (int k = 0; k < PACK_WORD_CHARS && full[i + k]; k++) key[k] = searchFold(full[i + k]);
+    emit(key);
+  }
+}
+
+template<typename Source>
+class IrPackWordIndex {
+  static constexpr uint8_t CACHE_ROWS = 16;
+
+  Source *src = nullptr;
+  PackWordsHeader header;
+  PackWordEntry cache[CACHE_ROWS];
+  int32_t cacheIdx[CACHE_ROWS];
+
+public:
+  uint32_t reads = 0;  // entries fetched from the Source, for benchmarks
+
+  bool open(Source &source, uint32_t fileSize, uint32_t packFileSize) {
+    src = &source;
+    for (uint8_t i = 0; i < CACHE_ROWS; i++) cacheIdx[i] = -1;
+    PackWordsHeader h;
+    if (!src->seek(0) || src->read((uint8_t *)&h, sizeof(h)) != sizeof(h)) return close();
+    if (h.magic != PACK_WORDS_MAGIC || h.version != PACK_WORDS_VERSION || h.packFileSize != packFileSize) return close();
+    if (sizeof(PackWordsHeader) + (uint64_t)h.count * sizeof(PackWordEntry) != fileSize) return close();
+    header = h;
+    return true;
+  }
+
+  bool close() {
+    src = nullptr;
+    header.count = 0;
+    return false;
+  }
+
+  bool isOpen() const {
+    return src != nullptr;
+  }
+  uint32_t count() const {
+    return src ? header.count : 0;
+  }
+
+  bool entry(uint32_t i, PackWordEntry &out) {
+    if (i >= count()) return false;
+    uint8_t slot = i % CACHE_ROWS;
+    if (cacheIdx[slot] != (int32_t)i) {
+      reads++;
+      if (!src->seek(sizeof(PackWordsHeader) + i * sizeof(PackWordEntry))) return false;
+      if (src->read((uint8_t *)&cache[slot], sizeof(PackWordEntry)) != sizeof(PackWordEntry)) return false;
+      cacheIdx[slot] = i;
+    }
+    out = cache[slot];
+    return true;
+  }
+
+  // First entry at or past the matches for query; with past = true, the
+  // first entry after them. from narrows the search when it is known to
+  // start later, as the end does once the start is found.
+  uint32_t bound(const char *query, bool past, uint32_t from = 0) {
+    uint32_t lo = from, hi = count();
+    PackWordEntry e;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (!entry(mid, e)) return count();
+      int c = searchPrefixCompare(e.key, query, PACK_WORD_CHARS);
+      if (c < 0 || (past && c == 0)) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo;
+  }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "./IR-signal.h"
+
+// ============================================================
+// Session log
+// ============================================================
+// One append-only file per recording session:
+//   SessionFileHeader, then per frame SessionRecordHeader + len durations.
+// deltaUs is the time since the previous recorded frame started, so
+// replay reproduces the original spacing and micros() wrapping during
+// an hour-long session doesn't matter. A gap of SESSION_MAX_GAP_MS or
+// more, which a 32-bit delta can't always hold (micros() wraps every
+// 71.6 minutes), is recorded as SESSION_MAX_GAP_MS and flagged.
+constexpr uint32_t SESSION_MAGIC = 0x4C535249;  // "IRSL"
+constexpr uint16_t SESSION_VERSION = 1;
+constexpr int SESSION_SECTOR_BYTES = 512;
+constexpr int SESSION_BUFFER_SECTORS = 8;
+constexpr int SESSION_BUFFER_BYTES = SESSION_SECTOR_BYTES * SESSION_BUFFER_SECTORS;
+constexpr uint32_t SESSION_MAX_GAP_MS = 60000;
+
+constexpr uint8_t SESSION_FLAG_OVERFLOW = 0x01;    // frame was longer than MAX_RAW_LEN
+constexpr uint8_t SESSION_FLAG_AFTER_DROP = 0x02;  // frames were dropped right before this one
+constexpr uint8_t SESSION_FLAG_LONG_GAP = 0x04;    // the real gap was longer than deltaUs
+
+struct SessionFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+} __attribute__((packed));
+
+struct SessionRecordHeader {
+  uint32_t deltaUs;
+  uint8_t len;
+  uint8_t flags;
+} __attribute__((packed));
+
+struct SessionRecord {
+  SessionRecordHeader header;
+  uint16_t durations[MAX_RAW_LEN];
+};
+
+// Write-behind buffer: frames are copied in from loop() and handed out
+// again one whole sector at a time, so the card only ever sees aligned
+// 512-byte writes. A frame that doesn't fit is counted, never blocks.
+class SessionWriteBuffer {
+  uint8_t buf[SESSION_BUFFER_BYTES];
+  uint32_t head = 0, tail = 0;  // running byte counts
+  uint32_t lastStartUs = 0, lastMs = 0;
+  bool hasLast = false, dropPending = false;
+
+  void put(const void *data, uint32_t n) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (uint32_t i = 0; i < n; i++) buf[(head + i) % SESSION_BUFFER_BYTES] = p[i];
+    head += n;
+  }
+
+public:
+  uint32_t framesRecorded = 0, framesDropped = 0;
+
+  void reset() {
+    head = tail = 0;
+    hasLast = dropPending = false;
+    framesRecorded = framesDropped = 0;
+    SessionFileHeader fh = { SESSION_MAGIC, SESSION_VERSION, 0 };
+    put(&fh, sizeof(fh));
+  }
+
+  // nowMs (millis()) is only there to tell a long gap from a wrapped one
+  bool addFrame(uint32_t startUs, uint32_t nowMs, const uint16_t *durations, uint8_t len, bool overflow) {
+    uint32_t bytes = sizeof(SessionRecordHeader) + len * sizeof(uint16_t);
+    if (SESSION_BUFFER_BYTES - pending() < bytes) {
+      framesDropped++;
+      dropPending = true;
+      return false;
+    }
+    SessionRecordHeader rh;
+    rh.deltaUs = hasLast ? startUs - lastStartUs : 0;
+    bool longGap = hasLast && (nowMs - lastMs >= SESSION_MAX_GAP_MS || rh.deltaUs >= SESSION_MAX_GAP_MS * 1000);
+    if (longGap) rh.deltaUs = SESSION_MAX_GAP_MS * 1000;
+    rh.len = len;
+    rh.flags = (overflow ? SESSION_FLAG_OVERFLOW : 0) | (dropPending ? SESSION_FLAG_AFTER_DROP : 0)
+               | (longGap ? SESSION_FLAG_LONG_GAP : 0);
+    put(&rh, sizeof(rh));
+    put(durations, len * sizeof(uint16_t));
+    lastStartUs = startUs;
+    lastMs = nowMs;
+    hasLast = true;
+    dropPending = false;
+    framesRecorded++;
+    return true;
+  }
+
+  uint32_t pending() const {
+    return head - tail;
+  }
+  uint32_t bytesTotal() const {
+    return head;
+  }
+
+  // Sectors start at tail, which only ever moves in whole sectors until
+  // the final flush, so a ready sector is always contiguous
+  bool sectorReady() const {
+    return pending() >= (uint32_t)SESSION_SECTOR_BYTES;
+  }
+  const uint8_t *peek() const {
+    return buf + tail % SESSION_BUFFER_BYTES;
+  }
+  // Bytes readable at peek() without wrapping
+  uint32_t contiguous() const {
+    uint32_t toEnd = SESSION_BUFFER_BYTES - tail % SESSION_BUFFER_BYTES;
+    return pending() < toEnd ? pending() : toEnd;
+  }
+  void consume(uint32_t n) {
+    tail += n;
+  }
+};
+
+// Source needs size_t read(uint8_t *, size_t) — an Arduino File works as-is
+template<typename Source>
+bool readSessionHeader(Source &src) {
+  SessionFileHeader fh;
+  if (src.read((uint8_t *)&fh, sizeof(fh)) != sizeof(fh)) return false;
+  return fh.magic == SESSION_MAGIC && fh.version == SESSION_VERSION;
+}
+
+template<typename Source>
+bool readSessionRecord(Source &src, SessionRecord &out) {
+  if (src.read((uint8_t *)&out.header, sizeof(out.header)) != sizeof(out.header)) return false;
+  if (out.header.len > MAX_RAW_LEN) return false;
+  size_t bytes = out.header.len * sizeof(uint16_t);
+  return src.read((uint8_t *)out.durations, bytes) == bytes;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================
+// Signal model
+// ============================================================
+// A signal is a "once" part followed by a "repeat" part, both stored
+// back to back in rawData as alternating mark/space durations (µs).
+// Pressing Send emits the once part (or the repeat part when there is
+// no once part); holding Send re-emits the repeat part at its own period.
+constexpr int MAX_SAVED_SIGNAL_CHARS = 25;
+constexpr int MAX_RAW_LEN = 200;
+
+// Saved to SD as-is. New fields are only ever appended so older,
+// shorter files still load (missing tail reads as zero).
+struct IRSignal {
+  char name[MAX_SAVED_SIGNAL_CHARS + 1];
+  uint16_t rawData[MAX_RAW_LEN];
+  uint8_t rawDataLen;  // once + repeat entries
+  uint8_t repeatLen;   // trailing rawData entries forming the repeat frame
+  // Section periods in µs, 0 = sum of the section. Only set when a
+  // lead-out gap didn't fit a uint16_t entry (NEC's ~95 ms repeat gap).
+  uint32_t oncePeriodUs;
+  uint32_t repeatPeriodUs;
+  uint32_t carrierHz;  // 0 = DEFAULT_CARRIER_HZ
+} __attribute__((packed));
+
+constexpr uint32_t DEFAULT_CARRIER_HZ = 38000;
+
+inline uint32_t signalCarrierHz(const IRSignal &signal) {
+  return signal.carrierHz ? signal.carrierHz : DEFAULT_CARRIER_HZ;
+}
+
+// IRremote's sendRaw() only takes whole kHz
+inline uint8_t signalCarrierKHz(const IRSignal &signal) {
+  uint32_t khz = (signalCarrierHz(signal) + 500) / 1000;
+  return khz > 255 ? 255 : (uint8_t)khz;
+}
+
+inline uint8_t signalOnceLen(const IRSignal &signal) {
+  return signal.rawDataLen - signal.repeatLen;
+}
+
+// Sections are addressed by their first rawData index: the struct is
+// packed, so a pointer into rawData may be unaligned
+inline uint8_t signalRepeatStart(const IRSignal &signal) {
+  return signalOnceLen(signal);
+}
+
+// Total air time of a section, including its trailing lead-out gap
+inline uint32_t sectionDurationUs(const IRSignal &signal, uint8_t start, uint8_t len) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < len; i++) total += signal.rawData[start + i];
+  return total;
+}
+
+// For code that takes a plain array (sendRaw, the RMT encoder); out
+// holds at least len entries
+inline const uint16_t *copySection(const IRSignal &signal, uint8_t start, uint8_t len, uint16_t *out) {
+  for (uint8_t i = 0; i < len; i++) out[i] = signal.rawData[start + i];
+  return out;
+}
+
+inline uint32_t signalOncePeriodUs(const IRSignal &signal) {
+  return signal.oncePeriodUs ? signal.oncePeriodUs : sectionDurationUs(signal, 0, signalOnceLen(signal));
+}
+
+inline uint32_t signalRepeatPeriodUs(const IRSignal &signal) {
+  return signal.repeatPeriodUs ? signal.repeatPeriodUs : sectionDurationUs(signal, signalRepeatStart(signal), signal.repeatLen);
+}
+
+// Clamp lengths read back from storage so a damaged file can't overrun rawData
+inline void sanitizeSignal(IRSignal &signal) {
+  signal.name[MAX_SAVED_SIGNAL_CHARS] = '\0';
+  if (signal.rawDataLen > MAX_RAW_LEN) signal.rawDataLen = MAX_RAW_LEN;
+  if (signal.repeatLen > signal.rawDataLen) signal.repeatLen = 0;
+}
+
+// ============================================================
+// Pronto hex
+// ============================================================
+// Learned Pronto layout: 0000, carrier word, once pairs, repeat pairs,
+// then (once + repeat) * 2 burst words in carrier periods.
+// Arrays not starting with 0000 are plain µs lists ending at the first 0.
+constexpr float PRONTO_CLOCK_US = 0.241246f;
+
+inline uint16_t prontoWordToUs(uint16_t word, float unitUs) {
+  float us = word * unitUs + 0.5f;
+  return us >= 65535.0f ? 65535 : (uint16_t)us;
+}
+
+// Carrier word is the period in Pronto clock ticks, e.g. 006D = 38.0 kHz, 0070 = 37.0 kHz
+inline uint32_t prontoCarrierHz(uint16_t word) {
+  return word ? (uint32_t)(1000000.0f / (word * PRONTO_CLOCK_US) + 0.5f) : 0;
+}
+
+inline bool prontoToSignal(const uint16_t *pronto, uint16_t maxWords, IRSignal &out) {
+  out.rawDataLen = 0;
+  out.repeatLen = 0;
+  out.oncePeriodUs = 0;
+  out.repeatPeriodUs = 0;
+  out.carrierHz = 0;
+
+  if (pronto[0] != 0x0000) {
+    uint16_t n = 0;
+    while (n < maxWords && n < MAX_RAW_LEN && pronto[n] != 0) {
+      out.rawData[n] = pronto[n];
+      n++;
+    }
+    out.rawDataLen = (uint8_t)n;
+    return n > 0;
+  }
+
+  if (maxWords < 4 || pronto[1] == 0) return false;
+  float unit = pronto[1] * PRONTO_CLOCK_US;
+  out.carrierHz = prontoCarrierHz(pronto[1]);
+  uint16_t onceVals = pronto[2] * 2, repeatVals = pronto[3] * 2;
+  if (onceVals + repeatVals > maxWords - 4 || onceVals + repeatVals > MAX_RAW_LEN) return false;
+
+  float onceUs = 0, repeatUs = 0;
+  for (uint16_t i = 0; i < onceVals + repeatVals; i++) {
+    out.rawData[i] = prontoWordToUs(pronto[4 + i], unit);
+    (i < onceVals ? onceUs : repeatUs) += pronto[4 + i] * unit;
+  }
+  out.rawDataLen = (uint8_t)(onceVals + repeatVals);
+  out.repeatLen = (uint8_t)repeatVals;
+  if (onceUs > sectionDurationUs(out, 0, onceVals) + 1) out.oncePeriodUs = (uint32_t)(onceUs + 0.5f);
+  if (repeatUs > sectionDurationUs(out, onceVals, repeatVals) + 1) out.repeatPeriodUs = (uint32_t)(repeatUs + 0.5f);
+  return out.rawDataLen > 0;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "./IR-signal.h"
+
+// ============================================================
+// Streaming receive
+// ============================================================
+// The receive pin interrupt timestamps every edge into IrEdgeRing.
+// loop() drains it into IrFrameSegmenter, which cuts frames on the
+// inter-frame gap and writes them straight into IrFrameQueue slots.
+// Frames keep arriving while the UI draws or the SD card is busy;
+// they wait in the ring or the queue until loop() gets to them.
+constexpr int IR_EDGE_RING_SIZE = 1024;   // power of two
+constexpr uint32_t IR_FRAME_GAP_US = 8000;  // same as IRremote's RECORD_GAP_MICROS
+constexpr int IR_FRAME_QUEUE_SLOTS = 8;
+constexpr uint8_t IR_MIN_FRAME_LEN = 3;  // shorter bursts are glitches (NEC repeat is 3)
+
+struct IrFrame {
+  uint16_t durations[MAX_RAW_LEN];  // mark first, trailing gap excluded
+  uint8_t len;
+  bool overflow;
+  uint32_t startUs;
+};
+
+// Single producer (ISR) / single consumer (loop). Each index is only
+// written by one side, so no read-modify-write atomics are needed —
+// the C3 has no hardware atomics. Bit 0 of each entry is the pin level.
+struct IrEdgeRing {
+  uint32_t edges[IR_EDGE_RING_SIZE];
+  std::atomic<uint32_t> head{ 0 }, tail{ 0 };
+  std::atomic<uint32_t> dropped{ 0 };
+
+  bool push(uint32_t timeUs, bool level) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= (uint32_t)IR_EDGE_RING_SIZE) {
+      dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    edges[h & (IR_EDGE_RING_SIZE - 1)] = (timeUs & ~1UL) | (level ? 1 : 0);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(uint32_t &timeUs, bool &level) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    uint32_t e = edges[t & (IR_EDGE_RING_SIZE - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    timeUs = e & ~1UL;
+    level = e & 1;
+    return true;
+  }
+
+  void clear() {
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+  }
+};
+
+// Fixed slots, written in place by the segmenter
+struct IrFrameQueue {
+  IrFrame slots[IR_FRAME_QUEUE_SLOTS];
+  uint8_t head = 0, count = 0;
+
+  IrFrame *acquire() {
+    return count < IR_FRAME_QUEUE_SLOTS ? &slots[(head + count) % IR_FRAME_QUEUE_SLOTS] : nullptr;
+  }
+  void commit() {
+    count++;
+  }
+  IrFrame *front() {
+    return count ? &slots[head] : nullptr;
+  }
+  // i-th queued frame, 0 = oldest
+  IrFrame *at(uint8_t i) {
+    return i < count ? &slots[(head + i) % IR_FRAME_QUEUE_SLOTS] : nullptr;
+  }
+  void pop() {
+    if (!count) return;
+    head = (head + 1) % IR_FRAME_QUEUE_SLOTS;
+    count--;
+  }
+  // Keeps a slot the segmenter is still writing at the new head
+  void clear() {
+    head = (head + count) % IR_FRAME_QUEUE_SLOTS;
+    count = 0;
+  }
+};
+
+class IrFrameSegmenter {
+  IrFrameQueue &queue;
+  IrFrame scratch;
+  IrFrame *frame = nullptr;
+  uint32_t lastEdgeUs = 0;
+  bool lastLevel, inFrame = false;
+  const bool markLevel;
+
+  void begin(uint32_t timeUs) {
+    frame = queue.acquire();
+    if (!frame) frame = &scratch;
+    frame->len = 0;
+    frame->overflow = false;
+    frame->startUs = timeUs;
+    inFrame = true;
+  }
+
+  void end() {
+    inFrame = false;
+    if (frame->len < IR_MIN_FRAME_LEN) return;
+    if (frame == &scratch) {
+      framesDropped++;
+      return;
+    }
+    queue.commit();
+    framesEmitted++;
+  }
+
+  void append(uint32_t durationUs) {
+    if (frame->len >= MAX_RAW_LEN) {
+      frame->overflow = true;
+      return;
+    }
+    frame->durations[frame->len++] = durationUs > 65535 ? 65535 : (uint16_t)durationUs;
+  }
+
+public:
+  uint32_t framesEmitted = 0, framesDropped = 0;
+
+  // IR receiver modules are active low, so a mark reads as level 0
+  explicit IrFrameSegmenter(IrFrameQueue &q, bool markLevel = false)
+    : queue(q), lastLevel(!markLevel), markLevel(markLevel) {}
+
+  void feed(uint32_t timeUs, bool level) {
+    if (level == lastLevel) return;  // a missed edge: keep the earlier timestamp
+    bool isMark = level == markLevel;
+    if (!inFrame) {
+      if (isMark) begin(timeUs);
+    } else if (isMark && timeUs - lastEdgeUs >= IR_FRAME_GAP_US) {
+      end();
+      begin(timeUs);
+    } else {
+      append(timeUs - lastEdgeUs);
+    }
+    lastEdgeUs = timeUs;
+    lastLevel = level;
+  }
+
+  // Closes the current frame once the line has been idle for a full gap
+  void poll(uint32_t nowUs) {
+    if (inFrame && lastLevel != markLevel && nowUs - lastEdgeUs >= IR_FRAME_GAP_US) end();
+  }
+
+  void drain(IrEdgeRing &ring) {
+    uint32_t timeUs;
+    bool level;
+    while (ring.pop(timeUs, level)) feed(timeUs, level);
+  }
+};
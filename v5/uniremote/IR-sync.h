@@ -0,0 +1,543 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================
+// Serial sync protocol
+// ============================================================
+// Frames on the wire:
+//   A5 5A | type | seq | len (LE16) | payload[len] | CRC-16/CCITT (LE16)
+// The CRC covers type..payload. A damaged frame is dropped and the
+// parser hunts for the next A5 5A, so stray debug prints on the same
+// port cost nothing but a skipped line.
+//
+// File data moves in DATA chunks under a go-back-N window: up to
+// SYNC_WINDOW chunks in flight, ACK carries the last in-order seq, NAK
+// the seq the receiver wants next. seq is the chunk index's low byte,
+// which is unambiguous while the window is far below 256.
+constexpr uint8_t SYNC_MAGIC0 = 0xA5;
+constexpr uint8_t SYNC_MAGIC1 = 0x5A;
+constexpr uint16_t SYNC_VERSION = 1;
+constexpr uint16_t SYNC_MAX_PAYLOAD = 256;
+constexpr uint16_t SYNC_CHUNK_BYTES = 256;
+constexpr uint16_t SYNC_FRAME_MAX = SYNC_MAX_PAYLOAD + 8;
+constexpr uint8_t SYNC_WINDOW = 4;
+constexpr uint32_t SYNC_RETRY_MS = 400;
+constexpr uint8_t SYNC_MAX_RETRIES = 10;
+// An upload that hears nothing for as long as a sender keeps retrying is
+// dropped, so a host that went away doesn't hold the temp file open
+constexpr uint32_t SYNC_RECEIVE_IDLE_MS = SYNC_RETRY_MS * (SYNC_MAX_RETRIES + 1);
+constexpr int SYNC_NAME_CHARS = 48;  // including the terminator
+
+enum SyncType : uint8_t {
+  SYNC_HELLO = 1,  // -> OK {version, chunk bytes, window}
+  SYNC_LIST,       // -> ENTRY {size, crc32, name} per file (seq = index), then LIST_END {count}
+  SYNC_ENTRY,
+  SYNC_LIST_END,
+  SYNC_GET,     // {name} -> OK {size}, DATA..., END {size, crc32}; the host answers END with OK
+  SYNC_PUT,     // {size, crc32, name} -> OK; DATA... (ACKed), END -> OK once stored
+  SYNC_DELETE,  // {name} -> OK
+  SYNC_DATA,
+  SYNC_END,
+  SYNC_ACK,
+  SYNC_NAK,
+  SYNC_OK,
+  SYNC_ERR,   // {code, text}
+  SYNC_TRACE  // -> like GET, with the device's event trace (IR-trace.h) as the file
+};
+
+enum SyncError : uint8_t {
+  SYNC_ERR_NAME = 1,
+  SYNC_ERR_NOT_FOUND,
+  SYNC_ERR_IO,
+  SYNC_ERR_CRC,
+  SYNC_ERR_PROTOCOL
+};
+
+inline uint16_t syncCrc16(uint16_t crc, const uint8_t *data, uint16_t len) {
+  for (uint16_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t b = 0; b < 8; b++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// zlib CRC-32; start with 0, feed chunks in order
+inline uint32_t syncCrc32(uint32_t crc, const uint8_t *data, uint32_t len) {
+  static const uint32_t NIBBLE[16] = { 0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                       0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                       0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C };
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc = NIBBLE[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+    crc = NIBBLE[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+inline void syncPut16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+inline void syncPut32(uint8_t *p, uint32_t v) {
+  for (uint8_t i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+inline uint16_t syncGet16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+inline uint32_t syncGet32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Signal library names only: no paths, no hidden files
+inline bool syncNameValid(const char *name, uint16_t len) {
+  if (len == 0 || len >= SYNC_NAME_CHARS || name[0] == '.') return false;
+  for (uint16_t i = 0; i < len; i++) {
+    char c = name[i];
+    bool ok = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == ' ' || c == '-' || c == '_' || c == '.';
+    if (!ok) return false;
+  }
+  return true;
+}
+
+// Returns the frame length written to out (at most SYNC_FRAME_MAX)
+inline uint16_t encodeSyncFrame(uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len, uint8_t *out) {
+  if (len > SYNC_MAX_PAYLOAD) len = SYNC_MAX_PAYLOAD;
+  out[0] = SYNC_MAGIC0;
+  out[1] = SYNC_MAGIC1;
+  out[2] = type;
+  out[3] = seq;
+  syncPut16(out + 4, len);
+  if (len) memcpy(out + 6, payload, len);
+  syncPut16(out + 6 + len, syncCrc16(0xFFFF, out + 2, len + 4));
+  return len + 8;
+}
+
+struct SyncFrame {
+  uint8_t type, seq;
+  uint16_t len;
+  uint8_t payload[SYNC_MAX_PAYLOAD];
+};
+
+// Byte-at-a-time, so it can sit behind any UART read loop
+class SyncFrameParser {
+  enum : uint8_t { WAIT_MAGIC0,
+                   WAIT_MAGIC1,
+                   HEADER,
+                   PAYLOAD,
+                   CRC } state = WAIT_MAGIC0;
+  uint8_t header[4];
+  uint8_t crcBytes[2];
+  uint16_t pos = 0;
+
+public:
+  SyncFrame frame;
+  uint32_t badFrames = 0;
+
+  bool feed(uint8_t b) {
+    switch (state) {
+      case WAIT_MAGIC0:
+        if (b == SYNC_MAGIC0) state = WAIT_MAGIC1;
+        return false;
+      case WAIT_MAGIC1:
+        state = b == SYNC_MAGIC1 ? HEADER : b == SYNC_MAGIC0 ? WAIT_MAGIC1 : WAIT_MAGIC0;
+        pos = 0;
+        return false;
+      case HEADER:
+        header[pos++] = b;
+        if (pos < 4) return false;
+        frame.type = header[0];
+        frame.seq = header[1];
+        frame.len = syncGet16(header + 2);
+        pos = 0;
+        if (frame.len > SYNC_MAX_PAYLOAD) {
+          badFrames++;
+          state = WAIT_MAGIC0;
+        } else {
+          state = frame.len ? PAYLOAD : CRC;
+        }
+        return false;
+      case PAYLOAD:
+        frame.payload[pos++] = b;
+        if (pos == frame.len) {
+          pos = 0;
+          state = CRC;
+        }
+        return false;
+      case CRC:
+        crcBytes[pos++] = b;
+        if (pos < 2) return false;
+        state = WAIT_MAGIC0;
+        if (syncCrc16(syncCrc16(0xFFFF, header, 4), frame.payload, frame.len) != syncGet16(crcBytes)) {
+          badFrames++;
+          return false;
+        }
+        return true;
+    }
+    return false;
+  }
+};
+
+// Sending side of one transfer, in chunk indices
+struct SyncWindow {
+  uint32_t base = 0, next = 0, total = 0;
+  uint32_t lastSendMs = 0;
+  uint8_t retries = 0;
+
+  void start(uint32_t bytes) {
+    total = (bytes + SYNC_CHUNK_BYTES - 1) / SYNC_CHUNK_BYTES;
+    base = next = 0;
+    retries = 0;
+  }
+  bool canSend() const {
+    return next < total && next - base < SYNC_WINDOW;
+  }
+  bool done() const {
+    return base >= total;
+  }
+  void ack(uint8_t seq) {
+    for (uint32_t i = base; i < next; i++) {
+      if ((i & 0xFF) == seq) {
+        base = i + 1;
+        retries = 0;
+        return;
+      }
+    }
+  }
+  // Resend everything not yet acknowledged
+  void rewind() {
+    next = base;
+  }
+  bool timedOut(uint32_t nowMs) const {
+    return base < next && nowMs - lastSendMs > SYNC_RETRY_MS;
+  }
+};
+
+// Receiving side: accepts chunks strictly in order and says what it
+// wants next. One NAK per gap, so a burst of out-of-order frames
+// doesn't trigger a burst of rewinds.
+struct SyncReceiveWindow {
+  uint32_t expected = 0;
+  bool nakSent = false;
+
+  void start() {
+    expected = 0;
+    nakSent = false;
+  }
+  // true: take the chunk. replyType is ACK, NAK, or 0 when nothing should be sent.
+  bool accept(uint8_t seq, uint8_t &replyType, uint8_t &replySeq) {
+    if (seq == (expected & 0xFF)) {
+      replyType = SYNC_ACK;
+      replySeq = seq;
+      expected++;
+      nakSent = false;
+      return true;
+    }
+    if (expected && seq == ((expected - 1) & 0xFF)) {
+      replyType = SYNC_ACK;
+      replySeq = seq;
+    } else {
+      replyType = nakSent ? 0 : SYNC_NAK;
+      replySeq = expected & 0xFF;
+      nakSent = true;
+    }
+    return false;
+  }
+};
+
+// ============================================================
+// Device side
+// ============================================================
+// Port needs int available(), int read() and
+// size_t write(const uint8_t *, size_t) — HardwareSerial and HWCDC fit.
+// Store needs:
+//   bool listBegin(); bool listNext(char *name, size_t n, uint32_t &size);
+//   bool openRead(const char *name, uint32_t &size);
+//   bool readAt(uint32_t offset, uint8_t *buf, uint16_t n); void closeRead();
+//   bool openWrite(); bool write(const uint8_t *buf, uint16_t n);
+//   bool commitWrite(const char *name); void abortWrite();
+//   bool remove(const char *name);
+//   bool openTrace(uint32_t &size);  // then readAt()/closeRead() as for a file
+// Files stream chunk by chunk between the store and the port; nothing
+// larger than one frame is ever buffered. service() does a bounded
+// amount of work per call so loop() keeps drawing.
+template<typename Port, typename Store>
+class SyncServer {
+  enum : uint8_t { IDLE,
+                   LISTING,
+                   SENDING,
+                   SENDING_END,
+                   RECEIVING } state = IDLE;
+  SyncFrameParser parser;
+  uint8_t out[SYNC_FRAME_MAX];
+  uint8_t chunk[SYNC_CHUNK_BYTES];
+
+  SyncWindow window;
+  SyncReceiveWindow rxWindow;
+  uint32_t fileSize = 0, fileCrc = 0, crcChunks = 0, received = 0;
+  uint32_t expectSize = 0, expectCrc = 0, lastDataMs = 0;
+  uint32_t lastCommitCrc = 0, lastCommitSize = 0;
+  bool lastCommitValid = false;
+  uint16_t listIndex = 0;
+  char name[SYNC_NAME_CHARS];
+
+  void send(Port &port, uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len) {
+    uint16_t n = encodeSyncFrame(type, seq, payload, len, out);
+    port.write(out, n);
+  }
+  void sendError(Port &port, uint8_t code, const char *text) {
+    uint8_t p[40];
+    p[0] = code;
+    uint16_t n = strlen(text) < sizeof(p) - 1 ? strlen(text) : sizeof(p) - 1;
+    memcpy(p + 1, text, n);
+    send(port, SYNC_ERR, 0, p, n + 1);
+  }
+
+  bool takeName(const SyncFrame &f, uint16_t offset) {
+    uint16_t len = f.len > offset ? f.len - offset : 0;
+    if (!syncNameValid((const char *)f.payload + offset, len)) return false;
+    memcpy(name, f.payload + offset, len);
+    name[len] = '\0';
+    return true;
+  }
+
+  // Drops whatever was in progress; a repeated request starts over
+  void abort(Store &store) {
+    if (state == SENDING || state == SENDING_END) store.closeRead();
+    if (state == RECEIVING) store.abortWrite();
+    state = IDLE;
+  }
+
+  uint32_t fileCrcOf(Store &store, const char *file, uint32_t size) {
+    uint32_t crc = 0, dummy;
+    if (!store.openRead(file, dummy)) return 0;
+    for (uint32_t off = 0; off < size; off += SYNC_CHUNK_BYTES) {
+      uint16_t n = size - off < SYNC_CHUNK_BYTES ? size - off : SYNC_CHUNK_BYTES;
+      if (!store.readAt(off, chunk, n)) break;
+      crc = syncCrc32(crc, chunk, n);
+    }
+    store.closeRead();
+    return crc;
+  }
+
+  // After an open: OK {size}, then DATA under the window
+  void startSending(Port &port, uint8_t seq, uint32_t nowMs) {
+    uint8_t p[4];
+    window.start(fileSize);
+    window.lastSendMs = nowMs;
+    fileCrc = 0;
+    crcChunks = 0;
+    state = SENDING;
+    syncPut32(p, fileSize);
+    send(port, SYNC_OK, seq, p, 4);
+  }
+
+  void handle(Port &port, Store &store, const SyncFrame &f, uint32_t nowMs) {
+    uint8_t p[12];
+    switch (f.type) {
+      case SYNC_HELLO:
+        abort(store);
+        syncPut16(p, SYNC_VERSION);
+        syncPut16(p + 2, SYNC_CHUNK_BYTES);
+        p[4] = SYNC_WINDOW;
+        send(port, SYNC_OK, f.seq, p, 5);
+        break;
+
+      case SYNC_LIST:
+        abort(store);
+        if (!store.listBegin()) {
+          sendError(port, SYNC_ERR_IO, "no library");
+          break;
+        }
+        listIndex = 0;
+        state = LISTING;
+        break;
+
+      case SYNC_GET:
+        abort(store);
+        if (!takeName(f, 0)) {
+          sendError(port, SYNC_ERR_NAME, "bad name");
+        } else if (!store.openRead(name, fileSize)) {
+          sendError(port, SYNC_ERR_NOT_FOUND, "not found");
+        } else {
+          startSending(port, f.seq, nowMs);
+        }
+        break;
+
+      case SYNC_TRACE:
+        abort(store);
+        if (!store.openTrace(fileSize)) sendError(port, SYNC_ERR_IO, "no trace");
+        else startSending(port, f.seq, nowMs);
+        break;
+
+      case SYNC_PUT:
+        abort(store);
+        lastCommitValid = false;
+        if (f.len < 8 || !takeName(f, 8)) {
+          sendError(port, SYNC_ERR_NAME, "bad name");
+        } else if (!store.openWrite()) {
+          sendError(port, SYNC_ERR_IO, "can't write");
+        } else {
+          expectSize = syncGet32(f.payload);
+          expectCrc = syncGet32(f.payload + 4);
+          received = 0;
+          fileCrc = 0;
+          rxWindow.start();
+          lastDataMs = nowMs;
+          state = RECEIVING;
+          send(port, SYNC_OK, f.seq, nullptr, 0);
+        }
+        break;
+
+      case SYNC_DELETE:
+        abort(store);
+        if (!takeName(f, 0)) sendError(port, SYNC_ERR_NAME, "bad name");
+        else if (!store.remove(name)) sendError(port, SYNC_ERR_NOT_FOUND, "not found");
+        else send(port, SYNC_OK, f.seq, nullptr, 0);
+        break;
+
+      case SYNC_DATA:
+        if (state != RECEIVING) break;
+        lastDataMs = nowMs;
+        {
+          uint8_t replyType, replySeq;
+          if (rxWindow.accept(f.seq, replyType, replySeq)) {
+            if (received + f.len > expectSize || !store.write(f.payload, f.len)) {
+              abort(store);
+              sendError(port, SYNC_ERR_IO, "write failed");
+              break;
+            }
+            received += f.len;
+            fileCrc = syncCrc32(fileCrc, f.payload, f.len);
+          }
+          if (replyType) send(port, replyType, replySeq, nullptr, 0);
+        }
+        break;
+
+      case SYNC_END:
+        if (state == RECEIVING) {
+          if (received != expectSize || fileCrc != expectCrc) {
+            abort(store);
+            sendError(port, SYNC_ERR_CRC, "crc mismatch");
+          } else if (!store.commitWrite(name)) {
+            state = IDLE;
+            sendError(port, SYNC_ERR_IO, "commit failed");
+          } else {
+            state = IDLE;
+            lastCommitValid = true;
+            lastCommitSize = received;
+            lastCommitCrc = fileCrc;
+            send(port, SYNC_OK, f.seq, nullptr, 0);
+          }
+        } else if (state == IDLE && lastCommitValid && f.len >= 8 && syncGet32(f.payload) == lastCommitSize && syncGet32(f.payload + 4) == lastCommitCrc) {
+          send(port, SYNC_OK, f.seq, nullptr, 0);  // our OK got lost
+        }
+        break;
+
+      case SYNC_ACK:
+        if (state == SENDING) window.ack(f.seq);
+        break;
+
+      case SYNC_NAK:
+        if (state == SENDING) {
+          if (f.seq != (window.base & 0xFF)) window.ack((f.seq - 1) & 0xFF);
+          window.rewind();
+        }
+        break;
+
+      case SYNC_OK:
+        if (state == SENDING_END) abort(store);
+        break;
+
+      default:
+        sendError(port, SYNC_ERR_PROTOCOL, "unknown frame");
+        break;
+    }
+  }
+
+  void sendEnd(Port &port, uint32_t nowMs) {
+    uint8_t p[8];
+    syncPut32(p, fileSize);
+    syncPut32(p + 4, fileCrc);
+    send(port, SYNC_END, 0, p, 8);
+    window.lastSendMs = nowMs;
+  }
+
+public:
+  uint32_t framesIn = 0;
+
+  bool busy() const {
+    return state != IDLE;
+  }
+  uint32_t badFrames() const {
+    return parser.badFrames;
+  }
+
+  void service(Port &port, Store &store, uint32_t nowMs) {
+    for (int budget = SYNC_FRAME_MAX * 2; budget > 0 && port.available() > 0; budget--) {
+      if (parser.feed((uint8_t)port.read())) {
+        framesIn++;
+        handle(port, store, parser.frame, nowMs);
+      }
+    }
+
+    if (state == LISTING) {
+      uint32_t size;
+      if (store.listNext(name, sizeof(name), size)) {
+        uint8_t p[8 + SYNC_NAME_CHARS];
+        uint16_t n = strlen(name);
+        syncPut32(p, size);
+        syncPut32(p + 4, fileCrcOf(store, name, size));
+        memcpy(p + 8, name, n);
+        send(port, SYNC_ENTRY, listIndex++ & 0xFF, p, 8 + n);
+      } else {
+        uint8_t p[2];
+        syncPut16(p, listIndex);
+        send(port, SYNC_LIST_END, 0, p, 2);
+        state = IDLE;
+      }
+    }
+
+    if (state == RECEIVING && nowMs - lastDataMs > SYNC_RECEIVE_IDLE_MS) {
+      abort(store);
+      sendError(port, SYNC_ERR_PROTOCOL, "upload timed out");
+    }
+
+    if (state == SENDING) {
+      if (window.timedOut(nowMs)) {
+        if (++window.retries > SYNC_MAX_RETRIES) {
+          abort(store);
+          return;
+        }
+        window.rewind();
+      }
+      // One chunk per pass keeps a write from ever blocking on a full TX
+      // buffer; loop() comes round faster than 115200 baud drains a frame
+      if (window.canSend()) {
+        uint32_t off = window.next * SYNC_CHUNK_BYTES;
+        uint16_t n = fileSize - off < SYNC_CHUNK_BYTES ? fileSize - off : SYNC_CHUNK_BYTES;
+        if (!store.readAt(off, chunk, n)) {
+          abort(store);
+          sendError(port, SYNC_ERR_IO, "read failed");
+          return;
+        }
+        if (window.next == crcChunks) {
+          fileCrc = syncCrc32(fileCrc, chunk, n);
+          crcChunks++;
+        }
+        send(port, SYNC_DATA, window.next & 0xFF, chunk, n);
+        window.next++;
+        window.lastSendMs = nowMs;
+      }
+      if (window.done()) {
+        state = SENDING_END;
+        window.retries = 0;
+        sendEnd(port, nowMs);
+      }
+    } else if (state == SENDING_END && nowMs - window.lastSendMs > SYNC_RETRY_MS) {
+      if (++window.retries > SYNC_MAX_RETRIES) abort(store);
+      else sendEnd(port, nowMs);
+    }
+  }
+};
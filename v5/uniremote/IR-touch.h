@@ -0,0 +1,172 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// ============================================================
+// Touch filtering
+// ============================================================
+// Raw XPT2046 readings go through TouchFilter before hit-testing and
+// scrolling see them:
+//  - pressure: a press starts at TOUCH_PRESS_Z and ends after
+//    TOUCH_LIFT_SAMPLES reads in a row under TOUCH_LIFT_Z, so a finger
+//    that goes light for one read stays one press
+//  - median of the last TOUCH_MEDIAN_SAMPLES positions, which drops the
+//    single wild reads a resistive panel gives while pressure changes
+//  - an adaptive low-pass (the "1 euro" filter): its cutoff rises with
+//    speed, so a finger held still doesn't wander over the drag
+//    threshold and a moving one isn't trailed far. The output is also
+//    never more than TOUCH_MAX_LAG_PX behind the median.
+// For steady motion the median is one read behind and the low-pass a
+// time constant behind; lagUs is their sum, and while the finger moves
+// the time constant is held under TOUCH_MAX_SMOOTH_LAG_US.
+constexpr uint16_t TOUCH_PRESS_Z = 600;
+constexpr uint16_t TOUCH_LIFT_Z = 400;
+constexpr uint8_t TOUCH_LIFT_SAMPLES = 2;
+constexpr uint8_t TOUCH_MEDIAN_SAMPLES = 3;     // odd
+constexpr float TOUCH_MIN_CUTOFF_HZ = 1;        // finger still
+constexpr float TOUCH_BETA = 20;                // Hz per px/ms of speed
+constexpr float TOUCH_SPEED_CUTOFF_HZ = 2;      // smoothing of the speed estimate
+constexpr float TOUCH_MOVING_SPEED = 0.2f;      // px/ms
+constexpr uint32_t TOUCH_MAX_SMOOTH_LAG_US = 8000;
+constexpr float TOUCH_MAX_LAG_PX = 3;
+
+// Calibration: the raw readings at the panel's edges (left/right,
+// top/bottom), so either may be the larger as the panel is mounted
+constexpr uint16_t TOUCH_RAW_MAX = 4095;
+constexpr uint16_t TOUCH_CAL_MIN_SPAN = 1000;
+
+struct TouchCalibration {
+  uint16_t xMin, xMax, yMin, yMax;
+
+  bool valid() const {
+    return abs((int)xMax - xMin) >= TOUCH_CAL_MIN_SPAN && abs((int)yMax - yMin) >= TOUCH_CAL_MIN_SPAN;
+  }
+  // Screen position of a raw reading, unclamped
+  float x(int32_t raw, int width) const {
+    return (float)(raw - xMin) * (width - 1) / ((int)xMax - xMin);
+  }
+  float y(int32_t raw, int height) const {
+    return (float)(raw - yMin) * (height - 1) / ((int)yMax - yMin);
+  }
+};
+
+// Raw reading at screen position 0 and size - 1, extrapolated from two
+// targets at s0 and s1 read as r0 and r1
+inline void touchCalibrationAxis(int s0, int32_t r0, int s1, int32_t r1, int size, uint16_t &rawMin, uint16_t &rawMax) {
+  auto clampRaw = [](float r) {
+    return (uint16_t)(r < 0 ? 0 : r > TOUCH_RAW_MAX ? TOUCH_RAW_MAX : lroundf(r));
+  };
+  float perPx = (float)(r1 - r0) / (s1 - s0);
+  rawMin = clampRaw(r0 - perPx * s0);
+  rawMax = clampRaw(r0 + perPx * (size - 1 - s0));
+}
+
+// Calibration from targets a and b, opposite corners of the screen
+inline TouchCalibration touchCalibrationFrom(int ax, int ay, int32_t rawAx, int32_t rawAy, int bx, int by, int32_t rawBx,
+                                             int32_t rawBy, int width, int height) {
+  TouchCalibration cal;
+  touchCalibrationAxis(ax, rawAx, bx, rawBx, width, cal.xMin, cal.xMax);
+  touchCalibrationAxis(ay, rawAy, by, rawBy, height, cal.yMin, cal.yMax);
+  return cal;
+}
+
+class TouchFilter {
+  float windowX[TOUCH_MEDIAN_SAMPLES], windowY[TOUCH_MEDIAN_SAMPLES];
+  float outX = 0, outY = 0;
+  float velocityX = 0, velocityY = 0;  // px/ms, smoothed
+  uint32_t lastUs = 0;
+  uint8_t next = 0, lightReads = 0;
+  bool down = false;
+
+  static float median(const float *v) {
+    float s[TOUCH_MEDIAN_SAMPLES];
+    for (uint8_t i = 0; i < TOUCH_MEDIAN_SAMPLES; i++) {
+      uint8_t j = i;
+      for (; j > 0 && s[j - 1] > v[i]; j--) s[j] = s[j - 1];
+      s[j] = v[i];
+    }
+    return s[TOUCH_MEDIAN_SAMPLES / 2];
+  }
+  // Time constant of a low-pass with this cutoff, and the weight it
+  // gives a new value dtMs after the last
+  static float tauUs(float cutoffHz) {
+    return 1e6f / (6.2831853f * cutoffHz);
+  }
+  static float alpha(float cutoffHz, float dtMs) {
+    return 1 / (1 + tauUs(cutoffHz) / 1000 / dtMs);
+  }
+
+public:
+  uint32_t lagUs = 0;    // for the last position, see above
+  bool moving = false;   // the last position was in motion
+  bool lifting = false;  // still pressed, but the last read was light: no new position
+
+  void reset() {
+    down = false;
+    lightReads = 0;
+    moving = false;
+    lifting = false;
+    lagUs = 0;
+  }
+  float x() const {
+    return outX;
+  }
+  float y() const {
+    return outY;
+  }
+
+  // One reading, already calibrated to screen pixels; true while pressed
+  bool add(uint32_t nowUs, float x, float y, uint16_t z) {
+    if (down ? z < TOUCH_LIFT_Z : z < TOUCH_PRESS_Z) {
+      if (down && ++lightReads >= TOUCH_LIFT_SAMPLES) reset();
+      lifting = down;
+      return down;
+    }
+    lightReads = 0;
+    lifting = false;
+    if (!down) {
+      // The first reading fills the window, so a press reports at once
+      for (uint8_t i = 0; i < TOUCH_MEDIAN_SAMPLES; i++) {
+        windowX[i] = x;
+        windowY[i] = y;
+      }
+      next = 0;
+      outX = x;
+      outY = y;
+      velocityX = velocityY = 0;
+      lastUs = nowUs;
+      down = true;
+      return true;
+    }
+    windowX[next] = x;
+    windowY[next] = y;
+    next = (next + 1) % TOUCH_MEDIAN_SAMPLES;
+    float mx = median(windowX), my = median(windowY);
+
+    float dtMs = (nowUs - lastUs) / 1000.0f;
+    lastUs = nowUs;
+    if (dtMs <= 0) dtMs = 0.001f;
+    // Smoothed with its sign, so jitter averages out of the speed
+    float av = alpha(TOUCH_SPEED_CUTOFF_HZ, dtMs);
+    velocityX += av * ((mx - outX) / dtMs - velocityX);
+    velocityY += av * ((my - outY) / dtMs - velocityY);
+    float speed = hypotf(velocityX, velocityY);
+    moving = speed >= TOUCH_MOVING_SPEED;
+    float cutoff = TOUCH_MIN_CUTOFF_HZ + TOUCH_BETA * speed;
+    float movingCutoff = 1e6f / (6.2831853f * TOUCH_MAX_SMOOTH_LAG_US);
+    if (moving && cutoff < movingCutoff) cutoff = movingCutoff;
+    float a = alpha(cutoff, dtMs);
+    outX += a * (mx - outX);
+    outY += a * (my - outY);
+
+    float dx = mx - outX, dy = my - outY, behind = hypotf(dx, dy);
+    if (behind > TOUCH_MAX_LAG_PX) {
+      outX = mx - dx * TOUCH_MAX_LAG_PX / behind;
+      outY = my - dy * TOUCH_MAX_LAG_PX / behind;
+    }
+    lagUs = (uint32_t)(dtMs * 1000 + tauUs(cutoff));
+    return true;
+  }
+};
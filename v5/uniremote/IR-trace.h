@@ -0,0 +1,152 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+// ============================================================
+// Event trace
+// ============================================================
+// A flight recorder of timestamped begin/end/instant events. Each
+// context that records gets its own ring with a single producer —
+// loop() one, the IR receive interrupt the other — so a push is a
+// plain store plus a release store of head, with no locks and no
+// read-modify-write atomics (the C3 has none). Rings overwrite their
+// oldest events.
+//
+// A dump freezes both rings (pushes are dropped meanwhile) and reads
+// them out as a flat little-endian stream:
+//   "IRTR" | version (16) | event bytes (16) | event count (32) | dump time us (32)
+//   then per event: time us (32) | id (8) | phase 'B'/'E'/'i' (8) | arg (16)
+// Rings follow each other, so events are only in order per ring;
+// v5/tools/irtrace.cpp sorts them and writes Chrome trace JSON.
+constexpr int TRACE_MAIN_EVENTS = 2048;  // power of two; ~5 s of idle loop()
+constexpr int TRACE_ISR_EVENTS = 128;    // power of two
+constexpr uint16_t TRACE_VERSION = 1;
+constexpr uint16_t TRACE_HEADER_BYTES = 16;
+constexpr uint16_t TRACE_EVENT_BYTES = 8;
+
+enum TraceId : uint8_t {
+  TRACE_SD = 1,       // one SD operation
+  TRACE_SPRITE_PUSH,  // a sprite going out to the panel
+  TRACE_TOUCH,        // one touch controller poll (args: its raw reading, see below)
+  TRACE_IR_CAPTURE,   // a received frame, first edge to last (arg: edges)
+  TRACE_IR_TX,        // a frame on air (arg: 1 for a repeat frame)
+  TRACE_DELAY,        // delay() (arg: ms)
+  TRACE_IR_RX_START,  // the receive interrupt saw a frame's first edge
+  TRACE_ID_COUNT
+};
+
+inline const char *traceName(uint8_t id) {
+  static const char *const NAMES[TRACE_ID_COUNT] = { "?", "sd", "sprite push", "touch", "ir capture", "ir tx", "delay", "ir rx start" };
+  return id < TRACE_ID_COUNT ? NAMES[id] : "?";
+}
+
+// A touch poll's raw reading: X and Y (12 bits) in the begin and end
+// args, each topped with a nibble of the pressure's top byte
+inline uint16_t traceTouchBeginArg(uint16_t x, uint16_t z) {
+  return (x & 0xFFF) | ((z > 4095 ? 4095 : z) >> 8) << 12;
+}
+inline uint16_t traceTouchEndArg(uint16_t y, uint16_t z) {
+  return (y & 0xFFF) | (((z > 4095 ? 4095 : z) >> 4) & 0xF) << 12;
+}
+inline void traceTouchReading(uint16_t beginArg, uint16_t endArg, uint16_t &x, uint16_t &y, uint16_t &z) {
+  x = beginArg & 0xFFF;
+  y = endArg & 0xFFF;
+  z = (beginArg >> 12) << 8 | (endArg >> 12) << 4;
+}
+
+struct TraceEvent {
+  uint32_t us;
+  uint8_t id;
+  char phase;
+  uint16_t arg;
+};
+
+template<int N>
+struct TraceRing {
+  TraceEvent events[N];
+  std::atomic<uint32_t> head{ 0 };
+
+  void push(uint32_t us, uint8_t id, char phase, uint16_t arg) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    events[h & (N - 1)] = { us, id, phase, arg };
+    head.store(h + 1, std::memory_order_release);
+  }
+  uint32_t count() const {
+    uint32_t h = head.load(std::memory_order_acquire);
+    return h < (uint32_t)N ? h : N;
+  }
+  // i-th oldest event still held
+  const TraceEvent &at(uint32_t i) const {
+    uint32_t h = head.load(std::memory_order_acquire);
+    return events[(h - count() + i) & (N - 1)];
+  }
+};
+
+class TraceBuffer {
+  TraceRing<TRACE_MAIN_EVENTS> main;
+  TraceRing<TRACE_ISR_EVENTS> isr;
+  std::atomic<bool> frozen{ false };
+  uint32_t dumpUs = 0;
+
+  void eventBytes(uint32_t i, uint8_t *out) const {
+    uint32_t fromIsr = isr.count();
+    const TraceEvent &e = i < fromIsr ? isr.at(i) : main.at(i - fromIsr);
+    for (uint8_t b = 0; b < 4; b++) out[b] = (e.us >> (8 * b)) & 0xFF;
+    out[4] = e.id;
+    out[5] = e.phase;
+    out[6] = e.arg & 0xFF;
+    out[7] = e.arg >> 8;
+  }
+
+public:
+  // From loop() and whatever it calls
+  void begin(uint8_t id, uint32_t us, uint16_t arg = 0) {
+    if (!frozen.load(std::memory_order_relaxed)) main.push(us, id, 'B', arg);
+  }
+  void end(uint8_t id, uint32_t us, uint16_t arg = 0) {
+    if (!frozen.load(std::memory_order_relaxed)) main.push(us, id, 'E', arg);
+  }
+  void instant(uint8_t id, uint32_t us, uint16_t arg = 0) {
+    if (!frozen.load(std::memory_order_relaxed)) main.push(us, id, 'i', arg);
+  }
+  // From the IR receive interrupt only
+  void isrInstant(uint8_t id, uint32_t us, uint16_t arg = 0) {
+    if (!frozen.load(std::memory_order_relaxed)) isr.push(us, id, 'i', arg);
+  }
+
+  // Holds the rings still for read(); returns the dump's size in bytes
+  uint32_t freeze(uint32_t nowUs) {
+    frozen.store(true, std::memory_order_release);
+    dumpUs = nowUs;
+    return TRACE_HEADER_BYTES + (isr.count() + main.count()) * TRACE_EVENT_BYTES;
+  }
+  void thaw() {
+    frozen.store(false, std::memory_order_release);
+  }
+
+  // Any byte range of the frozen dump, so it can go out in chunks
+  bool read(uint32_t offset, uint8_t *buf, uint16_t n) const {
+    uint32_t events = isr.count() + main.count();
+    if (!frozen.load(std::memory_order_acquire) || offset + n > TRACE_HEADER_BYTES + events * TRACE_EVENT_BYTES) return false;
+    uint8_t header[TRACE_HEADER_BYTES] = { 'I', 'R', 'T', 'R', TRACE_VERSION & 0xFF, TRACE_VERSION >> 8, TRACE_EVENT_BYTES, 0 };
+    for (uint8_t b = 0; b < 4; b++) {
+      header[8 + b] = (events >> (8 * b)) & 0xFF;
+      header[12 + b] = (dumpUs >> (8 * b)) & 0xFF;
+    }
+    uint8_t event[TRACE_EVENT_BYTES];
+    uint32_t cached = UINT32_MAX;
+    for (uint16_t k = 0; k < n; k++) {
+      uint32_t at = offset + k;
+      if (at < TRACE_HEADER_BYTES) {
+        buf[k] = header[at];
+        continue;
+      }
+      uint32_t i = (at - TRACE_HEADER_BYTES) / TRACE_EVENT_BYTES;
+      if (i != cached) eventBytes(cached = i, event);
+      buf[k] = event[(at - TRACE_HEADER_BYTES) % TRACE_EVENT_BYTES];
+    }
+    return true;
+  }
+};
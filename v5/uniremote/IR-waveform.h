@@ -0,0 +1,121 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "./IR-signal.h"
+
+// ============================================================
+// Waveform min/max pyramid
+// ============================================================
+// The base level is the signal's own durations: one node per mark or
+// space, laid out in time, plus the gap that pads each section to its
+// period. Each node keeps two bits: "saw a space" (min = 0) and "saw a
+// mark" (max = 1). Every level above halves the node count by merging
+// pairs, so any time span resolves to a handful of nodes and a redraw
+// costs O(screen width) however long the signal is. Edges sit where the
+// durations put them, so there is detail down to 1 µs at any zoom.
+constexpr int WAVE_MAX_INTERVALS = MAX_RAW_LEN + 2;  // + each section's gap
+constexpr int WAVE_MAX_LEVELS = 9;                   // 202 -> 1
+constexpr int WAVE_TOTAL_NODES = WAVE_MAX_INTERVALS * 2 + WAVE_MAX_LEVELS;  // halving rounds up
+
+class WaveformPyramid {
+  uint32_t startUs[WAVE_MAX_INTERVALS + 1];  // [intervals] is totalUs
+  uint8_t spaceBits[(WAVE_TOTAL_NODES + 7) / 8];
+  uint8_t markBits[(WAVE_TOTAL_NODES + 7) / 8];
+  uint16_t levelStart[WAVE_MAX_LEVELS];
+  uint16_t levelCount[WAVE_MAX_LEVELS];
+  uint16_t intervals = 0;
+  uint8_t levels = 0;
+
+  static bool getBit(const uint8_t *bits, uint16_t i) {
+    return bits[i >> 3] & (1 << (i & 7));
+  }
+  static void setBit(uint8_t *bits, uint16_t i) {
+    bits[i >> 3] |= 1 << (i & 7);
+  }
+
+  // An empty interval is kept, so the levels alternate, but sets no bit
+  uint32_t addInterval(uint32_t fromUs, uint32_t us, bool mark) {
+    startUs[intervals] = fromUs;
+    if (us) setBit(mark ? markBits : spaceBits, intervals);
+    intervals++;
+    return fromUs + us;
+  }
+
+  // Lays one section out from fromUs; the gap up to its period is space
+  uint32_t addSection(uint32_t fromUs, const IRSignal &signal, uint8_t start, uint8_t len, uint32_t periodUs) {
+    uint32_t t = fromUs;
+    for (uint8_t i = 0; i < len; i++) t = addInterval(t, signal.rawData[start + i], (i & 1) == 0);
+    if (len && fromUs + periodUs > t) t = addInterval(t, fromUs + periodUs - t, false);
+    return t;
+  }
+
+  // Index of the interval holding t, which is before totalUs
+  uint16_t intervalAt(uint32_t t) const {
+    uint16_t lo = 0, hi = intervals;  // startUs[lo] <= t < startUs[hi]
+    while (hi - lo > 1) {
+      uint16_t mid = (lo + hi) / 2;
+      if (startUs[mid] <= t) lo = mid;
+      else hi = mid;
+    }
+    return lo;
+  }
+
+public:
+  uint32_t totalUs = 0;
+
+  // Once section then one repeat frame, each stretched to its period
+  void build(const IRSignal &signal) {
+    memset(spaceBits, 0, sizeof(spaceBits));
+    memset(markBits, 0, sizeof(markBits));
+    intervals = 0;
+    uint32_t t = addSection(0, signal, 0, signalOnceLen(signal), signalOncePeriodUs(signal));
+    t = addSection(t, signal, signalRepeatStart(signal), signal.repeatLen, signalRepeatPeriodUs(signal));
+    if (intervals == 0) t = addInterval(0, 1, false);
+    startUs[intervals] = t;
+    totalUs = t;
+
+    levelStart[0] = 0;
+    levelCount[0] = intervals;
+    levels = 1;
+    while (levels < WAVE_MAX_LEVELS && levelCount[levels - 1] > 1) {
+      uint16_t below = levelStart[levels - 1], n = levelCount[levels - 1];
+      levelStart[levels] = below + n;
+      levelCount[levels] = (n + 1) / 2;
+      for (uint16_t i = 0; i < levelCount[levels]; i++) {
+        uint16_t a = below + 2 * i, b = (2 * i + 1 < n) ? a + 1 : a;
+        if (getBit(spaceBits, a) || getBit(spaceBits, b)) setBit(spaceBits, levelStart[levels] + i);
+        if (getBit(markBits, a) || getBit(markBits, b)) setBit(markBits, levelStart[levels] + i);
+      }
+      levels++;
+    }
+  }
+
+  // Lowest and highest level seen in [fromUs, endUs), idle past the end.
+  // Finds the intervals at both ends, then walks the pyramid bottom-up
+  // like a segment tree: O(log n) nodes.
+  void span(uint32_t fromUs, uint32_t endUs, bool &lo, bool &hi) const {
+    lo = true;
+    hi = false;
+    if (endUs > totalUs) {
+      lo = false;
+      endUs = totalUs;
+    }
+    if (fromUs >= endUs) {
+      lo = false;
+      return;
+    }
+    uint32_t l = intervalAt(fromUs), r = intervalAt(endUs - 1) + 1;
+    for (uint8_t level = 0; l < r && level < levels; level++, l >>= 1, r >>= 1) {
+      if (l & 1) visit(level, l++, lo, hi);
+      if (r & 1) visit(level, --r, lo, hi);
+    }
+  }
+
+private:
+  void visit(uint8_t level, uint32_t node, bool &lo, bool &hi) const {
+    uint16_t i = levelStart[level] + (uint16_t)node;
+    if (getBit(spaceBits, i)) lo = false;
+    if (getBit(markBits, i)) hi = true;
+  }
+};
@@ -4,8 +4,24 @@
 #include <SD.h>
 #include <IRremote.hpp>
 #include <Preferences.h>
-#include <functional>
-#include "./IR-codes.h"
+#include <driver/rmt.h>
+#include "./IR-signal.h"
+#include "./IR-database.h"
+#include "./IR-pack.h"
+#include "./IR-rmt.h"
+#include "./IR-stream.h"
+#include "./IR-monitor.h"
+#include "./IR-waveform.h"
+#include "./IR-session.h"
+#include "./IR-loopback.h"
+#include "./IR-sync.h"
+#include "./IR-natsort.h"
+#include "./IR-search.h"
+#include "./IR-busmeter.h"
+#include "./IR-perf.h"
+#include "./IR-trace.h"
+#include "./IR-kinetic.h"
+#include "./IR-touch.h"
 
 // ============================================================
 // Pin definitions
@@ -25,11 +41,54 @@ constexpr uint8_t IR_RX = 1;
 // ============================================================
 // Display driver
 // ============================================================
+// Tallies what the panel driver sends before passing it on; a RAMWR
+// command opens an address window and the data after it is pixels
+template<typename Bus>
+class CountingBus : public Bus {
+  static constexpr uint8_t CMD_RAMWR = 0x2C;
+  bool inRamWrite = false;
+  void data(uint32_t bytes, uint32_t pixels) {
+    tally.bytes += bytes;
+    if (inRamWrite) tally.pixels += pixels;
+  }
+public:
+  BusTally tally;
+  void beginTransaction() override {
+    tally.transactions++;
+    Bus::beginTransaction();
+  }
+  void writeCommand(uint32_t cmd, uint_fast8_t bit_length) override {
+    tally.bytes += bit_length / 8;
+    inRamWrite = (cmd & 0xFF) == CMD_RAMWR;
+    if (inRamWrite) tally.windows++;
+    Bus::writeCommand(cmd, bit_length);
+  }
+  void writeData(uint32_t value, uint_fast8_t bit_length) override {
+    data(bit_length / 8, bit_length / 16);
+    Bus::writeData(value, bit_length);
+  }
+  void writeDataRepeat(uint32_t value, uint_fast8_t bit_length, uint32_t count) override {
+    data(bit_length / 8 * count, count);
+    Bus::writeDataRepeat(value, bit_length, count);
+  }
+  void writePixels(lgfx::pixelcopy_t *param, uint32_t length) override {
+    data(param->dst_bits / 8 * length, length);
+    Bus::writePixels(param, length);
+  }
+  void writeBytes(const uint8_t *bytes, uint32_t length, bool dc, bool use_dma) override {
+    data(length, length / 2);
+    Bus::writeBytes(bytes, length, dc, use_dma);
+  }
+};
+
 class LGFX : public lgfx::LGFX_Device {
   lgfx::Panel_ILI9341 _panel_instance;
-  lgfx::Bus_SPI _bus_instance;
+  CountingBus<lgfx::Bus_SPI> _bus_instance;
   lgfx::Touch_XPT2046 _touch_instance;
 public:
+  const BusTally &busTally() const {
+    return _bus_instance.tally;
+  }
   LGFX(void) {
     {
       auto cfg = _bus_instance.config();
@@ -53,11 +112,8 @@ public:
       _panel_instance.config(cfg);
     }
     {
+      // Read raw; the sketch applies its own calibration (touchCal)
       auto cfg = _touch_instance.config();
-      cfg.x_min = 3850;
-      cfg.x_max = 240;
-      cfg.y_min = 250;
-      cfg.y_max = 3750;
       cfg.pin_sclk = TFT_CLK;
       cfg.pin_mosi = TFT_MOSI;
       cfg.pin_miso = TFT_MISO;
@@ -76,14 +132,6 @@ public:
 // ============================================================
 // Structs & type aliases
 // ============================================================
-constexpr int MAX_SAVED_SIGNAL_CHARS = 25;
-
-struct IRSignal {
-  char name[MAX_SAVED_SIGNAL_CHARS + 1];
-  uint16_t rawData[200];
-  uint8_t rawDataLen;
-} __attribute__((packed));
-
 struct TouchButton {
   int x, y, w, h;
   uint16_t color, textColor;
@@ -92,7 +140,9 @@ struct TouchButton {
   bool pressed, isBackButton, repeatable;
 };
 
-using RowRenderer = std::function<void(int idx, int y, int rowH, bool selected)>;
+// Plain function pointers, like TouchButton callbacks: every renderer is
+// a captureless lambda over globals, and a call never allocates
+using RowRenderer = void (*)(int idx, int y, int rowH, bool selected);
 
 struct ScrollList {
   int itemCount = 0;
@@ -100,8 +150,10 @@ struct ScrollList {
   int selectedIndex = -1;
   float scrollPx = 0;
   int viewX = 0, viewY = 0, viewW = 0, viewH = 0;
-  RowRenderer renderRow;
-  std::function<void()> onOpen = nullptr;
+  RowRenderer renderRow = nullptr;
+  void (*onOpen)() = nullptr;
+  bool horizontal = false;         // drag pans along x, taps don't select
+  void (*renderView)() = nullptr;  // draws the whole view instead of rows
 };
 
 struct Option {
@@ -109,14 +161,102 @@ struct Option {
   void (*callback)();
 };
 
+// A list screen that can sit under another one. Its model (listing,
+// selection, scroll) stays in RAM meanwhile, so Back only repaints
+struct ScreenKind {
+  void (*draw)();   // paints from the model, no SD access
+  void (*load)();   // refills the model from SD; nullptr: never needs to
+  void (*evict)();  // frees the model's heap; nullptr: holds none
+  bool retained;    // false: the screen above reuses the model's storage
+};
+
+struct ScreenEntry {
+  const ScreenKind *kind;
+  int selectedIndex;
+  float scrollPx;
+  bool stale;  // load() before draw()
+};
+
 struct ThemeColors {
   uint16_t primary, secondary, accent, dark, darkest;
 };
 
-struct HardcodedBrand {
-  const char *brandName;
-  const IRCode *codes;
-  uint8_t codesLength;
+enum LoopbackState : uint8_t {
+  LOOPBACK_IDLE,
+  LOOPBACK_SEND,  // waiting for the settle gap, then transmit
+  LOOPBACK_WAIT   // waiting for the echo frame
+};
+
+struct LoopbackResult {
+  char name[24];
+  bool echoed;
+  LoopbackStats stats;
+};
+
+// Info screen figures, kept in Preferences and adjusted as files come and
+// go; serviceStorageStats() re-measures them in the background
+struct StorageStats {
+  uint64_t cardBytes;  // SD.cardSize() of the card they describe
+  uint64_t totalBytes;
+  uint64_t usedBytes;     // files rounded up to whole clusters, plus a cluster per directory
+  uint32_t clusterBytes;  // from the boot sector, so writers can round the same way
+  uint32_t savedCount;
+  uint32_t sessionCount;
+  bool valid;
+};
+
+enum StatsReconcileState : uint8_t {
+  STATS_IDLE,
+  STATS_COUNT_SAVED,
+  STATS_COUNT_SESSIONS,
+  STATS_MEASURE
+};
+
+// One search hit; ref is the index slot (saved), the IR_DB_CODES row
+// (compiled) or the pack code index (pack)
+enum SearchSource : uint8_t {
+  SEARCH_SAVED,
+  SEARCH_COMPILED,
+  SEARCH_PACK
+};
+
+struct SearchResult {
+  uint8_t source;
+  uint32_t ref;
+};
+
+// Per-directory sort cache: the kept rows in listing order, each a
+// SortCacheRow and its name. Valid only for the mount that wrote it
+// (sdMountId), as another machine may change the card in between
+struct SortCacheHeader {
+  uint32_t magic;
+  uint32_t mount;
+  uint16_t kept;
+  uint16_t reserved;
+};
+
+struct SortCacheRow {
+  uint32_t size;
+  uint8_t isDir;
+  uint8_t nameLen;
+};
+
+// /saved-signals as seen by SyncServer (IR-sync.h); the trace dump is
+// read through the same calls while tracing is set
+struct SdSyncStore {
+  File dir, reader, writer;
+  bool tracing = false;
+  bool listBegin();
+  bool listNext(char *name, size_t n, uint32_t &size);
+  bool openRead(const char *name, uint32_t &size);
+  bool readAt(uint32_t offset, uint8_t *buf, uint16_t n);
+  void closeRead();
+  bool openWrite();
+  bool write(const uint8_t *buf, uint16_t n);
+  bool commitWrite(const char *name);
+  void abortWrite();
+  bool remove(const char *name);
+  bool openTrace(uint32_t &size);
 };
 
 // ============================================================
@@ -127,13 +267,150 @@ constexpr int LIST_VIEW_X = 5;
 constexpr int LIST_VIEW_Y = 26;
 constexpr int LIST_VIEW_W = 230;
 constexpr int LIST_VIEW_H = 228;
+constexpr int LIST_SCROLLBAR_W = 3;
 constexpr int LIST_BUTTON_Y = 260;
 
+// Touch buttons on one screen; the keyboard is the largest (26 keys,
+// 4 controls, Back)
+constexpr int MAX_TOUCH_BUTTONS = 32;
+
+// Screen stack: list screens under the current one. Deeper SD folders
+// push the oldest entry out; below SCREEN_EVICT_FREE_HEAP free, stacked
+// models are dropped and reread from SD on Back
+constexpr int SCREEN_STACK_DEPTH = 8;
+constexpr uint32_t SCREEN_EVICT_FREE_HEAP = 32768;
+
+// Monitor screen: list on top, duration histogram below
+constexpr int MONITOR_LIST_H = 128;
+constexpr int MONITOR_STATUS_Y = 158;
+constexpr int MONITOR_HIST_X = 10;
+constexpr int MONITOR_HIST_Y = 174;
+constexpr int MONITOR_HIST_H = 64;
+constexpr int MONITOR_BAR_W = 11;
+constexpr unsigned long MONITOR_REDRAW_MS = 100;
+constexpr unsigned long MONITOR_NOTE_MS = 1500;
+
+// Waveform screen: trace, time labels and overview bar share one sprite push
+constexpr int WAVE_VIEW_Y = 44;
+constexpr int WAVE_VIEW_H = 120;
+constexpr int WAVE_HIGH_Y = 8;
+constexpr int WAVE_LOW_Y = 80;
+constexpr int WAVE_LABEL_Y = 96;
+constexpr int WAVE_OVERVIEW_Y = 112;
+constexpr float WAVE_ZOOM_STEP = 2.0f;
+constexpr float WAVE_MIN_US_PER_PX = 1.0f;
+
+// Session recorder: frames are batched in RAM and written a sector per loop() pass
+constexpr int SESSION_LIST_H = 150;
+constexpr int SESSION_STATUS_Y = 184;
+constexpr int MAX_SESSION_FILES = 50;
+constexpr unsigned long SESSION_SYNC_MS = 5000;
+constexpr unsigned long SESSION_REDRAW_MS = 250;
+
+// Loopback self-test: same list/status/histogram layout as the monitor
+constexpr int MAX_LOOPBACK_SIGNALS = 80;
+constexpr int MAX_LOOPBACK_SAVED = 50;
+constexpr int LOOPBACK_HIST_X = 16;
+constexpr int LOOPBACK_BAR_W = 13;
+constexpr unsigned long LOOPBACK_ECHO_TIMEOUT_MS = 150;
+constexpr unsigned long LOOPBACK_SETTLE_MS = 120;
+
+// IR transmit: RMT plays frames in hardware, IrSender is the blocking fallback
+constexpr bool USE_RMT_TRANSMITTER = true;
+constexpr rmt_channel_t IR_RMT_TX_CHANNEL = RMT_CHANNEL_0;
+constexpr unsigned long RMT_BUSY_TIMEOUT_MS = 250;
+
 // Touch timing
 constexpr unsigned long REPEAT_INTERVAL = 200;
 constexpr int SCROLL_DRAG_THRESHOLD = 10;
 constexpr unsigned long DOUBLE_TAP_WINDOW = 400;
 
+// Touch calibration: this panel's raw edge readings until "Calibrate
+// touch" saves measured ones to Preferences. Its targets sit
+// TOUCH_CAL_INSET px in from opposite corners, and each needs
+// TOUCH_CAL_MIN_SAMPLES firm reads
+constexpr TouchCalibration TOUCH_CAL_DEFAULT = { 3850, 240, 250, 3750 };
+constexpr int TOUCH_CAL_INSET = 30;
+constexpr uint16_t TOUCH_CAL_SETTLE_SAMPLES = 2;  // skipped while the press firms up
+constexpr uint16_t TOUCH_CAL_MIN_SAMPLES = 5;
+// The panel may be too far off for a Cancel button to be hit, so a
+// target left untouched this long, or this many failed tries, leaves
+// with the calibration it had
+constexpr unsigned long TOUCH_CAL_TIMEOUT_MS = 15000;
+constexpr uint8_t TOUCH_CAL_MAX_ATTEMPTS = 3;
+
+// Drags and flings draw at a steady 30 fps (a full list push takes
+// ~21 ms); the touch panel is read every SCROLL_POLL_MS in between and
+// only the latest position is drawn
+constexpr uint32_t SCROLL_FRAME_US = 33333;
+constexpr unsigned long SCROLL_POLL_MS = 5;
+
+// Serial sync: the buffers hold a full window of DATA frames
+constexpr size_t SYNC_SERIAL_BUFFER_BYTES = 2048;
+constexpr const char *SYNC_TEMP_PATH = "/sync.tmp";
+
+// SD delete job: removes a batch of paths a slice per loop() pass, one
+// directory handle open at a time
+constexpr int MAX_SD_JOB_PATHS = 50;
+constexpr int SD_JOB_MAX_DEPTH = 8;
+constexpr unsigned long SD_JOB_SLICE_MS = 30;
+constexpr unsigned long SD_JOB_REDRAW_MS = 100;
+constexpr int SD_JOB_BAR_Y = 150;
+
+// Signal search: saved and compiled names indexed in RAM, the pack
+// through its word index on SD; the keyboard screen previews a few hits
+constexpr uint16_t MAX_SEARCH_NAMES = 512;
+constexpr uint16_t MAX_SEARCH_WORDS = 1536;
+constexpr int MAX_SEARCH_RESULTS = 50;
+constexpr int SEARCH_PREVIEW_ROWS = 4;
+constexpr int SEARCH_PREVIEW_Y = 56;
+constexpr int SEARCH_QUERY_CHARS = 24;
+constexpr int SEARCH_RESULT_NAME_CHARS = 2 * PACK_NAME_CHARS;  // "brand function"
+
+// Performance counters: the overlay (a line in the header strip) and the
+// JSON telemetry on Serial, each turned on by itself, report, then
+// restart, the current window
+constexpr unsigned long PERF_REPORT_MS = 1000;
+constexpr int PERF_OVERLAY_X = 15;
+constexpr int PERF_OVERLAY_W = 210;
+
+// Display bus accounting: each loop() pass that drew is charged to the
+// screen it drew, else to what the touch did. REPORT_BUS_OPS prints one
+// line per charge on Serial; a charge over its budget always does.
+// Budgets are bytes per charge, about 10% over what each draw costs now
+// (press and release: the largest button).
+constexpr bool REPORT_BUS_OPS = false;
+const BusBudget BUS_BUDGETS[] = {
+  { "screen MENU", 650000 },
+  { "screen Signal options", 460000 },
+  { "screen Transmit > Saved", 345000 },
+  { "screen Receive > Listen", 230000 },
+  { "screen SD Card options", 435000 },
+  { "screen SD Card > Files", 365000 },
+  { "screen Change theme", 500000 },
+  { "screen Enter signal name", 410000 },
+  { "press", 80000 },
+  { "release", 80000 },
+  { "scroll frame", 115000 },
+  { "list tap", 115000 },
+  { "monitor update", 100000 },
+  { "monitor update, scrolled", 45000 }
+};
+
+// Listings: a directory shows its first MAX_SD_FILES entries in natural
+// order; the rows are cached per directory under SORT_CACHE_DIR
+constexpr int MAX_SD_FILES = 100;
+constexpr const char *SORT_CACHE_DIR = "/.sort";
+constexpr uint32_t SORT_CACHE_MAGIC = 0x32524F53;  // "SOR2"
+
+// Storage stats: re-measured this often while the device is idle, and
+// written back to Preferences once changes settle
+constexpr unsigned long STATS_RECONCILE_MS = 15UL * 60 * 1000;
+constexpr unsigned long STATS_IDLE_MS = 5000;
+constexpr unsigned long STATS_SLICE_MS = 20;
+constexpr unsigned long STATS_PERSIST_MS = 2000;
+constexpr int STATS_MAX_DEPTH = 8;  // deeper directories count as one cluster each
+
 // ============================================================
 // Theme presets
 // ============================================================
@@ -155,9 +432,14 @@ void listSDInfo();
 void listSDFiles();
 void sdFormatOptions();
 void formatSD();
+void startSelectedDelete();
+void drawSDFileBrowser();
 void setThemeFuturisticRed();
 void setThemeFuturisticGreen();
 void setThemeFuturisticPurple();
+void togglePerfOverlay();
+void togglePerfTelemetry();
+void startTouchCalibration();
 
 const Option MENU_OPTIONS[] = {
   { "Signal options", signalOptions },
@@ -180,22 +462,38 @@ const Option SD_FORMAT_OPTIONS[] = {
   { "Yes, format", formatSD },
   { "Cancel formatting", sdData }
 };
+const Option SD_DELETE_OPTIONS[] = {
+  { "Yes, delete", startSelectedDelete },
+  { "Cancel", drawSDFileBrowser }
+};
 const Option THEME_OPTIONS[] = {
   { "Futuristic Red", setThemeFuturisticRed },
   { "Futuristic Green", setThemeFuturisticGreen },
   { "Futuristic Purple", setThemeFuturisticPurple },
+  { "Perf overlay", togglePerfOverlay },
+  { "Perf telemetry", togglePerfTelemetry },
+  { "Calibrate touch", startTouchCalibration },
   { "Back", drawMenuUI }
 };
 
-const HardcodedBrand hardcodedBrands[] = {
-  { "EPSON", EPSON_CODES, EPSON_CODES_LENGTH },
-  { "LED_STRIP", LED_STRIP_CODES, LED_STRIP_CODES_LENGTH },
-  { "ACER", ACER_CODES, ACER_CODES_LENGTH },
-  { "BENQ", BENQ_CODES, BENQ_CODES_LENGTH },
-  { "NEC", NEC_CODES, NEC_CODES_LENGTH },
-  { "PANASONIC", PANASONIC_CODES, PANASONIC_CODES_LENGTH }
-};
-const uint8_t hardcodedBrandsLength = sizeof(hardcodedBrands) / sizeof(hardcodedBrands[0]);
+void drawSavedSignalsList();
+void scanSavedSignalGroups();
+void evictSavedSignalGroups();
+void drawGroupedSignalsList();
+void scanGroupedSignals();
+void evictGroupedSignals();
+void drawBuiltInBrands();
+void drawBuiltInSignalsList();
+void drawSearchResults();
+void reloadSDFiles();
+
+const ScreenKind SAVED_GROUPS_SCREEN = { drawSavedSignalsList, scanSavedSignalGroups, evictSavedSignalGroups, true };
+const ScreenKind SAVED_GROUP_SCREEN = { drawGroupedSignalsList, scanGroupedSignals, evictGroupedSignals, true };
+const ScreenKind BRANDS_SCREEN = { drawBuiltInBrands, nullptr, nullptr, true };
+const ScreenKind BRAND_SIGNALS_SCREEN = { drawBuiltInSignalsList, nullptr, nullptr, true };
+const ScreenKind SEARCH_RESULTS_SCREEN = { drawSearchResults, nullptr, nullptr, true };
+const ScreenKind SD_FILES_SCREEN = { drawSDFileBrowser, reloadSDFiles, nullptr, false };
+
 
 // ============================================================
 // Global state
@@ -213,30 +511,169 @@ bool listSpriteReady = false;
 ScrollList activeList;
 ScrollList *activeScrollList = nullptr;
 
+// --- Screen stack ---
+ScreenEntry screenStack[SCREEN_STACK_DEPTH];
+uint8_t screenDepth = 0;
+
+// --- Display bus accounting ---
+BusOpTable busOps(BUS_BUDGETS, sizeof(BUS_BUDGETS) / sizeof(BUS_BUDGETS[0]));
+BusTally busOpStart;
+const char *busOpName = "background";
+char busOpScreen[BUS_OP_NAME_CHARS];
+
+// --- Event trace ---
+TraceBuffer trace;
+uint32_t traceLastIrEdgeUs = 0;  // receive ISR only
+
+// --- Performance counters ---
+PerfCounters perf;
+bool perfOverlayOn = false;
+bool perfTelemetryOn = false;
+unsigned long perfLoopStartUs = 0, perfTouchUs = 0;
+bool perfTapPending = false;
+
 // --- Button system ---
-TouchButton buttons[30];
+TouchButton buttons[MAX_TOUCH_BUTTONS];
 uint8_t buttonCount = 0;
 uint8_t activeBtnIndex = 0;
 
+// --- IR receive stream ---
+IrEdgeRing irEdges;
+IrFrameQueue irFrames;
+IrFrameSegmenter irSegmenter(irFrames);
+
+// --- IR monitor ---
+IrMonitor irMonitor;
+bool monitorActive = false;
+unsigned long monitorLastDrawMs = 0;
+uint32_t monitorDrawnSeq = 0;
+bool monitorRowsStale = false;  // frames arrived while a drag owned the list
+uint16_t monitorDrawnScale = 0;
+char monitorNote[32] = "";
+unsigned long monitorNoteUntil = 0;
+
+// --- IR session recorder ---
+SessionWriteBuffer sessionBuffer;
+File sessionFile;
+bool sessionRecording = false;
+bool sessionScreenActive = false;
+uint32_t sessionSeenFrames = 0;
+unsigned long sessionLastSyncMs = 0;
+unsigned long sessionLastDrawMs = 0;
+String sessionName = "";
+String sessionFiles[MAX_SESSION_FILES];
+int sessionFileCount = 0;
+
+// --- IR session replay ---
+File replayFile;
+bool sessionReplaying = false;
+SessionRecord replayRecord;
+IRSignal replaySignal;
+unsigned long replayLastUs = 0;
+uint32_t replayFrames = 0;
+
+// --- Loopback self-test ---
+LoopbackResult loopbackResults[MAX_LOOPBACK_SIGNALS];
+String loopbackSavedFiles[MAX_LOOPBACK_SAVED];
+int loopbackBuiltInCount = 0, loopbackSavedCount = 0;
+int loopbackCount = 0, loopbackIndex = 0;
+LoopbackStats loopbackTotals;
+LoopbackState loopbackState = LOOPBACK_IDLE;
+unsigned long loopbackDeadlineMs = 0;
+IRSignal loopbackSignal;
+
+// --- Waveform viewer ---
+IRSignal waveSignal;
+WaveformPyramid wavePyramid;
+ScrollList waveView;
+float waveUsPerPx = 1;
+
 // --- IR capture ---
-uint16_t currentRawData[200];
+uint16_t currentRawData[MAX_RAW_LEN];
 uint32_t currentDecodedHex = 0;
+uint32_t currentCarrierHz = DEFAULT_CARRIER_HZ;
 uint8_t currentRawDataLen = 0;
 bool signalCaptured = false;
 bool listeningForSignal = false;
 
+// --- IR transmit backend ---
+bool rmtTxReady = false;
+RmtSignalCache rmtCache;
+
+// --- IR hold-to-repeat ---
+IRSignal heldSignal;
+bool holdRepeatActive = false;
+unsigned long holdNextRepeatUs = 0;
+bool pressToggle = false;  // RC5/RC6 toggle bit of the last Send press
+
+// --- Serial sync ---
+SdSyncStore syncStore;
+SyncServer<decltype(Serial), SdSyncStore> syncServer;
+
 // --- Built-in signal browser ---
-const IRCode *currentBrandCodes = nullptr;
-uint8_t currentBrandCodesLength = 0;
+const IRCodeEntry *currentBrandCodes = nullptr;
+uint32_t currentBrandCodesLength = 0;
+File signalPackFile;
+IrPackReader<File> signalPack;
+PackBrandEntry currentPackBrand;
+bool currentBrandFromPack = false;
 int builtInBrandCount = 0;
 int builtInSignalCount = 0;
 String currentBrandPath = "";
 
+// --- Signal search ---
+SignalNameIndex<MAX_SEARCH_NAMES, MAX_SEARCH_WORDS> searchIndex;
+bool searchIndexReady = false;
+File signalWordsFile;
+IrPackWordIndex<File> signalWords;
+SearchResult searchResults[MAX_SEARCH_RESULTS];
+int searchResultCount = 0;
+uint32_t searchMatchCount = 0;
+char searchQuery[SEARCH_QUERY_CHARS + 1] = "";
+bool keyboardSearchMode = false;
+
 // --- SD file browser ---
-String sdFiles[500];
+String sdFiles[MAX_SD_FILES];
+bool sdFileMarked[MAX_SD_FILES];
+bool sdFileIsDir[MAX_SD_FILES];
+uint32_t sdFileSize[MAX_SD_FILES];
+NaturalSortKey sdSortKeys[MAX_SD_FILES];
+uint32_t sdMountId = 0;  // SD.begin() calls so far, kept in Preferences
 int sdFileCount = 0;
+int sdMarkedCount = 0;
 String currentPath = "/";
 
+// --- Storage stats ---
+StorageStats storageStats;
+StatsReconcileState statsState = STATS_IDLE;
+File statsDir;
+uint32_t statsCounted = 0;
+String statsDirPaths[STATS_MAX_DEPTH];
+uint32_t statsDirRead[STATS_MAX_DEPTH];
+uint8_t statsDepth = 0;
+uint64_t statsUsedBytes = 0;
+bool statsReconcileDue = false;
+bool statsDirty = false;
+bool storageInfoActive = false;
+unsigned long statsLastReconcileMs = 0;
+unsigned long statsChangedMs = 0;
+
+// --- SD delete job ---
+String sdJobPaths[MAX_SD_JOB_PATHS];
+int sdJobRows[MAX_SD_JOB_PATHS];
+bool sdJobPathOk[MAX_SD_JOB_PATHS];
+int sdJobPathCount = 0, sdJobNext = 0;
+File sdJobDir;
+String sdJobDirPaths[SD_JOB_MAX_DEPTH];
+uint16_t sdJobKept[SD_JOB_MAX_DEPTH];
+int sdJobDepth = 0;
+bool sdJobPathFailed = false;
+uint32_t sdJobRemoved = 0;
+bool sdJobActive = false;
+bool sdJobCancelled = false;
+void (*sdJobDone)() = nullptr;
+unsigned long sdJobLastDrawMs = 0;
+
 // --- Saved signal groups ---
 String savedSignalGroups[50];
 int savedSignalGroupCount = 0;
@@ -251,15 +688,34 @@ const char *const qwerty2[7] = { "Z", "X", "C", "V", "B", "N", "M" };
 char outputText[MAX_SAVED_SIGNAL_CHARS + 1] = "";
 
 // --- Touch / gesture ---
+TouchCalibration touchCal = TOUCH_CAL_DEFAULT;
+TouchFilter touchFilter;
 bool touchHeld = false;
 int heldButtonIndex = -1;
 unsigned long lastRepeatFire = 0;
 bool scrollGestureActive = false;
 bool scrollIsDragging = false;
+int32_t scrollStartX = 0;
 int32_t scrollStartY = 0;
 float scrollStartPx = 0;
+bool scrollCaughtFling = false;  // this touch stopped a fling, so it isn't a tap
+ScrollVelocity scrollVelocity;
+ScrollFling scrollFling;
+FramePacer scrollPacer(SCROLL_FRAME_US);
+float scrollShownPx = 0;  // offset of the last frame drawn
+uint32_t scrollFrames = 0;
 int lastTapIndex = -1;
 unsigned long lastTapTime = 0;
+unsigned long lastTouchMs = 0;
+
+// --- Touch calibration ---
+bool touchCalActive = false;
+uint8_t touchCalStep = 0;  // target being touched, 0 or 1
+int32_t touchCalSumX = 0, touchCalSumY = 0;
+uint16_t touchCalSamples = 0;
+int32_t touchCalRawX[2], touchCalRawY[2];
+unsigned long touchCalTargetMs = 0;  // when the current target went up
+uint8_t touchCalFailures = 0;
 
 // ============================================================
 // Function prototypes
@@ -274,13 +730,37 @@ void drawTitle(const char *title, uint16_t x = 90, uint16_t y = 305);
 void drawBackBtn(uint8_t x, uint8_t y, uint8_t w, uint8_t h, void (*cb)());
 void printCentered(const char *text, int y, uint16_t color, uint8_t size);
 
+// Display bus accounting
+void beginBusOp();
+void nameBusOp(const char *name);
+void endBusOp();
+
+// Performance counters
+void servicePerf();
+void drawPerfOverlay();
+unsigned long beginSdOp();
+void endSdOp(unsigned long startUs);
+void traceDelay(unsigned long ms);
+
 // Scroll engine
 void ensureListSprite(int w, int h);
 void clampScroll(ScrollList &list);
 void renderScrollList(ScrollList &list);
+void drawListScrollbar(const ScrollList &list);
+void presentListView(const ScrollList &list, unsigned long renderUs, int x, int w);
 void setupAndRenderScrollList(int count, int rowH, RowRenderer renderer);
+void serviceScrollFrame();
+
+// Screen stack
+void resetScreens();
+void pushScreen(const ScreenKind &kind);
+bool restoreScreen();
+void popScreen();
+void markScreensStale();
+int evictScreens();
 
 // Touch system
+bool readTouch(lgfx::touch_point_t &raw, int32_t &x, int32_t &y);
 int processTouchButtons(int tx, int ty);
 bool isTouchInButton(TouchButton *btn, int tx, int ty);
 void drawButton(TouchButton *btn, bool active);
@@ -290,45 +770,127 @@ void createOptions(const Option opts[], int count, int x = 10, int y = 50, int b
 // Screens
 void signalOptions();
 void listSavedSignals();
+void scanSavedSignalGroups();
+void evictSavedSignalGroups();
 void drawSavedSignalsList();
 void startSignalListen();
+void startSignalMonitor();
+void serviceMonitor();
+void drawMonitorUpdates();
+void drawMonitorRows(uint32_t added);
+void drawMonitorHistogram(bool full);
+void saveSelectedMonitorFrame();
+void startSessionScreen();
+void loadSessionFiles();
+void drawSessionStatus();
+void startSessionRecording();
+void stopSessionRecording();
+void recordNewFrames();
+void serviceSessionRecorder();
+void startSessionReplay();
+void stopSessionReplay();
+bool loadNextReplayFrame();
+void serviceSessionReplay();
+void startLoopbackTest();
+bool loadLoopbackSignal(int idx, IRSignal &signal, char *name, size_t nameSize);
+void serviceLoopbackTest();
+void finishLoopbackStep();
+void drawLoopbackStatus();
+void showWaveform(const IRSignal &signal, const char *title, void (*backCb)());
+void showCapturedWaveform();
+void renderWaveform();
+void drawWaveformZoom();
+void zoomWaveform(float factor);
+void openSignalPack();
+void closeSignalPack();
+void drawBuiltInBrands();
+bool loadBuiltInSignal(int idx, IRSignal &signal, bool toggle = false);
 void listBuiltInSignals();
+void drawBuiltInSignalsList();
 void builtInSignalsBrowser();
+void buildSearchIndex();
+void searchIndexAddSaved(const String &file);
+void searchIndexRemoveSaved(const String &file);
+void startSignalSearch();
+void drawSearchKeyboard();
+void searchKeyPressed(const char *label);
+void runSearch(int limit);
+const char *searchResultName(const SearchResult &r, char *buf, size_t n);
+bool loadSearchResult(const SearchResult &r, IRSignal &signal, bool toggle = false);
+void drawSearchPreview();
+void drawSearchResults();
 void sdData();
 void listSDInfo();
 void listSDFiles();
 void loadSDFiles(String path);
+void reloadSDFiles();
 void drawSDFileBrowser();
 void sdFormatOptions();
 void formatSD();
+void formatDone();
 void listGroupedSignals();
+void scanGroupedSignals();
+void evictGroupedSignals();
 void drawGroupedSignalsList();
+String sdFilePath(int idx);
 void deleteSelectedFile();
+void confirmSelectedDelete(int dirs);
+void deleteSelectedDone();
 void themeOptions();
 
 // Keyboard
+int drawKeyboardKeys(int top, int kH, int cH);
 void drawKeyboard();
 void keyboardButtonPressed();
 
 // IR
-void captureSignal();
+void onIrEdge();
+void serviceIrReceiver();
+bool decodeIrFrame(const IrFrame &frame);
+void captureSignal(const IrFrame &frame);
+void buildCapturedSignal(IRSignal &signal);
+uint32_t carrierForProtocol(decode_type_t protocol);
 void saveSignalToSD(const IRSignal &signal);
+bool loadSignalFromSD(const char *path, IRSignal &signal);
+void initRmtTransmitter();
+void sendSignalSection(const IRSignal &signal, bool repeat);
 void transmitSignal(const IRSignal &signal);
-uint16_t prontoToRawSignal(const uint16_t *pronto, uint16_t *outRaw, uint8_t maxOut);
+void serviceHeldTransmit();
+bool nextPressToggle();
 
 // SD helpers
 String formatBytes(uint64_t bytes);
-int countFilesInDirectory(const char *path);
-bool deleteDirectory(const char *path);
-void formatStatusLine(const char *label, uint16_t labelColor, const String &name);
+bool nextDirEntry(File &dir, String &name, bool &isDir);
+bool loadCachedListing(const String &path);
+void sortListing(File &dir, const String &path);
+void listingChanged(const String &entryPath);
+void dropSortCache(const String &dirPath);
+void sortStringsNaturally(String *items, int n);
+void loadStorageStats();
+uint64_t sdBytesOnCard(uint64_t size);
+void adjustStorageStats(int64_t bytes, int32_t saved, int32_t sessions);
+void noteSdFileRemoved(const String &path, uint32_t size);
+void serviceStorageStats();
+bool sdPreservedEntry(const String &dirPath, const String &name);
+void startSdDeleteJob(const char *title, void (*done)());
+void serviceSdDeleteJob();
+void drawSdJobProgress();
 String extractPrefix(String filename);
 
+// Serial sync
+void serviceSerialSync();
+
 // Theme
 ThemeColors themeFromIndex(uint8_t idx);
 void setTheme(uint8_t themeIndex);
 void setThemeFuturisticRed();
 void setThemeFuturisticGreen();
 void setThemeFuturisticPurple();
+void startTouchCalibration();
+void beginTouchCalibration();
+void drawTouchCalibrationTarget();
+void serviceTouchCalibration(const lgfx::touch_point_t &raw, bool touching);
+void endTouchCalibration(const char *outcome);
 
 // ============================================================
 // Setup & loop
@@ -344,56 +906,87 @@ bool pointInScrollView(ScrollList *list, int x, int y) {
 }
 
 void loop() {
+  unsigned long loopUs = micros();
+  if (perfLoopStartUs) perf.loop.add(loopUs - perfLoopStartUs);
+  perfLoopStartUs = loopUs;
+  beginBusOp();
+  serviceIrReceiver();
+  serviceSessionRecorder();
+  serviceSessionReplay();
+  serviceLoopbackTest();
+  serviceSerialSync();
+  serviceSdDeleteJob();
+  serviceStorageStats();
+  if (monitorActive) serviceMonitor();
+  if (sessionScreenActive && millis() - sessionLastDrawMs >= SESSION_REDRAW_MS) drawSessionStatus();
   if (listeningForSignal && !signalCaptured) {
-    if (IrReceiver.decode()) {
-      captureSignal();
+    if (IrFrame *frame = irFrames.front()) {
+      captureSignal(*frame);
+      irFrames.pop();
       buttonCount = 0;
       clearScreen();
       if (currentRawDataLen < 10) {
         printCentered("Invalid", 120, currentTheme.primary, 2);
         printCentered("signal!", 140, currentTheme.primary, 2);
-        delay(2000);
+        traceDelay(2000);
         startSignalListen();
       } else {
         signalCaptured = true;
         listeningForSignal = false;
-        printCentered("Captured!", 150, currentTheme.primary, 2);
-        delay(1500);
-        drawKeyboard();
+        showCapturedWaveform();
       }
-      IrReceiver.resume();
     }
   }
 
+  lgfx::touch_point_t rawTouch;
   int32_t tx, ty;
-  bool touching = tft.getTouch(&tx, &ty);
+  bool touching = readTouch(rawTouch, tx, ty);
 
-  if (touching) {
+  if (touchCalActive) {
+    serviceTouchCalibration(rawTouch, touching);
+  } else if (touching) {
+    lastTouchMs = millis();
     if (!touchHeld) {
       touchHeld = true;
+      perfTouchUs = micros();
+      perfTapPending = true;
       if (pointInScrollView(activeScrollList, (int)tx, (int)ty)) {
         scrollGestureActive = true;
         scrollIsDragging = false;
+        scrollCaughtFling = scrollFling.active;
+        scrollFling.stop();
+        scrollStartX = tx;
         scrollStartY = ty;
         scrollStartPx = activeScrollList->scrollPx;
+        scrollShownPx = activeScrollList->scrollPx;
+        scrollVelocity.clear();
+        scrollVelocity.add(micros(), activeScrollList->horizontal ? tx : ty);
         heldButtonIndex = -1;
       } else {
         scrollGestureActive = false;
+        nameBusOp("press");
         heldButtonIndex = processTouchButtons((int)tx, (int)ty);
         lastRepeatFire = millis();
       }
     } else if (scrollGestureActive && activeScrollList) {
-      int32_t delta = ty - scrollStartY;
-      if (!scrollIsDragging && abs((int)delta) > SCROLL_DRAG_THRESHOLD)
+      int32_t delta = activeScrollList->horizontal ? tx - scrollStartX : ty - scrollStartY;
+      // A light read repeats the last position, which would look like a stop
+      if (!touchFilter.lifting) scrollVelocity.add(micros(), activeScrollList->horizontal ? tx : ty);
+      if (!scrollIsDragging && abs((int)delta) > SCROLL_DRAG_THRESHOLD) {
         scrollIsDragging = true;
+        scrollPacer.restart(micros());
+      }
       if (scrollIsDragging) {
         activeScrollList->scrollPx = scrollStartPx - delta;
         clampScroll(*activeScrollList);
-        renderScrollList(*activeScrollList);
       }
     } else if (heldButtonIndex >= 0 && heldButtonIndex < buttonCount) {
       TouchButton *btn = &buttons[heldButtonIndex];
-      if (btn->repeatable && isTouchInButton(btn, (int)tx, (int)ty)) {
+      if (!isTouchInButton(btn, (int)tx, (int)ty)) {
+        holdRepeatActive = false;
+      } else if (holdRepeatActive) {
+        serviceHeldTransmit();
+      } else if (btn->repeatable) {
         unsigned long now = millis();
         if (now - lastRepeatFire > REPEAT_INTERVAL) {
           lastRepeatFire = now;
@@ -405,16 +998,28 @@ void loop() {
         }
       }
     }
-    delay(scrollIsDragging ? 16 : 50);
+    if (!holdRepeatActive && !scrollGestureActive) traceDelay(50);
 
   } else {
-    if (scrollGestureActive && !scrollIsDragging && activeScrollList) {
+    holdRepeatActive = false;
+    if (scrollGestureActive && scrollIsDragging && activeScrollList) {
+      // The finger's speed, reversed: dragging up scrolls down
+      scrollFling.start(-scrollVelocity.perMs(micros()), micros());
+      if (!scrollFling.active && activeScrollList->scrollPx != scrollShownPx) {
+        nameBusOp("scroll frame");
+        renderScrollList(*activeScrollList);
+        scrollShownPx = activeScrollList->scrollPx;
+        scrollFrames++;
+      }
+    }
+    if (scrollGestureActive && !scrollIsDragging && !scrollCaughtFling && activeScrollList && !activeScrollList->horizontal) {
       int relY = scrollStartY - activeScrollList->viewY;
       int tapped = (int)((activeScrollList->scrollPx + relY) / activeScrollList->rowHeight);
       if (tapped >= 0 && tapped < activeScrollList->itemCount) {
         unsigned long now = millis();
         bool isDoubleTap = (tapped == lastTapIndex) && (now - lastTapTime < DOUBLE_TAP_WINDOW);
         activeScrollList->selectedIndex = tapped;
+        nameBusOp("list tap");
         renderScrollList(*activeScrollList);
         if (isDoubleTap && activeScrollList->onOpen) {
           lastTapIndex = -1;
@@ -428,28 +1033,41 @@ void loop() {
     scrollGestureActive = false;
     scrollIsDragging = false;
     touchHeld = false;
+    perfTapPending = false;
     heldButtonIndex = -1;
     for (int i = 0; i < buttonCount; i++) {
       if (buttons[i].pressed) {
         buttons[i].pressed = false;
+        nameBusOp("release");
         drawButton(&buttons[i], false);
       }
     }
   }
-  delay(10);
+  serviceScrollFrame();
+  endBusOp();
+  servicePerf();
+  if (!holdRepeatActive) traceDelay(scrollGestureActive || scrollFling.active ? SCROLL_POLL_MS : 10);
 }
 
 // ============================================================
 // Display
 // ============================================================
 void initDisplay() {
+  Serial.setRxBufferSize(SYNC_SERIAL_BUFFER_BYTES);
+  Serial.setTxBufferSize(SYNC_SERIAL_BUFFER_BYTES);
   Serial.begin(115200);
   prefs.begin("uniremote", true);
   currentTheme = themeFromIndex(prefs.getUChar("theme", 0));
+  perfOverlayOn = prefs.getBool("perf", false);
+  perfTelemetryOn = prefs.getBool("perfJson", false);
+  TouchCalibration savedCal;
+  if (prefs.getBytes("touchCal", &savedCal, sizeof(savedCal)) == sizeof(savedCal) && savedCal.valid()) touchCal = savedCal;
   prefs.end();
 
-  IrSender.begin(IR_TX);
-  IrReceiver.begin(IR_RX);
+  if (USE_RMT_TRANSMITTER) initRmtTransmitter();
+  if (!rmtTxReady) IrSender.begin(IR_TX);
+  pinMode(IR_RX, INPUT);
+  attachInterrupt(digitalPinToInterrupt(IR_RX), onIrEdge, CHANGE);
 
   for (uint8_t cs : { TFT_CS, TOUCH_CS, SD_CS }) {
     pinMode(cs, OUTPUT);
@@ -458,7 +1076,15 @@ void initDisplay() {
 
   spiSD.begin(TFT_CLK, TFT_MISO, TFT_MOSI, SD_CS);
   initializedSD = SD.begin(SD_CS, spiSD, 20000000);
-  if (initializedSD && !SD.exists("/saved-signals")) SD.mkdir("/saved-signals");
+  if (initializedSD) {
+    prefs.begin("uniremote", false);
+    sdMountId = prefs.getUInt("sdMounts", 0) + 1;
+    prefs.putUInt("sdMounts", sdMountId);
+    prefs.end();
+  }
+  if (initializedSD && !SD.exists("/saved-signals") && SD.mkdir("/saved-signals")) listingChanged("/saved-signals");
+  if (initializedSD && !SD.exists(SORT_CACHE_DIR)) SD.mkdir(SORT_CACHE_DIR);
+  if (initializedSD) loadStorageStats();
 
   tft.init();
   tft.setRotation(0);
@@ -471,8 +1097,13 @@ void clearScreen() {
 }
 
 void drawHeaderFooter() {
+  monitorActive = false;
+  sessionScreenActive = false;
+  storageInfoActive = false;
+  loopbackState = LOOPBACK_IDLE;
   activeScrollList = nullptr;
   activeList.onOpen = nullptr;
+  scrollFling.stop();
   lastTapIndex = -1;
   tft.drawFastHLine(0, 0, 239, currentTheme.primary);
   for (int i = 0; i < 15; i++) {
@@ -487,6 +1118,7 @@ void drawHeaderFooter() {
 }
 
 void drawTitle(const char *title, uint16_t x, uint16_t y) {
+  snprintf(busOpScreen, sizeof(busOpScreen), "screen %s", title);
   tft.setTextSize(1);
   tft.setTextColor(currentTheme.primary);
   tft.setCursor(x, y);
@@ -509,7 +1141,7 @@ void drawBootSplash() {
   drawHeaderFooter();
   printCentered("UNIVERSAL", 120, currentTheme.primary, 3);
   printCentered("REMOTE", 155, currentTheme.primary, 3);
-  delay(2000);
+  traceDelay(2000);
   drawMenuUI();
 }
 
@@ -524,26 +1156,139 @@ void drawMenuUI() {
   drawTitle("MENU", 110);
 }
 
+// ============================================================
+// Display bus accounting
+// ============================================================
+// A pass's display traffic goes to the screen whose title it drew, else
+// to the last thing nameBusOp() was told; passes that drew nothing are
+// not recorded. The table is printed from the host build or on Serial.
+void beginBusOp() {
+  busOpStart = tft.busTally();
+  busOpName = "background";
+  busOpScreen[0] = '\0';
+}
+
+void nameBusOp(const char *name) {
+  busOpName = name;
+}
+
+void endBusOp() {
+  BusTally delta = tft.busTally() - busOpStart;
+  if (delta.bytes == 0) return;
+  const char *name = busOpScreen[0] ? busOpScreen : busOpName;
+  bool withinBudget = busOps.record(name, delta);
+  if (!REPORT_BUS_OPS && withinBudget) return;
+  Serial.printf("bus: %s %lu B, %lu windows, %lu px, %lu tx%s\n", name, (unsigned long)delta.bytes,
+                (unsigned long)delta.windows, (unsigned long)delta.pixels, (unsigned long)delta.transactions,
+                withinBudget ? "" : " OVER BUDGET");
+}
+
+// ============================================================
+// Performance counters
+// ============================================================
+// Every PERF_REPORT_MS the window's counters go out as one JSON line on
+// Serial (Perf telemetry) and a summary in the header strip (Perf
+// overlay), p95s in ms:
+//   L loop period  F render+present  T touch->callback  I tap->IR
+//   S SD op  H free heap/largest block (KB)  A sprite alloc failures
+void servicePerf() {
+  unsigned long now = millis();
+  if (now - perf.windowStartMs < PERF_REPORT_MS) return;
+  if (perfTelemetryOn) {
+    char line[640];
+    formatPerfJson(line, sizeof(line), perf, now, ESP.getFreeHeap(), ESP.getMaxAllocHeap());
+    Serial.print(line);
+  }
+  if (perfOverlayOn) {
+    beginBusOp();
+    nameBusOp("perf overlay");
+    drawPerfOverlay();
+    endBusOp();
+  }
+  perf.clearWindow(now);
+}
+
+void drawPerfOverlay() {
+  auto ms = [](const PerfHistogram &h) {
+    return (unsigned long)((h.percentile(95) + 999) / 1000);
+  };
+  char text[48];
+  int n = snprintf(text, sizeof(text), "L%lu F%lu+%lu T%lu I%lu S%lu H%lu/%lu", ms(perf.loop), ms(perf.render),
+                   ms(perf.present), ms(perf.touchCallback), ms(perf.tapToIr), ms(perf.sd),
+                   (unsigned long)(ESP.getFreeHeap() / 1024), (unsigned long)(ESP.getMaxAllocHeap() / 1024));
+  if (perf.spriteAllocFailures && n < (int)sizeof(text))
+    snprintf(text + n, sizeof(text) - n, " A%lu", (unsigned long)perf.spriteAllocFailures);
+  tft.setTextSize(1);
+  tft.setTextColor(currentTheme.accent, TFT_BLACK);
+  tft.fillRect(PERF_OVERLAY_X, 2, PERF_OVERLAY_W, 8, TFT_BLACK);
+  tft.setCursor(PERF_OVERLAY_X + (PERF_OVERLAY_W - tft.textWidth(text)) / 2, 2);
+  tft.print(text);
+}
+
+// SD work shows up both in the perf histogram and the trace
+unsigned long beginSdOp() {
+  unsigned long us = micros();
+  trace.begin(TRACE_SD, us);
+  return us;
+}
+
+void endSdOp(unsigned long startUs) {
+  unsigned long us = micros();
+  trace.end(TRACE_SD, us);
+  perf.sd.add(us - startUs);
+}
+
+void traceDelay(unsigned long ms) {
+  trace.begin(TRACE_DELAY, micros(), ms);
+  delay(ms);
+  trace.end(TRACE_DELAY, micros(), ms);
+}
+
+void togglePerfOverlay() {
+  perfOverlayOn = !perfOverlayOn;
+  prefs.begin("uniremote", false);
+  prefs.putBool("perf", perfOverlayOn);
+  prefs.end();
+  perf.clearWindow(millis());
+  if (!perfOverlayOn) tft.fillRect(PERF_OVERLAY_X, 2, PERF_OVERLAY_W, 8, TFT_BLACK);
+}
+
+void togglePerfTelemetry() {
+  perfTelemetryOn = !perfTelemetryOn;
+  prefs.begin("uniremote", false);
+  prefs.putBool("perfJson", perfTelemetryOn);
+  prefs.end();
+  perf.clearWindow(millis());
+}
+
 // ============================================================
 // Scroll engine
 // ============================================================
 void ensureListSprite(int w, int h) {
   if (listSpriteReady) return;
   listSprite.setColorDepth(16);
-  if (listSprite.createSprite(w, h)) {
+  if (listSprite.createSprite(w, h) || (evictScreens() && listSprite.createSprite(w, h))) {
     listSpriteReady = true;
   } else {
+    perf.spriteAllocFailures++;
     Serial.println("Sprite alloc failed — not enough RAM");
   }
 }
 
 void clampScroll(ScrollList &list) {
-  float maxScroll = max(0.0f, (float)(list.itemCount * list.rowHeight - list.viewH));
+  int viewExtent = list.horizontal ? list.viewW : list.viewH;
+  float maxScroll = max(0.0f, (float)(list.itemCount * list.rowHeight - viewExtent));
   list.scrollPx = constrain(list.scrollPx, 0.0f, maxScroll);
 }
 
+// The sprite is always LIST_VIEW-sized; shorter views push a clipped part
 void renderScrollList(ScrollList &list) {
-  ensureListSprite(list.viewW, list.viewH);
+  if (list.renderView) {
+    list.renderView();
+    return;
+  }
+  ensureListSprite(LIST_VIEW_W, LIST_VIEW_H);
+  unsigned long renderUs = micros();
   listSprite.fillSprite(TFT_BLACK);
 
   int firstIndex = (int)(list.scrollPx / list.rowHeight);
@@ -557,14 +1302,51 @@ void renderScrollList(ScrollList &list) {
     if (y + list.rowHeight < 0 || y > list.viewH) continue;
     if (list.renderRow) list.renderRow(idx, y, list.rowHeight, idx == list.selectedIndex);
   }
+  drawListScrollbar(list);
+  presentListView(list, renderUs, 0, list.viewW);
+}
 
+// Position bar down the view's right edge, over the rows
+void drawListScrollbar(const ScrollList &list) {
   float maxScroll = (float)(list.itemCount * list.rowHeight - list.viewH);
-  if (maxScroll > 0) {
-    int barH = max(15, (int)(list.viewH * (float)list.viewH / (list.itemCount * list.rowHeight)));
-    int barY = (int)((list.viewH - barH) * (list.scrollPx / maxScroll));
-    listSprite.fillRect(list.viewW - 3, barY, 3, barH, currentTheme.secondary);
-  }
+  if (maxScroll <= 0) return;
+  int barH = max(15, (int)(list.viewH * (float)list.viewH / (list.itemCount * list.rowHeight)));
+  int barY = (int)((list.viewH - barH) * (list.scrollPx / maxScroll));
+  listSprite.fillRect(list.viewW - LIST_SCROLLBAR_W, barY, LIST_SCROLLBAR_W, barH, currentTheme.secondary);
+}
+
+// Pushes the sprite's columns x..x+w of the view; the clip keeps the
+// panel transfer to that strip
+void presentListView(const ScrollList &list, unsigned long renderUs, int x, int w) {
+  unsigned long presentUs = micros();
+  perf.render.add(presentUs - renderUs);
+  trace.begin(TRACE_SPRITE_PUSH, presentUs);
+  tft.setClipRect(list.viewX + x, list.viewY, w, list.viewH);
   listSprite.pushSprite(list.viewX, list.viewY);
+  tft.clearClipRect();
+  unsigned long doneUs = micros();
+  trace.end(TRACE_SPRITE_PUSH, doneUs);
+  perf.present.add(doneUs - presentUs);
+}
+
+// Drags and flings draw here, once per SCROLL_FRAME_US at most, at
+// wherever the touch samples since the last frame left the list
+void serviceScrollFrame() {
+  if (!activeScrollList || !(scrollIsDragging || scrollFling.active)) return;
+  uint32_t now = micros();
+  if (!scrollPacer.due(now)) return;
+  ScrollList &list = *activeScrollList;
+  if (scrollFling.active) {
+    float to = list.scrollPx + scrollFling.advance(now);
+    list.scrollPx = to;
+    clampScroll(list);
+    if (list.scrollPx != to) scrollFling.stop();  // ran into an end
+  }
+  if (list.scrollPx == scrollShownPx) return;
+  nameBusOp("scroll frame");
+  renderScrollList(list);
+  scrollShownPx = list.scrollPx;
+  scrollFrames++;
 }
 
 void setupAndRenderScrollList(int count, int rowH, RowRenderer renderer) {
@@ -580,6 +1362,59 @@ void setupAndRenderScrollList(int count, int rowH, RowRenderer renderer) {
   renderScrollList(activeList);
 }
 
+// ============================================================
+// Screen stack
+// ============================================================
+// Opening a list from a list pushes the one being left; Back pops it
+// and puts its selection and scroll back. Chains start over from their
+// first list (resetScreens), whose own Back leaves the stack alone.
+void resetScreens() {
+  screenDepth = 0;
+}
+
+void pushScreen(const ScreenKind &kind) {
+  if (screenDepth == SCREEN_STACK_DEPTH) {
+    memmove(screenStack, screenStack + 1, sizeof(ScreenEntry) * (SCREEN_STACK_DEPTH - 1));
+    screenDepth--;
+  }
+  screenStack[screenDepth++] = { &kind, activeList.selectedIndex, activeList.scrollPx, !kind.retained };
+  if (ESP.getFreeHeap() < SCREEN_EVICT_FREE_HEAP) evictScreens();
+}
+
+// False when there was nothing to go back to
+bool restoreScreen() {
+  if (!screenDepth) return false;
+  ScreenEntry &e = screenStack[--screenDepth];
+  if (e.stale && e.kind->load) e.kind->load();
+  activeList.selectedIndex = e.selectedIndex;
+  activeList.scrollPx = e.scrollPx;
+  e.kind->draw();
+  return true;
+}
+
+void popScreen() {
+  if (!restoreScreen()) drawMenuUI();
+}
+
+// Files came or went under /saved-signals: stacked listings reload on Back
+void markScreensStale() {
+  for (uint8_t i = 0; i < screenDepth; i++)
+    if (screenStack[i].kind->load) screenStack[i].stale = true;
+}
+
+// Frees every stacked model that can be reread; returns how many
+int evictScreens() {
+  int n = 0;
+  for (uint8_t i = 0; i < screenDepth; i++) {
+    ScreenEntry &e = screenStack[i];
+    if (e.stale || !e.kind->evict) continue;
+    e.kind->evict();
+    e.stale = true;
+    n++;
+  }
+  return n;
+}
+
 // ============================================================
 // Screens — Signal
 // ============================================================
@@ -588,15 +1423,28 @@ void signalOptions() {
   clearScreen();
   const int btnSize = 100, gap = 10;
   const int startX = (240 - btnSize * 2 - gap) / 2;
-  createTouchBox(startX, 70, btnSize, btnSize, currentTheme.primary, currentTheme.primary, "Transmit", listSavedSignals);
-  createTouchBox(startX + btnSize + gap, 70, btnSize, btnSize, currentTheme.primary, currentTheme.primary, "Receive", startSignalListen);
-  createTouchBox(60, 190, 120, 45, currentTheme.secondary, currentTheme.secondary, "Back", drawMenuUI, true);
+  createTouchBox(startX, 35, btnSize, 90, currentTheme.primary, currentTheme.primary, "Transmit", listSavedSignals);
+  createTouchBox(startX + btnSize + gap, 35, btnSize, 90, currentTheme.primary, currentTheme.primary, "Receive", startSignalListen);
+  createTouchBox(startX, 135, btnSize, 45, currentTheme.primary, currentTheme.primary, "Monitor", startSignalMonitor);
+  createTouchBox(startX + btnSize + gap, 135, btnSize, 45, currentTheme.primary, currentTheme.primary, "Session", startSessionScreen);
+  createTouchBox(startX, 190, btnSize, 45, currentTheme.primary, currentTheme.primary, "Loopback", startLoopbackTest);
+  createTouchBox(startX + btnSize + gap, 190, btnSize, 45, currentTheme.primary, currentTheme.primary, "Search", startSignalSearch);
+  createTouchBox(60, 250, 120, 45, currentTheme.secondary, currentTheme.secondary, "Back", drawMenuUI, true);
   drawHeaderFooter();
   drawTitle("Signal options", 80);
 }
 
 void listSavedSignals() {
+  resetScreens();
+  scanSavedSignalGroups();
+  activeList.selectedIndex = 0;
+  activeList.scrollPx = 0;
+  drawSavedSignalsList();
+}
+
+void scanSavedSignalGroups() {
   savedSignalGroupCount = 0;
+  unsigned long startUs = beginSdOp();
   File dir = SD.open("/saved-signals");
   if (dir) {
     for (File e = dir.openNextFile(); e && savedSignalGroupCount < 50; e = dir.openNextFile()) {
@@ -615,9 +1463,13 @@ void listSavedSignals() {
     }
     dir.close();
   }
-  activeList.selectedIndex = 0;
-  activeList.scrollPx = 0;
-  drawSavedSignalsList();
+  endSdOp(startUs);
+  sortStringsNaturally(savedSignalGroups, savedSignalGroupCount);
+}
+
+void evictSavedSignalGroups() {
+  for (int i = 0; i < savedSignalGroupCount; i++) savedSignalGroups[i] = String();
+  savedSignalGroupCount = 0;
 }
 
 void drawSavedSignalsList() {
@@ -640,6 +1492,7 @@ void drawSavedSignalsList() {
   activeList.onOpen = []() {
     if (activeList.selectedIndex >= 0 && activeList.selectedIndex < savedSignalGroupCount) {
       currentSavedGroup = savedSignalGroups[activeList.selectedIndex];
+      pushScreen(SAVED_GROUPS_SCREEN);
       listGroupedSignals();
     }
   };
@@ -653,6 +1506,8 @@ void startSignalListen() {
   signalCaptured = false;
   currentRawDataLen = 0;
   currentDecodedHex = 0;
+  currentCarrierHz = DEFAULT_CARRIER_HZ;
+  irFrames.clear();
   clearScreen();
   printCentered("Listening", 120, currentTheme.primary, 2);
   printCentered("for signal...", 140, currentTheme.primary, 2);
@@ -664,155 +1519,1127 @@ void startSignalListen() {
   drawTitle("Receive > Listen", 70);
 }
 
-// ============================================================
-// Screens — Built-in signals
-// ============================================================
-void builtInSignalsBrowser() {
+// Continuous view of every incoming frame. Frames are pulled off the
+// queue each loop() pass, but the screen only redraws every
+// MONITOR_REDRAW_MS and only the parts that changed.
+void startSignalMonitor() {
   buttonCount = 0;
-  builtInBrandCount = hardcodedBrandsLength;
-  activeList.selectedIndex = 0;
-  activeList.scrollPx = 0;
+  listeningForSignal = false;
+  irFrames.clear();
+  irMonitor.clear();
+  monitorDrawnSeq = 0;
+  monitorRowsStale = false;
+  monitorDrawnScale = 0;
+  monitorNote[0] = '\0';
   clearScreen();
+  monitorActive = true;
 
-  if (builtInBrandCount == 0) {
-    printCentered("No brands", 120, currentTheme.primary, 2);
-    printCentered("found!", 140, currentTheme.primary, 2);
-    drawBackBtn(60, 200, 120, 40, drawMenuUI);
-    drawTitle("Built-in signals", 70);
-    return;
-  }
-  setupAndRenderScrollList(builtInBrandCount, 32, [](int idx, int y, int rowH, bool sel) {
-    listSprite.fillRect(0, y, LIST_VIEW_W, rowH - 2, sel ? currentTheme.primary : TFT_BLACK);
+  activeList.itemCount = 0;
+  activeList.rowHeight = 16;
+  activeList.selectedIndex = 0;
+  activeList.scrollPx = 0;
+  activeList.viewX = LIST_VIEW_X;
+  activeList.viewY = LIST_VIEW_Y;
+  activeList.viewW = LIST_VIEW_W;
+  activeList.viewH = MONITOR_LIST_H;
+  activeList.renderRow = [](int idx, int y, int rowH, bool sel) {
+    const MonitorFrame &f = irMonitor.newest(idx);
+    // Short of the scroll bar, which drawMonitorRows() redraws on its own
+    listSprite.fillRect(0, y, LIST_VIEW_W - LIST_SCROLLBAR_W, rowH - 2, sel ? currentTheme.primary : TFT_BLACK);
     listSprite.setTextColor(sel ? TFT_BLACK : TFT_WHITE);
-    listSprite.setTextSize(2);
-    listSprite.setCursor(5, y + 6);
-    listSprite.println(hardcodedBrands[idx].brandName);
-  });
-  activeList.onOpen = []() {
-    int idx = activeList.selectedIndex;
-    if (idx < 0 || idx >= builtInBrandCount) return;
-    currentBrandCodes = hardcodedBrands[idx].codes;
-    currentBrandCodesLength = hardcodedBrands[idx].codesLength;
-    currentBrandPath = hardcodedBrands[idx].brandName;
-    listBuiltInSignals();
+    listSprite.setTextSize(1);
+    listSprite.setCursor(5, y + 4);
+    if (f.decoded) {
+      listSprite.printf("#%lu %s A:0x%X C:0x%X", (unsigned long)f.seq, getProtocolString((decode_type_t)f.protocol), f.address, f.command);
+    } else {
+      listSprite.printf("#%lu RAW %u", (unsigned long)f.seq, f.len);
+    }
   };
-  createTouchBox(60, LIST_BUTTON_Y, 120, 28, currentTheme.secondary, currentTheme.secondary, "Back", drawMenuUI, true);
-  drawTitle("Built-in signals", 70);
-}
+  activeList.onOpen = saveSelectedMonitorFrame;
+  activeScrollList = &activeList;
+  renderScrollList(activeList);
 
-void listBuiltInSignals() {
-  buttonCount = 0;
-  activeList.selectedIndex = 0;
-  activeList.scrollPx = 0;
-  clearScreen();
+  tft.setTextSize(1);
+  tft.setTextColor(currentTheme.accent);
+  tft.setCursor(MONITOR_HIST_X, MONITOR_HIST_Y + MONITOR_HIST_H + 4);
+  tft.print("0");
+  tft.setCursor(MONITOR_HIST_X + 10 * MONITOR_BAR_W - 9, MONITOR_HIST_Y + MONITOR_HIST_H + 4);
+  tft.print("2.5");
+  tft.setCursor(MONITOR_HIST_X + MONITOR_HIST_BINS * MONITOR_BAR_W - 30, MONITOR_HIST_Y + MONITOR_HIST_H + 4);
+  tft.print(">5ms");
+  drawMonitorHistogram(true);
 
-  if (!currentBrandCodes || currentBrandCodesLength == 0) {
-    printCentered("Brand not", 120, currentTheme.primary, 2);
-    printCentered("found!", 140, currentTheme.primary, 2);
-    drawBackBtn(60, 200, 120, 40, builtInSignalsBrowser);
-    drawTitle("Brand signals", 75);
-    return;
-  }
-  builtInSignalCount = currentBrandCodesLength;
-  setupAndRenderScrollList(builtInSignalCount, 32, [](int idx, int y, int rowH, bool sel) {
-    listSprite.fillRect(0, y, LIST_VIEW_W, rowH - 2, sel ? currentTheme.primary : TFT_BLACK);
-    listSprite.setTextColor(sel ? TFT_BLACK : TFT_WHITE);
-    listSprite.setTextSize(2);
-    listSprite.setCursor(5, y + 6);
-    listSprite.println(currentBrandCodes[idx].codeName);
-  });
   createTouchBox(
     15, LIST_BUTTON_Y, 100, 28, currentTheme.secondary, currentTheme.secondary, "Back",
     []() {
-      builtInSignalsBrowser();
+      signalOptions();
     },
     true);
-  createTouchBox(125, LIST_BUTTON_Y, 100, 28, currentTheme.primary, currentTheme.primary, "Send", []() {
-    if (activeList.selectedIndex < 0 || activeList.selectedIndex >= builtInSignalCount) return;
-    const IRCode *code = &currentBrandCodes[activeList.selectedIndex];
-    IRSignal signal;
-    strncpy(signal.name, code->codeName, sizeof(signal.name) - 1);
-    signal.name[sizeof(signal.name) - 1] = '\0';
-    signal.rawDataLen = (uint8_t)prontoToRawSignal(code->codeArray, signal.rawData, 200);
-    transmitSignal(signal);
-  });
-  drawTitle((currentBrandPath + " signals").c_str(), 70);
+  createTouchBox(125, LIST_BUTTON_Y, 100, 28, currentTheme.primary, currentTheme.primary, "Save", saveSelectedMonitorFrame);
+  drawTitle("Receive > Monitor", 65);
 }
 
-// ============================================================
-// Screens — SD Card
-// ============================================================
-void sdData() {
-  createOptions(SD_CARD_OPTIONS, 4, 10, 47, 220, 45);
-  drawTitle("SD Card options", 75);
+void serviceMonitor() {
+  unsigned long now = millis();
+  while (IrFrame *frame = irFrames.front()) {
+    MonitorFrame &entry = irMonitor.add(*frame, now);
+    if (decodeIrFrame(*frame) && IrReceiver.decodedIRData.protocol != UNKNOWN) {
+      entry.decoded = true;
+      entry.protocol = IrReceiver.decodedIRData.protocol;
+      entry.address = IrReceiver.decodedIRData.address;
+      entry.command = IrReceiver.decodedIRData.command;
+      entry.carrierHz = carrierForProtocol(IrReceiver.decodedIRData.protocol);
+    }
+    irFrames.pop();
+  }
+  irMonitor.tick(now);
+  if (now - monitorLastDrawMs < MONITOR_REDRAW_MS) return;
+  monitorLastDrawMs = now;
+  drawMonitorUpdates();
 }
 
-void listSDInfo() {
-  buttonCount = 0;
-  clearScreen();
-  drawTitle("SD Card > Info", 75);
-  uint64_t total = SD.totalBytes(), used = SD.usedBytes();
-  int y = 110;
-
-  tft.setTextSize(3);
-  tft.setTextColor(currentTheme.primary);
-  tft.setCursor(5, 72);
-  tft.println("Storage");
-  tft.drawFastHLine(0, y - 12, 240, currentTheme.primary);
-  tft.drawFastHLine(0, y - 10, 240, currentTheme.primary);
-
-  tft.setTextSize(2);
-  auto row = [&](const char *label, String val) {
-    tft.setCursor(10, y);
-    tft.print(label);
-    tft.println(val);
-    y += 20;
-  };
-  row("Full: ", formatBytes(total));
-  row("Free: ", formatBytes(total - used));
-  row("Used: ", formatBytes(used));
-  y += 20;
-
-  tft.setTextSize(3);
-  tft.setCursor(5, y);
-  tft.println("Signals");
-  tft.drawFastHLine(0, y + 26, 240, currentTheme.primary);
-  tft.drawFastHLine(0, y + 28, 240, currentTheme.primary);
-  y += 40;
-  tft.setTextSize(2);
-  tft.setCursor(10, y);
-  tft.print("Saved: ");
-  tft.println(countFilesInDirectory("/saved-signals"));
+void drawMonitorUpdates() {
+  nameBusOp("monitor update");
+  uint32_t newFrames = irMonitor.totalFrames - monitorDrawnSeq;
+  if (newFrames) {
+    monitorDrawnSeq = irMonitor.totalFrames;
+    activeList.itemCount = irMonitor.count;
+    // Row 0 follows the newest frame; any other selection stays on its frame
+    if (activeList.selectedIndex > 0) {
+      activeList.selectedIndex += min(newFrames, (uint32_t)MONITOR_SLOTS);
+      if (activeList.selectedIndex >= irMonitor.count) activeList.selectedIndex = -1;
+    }
+    drawMonitorRows(newFrames);
+  }
 
-  drawBackBtn(185, 130, 55, 50, sdData);
+  tft.fillRect(0, MONITOR_STATUS_Y, 240, 12, TFT_BLACK);
+  tft.setTextSize(1);
+  tft.setCursor(LIST_VIEW_X, MONITOR_STATUS_Y + 2);
+  if (millis() < monitorNoteUntil) {
+    tft.setTextColor(0x07E0);
+    tft.print(monitorNote);
+  } else {
+    tft.setTextColor(currentTheme.accent);
+    tft.printf("%lu fps  %lu frames  %lu dropped", (unsigned long)irMonitor.fps, (unsigned long)irMonitor.totalFrames,
+               (unsigned long)(irSegmenter.framesDropped + irEdges.dropped.load()));
+  }
+  drawMonitorHistogram(false);
 }
 
-void listSDFiles() {
-  buttonCount = 0;
-  currentPath = "/";
-  activeList.selectedIndex = 0;
-  activeList.scrollPx = 0;
-  loadSDFiles(currentPath);
-  drawSDFileBrowser();
+// New frames go in at the top of the newest-first list. Scrolled away
+// from the top, the view moves down with the frames it shows, so only
+// the scroll bar changes. At the top, the sprite shifts down by the new
+// rows and only those (and the old newest, if it held the selection)
+// are drawn before the view goes out.
+void drawMonitorRows(uint32_t added) {
+  ScrollList &list = activeList;
+  if (scrollIsDragging) {
+    monitorRowsStale = true;
+    return;
+  }
+  unsigned long renderUs = micros();
+  int rowH = list.rowHeight;
+  int shiftPx = (int)min(added, (uint32_t)MONITOR_SLOTS) * rowH;
+  if (!monitorRowsStale && list.scrollPx > 0) {
+    float to = list.scrollPx + shiftPx;
+    list.scrollPx = to;
+    clampScroll(list);
+    scrollShownPx = list.scrollPx;
+    // Clamped: frames fell off the end of the ring under the view
+    if (list.scrollPx == to) {
+      nameBusOp("monitor update, scrolled");
+      listSprite.fillRect(list.viewW - LIST_SCROLLBAR_W, 0, LIST_SCROLLBAR_W, list.viewH, TFT_BLACK);
+      drawListScrollbar(list);
+      presentListView(list, renderUs, list.viewW - LIST_SCROLLBAR_W, LIST_SCROLLBAR_W);
+      return;
+    }
+  } else if (!monitorRowsStale && shiftPx < list.viewH) {
+    int rows = shiftPx / rowH + (list.selectedIndex == 0 ? 1 : 0);
+    listSprite.scroll(0, shiftPx);
+    listSprite.fillRect(0, 0, list.viewW, rows * rowH, TFT_BLACK);
+    listSprite.fillRect(list.viewW - LIST_SCROLLBAR_W, 0, LIST_SCROLLBAR_W, list.viewH, TFT_BLACK);
+    for (int idx = 0; idx < rows && idx < list.itemCount; idx++) list.renderRow(idx, idx * rowH, rowH, idx == list.selectedIndex);
+    drawListScrollbar(list);
+    presentListView(list, renderUs, 0, list.viewW);
+    return;
+  }
+  monitorRowsStale = false;
+  renderScrollList(list);
 }
 
-void loadSDFiles(String path) {
-  sdFileCount = 0;
-  File dir = SD.open(path);
-  if (!dir) {
-    Serial.println("Failed to open dir");
-    return;
+// Bars scale to the next power of two above the tallest bin, so the
+// scale (and with it every bar) only changes when a bin doubles
+void drawMonitorHistogram(bool full) {
+  uint16_t maxCount = irMonitor.histogramMax(), scale = 8;
+  while (scale < maxCount) scale <<= 1;
+  if (scale != monitorDrawnScale) {
+    monitorDrawnScale = scale;
+    full = true;
   }
-  for (File e = dir.openNextFile(); e && sdFileCount < 50; e = dir.openNextFile()) {
-    String name = String(e.name());
-    if (name.startsWith("/")) name = name.substring(1);
-    sdFiles[sdFileCount++] = e.isDirectory() ? ("DIR - " + name) : (name + " - " + formatBytes(e.size()));
-    e.close();
+  uint32_t dirty = full ? (1UL << MONITOR_HIST_BINS) - 1 : irMonitor.histDirty;
+  irMonitor.histDirty = 0;
+  for (int b = 0; b < MONITOR_HIST_BINS; b++) {
+    if (!(dirty & (1UL << b))) continue;
+    int x = MONITOR_HIST_X + b * MONITOR_BAR_W;
+    int h = (int)((uint32_t)irMonitor.histogram[b] * MONITOR_HIST_H / scale);
+    tft.fillRect(x, MONITOR_HIST_Y, MONITOR_BAR_W - 2, MONITOR_HIST_H - h, currentTheme.darkest);
+    if (h) tft.fillRect(x, MONITOR_HIST_Y + MONITOR_HIST_H - h, MONITOR_BAR_W - 2, h, b == MONITOR_HIST_BINS - 1 ? currentTheme.accent : currentTheme.primary);
   }
-  dir.close();
 }
 
-void drawSDFileBrowser() {
+void saveSelectedMonitorFrame() {
+  int idx = activeList.selectedIndex;
+  if (!monitorActive || idx < 0 || idx >= irMonitor.count) return;
+  const MonitorFrame &f = irMonitor.newest(idx);
+  if (!initializedSD) {
+    snprintf(monitorNote, sizeof(monitorNote), "No SD card");
+  } else {
+    IRSignal signal = {};
+    uint32_t n = f.seq;
+    do {
+      snprintf(signal.name, sizeof(signal.name), "MON-%lu", (unsigned long)n++);
+    } while (SD.exists(("/saved-signals/" + String(signal.name) + ".bin").c_str()));
+    memcpy(signal.rawData, f.durations, f.len * sizeof(uint16_t));
+    signal.rawDataLen = f.len;
+    signal.carrierHz = f.carrierHz;
+    saveSignalToSD(signal);
+    snprintf(monitorNote, sizeof(monitorNote), "Saved %s", signal.name);
+  }
+  monitorNoteUntil = millis() + MONITOR_NOTE_MS;
+  monitorLastDrawMs = 0;
+}
+
+// Recording keeps running on every other screen; this screen lists the
+// logs in /sessions and shows live counters.
+void startSessionScreen() {
+  buttonCount = 0;
+  clearScreen();
+  if (!initializedSD) {
+    printCentered("No SD card", 130, currentTheme.primary, 2);
+    drawBackBtn(60, 200, 120, 40, signalOptions);
+    drawTitle("Receive > Session", 65);
+    return;
+  }
+  loadSessionFiles();
+  activeList.itemCount = sessionFileCount;
+  activeList.rowHeight = 26;
+  activeList.selectedIndex = sessionFileCount ? 0 : -1;
+  activeList.scrollPx = 0;
+  activeList.viewX = LIST_VIEW_X;
+  activeList.viewY = LIST_VIEW_Y;
+  activeList.viewW = LIST_VIEW_W;
+  activeList.viewH = SESSION_LIST_H;
+  activeList.renderRow = [](int idx, int y, int rowH, bool sel) {
+    listSprite.fillRect(0, y, LIST_VIEW_W, rowH - 2, sel ? currentTheme.primary : TFT_BLACK);
+    listSprite.setTextColor(sel ? TFT_BLACK : TFT_WHITE);
+    listSprite.setTextSize(2);
+    listSprite.setCursor(5, y + 4);
+    listSprite.print(sessionFiles[idx]);
+  };
+  activeScrollList = &activeList;
+  renderScrollList(activeList);
+  sessionScreenActive = true;
+  drawSessionStatus();
+
+  createTouchBox(
+    15, LIST_BUTTON_Y, 70, 28, currentTheme.secondary, currentTheme.secondary, "Back",
+    []() {
+      signalOptions();
+    },
+    true);
+  createTouchBox(
+    90, LIST_BUTTON_Y, 60, 28, 0xF800, TFT_WHITE, sessionRecording ? "Stop" : "Rec", []() {
+      if (sessionRecording) stopSessionRecording();
+      else startSessionRecording();
+      startSessionScreen();
+    });
+  createTouchBox(
+    155, LIST_BUTTON_Y, 70, 28, currentTheme.primary, currentTheme.primary, sessionReplaying ? "Stop" : "Play", []() {
+      if (sessionReplaying) stopSessionReplay();
+      else startSessionReplay();
+      startSessionScreen();
+    });
+  drawTitle("Receive > Session", 65);
+}
+
+void loadSessionFiles() {
+  sessionFileCount = 0;
+  File dir = SD.open("/sessions");
+  if (!dir) return;
+  for (File e = dir.openNextFile(); e && sessionFileCount < MAX_SESSION_FILES; e = dir.openNextFile()) {
+    String name = String(e.name());
+    if (!e.isDirectory() && name.endsWith(".irl")) sessionFiles[sessionFileCount++] = name;
+    e.close();
+  }
+  dir.close();
+  sortStringsNaturally(sessionFiles, sessionFileCount);
+}
+
+void drawSessionStatus() {
+  sessionLastDrawMs = millis();
+  tft.fillRect(5, SESSION_STATUS_Y, 230, 60, TFT_BLACK);
+  tft.setTextSize(1);
+  tft.setCursor(5, SESSION_STATUS_Y);
+  if (sessionRecording) {
+    tft.setTextColor(0xF800);
+    tft.printf("REC %s", sessionName.c_str());
+    tft.setTextColor(TFT_WHITE);
+    tft.setCursor(5, SESSION_STATUS_Y + 14);
+    tft.printf("Frames: %lu  Dropped: %lu", (unsigned long)sessionBuffer.framesRecorded, (unsigned long)sessionBuffer.framesDropped);
+    tft.setCursor(5, SESSION_STATUS_Y + 28);
+    tft.printf("Written: %lu B  Buffered: %lu B", (unsigned long)(sessionBuffer.bytesTotal() - sessionBuffer.pending()),
+               (unsigned long)sessionBuffer.pending());
+  } else if (sessionReplaying) {
+    tft.setTextColor(currentTheme.primary);
+    tft.printf("PLAY %s", sessionName.c_str());
+    tft.setTextColor(TFT_WHITE);
+    tft.setCursor(5, SESSION_STATUS_Y + 14);
+    tft.printf("Frames sent: %lu", (unsigned long)replayFrames);
+  } else {
+    tft.setTextColor(currentTheme.accent);
+    tft.print("Idle - Rec logs every received frame");
+  }
+}
+
+void startSessionRecording() {
+  if (!initializedSD || sessionRecording) return;
+  stopSessionReplay();
+  if (!SD.exists("/sessions") && SD.mkdir("/sessions")) listingChanged("/sessions");
+  int n = 1;
+  do {
+    sessionName = "SESS-" + String(n++) + ".irl";
+  } while (SD.exists(("/sessions/" + sessionName).c_str()));
+  sessionFile = SD.open(("/sessions/" + sessionName).c_str(), FILE_WRITE);
+  if (!sessionFile) return;
+  listingChanged("/sessions/" + sessionName);
+  sessionBuffer.reset();
+  sessionSeenFrames = irSegmenter.framesEmitted;
+  sessionLastSyncMs = millis();
+  sessionRecording = true;
+}
+
+void stopSessionRecording() {
+  if (!sessionRecording) return;
+  sessionRecording = false;
+  while (sessionBuffer.pending()) {
+    uint32_t n = sessionBuffer.contiguous();
+    sessionFile.write(sessionBuffer.peek(), n);
+    sessionBuffer.consume(n);
+  }
+  adjustStorageStats(sdBytesOnCard(sessionFile.size()), 0, 1);
+  sessionFile.close();
+  listingChanged("/sessions/" + sessionName);
+}
+
+// Runs right after the segmenter, before any screen pops the queue, so
+// every newly emitted frame is still there. With nobody else reading
+// the queue the recorder pops them itself so it never fills up.
+void recordNewFrames() {
+  uint32_t fresh = irSegmenter.framesEmitted - sessionSeenFrames;
+  sessionSeenFrames = irSegmenter.framesEmitted;
+  if (fresh > irFrames.count) fresh = irFrames.count;
+  unsigned long nowMs = millis();
+  for (uint8_t i = irFrames.count - fresh; i < irFrames.count; i++) {
+    const IrFrame *f = irFrames.at(i);
+    sessionBuffer.addFrame(f->startUs, nowMs, f->durations, f->len, f->overflow);
+  }
+  if (!listeningForSignal && !monitorActive && loopbackState == LOOPBACK_IDLE) irFrames.clear();
+}
+
+// At most one sector per pass keeps the shared SPI bus free for the display
+void serviceSessionRecorder() {
+  if (!sessionRecording) return;
+  if (sessionBuffer.sectorReady()) {
+    sessionFile.write(sessionBuffer.peek(), SESSION_SECTOR_BYTES);
+    sessionBuffer.consume(SESSION_SECTOR_BYTES);
+  }
+  if (millis() - sessionLastSyncMs >= SESSION_SYNC_MS) {
+    sessionLastSyncMs = millis();
+    sessionFile.flush();
+  }
+}
+
+void startSessionReplay() {
+  int idx = activeList.selectedIndex;
+  if (sessionRecording || idx < 0 || idx >= sessionFileCount) return;
+  sessionName = sessionFiles[idx];
+  replayFile = SD.open(("/sessions/" + sessionName).c_str(), FILE_READ);
+  if (!replayFile) return;
+  if (!readSessionHeader(replayFile)) {
+    replayFile.close();
+    return;
+  }
+  memset(&replaySignal, 0, sizeof(IRSignal));
+  replayFrames = 0;
+  replayLastUs = micros();
+  sessionReplaying = loadNextReplayFrame();
+  if (!sessionReplaying) replayFile.close();
+}
+
+void stopSessionReplay() {
+  if (!sessionReplaying) return;
+  sessionReplaying = false;
+  replayFile.close();
+}
+
+bool loadNextReplayFrame() {
+  if (!readSessionRecord(replayFile, replayRecord)) return false;
+  memcpy(replaySignal.rawData, replayRecord.durations, replayRecord.header.len * sizeof(uint16_t));
+  replaySignal.rawDataLen = replayRecord.header.len;
+  return true;
+}
+
+// The next record is read ahead, so a frame goes out as soon as its
+// delta has elapsed since the previous one was sent. One still on the
+// air holds it back to a later pass rather than a wait in
+// sendSignalSection, so loop() keeps running; IrSender has no such
+// check and blocks for the frame.
+void serviceSessionReplay() {
+  if (!sessionReplaying) return;
+  unsigned long now = micros();
+  if (now - replayLastUs < replayRecord.header.deltaUs) return;
+  if (rmtTxReady && rmt_wait_tx_done(IR_RMT_TX_CHANNEL, 0) != ESP_OK) return;
+  replayLastUs += replayRecord.header.deltaUs;
+  sendSignalSection(replaySignal, false);
+  replayFrames++;
+  if (!loadNextReplayFrame()) {
+    stopSessionReplay();
+    if (sessionScreenActive) startSessionScreen();
+  }
+}
+
+// Sends every built-in and saved signal in turn and measures what comes
+// back on the device's own receiver. Point the LED at the receiver (or
+// at a white surface). One signal is in flight at a time; loop() drives
+// the steps through serviceLoopbackTest().
+void startLoopbackTest() {
+  buttonCount = 0;
+  loopbackState = LOOPBACK_IDLE;
+  clearScreen();
+
+  loopbackBuiltInCount = IR_DB_CODE_COUNT;
+  loopbackSavedCount = 0;
+  File dir = initializedSD ? SD.open("/saved-signals") : File();
+  if (dir) {
+    for (File e = dir.openNextFile(); e && loopbackSavedCount < MAX_LOOPBACK_SAVED; e = dir.openNextFile()) {
+      if (!e.isDirectory()) loopbackSavedFiles[loopbackSavedCount++] = String(e.name());
+      e.close();
+    }
+    dir.close();
+  }
+  loopbackCount = min(loopbackBuiltInCount + loopbackSavedCount, MAX_LOOPBACK_SIGNALS);
+  loopbackIndex = 0;
+  loopbackTotals = LoopbackStats();
+
+  activeList.itemCount = 0;
+  activeList.rowHeight = 16;
+  activeList.selectedIndex = -1;
+  activeList.scrollPx = 0;
+  activeList.viewX = LIST_VIEW_X;
+  activeList.viewY = LIST_VIEW_Y;
+  activeList.viewW = LIST_VIEW_W;
+  activeList.viewH = MONITOR_LIST_H;
+  activeList.renderRow = [](int idx, int y, int rowH, bool sel) {
+    const LoopbackResult &r = loopbackResults[idx];
+    listSprite.fillRect(0, y, LIST_VIEW_W, rowH - 2, sel ? currentTheme.primary : TFT_BLACK);
+    listSprite.setTextSize(1);
+    listSprite.setCursor(5, y + 4);
+    listSprite.setTextColor(sel ? TFT_BLACK : TFT_WHITE);
+    listSprite.print(r.name);
+    listSprite.setCursor(150, y + 4);
+    if (!r.echoed) {
+      listSprite.setTextColor(0xF800);
+      listSprite.print("no echo");
+    } else {
+      listSprite.setTextColor(r.stats.measured < r.stats.sentDurations ? currentTheme.accent : currentTheme.primary);
+      listSprite.printf("%u/%u %u", r.stats.meanAbsErrUs(), r.stats.maxAbsErrUs, r.stats.measured);
+    }
+  };
+  activeScrollList = &activeList;
+  renderScrollList(activeList);
+
+  tft.setTextSize(1);
+  tft.setTextColor(currentTheme.accent);
+  tft.setCursor(LOOPBACK_HIST_X, MONITOR_HIST_Y + MONITOR_HIST_H + 4);
+  tft.print("-200");
+  tft.setCursor(LOOPBACK_HIST_X + LOOPBACK_HIST_BINS / 2 * LOOPBACK_BAR_W - 3, MONITOR_HIST_Y + MONITOR_HIST_H + 4);
+  tft.print("0");
+  tft.setCursor(LOOPBACK_HIST_X + LOOPBACK_HIST_BINS * LOOPBACK_BAR_W - 42, MONITOR_HIST_Y + MONITOR_HIST_H + 4);
+  tft.print("+200us");
+  drawLoopbackStatus();
+
+  createTouchBox(
+    15, LIST_BUTTON_Y, 100, 28, currentTheme.secondary, currentTheme.secondary, "Back",
+    []() {
+      signalOptions();
+    },
+    true);
+  createTouchBox(125, LIST_BUTTON_Y, 100, 28, currentTheme.primary, currentTheme.primary, "Run", []() {
+    if (loopbackState != LOOPBACK_IDLE || loopbackCount == 0) return;
+    startLoopbackTest();
+    loopbackState = LOOPBACK_SEND;
+    loopbackDeadlineMs = millis();
+  });
+  drawTitle("Signal > Self-test", 65);
+}
+
+// Built-in codes first (table order), then /saved-signals
+bool loadLoopbackSignal(int idx, IRSignal &signal, char *name, size_t nameSize) {
+  memset(&signal, 0, sizeof(IRSignal));
+  if (idx >= loopbackBuiltInCount) {
+    String file = loopbackSavedFiles[idx - loopbackBuiltInCount];
+    snprintf(name, nameSize, "%s", file.c_str());
+    if (char *dot = strrchr(name, '.')) *dot = '\0';
+    return loadSignalFromSD(("/saved-signals/" + file).c_str(), signal);
+  }
+  if (!irDbSignal(IR_DB_CODES[idx], signal)) return false;
+  snprintf(name, nameSize, "%s", signal.name);
+  return true;
+}
+
+void serviceLoopbackTest() {
+  if (loopbackState == LOOPBACK_IDLE) return;
+  unsigned long now = millis();
+  LoopbackResult &r = loopbackResults[loopbackIndex];
+  bool repeatOnly = signalOnceLen(loopbackSignal) == 0;
+
+  if (loopbackState == LOOPBACK_SEND) {
+    if ((long)(now - loopbackDeadlineMs) < 0) return;
+    r.echoed = false;
+    r.stats = LoopbackStats();
+    if (!loadLoopbackSignal(loopbackIndex, loopbackSignal, r.name, sizeof(r.name))) {
+      finishLoopbackStep();
+      return;
+    }
+    repeatOnly = signalOnceLen(loopbackSignal) == 0;
+    irFrames.clear();
+    sendSignalSection(loopbackSignal, repeatOnly);
+    uint32_t periodUs = repeatOnly ? signalRepeatPeriodUs(loopbackSignal) : signalOncePeriodUs(loopbackSignal);
+    loopbackDeadlineMs = now + periodUs / 1000 + LOOPBACK_ECHO_TIMEOUT_MS;
+    loopbackState = LOOPBACK_WAIT;
+    return;
+  }
+
+  if (IrFrame *frame = irFrames.front()) {
+    uint16_t sent[MAX_RAW_LEN];
+    uint8_t sentStart = repeatOnly ? signalRepeatStart(loopbackSignal) : 0;
+    uint8_t sentLen = repeatOnly ? loopbackSignal.repeatLen : signalOnceLen(loopbackSignal);
+    copySection(loopbackSignal, sentStart, sentLen, sent);
+    // The echo is one frame: compare up to the first inter-frame gap (a
+    // Sony press sends three frames in one section)
+    for (uint8_t i = 1; i < sentLen; i += 2) {
+      if (sent[i] < IR_FRAME_GAP_US) continue;
+      sentLen = i + 1;
+      break;
+    }
+    alignLoopback(sent, sentLen, frame->durations, frame->len, r.stats);
+    r.echoed = true;
+    loopbackTotals.merge(r.stats);
+    irFrames.clear();
+    finishLoopbackStep();
+  } else if ((long)(now - loopbackDeadlineMs) >= 0) {
+    finishLoopbackStep();
+  }
+}
+
+void finishLoopbackStep() {
+  loopbackIndex++;
+  activeList.itemCount = loopbackIndex;
+  activeList.scrollPx = activeList.itemCount * activeList.rowHeight;
+  clampScroll(activeList);
+  renderScrollList(activeList);
+  drawLoopbackStatus();
+  loopbackState = loopbackIndex < loopbackCount ? LOOPBACK_SEND : LOOPBACK_IDLE;
+  loopbackDeadlineMs = millis() + LOOPBACK_SETTLE_MS;
+}
+
+void drawLoopbackStatus() {
+  tft.fillRect(LIST_VIEW_X, MONITOR_STATUS_Y, LIST_VIEW_W, 12, TFT_BLACK);
+  tft.setTextSize(1);
+  tft.setTextColor(TFT_WHITE);
+  tft.setCursor(LIST_VIEW_X, MONITOR_STATUS_Y + 2);
+  tft.printf("%d/%d  avg %uus max %uus  mark %+dus", loopbackIndex, loopbackCount, loopbackTotals.meanAbsErrUs(),
+             loopbackTotals.maxAbsErrUs, loopbackTotals.markBiasUs());
+
+  uint16_t scale = 1;
+  for (uint16_t c : loopbackTotals.histogram)
+    if (c > scale) scale = c;
+  for (int b = 0; b < LOOPBACK_HIST_BINS; b++) {
+    int x = LOOPBACK_HIST_X + b * LOOPBACK_BAR_W;
+    int h = (int)((uint32_t)loopbackTotals.histogram[b] * MONITOR_HIST_H / scale);
+    bool outer = b == 0 || b == LOOPBACK_HIST_BINS - 1;
+    tft.fillRect(x, MONITOR_HIST_Y, LOOPBACK_BAR_W - 2, MONITOR_HIST_H - h, currentTheme.darkest);
+    if (h) tft.fillRect(x, MONITOR_HIST_Y + MONITOR_HIST_H - h, LOOPBACK_BAR_W - 2, h, outer ? currentTheme.accent : currentTheme.primary);
+  }
+}
+
+// Pans by dragging the trace (waveView is a horizontal ScrollList, one
+// "row" per pixel of content) and zooms with -/+. Every redraw asks the
+// pyramid for one min/max span per column.
+void showWaveform(const IRSignal &signal, const char *title, void (*backCb)()) {
+  buttonCount = 0;
+  if (&signal != &waveSignal) waveSignal = signal;
+  wavePyramid.build(waveSignal);
+  clearScreen();
+
+  uint32_t carrierHz = signalCarrierHz(waveSignal);
+  tft.setTextSize(1);
+  tft.setTextColor(currentTheme.accent);
+  tft.setCursor(5, 13);
+  tft.printf("Len: %d  Pulses: %d  Carrier: %lu.%luk", waveSignal.rawDataLen, (waveSignal.rawDataLen + 1) / 2,
+             (unsigned long)(carrierHz / 1000), (unsigned long)(carrierHz % 1000 / 100));
+  tft.drawFastHLine(0, WAVE_VIEW_Y - 4, 240, currentTheme.darkest);
+
+  waveUsPerPx = (float)wavePyramid.totalUs / LIST_VIEW_W;
+  waveView.itemCount = LIST_VIEW_W;
+  waveView.rowHeight = 1;
+  waveView.scrollPx = 0;
+  waveView.selectedIndex = -1;
+  waveView.viewX = LIST_VIEW_X;
+  waveView.viewY = WAVE_VIEW_Y;
+  waveView.viewW = LIST_VIEW_W;
+  waveView.viewH = WAVE_VIEW_H;
+  waveView.horizontal = true;
+  waveView.renderView = renderWaveform;
+  activeScrollList = &waveView;
+  renderWaveform();
+  drawWaveformZoom();
+
+  createTouchBox(
+    15, 190, 100, 40, currentTheme.primary, currentTheme.primary, "-", []() {
+      zoomWaveform(1 / WAVE_ZOOM_STEP);
+    },
+    false, true);
+  createTouchBox(
+    125, 190, 100, 40, currentTheme.primary, currentTheme.primary, "+", []() {
+      zoomWaveform(WAVE_ZOOM_STEP);
+    },
+    false, true);
+  if (signalCaptured) {
+    createTouchBox(15, LIST_BUTTON_Y, 100, 28, currentTheme.secondary, currentTheme.secondary, "Back", backCb, true);
+    createTouchBox(125, LIST_BUTTON_Y, 100, 28, currentTheme.primary, currentTheme.primary, "Save", drawKeyboard);
+  } else {
+    createTouchBox(60, LIST_BUTTON_Y, 120, 28, currentTheme.secondary, currentTheme.secondary, "Back", backCb, true);
+  }
+  drawTitle(title, 70);
+}
+
+void showCapturedWaveform() {
+  buildCapturedSignal(waveSignal);
+  showWaveform(waveSignal, "Receive > Captured", []() {
+    signalCaptured = false;
+    startSignalListen();
+  });
+}
+
+void renderWaveform() {
+  ensureListSprite(LIST_VIEW_W, LIST_VIEW_H);
+  listSprite.fillSprite(TFT_BLACK);
+  listSprite.drawFastHLine(0, WAVE_LOW_Y, LIST_VIEW_W, currentTheme.darkest);
+
+  float t0 = waveView.scrollPx * waveUsPerPx;
+  int prevY = -1;
+  for (int x = 0; x < LIST_VIEW_W; x++) {
+    uint32_t a = (uint32_t)(t0 + x * waveUsPerPx), b = (uint32_t)(t0 + (x + 1) * waveUsPerPx);
+    if (b <= a) b = a + 1;
+    bool lo, hi;
+    wavePyramid.span(a, b, lo, hi);
+    int yTop = hi ? WAVE_HIGH_Y : WAVE_LOW_Y, yBottom = lo ? WAVE_HIGH_Y : WAVE_LOW_Y;
+    if (prevY >= 0) {  // join an edge that falls between two columns
+      yTop = min(yTop, prevY);
+      yBottom = max(yBottom, prevY);
+    }
+    listSprite.drawFastVLine(x, yTop, yBottom - yTop + 1, currentTheme.primary);
+    prevY = lo == hi ? (hi ? WAVE_HIGH_Y : WAVE_LOW_Y) : -1;
+  }
+
+  char label[16];
+  listSprite.setTextSize(1);
+  listSprite.setTextColor(TFT_WHITE);
+  snprintf(label, sizeof(label), "%.2fms", t0 / 1000);
+  listSprite.setCursor(0, WAVE_LABEL_Y);
+  listSprite.print(label);
+  snprintf(label, sizeof(label), "%.2fms", (t0 + LIST_VIEW_W * waveUsPerPx) / 1000);
+  listSprite.setCursor(LIST_VIEW_W - listSprite.textWidth(label), WAVE_LABEL_Y);
+  listSprite.print(label);
+
+  // Overview: whole signal with the visible window highlighted
+  int winX = (int)(t0 * LIST_VIEW_W / wavePyramid.totalUs);
+  int winW = max(4, (int)(LIST_VIEW_W * LIST_VIEW_W * waveUsPerPx / wavePyramid.totalUs));
+  listSprite.fillRect(0, WAVE_OVERVIEW_Y, LIST_VIEW_W, 6, currentTheme.darkest);
+  listSprite.fillRect(winX, WAVE_OVERVIEW_Y, winW, 6, currentTheme.secondary);
+
+  trace.begin(TRACE_SPRITE_PUSH, micros());
+  tft.setClipRect(waveView.viewX, waveView.viewY, waveView.viewW, waveView.viewH);
+  listSprite.pushSprite(waveView.viewX, waveView.viewY);
+  tft.clearClipRect();
+  trace.end(TRACE_SPRITE_PUSH, micros());
+}
+
+void drawWaveformZoom() {
+  float fitUsPerPx = (float)wavePyramid.totalUs / LIST_VIEW_W;
+  tft.fillRect(5, 25, 230, 10, TFT_BLACK);
+  tft.setTextSize(1);
+  tft.setTextColor(currentTheme.accent);
+  tft.setCursor(5, 26);
+  tft.printf("Time: %.2fms  Zoom: x%d  %.0fus/px", wavePyramid.totalUs / 1000.0f, (int)(fitUsPerPx / waveUsPerPx + 0.5f), waveUsPerPx);
+}
+
+// Keeps the time at the centre of the view fixed. Zooming stops at
+// WAVE_MIN_US_PER_PX, the durations' own resolution.
+void zoomWaveform(float factor) {
+  float fitUsPerPx = (float)wavePyramid.totalUs / LIST_VIEW_W;
+  float minUsPerPx = min(fitUsPerPx, WAVE_MIN_US_PER_PX);
+  float centerUs = (waveView.scrollPx + LIST_VIEW_W / 2.0f) * waveUsPerPx;
+  waveUsPerPx = constrain(waveUsPerPx / factor, minUsPerPx, fitUsPerPx);
+  waveView.itemCount = (int)ceilf(wavePyramid.totalUs / waveUsPerPx);
+  waveView.scrollPx = centerUs / waveUsPerPx - LIST_VIEW_W / 2.0f;
+  clampScroll(waveView);
+  renderWaveform();
+  drawWaveformZoom();
+}
+
+// ============================================================
+// Screens — Built-in signals
+// ============================================================
+// Brands from the compiled table come first, then the brands of the
+// pack on SD. The pack stays open while the browser is in use and
+// every row reads only its own index entry.
+void openSignalPack() {
+  if (signalPack.isOpen() || !initializedSD) return;
+  signalPackFile = SD.open("/built-in-signals/signals.irp", FILE_READ);
+  if (!signalPackFile) return;
+  if (!signalPack.open(signalPackFile, signalPackFile.size())) {
+    Serial.println("Ignoring /built-in-signals/signals.irp: bad header");
+    signalPackFile.close();
+    return;
+  }
+  signalWordsFile = SD.open("/built-in-signals/signals.irx", FILE_READ);
+  if (signalWordsFile && !signalWords.open(signalWordsFile, signalWordsFile.size(), signalPackFile.size())) {
+    Serial.println("Ignoring /built-in-signals/signals.irx: not built for this pack");
+    signalWordsFile.close();
+  }
+}
+
+void closeSignalPack() {
+  signalPack.close();
+  signalWords.close();
+  if (signalPackFile) signalPackFile.close();
+  if (signalWordsFile) signalWordsFile.close();
+}
+
+void builtInSignalsBrowser() {
+  resetScreens();
+  closeSignalPack();
+  openSignalPack();
+  activeList.selectedIndex = 0;
+  activeList.scrollPx = 0;
+  drawBuiltInBrands();
+}
+
+void drawBuiltInBrands() {
+  buttonCount = 0;
+  builtInBrandCount = DB_BRAND_COUNT + signalPack.brandCount();
+  clearScreen();
+
+  if (builtInBrandCount == 0) {
+    printCentered("No brands", 120, currentTheme.primary, 2);
+    printCentered("found!", 140, currentTheme.primary, 2);
+    drawBackBtn(60, 200, 120, 40, drawMenuUI);
+    drawTitle("Built-in signals", 70);
+    return;
+  }
+  setupAndRenderScrollList(builtInBrandCount, 32, [](int idx, int y, int rowH, bool sel) {
+    listSprite.fillRect(0, y, LIST_VIEW_W, rowH - 2, sel ? currentTheme.primary : TFT_BLACK);
+    listSprite.setTextColor(sel ? TFT_BLACK : TFT_WHITE);
+    listSprite.setTextSize(2);
+    listSprite.setCursor(5, y + 6);
+    if (idx < DB_BRAND_COUNT) {
+      listSprite.println(IR_DB_BRANDS[idx]);
+      return;
+    }
+    PackBrandEntry brand;
+    if (!signalPack.brand(idx - DB_BRAND_COUNT, brand)) return;
+    listSprite.println(brand.name);
+    listSprite.setTextSize(1);
+    listSprite.setCursor(LIST_VIEW_W - 22, y + 11);
+    listSprite.print("SD");
+  });
+  activeList.onOpen = []() {
+    int idx = activeList.selectedIndex;
+    if (idx < 0 || idx >= builtInBrandCount) return;
+    currentBrandFromPack = idx >= DB_BRAND_COUNT;
+    if (currentBrandFromPack) {
+      if (!signalPack.brand(idx - DB_BRAND_COUNT, currentPackBrand)) return;
+      currentBrandCodes = nullptr;
+      currentBrandCodesLength = currentPackBrand.codeCount;
+      currentBrandPath = currentPackBrand.name;
+    } else {
+      uint16_t first;
+      currentBrandCodesLength = irDbBrandRange(idx, first);
+      currentBrandCodes = &IR_DB_CODES[first];
+      currentBrandPath = IR_DB_BRANDS[idx];
+    }
+    pushScreen(BRANDS_SCREEN);
+    listBuiltInSignals();
+  };
+  createTouchBox(
+    60, LIST_BUTTON_Y, 120, 28, currentTheme.secondary, currentTheme.secondary, "Back",
+    []() {
+      closeSignalPack();
+      drawMenuUI();
+    },
+    true);
+  drawTitle("Built-in signals", 70);
+}
+
+bool loadBuiltInSignal(int idx, IRSignal &signal, bool toggle) {
+  if (currentBrandFromPack) return signalPack.loadSignal(currentPackBrand, currentPackBrand.firstCode + idx, signal, toggle);
+  return irDbSignal(currentBrandCodes[idx], signal, toggle);
+}
+
+void listBuiltInSignals() {
+  activeList.selectedIndex = 0;
+  activeList.scrollPx = 0;
+  drawBuiltInSignalsList();
+}
+
+void drawBuiltInSignalsList() {
+  buttonCount = 0;
+  clearScreen();
+
+  if ((!currentBrandCodes && !currentBrandFromPack) || currentBrandCodesLength == 0) {
+    printCentered("Brand not", 120, currentTheme.primary, 2);
+    printCentered("found!", 140, currentTheme.primary, 2);
+    drawBackBtn(60, 200, 120, 40, popScreen);
+    drawTitle("Brand signals", 75);
+    return;
+  }
+  builtInSignalCount = currentBrandCodesLength;
+  setupAndRenderScrollList(builtInSignalCount, 32, [](int idx, int y, int rowH, bool sel) {
+    listSprite.fillRect(0, y, LIST_VIEW_W, rowH - 2, sel ? currentTheme.primary : TFT_BLACK);
+    listSprite.setTextColor(sel ? TFT_BLACK : TFT_WHITE);
+    listSprite.setTextSize(2);
+    listSprite.setCursor(5, y + 6);
+    const char *name = "?";
+    const char *protocol = "?";
+    PackCodeEntry code;
+    if (!currentBrandFromPack) {
+      name = IR_DB_FUNCTIONS[currentBrandCodes[idx].function];
+      protocol = irProtocolName(currentBrandCodes[idx].protocol);
+    } else if (signalPack.code(currentPackBrand.firstCode + idx, code)) {
+      name = code.name;
+      protocol = code.kind == PACK_KIND_PROTOCOL ? irProtocolName(code.protocol) : "raw";
+    }
+    listSprite.println(name);
+    listSprite.setTextSize(1);
+    listSprite.setCursor(LIST_VIEW_W - 70, y + 11);
+    listSprite.print(protocol);
+  });
+  createTouchBox(15, LIST_BUTTON_Y, 70, 28, currentTheme.secondary, currentTheme.secondary, "Back", popScreen, true);
+  createTouchBox(
+    90, LIST_BUTTON_Y, 60, 28, currentTheme.primary, currentTheme.primary, "View", []() {
+      if (activeList.selectedIndex < 0 || activeList.selectedIndex >= builtInSignalCount) return;
+      if (loadBuiltInSignal(activeList.selectedIndex, waveSignal)) {
+        pushScreen(BRAND_SIGNALS_SCREEN);
+        showWaveform(waveSignal, waveSignal.name, popScreen);
+      }
+    });
+  createTouchBox(155, LIST_BUTTON_Y, 70, 28, currentTheme.primary, currentTheme.primary, "Send", []() {
+    if (activeList.selectedIndex < 0 || activeList.selectedIndex >= builtInSignalCount) return;
+    IRSignal signal;
+    if (loadBuiltInSignal(activeList.selectedIndex, signal, nextPressToggle())) transmitSignal(signal);
+  });
+  char title[40];
+  snprintf(title, sizeof(title), "%s signals", currentBrandPath.c_str());
+  drawTitle(title, 70);
+}
+
+// ============================================================
+// Screens — Search
+// ============================================================
+// Saved and compiled names sit in searchIndex (IR-search.h), built on
+// first use and kept current by every save and delete; pack codes are
+// looked up in the pack's own word index. Each keystroke re-runs the
+// query for the few preview rows only; ">" fetches the full list.
+void buildSearchIndex() {
+  searchIndex.clear();
+  searchIndex.beginBulk();
+  for (uint16_t i = 0; i < IR_DB_CODE_COUNT; i++) {
+    const IRCodeEntry &e = IR_DB_CODES[i];
+    String name = String(IR_DB_BRANDS[e.brand]) + " " + IR_DB_FUNCTIONS[e.function];
+    searchIndex.add(name.c_str(), (uint32_t)SEARCH_COMPILED << 24 | i);
+  }
+  File dir = SD.open("/saved-signals");
+  String name;
+  bool isDir;
+  while (dir && nextDirEntry(dir, name, isDir))
+    if (!isDir && name.endsWith(".bin")) searchIndex.add(name.substring(0, name.length() - 4).c_str(), (uint32_t)SEARCH_SAVED << 24);
+  if (dir) dir.close();
+  searchIndex.finishBulk();
+  searchIndexReady = true;
+}
+
+void searchIndexAddSaved(const String &file) {
+  if (searchIndexReady && file.endsWith(".bin"))
+    searchIndex.add(file.substring(0, file.length() - 4).c_str(), (uint32_t)SEARCH_SAVED << 24);
+}
+
+void searchIndexRemoveSaved(const String &file) {
+  if (searchIndexReady && file.endsWith(".bin")) searchIndex.remove(file.substring(0, file.length() - 4).c_str());
+}
+
+void startSignalSearch() {
+  searchQuery[0] = '\0';
+  closeSignalPack();
+  openSignalPack();
+  if (!searchIndexReady) buildSearchIndex();
+  drawSearchKeyboard();
+}
+
+void drawSearchKeyboard() {
+  buttonCount = 0;
+  clearScreen();
+  keyboardSearchMode = true;
+  tft.setTextSize(1);
+  tft.setTextColor(currentTheme.accent);
+  tft.setCursor(5, 13);
+  tft.print("Search:");
+  tft.drawRect(5, 22, 230, 18, currentTheme.primary);
+
+  int bottom = drawKeyboardKeys(116, 32, 30);
+  createTouchBox(
+    80, bottom + 8, 80, 26, currentTheme.secondary, currentTheme.secondary, "Back",
+    []() {
+      keyboardSearchMode = false;
+      closeSignalPack();
+      signalOptions();
+    },
+    true);
+  drawTitle("Search signals", 70);
+  runSearch(SEARCH_PREVIEW_ROWS);
+  drawSearchPreview();
+}
+
+void searchKeyPressed(const char *label) {
+  int len = strlen(searchQuery);
+  if (strcmp(label, "<") == 0) {
+    if (len > 0) searchQuery[len - 1] = '\0';
+  } else if (strcmp(label, ">") == 0) {
+    runSearch(MAX_SEARCH_RESULTS);
+    resetScreens();
+    activeList.selectedIndex = 0;
+    activeList.scrollPx = 0;
+    drawSearchResults();
+    return;
+  } else if (len < SEARCH_QUERY_CHARS) {
+    searchQuery[len] = (label[0] == '_') ? ' ' : label[0];
+    searchQuery[len + 1] = '\0';
+  }
+  runSearch(SEARCH_PREVIEW_ROWS);
+  drawSearchPreview();
+}
+
+void runSearch(int limit) {
+  searchResultCount = 0;
+  searchMatchCount = 0;
+  if (!searchQuery[0]) return;
+  searchMatchCount = searchIndex.query(searchQuery, [limit](uint16_t slot) {
+    if (searchResultCount >= limit) return false;
+    uint32_t tag = searchIndex.tag(slot);
+    uint8_t source = tag >> 24;
+    searchResults[searchResultCount++] = { source, source == SEARCH_SAVED ? slot : tag & 0xFFFFFF };
+    return true;
+  });
+  if (!signalWords.isOpen()) return;
+
+  // Word hits: a code matching on two of its words counts twice here
+  uint32_t first = signalWords.bound(searchQuery, false), end = signalWords.bound(searchQuery, true, first);
+  searchMatchCount += end - first;
+  bool verify = strlen(searchQuery) > PACK_WORD_CHARS;
+  PackWordEntry w;
+  for (uint32_t i = first; i < end && searchResultCount < limit; i++) {
+    if (!signalWords.entry(i, w)) break;
+    bool dup = false;
+    for (int r = 0; r < searchResultCount && !dup; r++)
+      dup = searchResults[r].source == SEARCH_PACK && searchResults[r].ref == w.code;
+    SearchResult hit = { SEARCH_PACK, w.code };
+    char name[SEARCH_RESULT_NAME_CHARS];
+    if (dup || (verify && !searchNameMatches(searchResultName(hit, name, sizeof(name)), searchQuery))) continue;
+    searchResults[searchResultCount++] = hit;
+  }
+}
+
+// Saved names come straight from the index; the others are built in buf
+const char *searchResultName(const SearchResult &r, char *buf, size_t n) {
+  if (r.source == SEARCH_SAVED) return searchIndex.name(r.ref);
+  if (r.source == SEARCH_COMPILED) {
+    snprintf(buf, n, "%s %s", IR_DB_BRANDS[IR_DB_CODES[r.ref].brand], IR_DB_FUNCTIONS[IR_DB_CODES[r.ref].function]);
+    return buf;
+  }
+  PackBrandEntry b;
+  PackCodeEntry c;
+  int32_t bi = signalPack.brandOfCode(r.ref);
+  if (bi < 0 || !signalPack.brand(bi, b) || !signalPack.code(r.ref, c)) return "?";
+  snprintf(buf, n, "%s %s", b.name, c.name);
+  return buf;
+}
+
+bool loadSearchResult(const SearchResult &r, IRSignal &signal, bool toggle) {
+  if (r.source == SEARCH_SAVED)
+    return loadSignalFromSD(("/saved-signals/" + String(searchIndex.name(r.ref)) + ".bin").c_str(), signal);
+  if (r.source == SEARCH_COMPILED) return irDbSignal(IR_DB_CODES[r.ref], signal, toggle);
+  PackBrandEntry b;
+  int32_t bi = signalPack.brandOfCode(r.ref);
+  return bi >= 0 && signalPack.brand(bi, b) && signalPack.loadSignal(b, r.ref, signal, toggle);
+}
+
+void drawSearchPreview() {
+  tft.fillRect(6, 23, 228, 16, TFT_BLACK);
+  tft.setTextSize(1);
+  tft.setTextColor(currentTheme.primary);
+  tft.setCursor(8, 26);
+  tft.print(searchQuery);
+
+  tft.fillRect(0, SEARCH_PREVIEW_Y - 12, 240, 12 + SEARCH_PREVIEW_ROWS * 14, TFT_BLACK);
+  tft.setTextColor(currentTheme.accent);
+  tft.setCursor(5, SEARCH_PREVIEW_Y - 12);
+  if (searchQuery[0]) tft.printf("%lu matches", (unsigned long)searchMatchCount);
+  else tft.print("Type part of a name");
+  char name[SEARCH_RESULT_NAME_CHARS];
+  for (int i = 0; i < searchResultCount && i < SEARCH_PREVIEW_ROWS; i++) {
+    tft.setTextColor(TFT_WHITE);
+    tft.setCursor(5, SEARCH_PREVIEW_Y + i * 14);
+    tft.print(searchResultName(searchResults[i], name, sizeof(name)));
+  }
+}
+
+void drawSearchResults() {
+  buttonCount = 0;
+  clearScreen();
+  if (searchResultCount == 0) {
+    printCentered("No matches", 140, currentTheme.primary, 2);
+    drawBackBtn(60, 200, 120, 40, drawSearchKeyboard);
+    drawTitle("Search results", 70);
+    return;
+  }
+  setupAndRenderScrollList(searchResultCount, 26, [](int idx, int y, int rowH, bool sel) {
+    listSprite.fillRect(0, y, LIST_VIEW_W, rowH - 2, sel ? currentTheme.primary : TFT_BLACK);
+    listSprite.setTextColor(sel ? TFT_BLACK : TFT_WHITE);
+    listSprite.setTextSize(1);
+    listSprite.setCursor(5, y + 8);
+    char name[SEARCH_RESULT_NAME_CHARS];
+    listSprite.print(searchResultName(searchResults[idx], name, sizeof(name)));
+    listSprite.setCursor(LIST_VIEW_W - 30, y + 8);
+    listSprite.print(searchResults[idx].source == SEARCH_SAVED ? "SD" : "");
+  });
+  activeList.onOpen = []() {
+    if (activeList.selectedIndex < 0 || activeList.selectedIndex >= searchResultCount) return;
+    if (loadSearchResult(searchResults[activeList.selectedIndex], waveSignal)) {
+      pushScreen(SEARCH_RESULTS_SCREEN);
+      showWaveform(waveSignal, waveSignal.name, popScreen);
+    }
+  };
+  createTouchBox(15, LIST_BUTTON_Y, 70, 28, currentTheme.secondary, currentTheme.secondary, "Back", drawSearchKeyboard, true);
+  createTouchBox(
+    90, LIST_BUTTON_Y, 60, 28, currentTheme.primary, currentTheme.primary, "View", []() {
+      if (activeList.onOpen) activeList.onOpen();
+    });
+  createTouchBox(155, LIST_BUTTON_Y, 70, 28, currentTheme.primary, currentTheme.primary, "Send", []() {
+    if (activeList.selectedIndex < 0 || activeList.selectedIndex >= searchResultCount) return;
+    IRSignal signal;
+    if (loadSearchResult(searchResults[activeList.selectedIndex], signal, nextPressToggle())) transmitSignal(signal);
+  });
+  drawTitle("Search results", 70);
+}
+
+// ============================================================
+// Screens — SD Card
+// ============================================================
+void sdData() {
+  createOptions(SD_CARD_OPTIONS, 4, 10, 47, 220, 45);
+  drawTitle("SD Card options", 75);
+}
+
+void listSDInfo() {
+  buttonCount = 0;
+  clearScreen();
+  drawTitle("SD Card > Info", 75);
+  storageInfoActive = true;
+  const StorageStats &st = storageStats;
+  if (!st.valid) statsReconcileDue = true;
+  int y = 110;
+
+  tft.setTextSize(3);
+  tft.setTextColor(currentTheme.primary);
+  tft.setCursor(5, 72);
+  tft.println("Storage");
+  tft.drawFastHLine(0, y - 12, 240, currentTheme.primary);
+  tft.drawFastHLine(0, y - 10, 240, currentTheme.primary);
+
+  tft.setTextSize(2);
+  auto row = [&](const char *label, String val) {
+    tft.setCursor(10, y);
+    tft.print(label);
+    tft.println(val);
+    y += 20;
+  };
+  row("Full: ", st.valid ? formatBytes(st.totalBytes) : String("..."));
+  row("Free: ", st.valid ? formatBytes(st.totalBytes - st.usedBytes) : String("..."));
+  row("Used: ", st.valid ? formatBytes(st.usedBytes) : String("..."));
+  y += 20;
+
+  tft.setTextSize(3);
+  tft.setCursor(5, y);
+  tft.println("Signals");
+  tft.drawFastHLine(0, y + 26, 240, currentTheme.primary);
+  tft.drawFastHLine(0, y + 28, 240, currentTheme.primary);
+  y += 40;
+  tft.setTextSize(2);
+  row("Saved: ", st.valid ? String(st.savedCount) : String("..."));
+  row("Sessions: ", st.valid ? String(st.sessionCount) : String("..."));
+  if (!st.valid || statsState != STATS_IDLE) printCentered("Measuring...", 290, currentTheme.accent, 1);
+
+  drawBackBtn(185, 130, 55, 50, sdData);
+}
+
+void listSDFiles() {
+  buttonCount = 0;
+  resetScreens();
+  currentPath = "/";
+  activeList.selectedIndex = 0;
+  activeList.scrollPx = 0;
+  loadSDFiles(currentPath);
+  drawSDFileBrowser();
+}
+
+void reloadSDFiles() {
+  loadSDFiles(currentPath);
+}
+
+void loadSDFiles(String path) {
+  unsigned long startUs = beginSdOp();
+  sdFileCount = 0;
+  sdMarkedCount = 0;
+  if (!loadCachedListing(path)) {
+    File dir = SD.open(path);
+    if (!dir) {
+      Serial.println("Failed to open dir");
+      endSdOp(startUs);
+      return;
+    }
+    sortListing(dir, path);
+    dir.close();
+  }
+  for (int i = 0; i < sdFileCount; i++) {
+    sdFileMarked[i] = false;
+    if (sdFileIsDir[i]) sdFiles[i] = "DIR - " + sdFiles[i];
+    else sdFiles[i] += " - " + formatBytes(sdFileSize[i]);
+  }
+  endSdOp(startUs);
+}
+
+void drawSDFileBrowser() {
   buttonCount = 0;
   clearScreen();
   tft.setTextSize(1);
@@ -832,16 +2659,18 @@ void drawSDFileBrowser() {
     listSprite.fillRect(0, y, LIST_VIEW_W, rowH - 2, sel ? currentTheme.primary : TFT_BLACK);
     listSprite.setTextColor(sel ? TFT_BLACK : TFT_WHITE);
     listSprite.setTextSize(1);
-    listSprite.setCursor(5, y + 6);
-    String name = sdFiles[idx];
-    if (name.length() > 35) name = name.substring(0, 32) + "...";
-    listSprite.println(name);
+    if (sdFileMarked[idx]) listSprite.fillRect(4, y + 7, 6, 6, sel ? TFT_BLACK : currentTheme.accent);
+    listSprite.setCursor(14, y + 6);
+    const String &name = sdFiles[idx];
+    if (name.length() > 33) listSprite.printf("%.30s...", name.c_str());
+    else listSprite.print(name);
   });
   activeList.onOpen = []() {
     if (activeList.selectedIndex < 0 || activeList.selectedIndex >= sdFileCount) return;
     String sel = sdFiles[activeList.selectedIndex];
     if (!sel.startsWith("DIR - ")) return;
     String dir = sel.substring(6);
+    pushScreen(SD_FILES_SCREEN);
     currentPath = (currentPath == "/") ? ("/" + dir) : (currentPath + "/" + dir);
     loadSDFiles(currentPath);
     activeList.selectedIndex = 0;
@@ -849,23 +2678,29 @@ void drawSDFileBrowser() {
     drawSDFileBrowser();
   };
 
-  bool isDir = (activeList.selectedIndex >= 0 && activeList.selectedIndex < sdFileCount) && sdFiles[activeList.selectedIndex].startsWith("DIR - ");
   const char *backLabel = (currentPath == "/") ? "Back" : "Up";
   void (*backCb)() = (currentPath == "/") ? sdData : (void (*)())[]() {
     int slash = currentPath.lastIndexOf('/');
     currentPath = (slash > 0) ? currentPath.substring(0, slash) : "/";
+    if (restoreScreen()) return;
     loadSDFiles(currentPath);
     activeList.selectedIndex = 0;
     activeList.scrollPx = 0;
     drawSDFileBrowser();
   };
 
-  if (isDir) {
-    createTouchBox(60, LIST_BUTTON_Y, 120, 28, currentTheme.secondary, currentTheme.secondary, backLabel, backCb, true);
-  } else {
-    createTouchBox(15, LIST_BUTTON_Y, 135, 28, currentTheme.secondary, currentTheme.secondary, backLabel, backCb, true);
-    createTouchBox(160, LIST_BUTTON_Y, 65, 28, 0xF800, TFT_WHITE, "Del", deleteSelectedFile);
-  }
+  createTouchBox(15, LIST_BUTTON_Y, 70, 28, currentTheme.secondary, currentTheme.secondary, backLabel, backCb, true);
+  createTouchBox(
+    90, LIST_BUTTON_Y, 60, 28, currentTheme.primary, currentTheme.primary, "Mark", []() {
+      int sel = activeList.selectedIndex;
+      if (sel < 0 || sel >= sdFileCount) return;
+      String path = sdFilePath(sel);
+      if (sdPreservedEntry(currentPath, path.substring(path.lastIndexOf('/') + 1))) return;
+      sdFileMarked[sel] = !sdFileMarked[sel];
+      sdMarkedCount += sdFileMarked[sel] ? 1 : -1;
+      renderScrollList(activeList);
+    });
+  createTouchBox(155, LIST_BUTTON_Y, 70, 28, 0xF800, TFT_WHITE, "Del", deleteSelectedFile);
   drawTitle("SD Card > Files", 75);
 }
 
@@ -876,42 +2711,55 @@ void sdFormatOptions() {
   drawTitle("SD Card > Format", 75);
 }
 
+// Queues every root entry except the preserved ones; a root with more
+// entries than the job holds ends with "/" itself, which sweeps the rest
 void formatSD() {
   File root = SD.open("/");
   if (!root) return;
-  clearScreen();
-  tft.setTextColor(currentTheme.primary);
-  tft.setTextSize(2);
-  tft.setCursor(30, 100);
-  tft.println("Formatting...");
-
+  sdJobPathCount = 0;
   for (File e = root.openNextFile(); e; e = root.openNextFile()) {
     String name = String(e.name());
-    bool isDir = e.isDirectory();
+    if (name.startsWith("/")) name = name.substring(1);
     e.close();
-    if (name == "System Volume Information" || name == "built-in-signals") {
-      formatStatusLine("Skipping:", currentTheme.primary, name);
-      delay(1000);
-      continue;
+    if (sdPreservedEntry("/", name)) continue;
+    if (sdJobPathCount == MAX_SD_JOB_PATHS - 1) {
+      sdJobPaths[sdJobPathCount++] = "/";
+      break;
     }
-    formatStatusLine("Deleting:", currentTheme.primary, name);
-    bool ok = isDir ? deleteDirectory(("/" + name).c_str()) : SD.remove(("/" + name).c_str());
-    formatStatusLine(ok ? "Deleted:" : "Failed:", ok ? (uint16_t)0x07E0 : (uint16_t)0xF800, name);
-    delay(1000);
+    sdJobPaths[sdJobPathCount++] = "/" + name;
   }
   root.close();
+  startSdDeleteJob("SD Card > Format", formatDone);
+}
+
+void formatDone() {
+  if (!SD.exists("/saved-signals") && SD.mkdir("/saved-signals")) listingChanged("/saved-signals");
+  statsReconcileDue = true;
+  bool ok = !sdJobCancelled;
+  for (int i = 0; i < sdJobPathCount; i++) ok = ok && sdJobPathOk[i];
+  buttonCount = 0;
   clearScreen();
-  printCentered("Formatting done!", 140, 0x07E0, 2);
+  printCentered(ok ? "Formatting done!" : sdJobCancelled ? "Cancelled" : "Some files failed", 120, ok ? (uint16_t)0x07E0 : (uint16_t)0xF800, 2);
   tft.setTextSize(1);
   tft.setTextColor(TFT_WHITE);
-  tft.setCursor(30, 170);
+  tft.setCursor(30, 150);
+  tft.print("Removed: ");
+  tft.print(sdJobRemoved);
+  tft.println(" entries");
+  tft.setCursor(30, 165);
   tft.println("Preserved: built-in-signals");
-  delay(2000);
-  if (!SD.exists("/saved-signals")) SD.mkdir("/saved-signals");
-  drawMenuUI();
+  drawBackBtn(60, 200, 120, 40, drawMenuUI);
+  drawTitle("SD Card > Format", 75);
 }
 
 void listGroupedSignals() {
+  scanGroupedSignals();
+  activeList.selectedIndex = 0;
+  activeList.scrollPx = 0;
+  drawGroupedSignalsList();
+}
+
+void scanGroupedSignals() {
   groupedSignalCount = 0;
   File dir = SD.open("/saved-signals");
   if (dir) {
@@ -925,9 +2773,12 @@ void listGroupedSignals() {
     }
     dir.close();
   }
-  activeList.selectedIndex = 0;
-  activeList.scrollPx = 0;
-  drawGroupedSignalsList();
+  sortStringsNaturally(groupedSignalFiles, groupedSignalCount);
+}
+
+void evictGroupedSignals() {
+  for (int i = 0; i < groupedSignalCount; i++) groupedSignalFiles[i] = String();
+  groupedSignalCount = 0;
 }
 
 void drawGroupedSignalsList() {
@@ -936,7 +2787,7 @@ void drawGroupedSignalsList() {
   if (groupedSignalCount == 0) {
     printCentered("No signals", 120, currentTheme.primary, 2);
     printCentered("in group!", 140, currentTheme.primary, 2);
-    drawBackBtn(60, 200, 120, 40, listSavedSignals);
+    drawBackBtn(60, 200, 120, 40, popScreen);
     drawTitle("Group signals", 75);
     return;
   }
@@ -945,50 +2796,115 @@ void drawGroupedSignalsList() {
     listSprite.setTextColor(sel ? TFT_BLACK : TFT_WHITE);
     listSprite.setTextSize(2);
     listSprite.setCursor(5, y + 6);
-    String name = groupedSignalFiles[idx];
-    name.replace(".bin", "");
-    int h = name.indexOf('-');
-    if (h >= 0) name = name.substring(h + 1);
-    listSprite.println(name);
+    // The file name without its group prefix and ".bin"
+    const char *name = groupedSignalFiles[idx].c_str();
+    const char *dash = strchr(name, '-');
+    if (dash) name = dash + 1;
+    const char *ext = strstr(name, ".bin");
+    listSprite.printf("%.*s", ext ? (int)(ext - name) : (int)strlen(name), name);
   });
+  createTouchBox(15, LIST_BUTTON_Y, 70, 28, currentTheme.secondary, currentTheme.secondary, "Back", popScreen, true);
   createTouchBox(
-    15, LIST_BUTTON_Y, 100, 28, currentTheme.secondary, currentTheme.secondary, "Back",
-    []() {
-      listSavedSignals();
-    },
-    true);
-  createTouchBox(125, LIST_BUTTON_Y, 100, 28, currentTheme.primary, currentTheme.primary, "Send", []() {
+    90, LIST_BUTTON_Y, 60, 28, currentTheme.primary, currentTheme.primary, "View", []() {
+      if (activeList.selectedIndex < 0 || activeList.selectedIndex >= groupedSignalCount) return;
+      if (loadSignalFromSD(("/saved-signals/" + groupedSignalFiles[activeList.selectedIndex]).c_str(), waveSignal)) {
+        pushScreen(SAVED_GROUP_SCREEN);
+        showWaveform(waveSignal, waveSignal.name, popScreen);
+      }
+    });
+  createTouchBox(155, LIST_BUTTON_Y, 70, 28, currentTheme.primary, currentTheme.primary, "Send", []() {
     if (activeList.selectedIndex < 0 || activeList.selectedIndex >= groupedSignalCount) return;
-    File f = SD.open(("/saved-signals/" + groupedSignalFiles[activeList.selectedIndex]).c_str(), FILE_READ);
-    if (f) {
-      IRSignal signal;
-      f.read((uint8_t *)&signal, sizeof(IRSignal));
-      f.close();
+    IRSignal signal;
+    if (loadSignalFromSD(("/saved-signals/" + groupedSignalFiles[activeList.selectedIndex]).c_str(), signal)) {
       digitalWrite(SD_CS, HIGH);
       digitalWrite(TOUCH_CS, HIGH);
-      delay(10);
+      traceDelay(10);
       transmitSignal(signal);
     }
   });
-  drawTitle((currentSavedGroup + " signals").c_str(), 70);
+  char title[40];
+  snprintf(title, sizeof(title), "%s signals", currentSavedGroup.c_str());
+  drawTitle(title, 70);
 }
 
-void deleteSelectedFile() {
-  if (activeList.selectedIndex < 0 || activeList.selectedIndex >= sdFileCount) return;
-  String sel = sdFiles[activeList.selectedIndex];
-  if (sel.startsWith("DIR - ")) return;
-  int dash = sel.lastIndexOf(" - ");
-  String name = (dash > 0) ? sel.substring(0, dash) : sel;
-  String path = (currentPath == "/") ? ("/" + name) : (currentPath + "/" + name);
-  if (SD.remove(path.c_str())) {
-    loadSDFiles(currentPath);
-    if (activeList.selectedIndex >= sdFileCount && sdFileCount > 0)
-      activeList.selectedIndex = sdFileCount - 1;
-    drawSDFileBrowser();
+String sdFilePath(int idx) {
+  String sel = sdFiles[idx];
+  String name;
+  if (sel.startsWith("DIR - ")) {
+    name = sel.substring(6);
   } else {
+    int dash = sel.lastIndexOf(" - ");
+    name = (dash > 0) ? sel.substring(0, dash) : sel;
+  }
+  return (currentPath == "/") ? ("/" + name) : (currentPath + "/" + name);
+}
+
+// Deletes the marked rows, or the selected file when nothing is marked.
+// Preserved root entries are never queued, and a job that would empty
+// a directory asks first
+void deleteSelectedFile() {
+  sdJobPathCount = 0;
+  int dirs = 0;
+  for (int i = 0; i < sdFileCount && sdJobPathCount < MAX_SD_JOB_PATHS; i++) {
+    bool take = sdMarkedCount ? sdFileMarked[i] : (i == activeList.selectedIndex && !sdFiles[i].startsWith("DIR - "));
+    if (!take) continue;
+    String path = sdFilePath(i);
+    if (sdPreservedEntry(currentPath, path.substring(path.lastIndexOf('/') + 1))) continue;
+    dirs += sdFileIsDir[i];
+    sdJobRows[sdJobPathCount] = i;
+    sdJobPaths[sdJobPathCount++] = path;
+  }
+  if (sdJobPathCount == 0) return;
+  if (dirs) confirmSelectedDelete(dirs);
+  else startSelectedDelete();
+}
+
+// sdJobPaths[] stays queued while this is up; Cancel goes back to the
+// listing with its marks
+void confirmSelectedDelete(int dirs) {
+  buttonCount = 0;
+  clearScreen();
+  createOptions(SD_DELETE_OPTIONS, 2, 10, 100);
+  char line[40];
+  snprintf(line, sizeof(line), "Delete %d entr%s?", sdJobPathCount, sdJobPathCount == 1 ? "y" : "ies");
+  printCentered(line, 60, currentTheme.primary, 2);
+  snprintf(line, sizeof(line), "%d folder%s with all they hold", dirs, dirs == 1 ? "" : "s");
+  printCentered(line, 90, TFT_WHITE, 1);
+  drawTitle("SD Card > Files", 75);
+}
+
+void startSelectedDelete() {
+  startSdDeleteJob("SD Card > Files", deleteSelectedDone);
+}
+
+// Drops the removed rows from the listing in place instead of re-reading
+// the directory; rows that failed or were never reached stay marked
+void deleteSelectedDone() {
+  int kept = 0, failed = 0, sel = activeList.selectedIndex;
+  for (int i = 0, k = 0; i < sdFileCount; i++) {
+    bool removed = false;
+    if (k < sdJobPathCount && sdJobRows[k] == i) {
+      removed = sdJobPathOk[k];
+      if (!removed) failed++;
+      k++;
+    }
+    if (removed) {
+      if (i < activeList.selectedIndex) sel--;
+      continue;
+    }
+    sdFiles[kept] = sdFiles[i];
+    sdFileIsDir[kept] = sdFileIsDir[i];
+    sdFileMarked[kept++] = sdFileMarked[i];
+  }
+  sdFileCount = kept;
+  sdMarkedCount = 0;
+  for (int i = 0; i < sdFileCount; i++) sdMarkedCount += sdFileMarked[i];
+  activeList.selectedIndex = constrain(sel, 0, max(sdFileCount - 1, 0));
+  drawSDFileBrowser();
+  if (failed && !sdJobCancelled) {
     printCentered("Delete", 100, 0xF800, 2);
     printCentered("failed!", 120, 0xF800, 2);
-    delay(1500);
+    traceDelay(1500);
     drawSDFileBrowser();
   }
 }
@@ -997,7 +2913,7 @@ void deleteSelectedFile() {
 // Screens — Theme
 // ============================================================
 void themeOptions() {
-  createOptions(THEME_OPTIONS, 4, 10, 47, 220, 45);
+  createOptions(THEME_OPTIONS, 7, 10, 42, 220, 30);
   drawTitle("Change theme", 85);
 }
 
@@ -1026,25 +2942,142 @@ void setTheme(uint8_t themeIndex) {
   ThemeColors newTheme = themeFromIndex(themeIndex);
 
   tft.fillScreen(TFT_BLACK);
-  delay(60);
+  traceDelay(60);
   for (int r = 0; r <= 210; r += 7) {
     tft.fillCircle(120, 160, r, newTheme.primary);
     tft.drawCircle(120, 160, r + 1, TFT_BLACK);
     tft.drawCircle(120, 160, r + 2, newTheme.accent);
-    delay(10);
+    traceDelay(10);
   }
   tft.fillRect(0, 0, 240, 320, newTheme.primary);
-  delay(80);
+  traceDelay(80);
   currentTheme = newTheme;
   drawMenuUI();
 }
 
+// Touch calibration: a cross near one corner, then the opposite one.
+// Each touch's mean raw reading, past its first few, is extrapolated
+// to the panel's edges. Any touch counts wherever it lands, so a panel
+// whose saved calibration is off can still be recalibrated.
+void startTouchCalibration() {
+  touchCalFailures = 0;
+  beginTouchCalibration();
+}
+
+void beginTouchCalibration() {
+  buttonCount = 0;
+  touchCalActive = true;
+  touchCalStep = 0;
+  touchCalSumX = touchCalSumY = 0;
+  touchCalSamples = 0;
+  drawTouchCalibrationTarget();
+}
+
+void drawTouchCalibrationTarget() {
+  nameBusOp("touch calibration");
+  int x = touchCalStep ? tft.width() - 1 - TOUCH_CAL_INSET : TOUCH_CAL_INSET;
+  int y = touchCalStep ? tft.height() - 1 - TOUCH_CAL_INSET : TOUCH_CAL_INSET;
+  tft.fillScreen(TFT_BLACK);
+  tft.drawFastHLine(x - 12, y, 25, currentTheme.primary);
+  tft.drawFastVLine(x, y - 12, 25, currentTheme.primary);
+  tft.drawCircle(x, y, 6, currentTheme.accent);
+  printCentered("Touch the cross", 150, currentTheme.primary, 2);
+  printCentered(touchCalStep ? "2 of 2" : "1 of 2", 175, currentTheme.secondary, 1);
+  printCentered("No touch for 15 s keeps the old one", 195, currentTheme.secondary, 1);
+  touchCalTargetMs = millis();
+}
+
+void serviceTouchCalibration(const lgfx::touch_point_t &raw, bool touching) {
+  if (touching) {
+    if (raw.size >= TOUCH_PRESS_Z && ++touchCalSamples > TOUCH_CAL_SETTLE_SAMPLES) {
+      touchCalSumX += raw.x;
+      touchCalSumY += raw.y;
+    }
+    return;
+  }
+  int n = touchCalSamples - TOUCH_CAL_SETTLE_SAMPLES;
+  int32_t sumX = touchCalSumX, sumY = touchCalSumY;
+  touchCalSumX = touchCalSumY = 0;
+  touchCalSamples = 0;
+  if (n < TOUCH_CAL_MIN_SAMPLES) {  // no touch, or too brief to trust
+    if (millis() - touchCalTargetMs >= TOUCH_CAL_TIMEOUT_MS) endTouchCalibration("cancelled");
+    return;
+  }
+  touchCalRawX[touchCalStep] = sumX / n;
+  touchCalRawY[touchCalStep] = sumY / n;
+  if (++touchCalStep < 2) {
+    drawTouchCalibrationTarget();
+    return;
+  }
+
+  int w = tft.width(), h = tft.height();
+  TouchCalibration cal = touchCalibrationFrom(TOUCH_CAL_INSET, TOUCH_CAL_INSET, touchCalRawX[0], touchCalRawY[0],
+                                              w - 1 - TOUCH_CAL_INSET, h - 1 - TOUCH_CAL_INSET, touchCalRawX[1],
+                                              touchCalRawY[1], w, h);
+  if (!cal.valid()) {
+    if (++touchCalFailures >= TOUCH_CAL_MAX_ATTEMPTS) {
+      endTouchCalibration("failed");
+      return;
+    }
+    tft.fillScreen(TFT_BLACK);
+    printCentered("Calibration", 140, currentTheme.primary, 2);
+    printCentered("failed", 160, currentTheme.primary, 2);
+    traceDelay(1500);
+    beginTouchCalibration();
+    return;
+  }
+  touchCal = cal;
+  prefs.begin("uniremote", false);
+  prefs.putBytes("touchCal", &touchCal, sizeof(touchCal));
+  prefs.end();
+  touchCalActive = false;
+  themeOptions();
+}
+
+// Leaves with touchCal as it was
+void endTouchCalibration(const char *outcome) {
+  tft.fillScreen(TFT_BLACK);
+  printCentered("Calibration", 140, currentTheme.primary, 2);
+  printCentered(outcome, 160, currentTheme.primary, 2);
+  printCentered("The old one is kept", 185, currentTheme.secondary, 1);
+  traceDelay(1500);
+  touchCalActive = false;
+  themeOptions();
+}
+
 // ============================================================
 // Keyboard
 // ============================================================
+// Letter rows plus the < _ - > control row; returns the y below it
+int drawKeyboardKeys(int top, int kH, int cH) {
+  const int kW = 22, kG = 2, kS = kW + kG;
+  const int r0y = top, r1y = r0y + kH + 3, r2y = r1y + kH + 3;
+
+  int x0 = (240 - (10 * kW + 9 * kG)) / 2;
+  for (int i = 0; i < 10; i++)
+    createTouchBox(x0 + i * kS, r0y, kW, kH, currentTheme.primary, TFT_WHITE, qwerty0[i], keyboardButtonPressed);
+
+  x0 = (240 - (9 * kW + 8 * kG)) / 2;
+  for (int i = 0; i < 9; i++)
+    createTouchBox(x0 + i * kS, r1y, kW, kH, currentTheme.primary, TFT_WHITE, qwerty1[i], keyboardButtonPressed);
+
+  x0 = (240 - (7 * kW + 6 * kG)) / 2;
+  for (int i = 0; i < 7; i++)
+    createTouchBox(x0 + i * kS, r2y, kW, kH, currentTheme.primary, TFT_WHITE, qwerty2[i], keyboardButtonPressed);
+
+  const int cW = 52, cG = 8, ctrlY = r2y + kH + 16;
+  const int cX = (240 - (4 * cW + 3 * cG)) / 2;
+  createTouchBox(cX, ctrlY, cW, cH, 0xF800, TFT_WHITE, "<", keyboardButtonPressed);
+  createTouchBox(cX + (cW + cG), ctrlY, cW, cH, currentTheme.dark, TFT_WHITE, "_", keyboardButtonPressed);
+  createTouchBox(cX + 2 * (cW + cG), ctrlY, cW, cH, currentTheme.dark, TFT_WHITE, "-", keyboardButtonPressed);
+  createTouchBox(cX + 3 * (cW + cG), ctrlY, cW, cH, 0x07E0, TFT_WHITE, ">", keyboardButtonPressed);
+  return ctrlY + cH;
+}
+
 void drawKeyboard() {
   buttonCount = 0;
   clearScreen();
+  keyboardSearchMode = false;
 
   tft.setTextSize(1);
   tft.setTextColor(currentTheme.accent);
@@ -1057,7 +3090,7 @@ void drawKeyboard() {
 
   tft.setTextColor(currentTheme.accent);
   tft.setCursor(5, 44);
-  tft.printf("Raw: %d pulses", currentRawDataLen);
+  tft.printf("Raw: %d @ %luk", currentRawDataLen, (unsigned long)((currentCarrierHz + 500) / 1000));
   tft.setTextColor(0xF800);
   tft.setCursor(120, 44);
   tft.print("HEX:");
@@ -1069,30 +3102,10 @@ void drawKeyboard() {
   }
   tft.drawFastHLine(0, 55, 240, currentTheme.darkest);
 
-  const int kW = 22, kH = 42, kG = 2, kS = kW + kG;
-  const int r0y = 74, r1y = r0y + kH + 3, r2y = r1y + kH + 3;
-
-  int x0 = (240 - (10 * kW + 9 * kG)) / 2;
-  for (int i = 0; i < 10; i++)
-    createTouchBox(x0 + i * kS, r0y, kW, kH, currentTheme.primary, TFT_WHITE, qwerty0[i], keyboardButtonPressed);
-
-  x0 = (240 - (9 * kW + 8 * kG)) / 2;
-  for (int i = 0; i < 9; i++)
-    createTouchBox(x0 + i * kS, r1y, kW, kH, currentTheme.primary, TFT_WHITE, qwerty1[i], keyboardButtonPressed);
-
-  x0 = (240 - (7 * kW + 6 * kG)) / 2;
-  for (int i = 0; i < 7; i++)
-    createTouchBox(x0 + i * kS, r2y, kW, kH, currentTheme.primary, TFT_WHITE, qwerty2[i], keyboardButtonPressed);
-
-  const int cW = 52, cH = 40, cG = 8, ctrlY = r2y + kH + 16;
-  const int cX = (240 - (4 * cW + 3 * cG)) / 2;
-  createTouchBox(cX, ctrlY, cW, cH, 0xF800, TFT_WHITE, "<", keyboardButtonPressed);
-  createTouchBox(cX + (cW + cG), ctrlY, cW, cH, currentTheme.dark, TFT_WHITE, "_", keyboardButtonPressed);
-  createTouchBox(cX + 2 * (cW + cG), ctrlY, cW, cH, currentTheme.dark, TFT_WHITE, "-", keyboardButtonPressed);
-  createTouchBox(cX + 3 * (cW + cG), ctrlY, cW, cH, 0x07E0, TFT_WHITE, ">", keyboardButtonPressed);
+  int bottom = drawKeyboardKeys(74, 42, 40);
 
   createTouchBox(
-    80, ctrlY + cH + 8, 80, 26, currentTheme.secondary, currentTheme.secondary, "Back",
+    80, bottom + 8, 80, 26, currentTheme.secondary, currentTheme.secondary, "Back",
     []() {
       outputText[0] = '\0';
       signalCaptured = false;
@@ -1106,6 +3119,10 @@ void drawKeyboard() {
 
 void keyboardButtonPressed() {
   const char *label = buttons[activeBtnIndex].label;
+  if (keyboardSearchMode) {
+    searchKeyPressed(label);
+    return;
+  }
 
   if (strcmp(label, "<") == 0) {
     int len = strlen(outputText);
@@ -1114,14 +3131,12 @@ void keyboardButtonPressed() {
   } else if (strcmp(label, ">") == 0) {
     if (strlen(outputText) == 0) return;
     IRSignal signal;
-    strncpy(signal.name, outputText, MAX_SAVED_SIGNAL_CHARS);
-    signal.name[MAX_SAVED_SIGNAL_CHARS] = '\0';
-    memcpy(signal.rawData, currentRawData, sizeof(signal.rawData));
-    signal.rawDataLen = currentRawDataLen;
+    buildCapturedSignal(signal);
+    snprintf(signal.name, sizeof(signal.name), "%s", outputText);
     saveSignalToSD(signal);
     clearScreen();
     printCentered("Saved!", 150, currentTheme.primary, 2);
-    delay(2000);
+    traceDelay(2000);
     outputText[0] = '\0';
     signalCaptured = false;
     buttonCount = 0;
@@ -1155,38 +3170,184 @@ void keyboardButtonPressed() {
 // ============================================================
 // IR
 // ============================================================
-void captureSignal() {
-  if (IrReceiver.decodedIRData.rawlen == 0) {
-    IrReceiver.resume();
-    return;
+void IRAM_ATTR onIrEdge() {
+  uint32_t now = micros();
+  if (now - traceLastIrEdgeUs >= IR_FRAME_GAP_US) trace.isrInstant(TRACE_IR_RX_START, now);
+  traceLastIrEdgeUs = now;
+  irEdges.push(now, digitalRead(IR_RX));
+}
+
+// Runs every loop() pass: turns buffered edges into complete frames
+void serviceIrReceiver() {
+  uint32_t emitted = irSegmenter.framesEmitted;
+  irSegmenter.drain(irEdges);
+  irSegmenter.poll(micros());
+  uint32_t fresh = irSegmenter.framesEmitted - emitted;
+  for (uint8_t i = irFrames.count - min(fresh, (uint32_t)irFrames.count); i < irFrames.count; i++) {
+    const IrFrame &frame = *irFrames.at(i);
+    uint32_t endUs = frame.startUs;
+    for (uint8_t d = 0; d < frame.len; d++) endUs += frame.durations[d];
+    trace.begin(TRACE_IR_CAPTURE, frame.startUs, frame.len);
+    trace.end(TRACE_IR_CAPTURE, endUs, frame.len);
+  }
+  if (sessionRecording) recordNewFrames();
+}
+
+// IrReceiver's own timer ISR is never started; its protocol decoders are
+// run over our frames by loading them into rawbuf (50 µs ticks)
+bool decodeIrFrame(const IrFrame &frame) {
+  uint16_t n = min((uint16_t)frame.len, (uint16_t)(RAW_BUFFER_LENGTH - 1));
+  IrReceiver.irparams.rawbuf[0] = IR_FRAME_GAP_US / MICROS_PER_TICK;
+  for (uint16_t i = 0; i < n; i++)
+    IrReceiver.irparams.rawbuf[i + 1] = (frame.durations[i] + MICROS_PER_TICK / 2) / MICROS_PER_TICK;
+  IrReceiver.irparams.rawlen = n + 1;
+  IrReceiver.irparams.OverflowFlag = frame.overflow;
+  IrReceiver.irparams.StateForISR = IR_REC_STATE_STOP;
+  bool decoded = IrReceiver.decode();
+  IrReceiver.irparams.StateForISR = IR_REC_STATE_IDLE;
+  return decoded;
+}
+
+void captureSignal(const IrFrame &frame) {
+  currentRawDataLen = frame.len;
+  memcpy(currentRawData, frame.durations, frame.len * sizeof(uint16_t));
+  currentDecodedHex = 0;
+  currentCarrierHz = DEFAULT_CARRIER_HZ;
+  if (decodeIrFrame(frame)) {
+    currentDecodedHex = IrReceiver.decodedIRData.decodedRawData;
+    currentCarrierHz = carrierForProtocol(IrReceiver.decodedIRData.protocol);
   }
-  currentRawDataLen = min((uint16_t)(IrReceiver.decodedIRData.rawlen - 1), (uint16_t)200);
-  for (uint16_t i = 0; i < currentRawDataLen; i++)
-    currentRawData[i] = IrReceiver.irparams.rawbuf[i + 1] * MICROS_PER_TICK;
-  currentDecodedHex = IrReceiver.decodedIRData.decodedRawData;
   signalCaptured = true;
-  IrReceiver.resume();
+}
+
+void buildCapturedSignal(IRSignal &signal) {
+  memset(&signal, 0, sizeof(IRSignal));
+  memcpy(signal.rawData, currentRawData, currentRawDataLen * sizeof(uint16_t));
+  signal.rawDataLen = currentRawDataLen;
+  signal.carrierHz = currentCarrierHz;
+}
+
+// The receiver module demodulates, so the carrier itself is never seen.
+// When the frame decodes as a known protocol use that protocol's carrier.
+uint32_t carrierForProtocol(decode_type_t protocol) {
+  switch (protocol) {
+    case SONY: return 40000;
+    case RC5:
+    case RC6: return 36000;
+    case PANASONIC:
+    case KASEIKYO: return 37000;
+    default: return DEFAULT_CARRIER_HZ;
+  }
 }
 
 void saveSignalToSD(const IRSignal &signal) {
+  unsigned long startUs = beginSdOp();
   String path = "/saved-signals/" + String(signal.name) + ".bin";
+  // The old file may be another size (an older build's, or a synced one)
+  File old = SD.open(path.c_str());
+  bool existed = old;
+  uint32_t oldSize = existed ? old.size() : 0;
+  if (existed) old.close();
   File f = SD.open(path.c_str(), FILE_WRITE);
   if (f) {
     f.write((uint8_t *)&signal, sizeof(IRSignal));
     f.close();
+    if (!existed || oldSize != sizeof(IRSignal)) {
+      listingChanged(path);
+      adjustStorageStats((int64_t)sdBytesOnCard(sizeof(IRSignal)) - sdBytesOnCard(oldSize), existed ? 0 : 1, 0);
+      markScreensStale();
+    }
+    if (!existed) searchIndexAddSaved(String(signal.name) + ".bin");
+  }
+  endSdOp(startUs);
+}
+
+bool loadSignalFromSD(const char *path, IRSignal &signal) {
+  unsigned long startUs = beginSdOp();
+  File f = SD.open(path, FILE_READ);
+  if (!f) {
+    endSdOp(startUs);
+    return false;
+  }
+  memset(&signal, 0, sizeof(IRSignal));
+  f.read((uint8_t *)&signal, min((size_t)f.size(), sizeof(IRSignal)));
+  f.close();
+  endSdOp(startUs);
+  sanitizeSignal(signal);
+  return signal.rawDataLen > 0;
+}
+
+void initRmtTransmitter() {
+  rmt_config_t cfg = RMT_DEFAULT_CONFIG_TX((gpio_num_t)IR_TX, IR_RMT_TX_CHANNEL);
+  cfg.clk_div = RMT_CLOCK_DIV;
+  cfg.tx_config.carrier_en = true;
+  cfg.tx_config.carrier_freq_hz = DEFAULT_CARRIER_HZ;
+  cfg.tx_config.carrier_duty_percent = RMT_CARRIER_DUTY_PERCENT;
+  cfg.tx_config.carrier_level = RMT_CARRIER_LEVEL_HIGH;
+  cfg.tx_config.idle_output_en = true;
+  cfg.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+  rmtTxReady = rmt_config(&cfg) == ESP_OK && rmt_driver_install(IR_RMT_TX_CHANNEL, 0, 0) == ESP_OK;
+  if (!rmtTxReady) Serial.println("RMT init failed — using IrSender");
+}
+
+// RMT returns as soon as the frame is queued; IrSender blocks for the
+// whole frame including its lead-out gap
+void sendSignalSection(const IRSignal &signal, bool repeat) {
+  unsigned long startUs = micros();
+  trace.begin(TRACE_IR_TX, startUs, repeat);
+  trace.end(TRACE_IR_TX, startUs + (repeat ? signalRepeatPeriodUs(signal) : signalOncePeriodUs(signal)), repeat);
+  if (rmtTxReady) {
+    if (rmt_wait_tx_done(IR_RMT_TX_CHANNEL, pdMS_TO_TICKS(RMT_BUSY_TIMEOUT_MS)) != ESP_OK)
+      rmt_tx_stop(IR_RMT_TX_CHANNEL);
+    const RmtCacheEntry &entry = rmtCache.get(signal);
+    const RmtFrame &frame = repeat ? entry.repeat : entry.once;
+    rmt_set_tx_carrier(IR_RMT_TX_CHANNEL, true, entry.carrierHighTicks, entry.carrierLowTicks, RMT_CARRIER_LEVEL_HIGH);
+    rmt_write_items(IR_RMT_TX_CHANNEL, (const rmt_item32_t *)frame.items, frame.itemCount, false);
+    return;
+  }
+  uint16_t section[MAX_RAW_LEN];
+  if (repeat) {
+    IrSender.sendRaw(copySection(signal, signalRepeatStart(signal), signal.repeatLen, section), signal.repeatLen,
+                     signalCarrierKHz(signal));
+  } else {
+    IrSender.sendRaw(copySection(signal, 0, signalOnceLen(signal), section), signalOnceLen(signal), signalCarrierKHz(signal));
   }
 }
 
+// Sends the first frame and arms hold-to-repeat; a code without a
+// once part starts straight with its repeat frame
 void transmitSignal(const IRSignal &signal) {
-  IrSender.sendRaw(signal.rawData, signal.rawDataLen, 38);
+  bool hasOnce = signalOnceLen(signal) > 0;
+  if (!hasOnce && signal.repeatLen == 0) return;
+  if (&signal != &heldSignal) heldSignal = signal;
+  holdNextRepeatUs = micros() + (hasOnce ? signalOncePeriodUs(heldSignal) : signalRepeatPeriodUs(heldSignal));
+  holdRepeatActive = heldSignal.repeatLen > 0;
+  if (perfTapPending) {
+    perf.tapToIr.add(micros() - perfTouchUs);
+    perfTapPending = false;
+  }
+  sendSignalSection(heldSignal, !hasOnce);
 }
 
-uint16_t prontoToRawSignal(const uint16_t *pronto, uint16_t *outRaw, uint8_t maxOut) {
-  float unit = pronto[1] * 0.241246f;
-  uint16_t totalVals = (pronto[2] + pronto[3]) * 2;
-  totalVals = min(totalVals, (uint16_t)min((int)maxOut, 150 - 4));
-  for (uint16_t i = 0; i < totalVals; i++) outRaw[i] = (uint16_t)(pronto[4 + i] * unit);
-  return totalVals;
+// RC5 and RC6 receivers tell a new press from a held key by the toggle
+// bit, so each Send press flips it; held repeats keep the press's signal
+bool nextPressToggle() {
+  pressToggle = !pressToggle;
+  return pressToggle;
+}
+
+// Called while a Send button is held: the repeat frame goes out once per
+// its own period (frame + lead-out), not at the button REPEAT_INTERVAL
+void serviceHeldTransmit() {
+  long waitUs = (long)(holdNextRepeatUs - micros());
+  if (rmtTxReady) {
+    if (waitUs > 0 || rmt_wait_tx_done(IR_RMT_TX_CHANNEL, 0) != ESP_OK) return;
+  } else {
+    if (waitUs > 20000) return;
+    if (waitUs > 0) delayMicroseconds(waitUs);
+  }
+  holdNextRepeatUs += signalRepeatPeriodUs(heldSignal);
+  sendSignalSection(heldSignal, true);
 }
 
 // ============================================================
@@ -1199,47 +3360,500 @@ String formatBytes(uint64_t bytes) {
   return String(bytes / (1024.0 * 1024.0 * 1024.0), 1) + " GB";
 }
 
-int countFilesInDirectory(const char *path) {
-  File dir = SD.open(path);
-  if (!dir || !dir.isDirectory()) return 0;
-  int count = 0;
-  for (File e = dir.openNextFile(); e; e = dir.openNextFile()) {
-    if (!e.isDirectory()) count++;
-    e.close();
+// ------------------------------------------------------------
+// Storage stats — SD.usedBytes() and SD.totalBytes() scan the whole FAT
+// and counting a directory opens every entry, so the Info screen reads
+// these cached figures instead. Writers adjust them as they go; the
+// reconcile below re-measures from scratch a directory slice per loop()
+// pass, only when nothing else is using the card, and restarts if a
+// writer gets in first. Used space is added up from the files' sizes in
+// whole clusters and the card's size is read from its boot sector, so
+// neither needs the FAT.
+// ------------------------------------------------------------
+void loadStorageStats() {
+  prefs.begin("uniremote", true);
+  bool found = prefs.getBytes("sdStats", &storageStats, sizeof(StorageStats)) == sizeof(StorageStats);
+  prefs.end();
+  if (!found || storageStats.cardBytes != SD.cardSize()) storageStats.valid = false;
+  statsReconcileDue = !storageStats.valid;
+  statsLastReconcileMs = millis();
+}
+
+void saveStorageStats() {
+  prefs.begin("uniremote", false);
+  prefs.putBytes("sdStats", &storageStats, sizeof(StorageStats));
+  prefs.end();
+  statsDirty = false;
+}
+
+void restartStatsReconcile() {
+  if (statsState == STATS_IDLE) return;
+  if (statsDir) statsDir.close();
+  statsState = STATS_IDLE;
+  statsReconcileDue = true;
+}
+
+// What a file of this size takes on the card
+uint64_t sdBytesOnCard(uint64_t size) {
+  uint32_t c = storageStats.clusterBytes;
+  return c ? (size + c - 1) / c * c : size;
+}
+
+// Cluster and data-area size from the FAT boot sector, found past the
+// MBR when the card has a partition table
+bool sdVolumeGeometry(uint32_t &clusterBytes, uint64_t &totalBytes) {
+  uint8_t sector[512];
+  auto bootSector = [&]() {
+    uint16_t bps = sector[11] | sector[12] << 8;
+    uint8_t spc = sector[13];
+    return (sector[0] == 0xEB || sector[0] == 0xE9) && bps >= 512 && bps <= 4096 && !(bps & (bps - 1)) && spc && !(spc & (spc - 1));
+  };
+  unsigned long startUs = beginSdOp();
+  bool ok = SD.readRAW(sector, 0);
+  if (ok && !bootSector()) {
+    uint32_t lba = sector[0x1C6] | sector[0x1C7] << 8 | (uint32_t)sector[0x1C8] << 16 | (uint32_t)sector[0x1C9] << 24;
+    ok = SD.readRAW(sector, lba) && bootSector();
   }
-  dir.close();
-  return count;
+  endSdOp(startUs);
+  if (!ok) return false;
+  uint16_t bps = sector[11] | sector[12] << 8, reserved = sector[14] | sector[15] << 8;
+  uint16_t rootEntries = sector[17] | sector[18] << 8, sectors16 = sector[19] | sector[20] << 8;
+  uint16_t fat16 = sector[22] | sector[23] << 8;
+  uint32_t sectors = sectors16 ? sectors16 : sector[32] | sector[33] << 8 | (uint32_t)sector[34] << 16 | (uint32_t)sector[35] << 24;
+  uint32_t fatSectors = fat16 ? fat16 : sector[36] | sector[37] << 8 | (uint32_t)sector[38] << 16 | (uint32_t)sector[39] << 24;
+  uint32_t overhead = reserved + sector[16] * fatSectors + (rootEntries * 32 + bps - 1) / bps;
+  if (sectors <= overhead) return false;
+  clusterBytes = (uint32_t)bps * sector[13];
+  totalBytes = (uint64_t)((sectors - overhead) / sector[13]) * clusterBytes;
+  return true;
 }
 
-bool deleteDirectory(const char *path) {
-  File dir = SD.open(path);
-  if (!dir) return false;
-  if (!dir.isDirectory()) {
-    dir.close();
-    return SD.remove(path);
+void adjustStorageStats(int64_t bytes, int32_t saved, int32_t sessions) {
+  restartStatsReconcile();
+  if (!storageStats.valid) return;
+  int64_t used = (int64_t)storageStats.usedBytes + bytes;
+  int64_t savedCount = (int64_t)storageStats.savedCount + saved;
+  int64_t sessionCount = (int64_t)storageStats.sessionCount + sessions;
+  storageStats.usedBytes = used < 0 ? 0 : used;
+  storageStats.savedCount = savedCount < 0 ? 0 : savedCount;
+  storageStats.sessionCount = sessionCount < 0 ? 0 : sessionCount;
+  statsDirty = true;
+  statsChangedMs = millis();
+}
+
+void noteSdFileRemoved(const String &path, uint32_t size) {
+  listingChanged(path);
+  String parent = path.substring(0, path.lastIndexOf('/'));
+  if (parent == "/saved-signals") {
+    searchIndexRemoveSaved(path.substring(parent.length() + 1));
+    markScreensStale();
   }
-  for (File e = dir.openNextFile(); e; e = dir.openNextFile()) {
-    String ePath = String(path) + "/" + e.name();
+  adjustStorageStats(-(int64_t)sdBytesOnCard(size), parent == "/saved-signals" ? -1 : 0, parent == "/sessions" ? -1 : 0);
+}
+
+bool statsCardIdle() {
+  return !sdJobActive && !syncServer.busy() && !sessionRecording && !sessionReplaying;
+}
+
+// Counts the files in statsDir for one slice; true once it is exhausted
+bool statsCountSlice() {
+  if (!statsDir) return true;
+  unsigned long start = millis();
+  while (millis() - start < STATS_SLICE_MS) {
+    File e = statsDir.openNextFile();
+    if (!e) {
+      statsDir.close();
+      return true;
+    }
+    if (!e.isDirectory()) statsCounted++;
+    e.close();
+  }
+  return false;
+}
+
+// Adds up the tree under statsDirPaths[0] for one slice; true once done.
+// As in the delete job only the deepest directory is open, and a parent
+// is reopened past the entries already read.
+bool statsMeasureSlice() {
+  unsigned long start = millis();
+  while (millis() - start < STATS_SLICE_MS) {
+    File e = statsDir.openNextFile();
+    if (!e) {
+      statsDir.close();
+      if (--statsDepth == 0) return true;
+      statsDir = SD.open(statsDirPaths[statsDepth - 1]);
+      for (uint32_t i = 0; statsDir && i < statsDirRead[statsDepth - 1]; i++) {
+        File skip = statsDir.openNextFile();
+        if (!skip) break;
+        skip.close();
+      }
+      continue;
+    }
+    statsDirRead[statsDepth - 1]++;
     bool isDir = e.isDirectory();
+    uint64_t size = isDir ? 0 : e.size();
+    String name = String(e.name());
     e.close();
-    if (!(isDir ? deleteDirectory(ePath.c_str()) : SD.remove(ePath.c_str()))) {
-      dir.close();
-      return false;
+    if (!isDir) {
+      statsUsedBytes += sdBytesOnCard(size);
+      continue;
     }
+    statsUsedBytes += storageStats.clusterBytes;
+    if (statsDepth == STATS_MAX_DEPTH) continue;
+    name = name.substring(name.lastIndexOf('/') + 1);
+    const String &dir = statsDirPaths[statsDepth - 1];
+    statsDirPaths[statsDepth] = (dir == "/") ? ("/" + name) : (dir + "/" + name);
+    statsDirRead[statsDepth] = 0;
+    statsDir.close();
+    statsDir = SD.open(statsDirPaths[statsDepth++]);
   }
-  dir.close();
-  return SD.rmdir(path);
+  return false;
+}
+
+void serviceStorageStats() {
+  if (!initializedSD) return;
+  unsigned long now = millis();
+  if (statsDirty && now - statsChangedMs >= STATS_PERSIST_MS) saveStorageStats();
+
+  if (statsState == STATS_IDLE) {
+    bool due = statsReconcileDue || now - statsLastReconcileMs >= STATS_RECONCILE_MS;
+    bool idle = storageInfoActive || now - lastTouchMs >= STATS_IDLE_MS;
+    if (!due || !idle || !statsCardIdle()) return;
+    statsCounted = 0;
+    statsDir = SD.open("/saved-signals");
+    statsState = STATS_COUNT_SAVED;
+    return;
+  }
+  if (!statsCardIdle()) {
+    restartStatsReconcile();
+    return;
+  }
+  if (statsState == STATS_COUNT_SAVED) {
+    if (!statsCountSlice()) return;
+    storageStats.savedCount = statsCounted;
+    statsCounted = 0;
+    statsDir = SD.open("/sessions");
+    statsState = STATS_COUNT_SESSIONS;
+  } else if (statsState == STATS_COUNT_SESSIONS) {
+    if (!statsCountSlice()) return;
+    storageStats.sessionCount = statsCounted;
+    if (!sdVolumeGeometry(storageStats.clusterBytes, storageStats.totalBytes)) {
+      restartStatsReconcile();
+      statsReconcileDue = false;
+      statsLastReconcileMs = millis();
+      return;
+    }
+    statsUsedBytes = 0;
+    statsDepth = 1;
+    statsDirPaths[0] = "/";
+    statsDirRead[0] = 0;
+    statsDir = SD.open("/");
+    statsState = STATS_MEASURE;
+  } else {
+    if (!statsMeasureSlice()) return;
+    storageStats.cardBytes = SD.cardSize();
+    storageStats.usedBytes = statsUsedBytes;
+    storageStats.valid = true;
+    statsState = STATS_IDLE;
+    statsReconcileDue = false;
+    statsLastReconcileMs = millis();
+    saveStorageStats();
+    if (storageInfoActive) listSDInfo();
+  }
+}
+
+// Root entries the format wipe leaves in place
+bool sdPreservedEntry(const String &dirPath, const String &name) {
+  return dirPath == "/" && (name == "System Volume Information" || name == "built-in-signals");
+}
+
+// ------------------------------------------------------------
+// SD delete job — removes sdJobPaths[] (files, or directories with
+// everything under them) a time slice per loop() pass, so the screen
+// keeps drawing progress and Cancel stays live. Only the directory being
+// emptied is held open: entries are removed as they are read, so on the
+// way back up the parent is reopened and just the entries it kept
+// (preserved or failed) are skipped.
+// ------------------------------------------------------------
+void startSdDeleteJob(const char *title, void (*done)()) {
+  stopSessionRecording();
+  stopSessionReplay();
+  closeSignalPack();
+  sdJobDone = done;
+  sdJobNext = 0;
+  sdJobDepth = 0;
+  sdJobRemoved = 0;
+  sdJobCancelled = false;
+  sdJobActive = true;
+  for (int i = 0; i < sdJobPathCount; i++) sdJobPathOk[i] = false;
+
+  buttonCount = 0;
+  clearScreen();
+  printCentered("Deleting...", 110, currentTheme.primary, 2);
+  createTouchBox(
+    60, LIST_BUTTON_Y, 120, 28, currentTheme.secondary, currentTheme.secondary, "Cancel", []() {
+      sdJobCancelled = true;
+    },
+    true);
+  drawTitle(title, 75);
+  drawSdJobProgress();
+}
+
+// Reopens the directory on top of the stack past the entries it keeps
+void sdJobReopen() {
+  sdJobDir = SD.open(sdJobDirPaths[sdJobDepth - 1]);
+  if (!sdJobDir) {
+    sdJobDepth = 0;
+    sdJobPathOk[sdJobNext++] = false;
+    return;
+  }
+  for (uint16_t i = 0; i < sdJobKept[sdJobDepth - 1]; i++) {
+    File e = sdJobDir.openNextFile();
+    if (!e) break;
+    e.close();
+  }
+}
+
+// The directory on top of the stack is empty apart from kept entries
+void sdJobLeave() {
+  sdJobDir.close();
+  String path = sdJobDirPaths[--sdJobDepth];
+  bool ok = path == "/" || SD.rmdir(path.c_str());
+  if (ok && path != "/") {
+    sdJobRemoved++;
+    listingChanged(path);
+    dropSortCache(path);
+  }
+  if (sdJobDepth == 0) {
+    sdJobPathOk[sdJobNext++] = ok && !sdJobPathFailed;
+    return;
+  }
+  if (!ok) {
+    sdJobKept[sdJobDepth - 1]++;
+    sdJobPathFailed = true;
+  }
+  sdJobReopen();
+}
+
+void sdJobStep() {
+  if (sdJobDepth == 0) {
+    const String &path = sdJobPaths[sdJobNext];
+    sdJobPathFailed = false;
+    File f = SD.open(path);
+    if (!f) {
+      sdJobPathOk[sdJobNext++] = false;
+    } else if (!f.isDirectory()) {
+      uint32_t size = f.size();
+      f.close();
+      bool ok = SD.remove(path.c_str());
+      if (ok) {
+        sdJobRemoved++;
+        noteSdFileRemoved(path, size);
+      }
+      sdJobPathOk[sdJobNext++] = ok;
+    } else {
+      sdJobDir = f;
+      sdJobDirPaths[0] = path;
+      sdJobKept[0] = 0;
+      sdJobDepth = 1;
+    }
+    return;
+  }
+
+  File e = sdJobDir.openNextFile();
+  if (!e) {
+    sdJobLeave();
+    return;
+  }
+  String name = String(e.name());
+  name = name.substring(name.lastIndexOf('/') + 1);
+  bool isDir = e.isDirectory();
+  uint32_t size = isDir ? 0 : e.size();
+  e.close();
+  const String &dir = sdJobDirPaths[sdJobDepth - 1];
+  if (sdPreservedEntry(dir, name)) {
+    sdJobKept[sdJobDepth - 1]++;
+    return;
+  }
+  String child = (dir == "/") ? ("/" + name) : (dir + "/" + name);
+  if (!isDir) {
+    if (SD.remove(child.c_str())) {
+      sdJobRemoved++;
+      noteSdFileRemoved(child, size);
+    } else {
+      sdJobKept[sdJobDepth - 1]++;
+      sdJobPathFailed = true;
+    }
+    return;
+  }
+  if (sdJobDepth < SD_JOB_MAX_DEPTH) {
+    sdJobDir.close();
+    sdJobDir = SD.open(child);
+    if (sdJobDir) {
+      sdJobDirPaths[sdJobDepth] = child;
+      sdJobKept[sdJobDepth] = 0;
+      sdJobDepth++;
+      return;
+    }
+  }
+  sdJobKept[sdJobDepth - 1]++;
+  sdJobPathFailed = true;
+  if (!sdJobDir) sdJobReopen();
+}
+
+void serviceSdDeleteJob() {
+  if (!sdJobActive) return;
+  unsigned long start = millis();
+  while (!sdJobCancelled && sdJobNext < sdJobPathCount && millis() - start < SD_JOB_SLICE_MS)
+    sdJobStep();
+  if (sdJobCancelled || sdJobNext >= sdJobPathCount) {
+    if (sdJobDir) sdJobDir.close();
+    sdJobDepth = 0;
+    sdJobActive = false;
+    if (sdJobDone) sdJobDone();
+    return;
+  }
+  if (millis() - sdJobLastDrawMs >= SD_JOB_REDRAW_MS) drawSdJobProgress();
 }
 
-void formatStatusLine(const char *label, uint16_t labelColor, const String &name) {
-  tft.fillRect(0, 125, 240, 55, TFT_BLACK);
+void drawSdJobProgress() {
+  sdJobLastDrawMs = millis();
+  int w = sdJobPathCount ? 200 * sdJobNext / sdJobPathCount : 200;
+  tft.drawRect(19, SD_JOB_BAR_Y - 1, 202, 14, currentTheme.primary);
+  tft.fillRect(20, SD_JOB_BAR_Y, w, 12, currentTheme.primary);
+  tft.fillRect(20 + w, SD_JOB_BAR_Y, 200 - w, 12, currentTheme.darkest);
+
+  tft.fillRect(0, SD_JOB_BAR_Y + 20, 240, 40, TFT_BLACK);
   tft.setTextSize(2);
-  tft.setTextColor(labelColor);
-  tft.setCursor(10, 130);
-  tft.print(label);
+  tft.setTextColor(currentTheme.primary);
+  tft.setCursor(20, SD_JOB_BAR_Y + 22);
+  tft.print("Removed: ");
+  tft.println(sdJobRemoved);
+  String at = sdJobDepth ? sdJobDirPaths[sdJobDepth - 1] : (sdJobNext < sdJobPathCount ? sdJobPaths[sdJobNext] : String(""));
+  if (at.length() > 33) at = "..." + at.substring(at.length() - 30);
+  tft.setTextSize(1);
   tft.setTextColor(TFT_WHITE);
-  tft.setCursor(0, 155);
-  tft.println(name);
+  tft.setCursor(20, SD_JOB_BAR_Y + 46);
+  tft.println(at);
+}
+
+// ------------------------------------------------------------
+// Sorted listings — the first MAX_SD_FILES entries of a directory in
+// natural order, picked by NaturalTopK (IR-natsort.h) in one readdir pass
+// that never opens a file; only the kept files are opened, for their
+// sizes. The rows are saved as they are shown, so a cached visit reads
+// one file and not the directory. FAT does not touch a directory's mtime
+// when its entries change, so the sketch drops a directory's cache itself
+// whenever it changes it (listingChanged), and a cache from an earlier
+// mount is never trusted.
+// ------------------------------------------------------------
+bool nextDirEntry(File &dir, String &name, bool &isDir) {
+  name = dir.getNextFileName(&isDir);
+  if (name.length() == 0) return false;
+  name = name.substring(name.lastIndexOf('/') + 1);
+  return true;
+}
+
+String sortCachePath(const String &path) {
+  char name[20];
+  snprintf(name, sizeof(name), "/%08lx.idx", (unsigned long)syncCrc32(0, (const uint8_t *)path.c_str(), path.length()));
+  return String(SORT_CACHE_DIR) + name;
+}
+
+void dropSortCache(const String &dirPath) {
+  String cache = sortCachePath(dirPath);
+  if (SD.exists(cache.c_str())) SD.remove(cache.c_str());
+}
+
+// An entry was created, removed or resized: its directory lists afresh
+void listingChanged(const String &entryPath) {
+  int slash = entryPath.lastIndexOf('/');
+  dropSortCache(slash > 0 ? entryPath.substring(0, slash) : String("/"));
+}
+
+bool loadCachedListing(const String &path) {
+  File f = SD.open(sortCachePath(path));
+  if (!f) return false;
+  SortCacheHeader h;
+  bool ok = f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) && h.magic == SORT_CACHE_MAGIC && h.mount == sdMountId
+            && h.kept <= MAX_SD_FILES;
+  char name[256];
+  int n = 0;
+  for (; ok && n < h.kept; n++) {
+    SortCacheRow row;
+    ok = f.read((uint8_t *)&row, sizeof(row)) == sizeof(row) && f.read((uint8_t *)name, row.nameLen) == row.nameLen;
+    if (!ok) break;
+    name[row.nameLen] = '\0';
+    sdFiles[n] = name;
+    sdFileIsDir[n] = row.isDir;
+    sdFileSize[n] = row.size;
+  }
+  f.close();
+  sdFileCount = ok ? n : 0;
+  return ok;
+}
+
+void writeSortCache(const String &path) {
+  if (!SD.exists(SORT_CACHE_DIR)) SD.mkdir(SORT_CACHE_DIR);
+  File f = SD.open(sortCachePath(path), FILE_WRITE);
+  if (!f) return;
+  SortCacheHeader h = { SORT_CACHE_MAGIC, sdMountId, (uint16_t)sdFileCount, 0 };
+  f.write((const uint8_t *)&h, sizeof(h));
+  for (int i = 0; i < sdFileCount; i++) {
+    SortCacheRow row = { sdFileSize[i], sdFileIsDir[i], (uint8_t)min(sdFiles[i].length(), (unsigned)255) };
+    f.write((const uint8_t *)&row, sizeof(row));
+    f.write((const uint8_t *)sdFiles[i].c_str(), row.nameLen);
+  }
+  f.close();
+}
+
+void sortListing(File &dir, const String &path) {
+  auto nameOf = [](uint16_t slot) {
+    return sdFiles[slot].c_str();
+  };
+  NaturalTopK<decltype(nameOf)> top(sdSortKeys, MAX_SD_FILES, nameOf);
+  String name;
+  bool isDir;
+  for (uint32_t pos = 0; nextDirEntry(dir, name, isDir); pos++) {
+    if (name.startsWith(".")) continue;
+    int slot = top.slotFor(name.c_str(), isDir);
+    if (slot < 0) continue;
+    sdFiles[slot] = name;
+    sdFileIsDir[slot] = isDir;
+    top.place(pos);
+  }
+  sdFileCount = top.finish();
+  naturalApplyOrder(sdSortKeys, sdFileCount, [](int dst, int src) {
+    static String spareName;
+    static bool spareDir;
+    (dst < 0 ? spareName : sdFiles[dst]) = std::move(src < 0 ? spareName : sdFiles[src]);
+    (dst < 0 ? spareDir : sdFileIsDir[dst]) = src < 0 ? spareDir : sdFileIsDir[src];
+  });
+  for (int i = 0; i < sdFileCount; i++) {
+    sdFileSize[i] = 0;
+    if (sdFileIsDir[i]) continue;
+    File f = SD.open((path == "/") ? ("/" + sdFiles[i]) : (path + "/" + sdFiles[i]));
+    if (f) {
+      sdFileSize[i] = f.size();
+      f.close();
+    }
+  }
+  writeSortCache(path);
+}
+
+// Short in-RAM lists (groups, sessions): sort compact keys, then move
+// each String once
+void sortStringsNaturally(String *items, int n) {
+  NaturalSortKey keys[MAX_SD_FILES];
+  n = min(n, MAX_SD_FILES);
+  for (int i = 0; i < n; i++) keys[i] = { naturalSortHead(items[i].c_str(), false), (uint16_t)i, (uint16_t)i };
+  naturalSort(keys, n, [items](uint16_t slot) {
+    return items[slot].c_str();
+  });
+  String spare;
+  naturalApplyOrder(keys, n, [items, &spare](int dst, int src) {
+    (dst < 0 ? spare : items[dst]) = std::move(src < 0 ? spare : items[src]);
+  });
 }
 
 String extractPrefix(String filename) {
@@ -1248,15 +3862,146 @@ String extractPrefix(String filename) {
   return (i > 0) ? filename.substring(0, i) : filename;
 }
 
+// ============================================================
+// Serial sync
+// ============================================================
+// The host tool (v5/tools/irsync.cpp) lists, reads, writes and deletes
+// /saved-signals through SyncServer. Chunks go straight between the
+// open File and the UART; uploads land in SYNC_TEMP_PATH and only
+// replace the real file once size and CRC check out.
+void serviceSerialSync() {
+  if (sdJobActive) return;
+  syncServer.service(Serial, syncStore, millis());
+}
+
+bool SdSyncStore::listBegin() {
+  if (dir) dir.close();
+  dir = SD.open("/saved-signals");
+  return dir && dir.isDirectory();
+}
+
+bool SdSyncStore::listNext(char *name, size_t n, uint32_t &size) {
+  for (File e = dir.openNextFile(); e; e = dir.openNextFile()) {
+    bool take = !e.isDirectory() && syncNameValid(e.name(), strlen(e.name()));
+    if (take) {
+      strncpy(name, e.name(), n - 1);
+      name[n - 1] = '\0';
+      size = e.size();
+    }
+    e.close();
+    if (take) return true;
+  }
+  dir.close();
+  return false;
+}
+
+bool SdSyncStore::openRead(const char *name, uint32_t &size) {
+  reader = SD.open((String("/saved-signals/") + name).c_str(), FILE_READ);
+  if (!reader || reader.isDirectory()) {
+    closeRead();
+    return false;
+  }
+  size = reader.size();
+  return true;
+}
+
+bool SdSyncStore::readAt(uint32_t offset, uint8_t *buf, uint16_t n) {
+  if (tracing) return trace.read(offset, buf, n);
+  unsigned long startUs = beginSdOp();
+  bool ok = reader && reader.seek(offset) && reader.read(buf, n) == n;
+  endSdOp(startUs);
+  return ok;
+}
+
+void SdSyncStore::closeRead() {
+  if (reader) reader.close();
+  if (tracing) trace.thaw();
+  tracing = false;
+}
+
+// Recording stops until the dump has gone out, so it can't shift under
+// the transfer
+bool SdSyncStore::openTrace(uint32_t &size) {
+  closeRead();
+  tracing = true;
+  size = trace.freeze(micros());
+  return true;
+}
+
+bool SdSyncStore::openWrite() {
+  abortWrite();
+  if (!SD.exists("/saved-signals") && SD.mkdir("/saved-signals")) listingChanged("/saved-signals");
+  writer = SD.open(SYNC_TEMP_PATH, FILE_WRITE);
+  if (writer) listingChanged(SYNC_TEMP_PATH);
+  return (bool)writer;
+}
+
+bool SdSyncStore::write(const uint8_t *buf, uint16_t n) {
+  unsigned long startUs = beginSdOp();
+  bool ok = writer && writer.write(buf, n) == n;
+  endSdOp(startUs);
+  return ok;
+}
+
+bool SdSyncStore::commitWrite(const char *name) {
+  uint32_t size = writer.size();
+  writer.close();
+  String path = String("/saved-signals/") + name;
+  File old = SD.open(path.c_str());
+  bool existed = old;
+  uint32_t oldSize = existed ? old.size() : 0;
+  if (existed) {
+    old.close();
+    SD.remove(path.c_str());
+  }
+  bool ok = SD.rename(SYNC_TEMP_PATH, path.c_str());
+  if (ok) listingChanged(path);
+  if (ok && !existed) searchIndexAddSaved(name);
+  else if (!ok && existed) searchIndexRemoveSaved(name);
+  if (ok != existed) markScreensStale();
+  adjustStorageStats((int64_t)sdBytesOnCard(ok ? size : 0) - sdBytesOnCard(oldSize), (ok ? 1 : 0) - (existed ? 1 : 0), 0);
+  return ok;
+}
+
+void SdSyncStore::abortWrite() {
+  if (writer) writer.close();
+  if (SD.exists(SYNC_TEMP_PATH) && SD.remove(SYNC_TEMP_PATH)) listingChanged(SYNC_TEMP_PATH);
+}
+
+bool SdSyncStore::remove(const char *name) {
+  String path = String("/saved-signals/") + name;
+  File f = SD.open(path.c_str());
+  uint32_t size = f ? f.size() : 0;
+  if (f) f.close();
+  if (!SD.remove(path.c_str())) return false;
+  noteSdFileRemoved(path, size);
+  return true;
+}
+
 // ============================================================
 // Touch system
 // ============================================================
+// One poll of the panel through touchFilter (IR-touch.h). The raw
+// reading rides in the trace span, so a dump can be replayed on the host
+bool readTouch(lgfx::touch_point_t &raw, int32_t &x, int32_t &y) {
+  unsigned long startUs = micros();
+  if (!tft.getTouchRaw(&raw, 1)) raw = {};
+  bool touching = touchFilter.add(startUs, touchCal.x(raw.x, tft.width()), touchCal.y(raw.y, tft.height()), raw.size);
+  trace.begin(TRACE_TOUCH, startUs, traceTouchBeginArg(raw.x, raw.size));
+  trace.end(TRACE_TOUCH, micros(), traceTouchEndArg(raw.y, raw.size));
+  if (touchFilter.moving) perf.touchLag.add(touchFilter.lagUs);
+  x = lroundf(touchFilter.x());
+  y = lroundf(touchFilter.y());
+  return touching;
+}
+
 int processTouchButtons(int tx, int ty) {
   for (int i = 0; i < buttonCount; i++) {
     if (isTouchInButton(&buttons[i], tx, ty)) {
       buttons[i].pressed = true;
       drawButton(&buttons[i], true);
       activeBtnIndex = i;
+      perf.touchCallback.add(micros() - perfTouchUs);
       if (buttons[i].callback) buttons[i].callback();
       return i;
     }
@@ -1265,6 +4010,7 @@ int processTouchButtons(int tx, int ty) {
 }
 
 void createTouchBox(int x, int y, int w, int h, uint16_t color, uint16_t textColor, const char *label, void (*cb)(), bool isBack, bool repeatable) {
+  if (buttonCount >= MAX_TOUCH_BUTTONS) return;
   TouchButton *btn = &buttons[buttonCount];
   btn->x = x;
   btn->y = y;